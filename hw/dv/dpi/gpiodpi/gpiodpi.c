@@ -14,11 +14,13 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <limits.h>
+#include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <time.h>
 #include <unistd.h>
 
 // This file does a lot of bit setting and getting; these macros are intended to
@@ -27,6 +29,11 @@
 #define SET_BIT(word, bit_idx) ((word) |= (1 << (bit_idx)))
 #define CLR_BIT(word, bit_idx) ((word) &= ~(1 << (bit_idx)))
 
+// Change records buffered before they are written to the device-to-host FIFO.
+// When the host doesn't read them fast enough, further changes are dropped
+// and counted.
+#define GPIODPI_MAX_RECORDS 256
+
 struct gpiodpi_ctx {
   // The number of pins we're driving.
   int n_bits;
@@ -40,6 +47,27 @@ struct gpiodpi_ctx {
   char dev_to_host_path[PATH_MAX];
   int host_to_dev_fifo;
   char host_to_dev_path[PATH_MAX];
+
+  // Whether the FIFOs use the binary protocol (see gpiodpi.h)
+  int binary;
+
+  // Binary mode: bytes waiting to be written to the device-to-host FIFO
+  uint8_t out_buf[sizeof(struct gpiodpi_header) +
+                  GPIODPI_MAX_RECORDS * sizeof(struct gpiodpi_record)];
+  size_t out_len;
+
+  // Binary mode: pin state sent in the last record, and the number of records
+  // dropped since then
+  uint32_t last_value;
+  uint32_t last_oe;
+  uint32_t dropped;
+
+  // Binary mode: partially received host record
+  uint8_t in_buf[sizeof(struct gpiodpi_host_record)];
+  size_t in_len;
+
+  // Wall-clock time of the last read from the host-to-device FIFO
+  struct timespec last_poll;
 };
 
 /**
@@ -78,12 +106,17 @@ static int open_fifo(char *path_buf, int flags) {
  * @arg wfifo the path to the "write" side (w.r.t the host).
  * @arg n_bits the number of pins supported.
  */
-static void print_usage(char *rfifo, char *wfifo, int n_bits) {
+static void print_usage(char *rfifo, char *wfifo, int n_bits, int binary) {
   printf("\n");
   printf(
       "GPIO: FIFO pipes created at %s (read) and %s (write) for %d-bit wide "
       "GPIO.\n",
       rfifo, wfifo, n_bits);
+  if (binary) {
+    printf("GPIO: The FIFOs use the binary protocol. To watch the pins, run\n");
+    printf("$ util/gpiodpi.py %s\n", rfifo);
+    return;
+  }
   printf(
       "GPIO: To measure the values of the pins as driven by the device, run\n");
   printf("$ cat %s  # '0' low, '1' high, 'X' floating\n", rfifo);
@@ -92,7 +125,7 @@ static void print_usage(char *rfifo, char *wfifo, int n_bits) {
          wfifo);
 }
 
-void *gpiodpi_create(const char *name, int n_bits) {
+void *gpiodpi_create(const char *name, int n_bits, int binary) {
   struct gpiodpi_ctx *ctx =
       (struct gpiodpi_ctx *)malloc(sizeof(struct gpiodpi_ctx));
   assert(ctx);
@@ -103,6 +136,14 @@ void *gpiodpi_create(const char *name, int n_bits) {
   ctx->n_bits = n_bits;
 
   ctx->driven_pin_values = 0;
+  ctx->binary = binary;
+  ctx->out_len = 0;
+  ctx->last_value = 0;
+  ctx->last_oe = 0;
+  ctx->dropped = 0;
+  ctx->in_len = 0;
+  ctx->last_poll.tv_sec = 0;
+  ctx->last_poll.tv_nsec = 0;
 
   char cwd_buf[PATH_MAX];
   char *cwd = getcwd(cwd_buf, sizeof(cwd_buf));
@@ -128,16 +169,92 @@ void *gpiodpi_create(const char *name, int n_bits) {
   int flags = fcntl(ctx->host_to_dev_fifo, F_GETFL, 0);
   fcntl(ctx->host_to_dev_fifo, F_SETFL, flags | O_NONBLOCK);
 
-  print_usage(ctx->dev_to_host_path, ctx->host_to_dev_path, ctx->n_bits);
+  if (binary) {
+    // Records are flushed in batches, and must never stall the simulation.
+    flags = fcntl(ctx->dev_to_host_fifo, F_GETFL, 0);
+    fcntl(ctx->dev_to_host_fifo, F_SETFL, flags | O_NONBLOCK);
+
+    struct gpiodpi_header header;
+    memcpy(header.magic, GPIODPI_MAGIC, sizeof(header.magic));
+    header.version = GPIODPI_VERSION;
+    header.n_bits = n_bits;
+    memcpy(ctx->out_buf, &header, sizeof(header));
+    ctx->out_len = sizeof(header);
+  }
+
+  print_usage(ctx->dev_to_host_path, ctx->host_to_dev_path, ctx->n_bits,
+              binary);
 
   return (void *)ctx;
 }
 
-void gpiodpi_device_to_host(void *ctx_void, svBitVecVal *gpio_data,
-                            svBitVecVal *gpio_oe) {
+/**
+ * Writes as much of the buffered binary output as the FIFO will take.
+ */
+static void flush_records(struct gpiodpi_ctx *ctx) {
+  if (ctx->out_len == 0) {
+    return;
+  }
+
+  ssize_t written = write(ctx->dev_to_host_fifo, ctx->out_buf, ctx->out_len);
+  if (written <= 0) {
+    // Most likely EAGAIN, because the FIFO is full; try again later.
+    return;
+  }
+
+  ctx->out_len -= written;
+  memmove(ctx->out_buf, ctx->out_buf + written, ctx->out_len);
+}
+
+/**
+ * Buffers a change record, flushing the buffer first if it is full.
+ */
+static void add_record(struct gpiodpi_ctx *ctx, uint64_t cycle, uint32_t value,
+                       uint32_t oe) {
+  uint32_t mask =
+      ctx->n_bits == 32 ? 0xffffffff : ((uint32_t)1 << ctx->n_bits) - 1;
+  value &= oe & mask;
+  oe &= mask;
+
+  uint32_t changed = (value ^ ctx->last_value) | (oe ^ ctx->last_oe);
+  if (changed == 0) {
+    return;
+  }
+
+  if (ctx->out_len + sizeof(struct gpiodpi_record) > sizeof(ctx->out_buf)) {
+    flush_records(ctx);
+  }
+  if (ctx->out_len + sizeof(struct gpiodpi_record) > sizeof(ctx->out_buf)) {
+    // Keep |last_value| and |last_oe|, so the next record reports every pin
+    // that changed since the host last heard from us.
+    ++ctx->dropped;
+    return;
+  }
+
+  struct gpiodpi_record record;
+  record.cycle = cycle;
+  record.changed = changed;
+  record.value = value;
+  record.oe = oe;
+  record.dropped = ctx->dropped;
+  memcpy(ctx->out_buf + ctx->out_len, &record, sizeof(record));
+  ctx->out_len += sizeof(record);
+
+  ctx->last_value = value;
+  ctx->last_oe = oe;
+  ctx->dropped = 0;
+}
+
+void gpiodpi_device_to_host(void *ctx_void, uint64_t cycle,
+                            svBitVecVal *gpio_data, svBitVecVal *gpio_oe) {
   struct gpiodpi_ctx *ctx = (struct gpiodpi_ctx *)ctx_void;
   assert(ctx);
 
+  if (ctx->binary) {
+    add_record(ctx, cycle, gpio_data[0], gpio_oe[0]);
+    return;
+  }
+
   // Write 0, 1, or X (when oe is not set) for each GPIO pin, in big endian
   // order (i.e., pin 0 is the last character written). Finish it with a
   // newline.
@@ -186,10 +303,71 @@ static uint32_t parse_dec(char **text) {
   return value;
 }
 
+/**
+ * Returns whether at least GPIODPI_POLL_INTERVAL_US of wall-clock time passed
+ * since this last returned true.
+ */
+static bool poll_due(struct gpiodpi_ctx *ctx) {
+  struct timespec now;
+  if (clock_gettime(CLOCK_MONOTONIC, &now) != 0) {
+    return true;
+  }
+
+  int64_t elapsed_us = (now.tv_sec - ctx->last_poll.tv_sec) * 1000000 +
+                       (now.tv_nsec - ctx->last_poll.tv_nsec) / 1000;
+  if (elapsed_us < GPIODPI_POLL_INTERVAL_US) {
+    return false;
+  }
+
+  ctx->last_poll = now;
+  return true;
+}
+
+/**
+ * Applies the records the host wrote to the host-to-device FIFO.
+ */
+static void read_host_records(struct gpiodpi_ctx *ctx, uint32_t gpio_oe) {
+  uint8_t buf[16 * sizeof(struct gpiodpi_host_record)];
+  ssize_t read_len = read(ctx->host_to_dev_fifo, buf, sizeof(buf));
+  if (read_len <= 0) {
+    return;
+  }
+
+  for (ssize_t i = 0; i < read_len; ++i) {
+    ctx->in_buf[ctx->in_len++] = buf[i];
+    if (ctx->in_len < sizeof(ctx->in_buf)) {
+      continue;
+    }
+    ctx->in_len = 0;
+
+    struct gpiodpi_host_record record;
+    memcpy(&record, ctx->in_buf, sizeof(record));
+    if (record.mask & ~gpio_oe) {
+      fprintf(stderr, "GPIO: Host tried to drive disabled pins: 0x%08x\n",
+              record.mask & ~gpio_oe);
+    }
+    ctx->driven_pin_values =
+        (ctx->driven_pin_values & ~record.mask) | (record.value & record.mask);
+  }
+}
+
 uint32_t gpiodpi_host_to_device_tick(void *ctx_void, svBitVecVal *gpio_oe) {
   struct gpiodpi_ctx *ctx = (struct gpiodpi_ctx *)ctx_void;
   assert(ctx);
 
+  if (ctx->binary) {
+    flush_records(ctx);
+  }
+
+  if (!poll_due(ctx)) {
+    return ctx->driven_pin_values;
+  }
+
+  if (ctx->binary) {
+    read_host_records(ctx, gpio_oe[0]);
+    return ctx->driven_pin_values;
+  }
+
   char gpio_str[32 + 2];
   ssize_t read_len = read(ctx->host_to_dev_fifo, gpio_str, 32 + 1);
   if (read_len < 0) {
@@ -241,6 +419,10 @@ void gpiodpi_close(void *ctx_void) {
     return;
   }
 
+  if (ctx->binary) {
+    flush_records(ctx);
+  }
+
   if (close(ctx->dev_to_host_fifo) != 0) {
     printf("GPIO: Failed to close FIFO file at %s: %s\n", ctx->dev_to_host_path,
            strerror(errno));
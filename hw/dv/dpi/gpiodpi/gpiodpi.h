@@ -5,26 +5,69 @@
 #ifndef OPENTITAN_HW_DV_DPI_GPIODPI_GPIODPI_H_
 #define OPENTITAN_HW_DV_DPI_GPIODPI_GPIODPI_H_
 
+#include <stdint.h>
 #include <svdpi.h>
 
 extern "C" {
 
+/**
+ * Binary protocol
+ *
+ * In binary mode the device-to-host FIFO starts with a gpiodpi_header,
+ * followed by a gpiodpi_record for each change of the pins. Records are
+ * buffered and written in batches, so they may reach the host up to one poll
+ * interval late; their timestamps are exact. The host drives pins by writing
+ * gpiodpi_host_record structs to the host-to-device FIFO. All fields are in
+ * host byte order. util/gpiodpi.py implements the host side.
+ */
+#define GPIODPI_MAGIC "GPIO"
+#define GPIODPI_VERSION 1
+
+// Minimum wall-clock time between reads of the host-to-device FIFO
+#define GPIODPI_POLL_INTERVAL_US 1000
+
+struct gpiodpi_header {
+  char magic[4];  // GPIODPI_MAGIC
+  uint16_t version;
+  uint16_t n_bits;
+};
+
+struct gpiodpi_record {
+  // Clock cycle at which the change happened
+  uint64_t cycle;
+  // Pins whose state changed
+  uint32_t changed;
+  // Values driven by the device, valid where |oe| is set; other pins float
+  uint32_t value;
+  uint32_t oe;
+  // Records lost before this one because the host didn't keep up
+  uint32_t dropped;
+};
+
+struct gpiodpi_host_record {
+  // Pins to drive, and the values to drive them to
+  uint32_t mask;
+  uint32_t value;
+};
+
 /**
  * Allocate a new GPIO DPI interface, returned as an opaque pointer.
  *
  * @param name a name to use when creating the inner FIFO.
  * @param n_bits number of bits to write in each direction; this must be at
  *        most 32 bits.
+ * @param binary use the binary protocol rather than text.
  */
-void *gpiodpi_create(const char *name, int n_bits);
+void *gpiodpi_create(const char *name, int n_bits, int binary);
 
 /**
  * Attempt to post the current GPIO state to the outside world.
  *
  * Intended to be called from SystemVerilog.
+ * @param cycle the current clock cycle, for binary mode timestamps.
  */
-void gpiodpi_device_to_host(void *ctx_void, svBitVecVal *gpio_data,
-                            svBitVecVal *gpio_oe);
+void gpiodpi_device_to_host(void *ctx_void, uint64_t cycle,
+                            svBitVecVal *gpio_data, svBitVecVal *gpio_oe);
 
 /**
  * Attempt to read a GPIO command from the outside world.
@@ -33,7 +76,11 @@ void gpiodpi_device_to_host(void *ctx_void, svBitVecVal *gpio_data,
  * low commands, terminated by a newline. A high command is of the form |hXX|,
  * where XX are hex digits, pulls the XXth GPIO pin high; a low command, |lXX|,
  * does the opposite. All other pins at left in an unspecified state. Invalid
- * commands are ignored.
+ * commands are ignored. In binary mode, the host sends gpiodpi_host_record
+ * structs instead.
+ *
+ * The FIFO is read at most once every GPIODPI_POLL_INTERVAL_US of wall-clock
+ * time; pending binary records are written out on every call.
  *
  * Intended to be called from SystemVerilog.
  * @return the values to pull the GPIO pins to.
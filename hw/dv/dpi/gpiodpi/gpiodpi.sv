@@ -15,10 +15,12 @@ module gpiodpi
   input  logic [N_GPIO-1:0] gpio_en_d2p
 );
    import "DPI-C" function
-     chandle gpiodpi_create(input string name, input int n_bits);
+     chandle gpiodpi_create(input string name, input int n_bits,
+                            input int binary);
 
    import "DPI-C" function
-     void gpiodpi_device_to_host(input chandle ctx, input [N_GPIO-1:0] gpio_d2p,
+     void gpiodpi_device_to_host(input chandle ctx, input longint unsigned cycle,
+                                 input [N_GPIO-1:0] gpio_d2p,
                                  input [N_GPIO-1:0] gpio_en_d2p);
 
    import "DPI-C" function
@@ -30,19 +32,24 @@ module gpiodpi
 
    chandle ctx;
 
+   // Pass +GPIODPI_BINARY_<NAME> to use the binary, timestamped protocol (see
+   // gpiodpi.h) instead of text.
    initial begin
-     ctx = gpiodpi_create(NAME, N_GPIO);
+     ctx = gpiodpi_create(NAME, N_GPIO, $test$plusargs({"GPIODPI_BINARY_", NAME}));
    end
 
    final begin
      gpiodpi_close(ctx);
    end
 
-   logic [N_GPIO-1:0] gpio_d2p_r;
+   longint unsigned cycle;
+   logic [N_GPIO-1:0] gpio_d2p_r, gpio_en_d2p_r;
    always_ff @(posedge clk_i) begin
+     cycle <= cycle + 1;
      gpio_d2p_r <= gpio_d2p;
-     if (gpio_d2p_r != gpio_d2p) begin
-       gpiodpi_device_to_host(ctx, gpio_d2p, gpio_en_d2p);
+     gpio_en_d2p_r <= gpio_en_d2p;
+     if (gpio_d2p_r != gpio_d2p || gpio_en_d2p_r != gpio_en_d2p) begin
+       gpiodpi_device_to_host(ctx, cycle, gpio_d2p, gpio_en_d2p);
      end
    end
 
@@ -58,7 +65,8 @@ module gpiodpi
 
    // gpiodpio_host_to_device_tick() will be called every MAX_COUNT
    // clock posedges; this should be kept reasonably high, since each
-   // tick call will perform at least one syscall.
+   // tick call may perform syscalls. In binary mode this is also the
+   // latency with which changes reach the host.
    localparam MAX_COUNT = 2048;
    logic [$clog2(MAX_COUNT)-1:0] counter;
 
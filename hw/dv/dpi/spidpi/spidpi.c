@@ -12,6 +12,8 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <limits.h>
+#include <poll.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -26,8 +28,148 @@
 // and resume at the first SPI packet
 // #define CONTROL_TRACE
 
+// True until spidpi_close() asks the reader thread to stop
+static bool reader_running(struct spidpi_ctx *ctx) {
+  return __atomic_load_n(&ctx->reader_run, __ATOMIC_ACQUIRE);
+}
+
+/**
+ * Read exactly |len| bytes from the pty into |buf|
+ *
+ * Returns false if the reader thread was asked to stop before all bytes
+ * arrived.
+ */
+static bool read_exact(struct spidpi_ctx *ctx, uint8_t *buf, size_t len) {
+  size_t got = 0;
+  while (got < len) {
+    if (!reader_running(ctx)) {
+      return false;
+    }
+    // Time out regularly to notice when spidpi_close() stops the thread.
+    struct pollfd pfd = {ctx->host, POLLIN, 0};
+    if (poll(&pfd, 1, 100) <= 0) {
+      continue;
+    }
+    ssize_t n = read(ctx->host, buf + got, len - got);
+    if (n == -1) {
+      if (errno != EAGAIN && errno != EINTR) {
+        fprintf(stderr, "SPI: Read on pty gave %s\n", strerror(errno));
+        usleep(100000);
+      }
+      continue;
+    }
+    got += n;
+  }
+  return true;
+}
+
+/**
+ * Reader thread: parse transactions from the pty and queue them
+ *
+ * Blocking on the pty here keeps system calls out of spidpi_tick(), which only
+ * has to check the queue.
+ */
+static void *reader_main(void *ctx_void) {
+  struct spidpi_ctx *ctx = (struct spidpi_ctx *)ctx_void;
+
+  while (reader_running(ctx)) {
+    uint8_t hdr[SPIDPI_HEADER_SIZE];
+    if (!read_exact(ctx, hdr, sizeof(hdr))) {
+      break;
+    }
+
+    int len = hdr[2] | (hdr[3] << 8);
+    if (len == 0 || len > SPIDPI_MAX_TRANSACTION) {
+      fprintf(stderr, "SPI: Dropping transaction with bad length %d\n", len);
+      // Skip the data to stay in sync with the framing.
+      uint8_t discard[256];
+      while (len > 0) {
+        int n = len < (int)sizeof(discard) ? len : (int)sizeof(discard);
+        if (!read_exact(ctx, discard, n)) {
+          return NULL;
+        }
+        len -= n;
+      }
+      continue;
+    }
+
+    // Wait for the simulation to free up a slot
+    unsigned int tail = ctx->qtail;
+    while (tail - __atomic_load_n(&ctx->qhead, __ATOMIC_ACQUIRE) ==
+           SPIDPI_QUEUE_DEPTH) {
+      if (!reader_running(ctx)) {
+        return NULL;
+      }
+      usleep(100);
+    }
+
+    struct spidpi_xact *xact = &ctx->queue[tail % SPIDPI_QUEUE_DEPTH];
+    int mode = hdr[0] & SPIDPI_FLAG_MODE_MASK;
+    xact->cpol = (mode & 2) >> 1;
+    xact->cpha = mode & 1;
+    xact->msbfirst = !(hdr[0] & SPIDPI_FLAG_LSB_FIRST);
+    xact->half_period = hdr[1] ? hdr[1] : SPIDPI_DEFAULT_HALF_PERIOD;
+    xact->len = len;
+    if (!read_exact(ctx, xact->data, len)) {
+      break;
+    }
+    __atomic_store_n(&ctx->qtail, tail + 1, __ATOMIC_RELEASE);
+  }
+  return NULL;
+}
+
+/**
+ * Write the bytes sampled on SDO during the current transaction to the pty
+ *
+ * If the host doesn't read them (so that the pty buffer stays full) for
+ * SPIDPI_WRITE_TIMEOUT_MS, the rest of the response is dropped rather than
+ * stalling the simulation.
+ */
+static void write_response(struct spidpi_ctx *ctx) {
+  int len = ctx->xact->len;
+  int done = 0;
+  while (done < len) {
+    ssize_t n = write(ctx->host, ctx->din + done, len - done);
+    if (n == -1) {
+      if (errno == EINTR) {
+        continue;
+      }
+      if (errno == EAGAIN || errno == EWOULDBLOCK) {
+        struct pollfd pfd = {ctx->host, POLLOUT, 0};
+        if (poll(&pfd, 1, SPIDPI_WRITE_TIMEOUT_MS) > 0) {
+          continue;
+        }
+        fprintf(stderr,
+                "SPI: Host isn't reading, dropping %d of %d response "
+                "bytes\n",
+                len - done, len);
+        return;
+      }
+      fprintf(stderr, "SPI: Write on pty gave %s\n", strerror(errno));
+      return;
+    }
+    done += n;
+  }
+}
+
+// Value of SDI for bit |bit| of the current transaction
+static char sdi_bit(const struct spidpi_xact *xact, int bit) {
+  int mask = xact->msbfirst ? 0x80 >> (bit & 7) : 0x01 << (bit & 7);
+  return (xact->data[bit >> 3] & mask) ? P2D_SDI : 0;
+}
+
+// Record the value of SDO for bit |bit| of the current transaction
+static void sample_sdo(struct spidpi_ctx *ctx, int bit, int d2p) {
+  int mask = ctx->xact->msbfirst ? 0x80 >> (bit & 7) : 0x01 << (bit & 7);
+  if ((bit & 7) == 0) {
+    ctx->din[bit >> 3] = 0;
+  }
+  if (d2p & D2P_SDO) {
+    ctx->din[bit >> 3] |= mask;
+  }
+}
+
 void *spidpi_create(const char *name, int mode, int loglevel) {
-  int i;
   struct spidpi_ctx *ctx =
       (struct spidpi_ctx *)calloc(1, sizeof(struct spidpi_ctx));
   assert(ctx);
@@ -35,20 +177,15 @@ void *spidpi_create(const char *name, int mode, int loglevel) {
   ctx->loglevel = loglevel;
   ctx->mon = monitor_spi_init(mode);
   ctx->tick = 0;
-  ctx->msbfirst = 1;
-  ctx->nmax = MAX_TRANSACTION;
-  ctx->nin = 0;
-  ctx->nout = 0;
-  ctx->bout = 0;
   ctx->state = SP_IDLE;
-  /* mode is CPOL << 1 | CPHA
-   * cpol = 0 --> external clock matches internal
-   * cpha = 0 --> drive on internal falling edge, capture on rising
+  ctx->xact = NULL;
+  ctx->qhead = 0;
+  ctx->qtail = 0;
+  /* mode is CPOL << 1 | CPHA and sets the idle level of the clock until the
+   * first transaction, which carries its own mode.
+   * CPOL = 1 for clock idle high
    */
-  ctx->cpol = ((mode == 0) || (mode == 2)) ? 0 : 1;
-  ctx->cpha = ((mode == 1) || (mode == 3)) ? 1 : 0;
-  /* CPOL = 1 for clock idle high */
-  ctx->driving = P2D_CSB | ((ctx->cpol) ? P2D_SCK : 0);
+  ctx->driving = P2D_CSB | ((mode & 2) ? P2D_SCK : 0);
   char cwd[PATH_MAX];
   char *cwd_rv;
   cwd_rv = getcwd(cwd, sizeof(cwd));
@@ -71,10 +208,11 @@ void *spidpi_create(const char *name, int mode, int loglevel) {
 
   printf(
       "\n"
-      "SPI: Created %s for %s. Connect to it with any terminal program, e.g.\n"
-      "$ screen %s\n"
-      "NOTE: a SPI transaction is run for every 4 characters entered.\n",
-      ctx->ptyname, name, ctx->ptyname);
+      "SPI: Created %s for %s.\n"
+      "NOTE: transactions are framed with a 4 byte header, see "
+      "hw/dv/dpi/spidpi/spidpi.h\n"
+      "or use sw/host/spiflash.\n",
+      ctx->ptyname, name);
 
   rv = snprintf(ctx->mon_pathname, PATH_MAX, "%s/%s.log", cwd, name);
   assert(rv <= PATH_MAX && rv > 0);
@@ -91,6 +229,10 @@ void *spidpi_create(const char *name, int mode, int loglevel) {
       "$ tail -f %s\n",
       ctx->mon_pathname, ctx->mon_pathname);
 
+  __atomic_store_n(&ctx->reader_run, true, __ATOMIC_RELEASE);
+  rv = pthread_create(&ctx->reader, NULL, reader_main, (void *)ctx);
+  assert(rv == 0 && "Unable to create SPI reader thread");
+
   return (void *)ctx;
 }
 
@@ -112,96 +254,85 @@ char spidpi_tick(void *ctx_void, const svLogicVecVal *d2p_data) {
               d2p);
 
   if (ctx->state == SP_IDLE) {
-    int n = read(ctx->host, &(ctx->buf[ctx->nin]), ctx->nmax - ctx->nin);
-    if (n == -1) {
-      if (errno != EAGAIN) {
-        fprintf(stderr, "Read on SPI FIFO gave %s\n", strerror(errno));
-      }
-    } else {
-      ctx->nin += n;
-      if (ctx->nin == ctx->nmax) {
-        ctx->nout = 0;
-        ctx->nin = 0;
-        ctx->bout = ctx->msbfirst ? 0x80 : 0x01;
-        ctx->bin = ctx->msbfirst ? 0x80 : 0x01;
-        ctx->din = 0;
-        ctx->state = SP_CSFALL;
+    if (ctx->qhead == __atomic_load_n(&ctx->qtail, __ATOMIC_ACQUIRE)) {
+      return ctx->driving;
+    }
+    // Start the next transaction, first moving SCK to its idle level
+    ctx->xact = &ctx->queue[ctx->qhead % SPIDPI_QUEUE_DEPTH];
+    ctx->edge = 0;
+    ctx->count = ctx->xact->half_period;
+    ctx->driving = P2D_CSB | (ctx->xact->cpol ? P2D_SCK : 0);
+    ctx->state = SP_CSFALL;
 #ifdef CONTROL_TRACE
-        VerilatorSimCtrl::GetInstance().TraceOn();
+    VerilatorSimCtrl::GetInstance().TraceOn();
 #endif
-      }
-    }
+    return ctx->driving;
   }
-  // SPI clock toggles every 4th tick (i.e. freq=primary_frequency/8)
-  if ((ctx->tick & 3) || (ctx->state == SP_IDLE)) {
+
+  // Only act once every half-period of SCK
+  if (--ctx->count > 0) {
     return ctx->driving;
   }
 
-  // Only get here on sck edges when active
-  int internal_sck = (ctx->tick & 4) ? 1 : 0;
-  int set_sck = (internal_sck ? P2D_SCK : 0);
-  if (ctx->cpol) {
-    set_sck ^= P2D_SCK;
+  if (ctx->state == SP_CSHIGH) {
+    // CSB has been high for a half-period, ready for the next transaction
+    ctx->state = SP_IDLE;
+    return ctx->driving;
   }
 
-  if (internal_sck == ctx->cpha) {
-    // host driving edge (falling for mode 0)
-    switch (ctx->state) {
-      case SP_DMOVE:
-        // SCLK low, CSB low
-        ctx->driving =
-            set_sck | (ctx->buf[ctx->nout] & ctx->bout) ? P2D_SDI : 0;
-        ctx->bout = (ctx->msbfirst) ? ctx->bout >> 1 : ctx->bout << 1;
-        if ((ctx->bout & 0xff) == 0) {
-          ctx->bout = ctx->msbfirst ? 0x80 : 0x01;
-          ctx->nout++;
-          if (ctx->nout == ctx->nmax) {
-            ctx->state = SP_LASTBIT;
-          }
+  const struct spidpi_xact *xact = ctx->xact;
+  ctx->count = xact->half_period;
+  /* cpha = 0 --> drive on trailing edge, capture on leading
+   * cpha = 1 --> drive on leading edge, capture on trailing
+   */
+  char idle_sck = xact->cpol ? P2D_SCK : 0;
+  int nbits = xact->len * 8;
+
+  switch (ctx->state) {
+    case SP_CSFALL:
+      // CSB low, clock idle, drive SDI to the first bit unless it is driven on
+      // the first edge
+      ctx->driving = idle_sck | (xact->cpha ? 0 : sdi_bit(xact, 0));
+      ctx->state = SP_DMOVE;
+      break;
+    case SP_DMOVE: {
+      int bit = ctx->edge >> 1;
+      char sdi = ctx->driving & P2D_SDI;
+      if (!(ctx->edge & 1)) {
+        // Leading edge
+        if (xact->cpha) {
+          sdi = sdi_bit(xact, bit);
+        } else {
+          sample_sdo(ctx, bit, d2p);
         }
-        break;
-      case SP_LASTBIT:
-        ctx->state = SP_CSRISE;
-        // fallthrough
-      default:
-        ctx->driving = set_sck | (ctx->driving & ~P2D_SCK);
-        break;
-    }
-  } else {
-    // host other edge (rising for mode 0)
-    switch (ctx->state) {
-        // Read input data (opposite edge to sending)
-        // both DMOVE and LASTBIT states are data moving ones!
-      case SP_DMOVE:
-      case SP_LASTBIT:
-        ctx->din = ctx->din | ((d2p & D2P_SDO) ? ctx->bin : 0);
-        ctx->bin = (ctx->msbfirst) ? ctx->bin >> 1 : ctx->bin << 1;
-        if (ctx->bin == 0) {
-          int rv = write(ctx->host, &(ctx->din), 1);
-          assert(rv == 1 && "write() failed.");
-          ctx->bin = (ctx->msbfirst) ? 0x80 : 0x01;
-          ctx->din = 0;
+        ctx->driving = (idle_sck ^ P2D_SCK) | sdi;
+      } else {
+        // Trailing edge
+        if (xact->cpha) {
+          sample_sdo(ctx, bit, d2p);
+        } else if (bit + 1 < nbits) {
+          sdi = sdi_bit(xact, bit + 1);
         }
-        ctx->driving = set_sck | (ctx->driving & ~P2D_SCK);
-        break;
-      case SP_CSFALL:
-        // CSB low, drive SDI to first bit
-        ctx->driving =
-            (set_sck | (ctx->buf[ctx->nout] & ctx->bout) ? P2D_SDI : 0);
-        ctx->state = SP_DMOVE;
-        break;
-      case SP_CSRISE:
-        // CSB high, clock stopped
-        ctx->driving = P2D_CSB;
-        ctx->state = SP_IDLE;
-        break;
-      case SP_FINISH:
-        VerilatorSimCtrl::GetInstance().RequestStop(true);
-        break;
-      default:
-        ctx->driving = set_sck | (ctx->driving & ~P2D_SCK);
-        break;
+        ctx->driving = idle_sck | sdi;
+      }
+      if (++ctx->edge == 2 * nbits) {
+        ctx->state = SP_CSRISE;
+      }
+      break;
     }
+    case SP_CSRISE:
+      // CSB high, clock stopped. Hand back the response and the queue slot.
+      ctx->driving = P2D_CSB | idle_sck;
+      write_response(ctx);
+      ctx->xact = NULL;
+      __atomic_store_n(&ctx->qhead, ctx->qhead + 1, __ATOMIC_RELEASE);
+      ctx->state = SP_CSHIGH;
+      break;
+    case SP_FINISH:
+      VerilatorSimCtrl::GetInstance().RequestStop(true);
+      break;
+    default:
+      break;
   }
   return ctx->driving;
 }
@@ -211,6 +342,11 @@ void spidpi_close(void *ctx_void) {
   if (!ctx) {
     return;
   }
+  __atomic_store_n(&ctx->reader_run, false, __ATOMIC_RELEASE);
+  pthread_join(ctx->reader, NULL);
+  close(ctx->host);
+  close(ctx->device);
   fclose(ctx->mon_file);
+  free(ctx->mon);
   free(ctx);
 }
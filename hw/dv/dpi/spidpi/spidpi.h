@@ -6,11 +6,60 @@
 #define OPENTITAN_HW_DV_DPI_SPIDPI_SPIDPI_H_
 
 #include <limits.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
 #include <svdpi.h>
 
 extern "C" {
 
-#define MAX_TRANSACTION 4
+/**
+ * Host protocol
+ *
+ * Software on the host drives the SPI bus by writing transactions to the pty
+ * that spidpi creates. Each transaction is a 4 byte header followed by the
+ * bytes to send on SDI:
+ *
+ *   byte 0:    flags, see SPIDPI_FLAG_*
+ *   byte 1:    SCK half-period in host clock cycles (0 for the default)
+ *   bytes 2-3: number of data bytes, little-endian, 1 to
+ *              SPIDPI_MAX_TRANSACTION
+ *
+ * Chip select is held low for the whole transaction. Once it is released
+ * again, the bytes that were sampled on SDO (as many as were sent) are written
+ * back to the pty in one go.
+ */
+#define SPIDPI_HEADER_SIZE 4
+
+// Size of the largest transaction, the default size of the spi_device RX
+// buffer.
+#define SPIDPI_MAX_TRANSACTION 2048
+
+// SPI mode for the transaction, CPOL << 1 | CPHA
+#define SPIDPI_FLAG_MODE_MASK 0x3
+// Shift bytes out and in LSB first
+#define SPIDPI_FLAG_LSB_FIRST 0x4
+
+// SCK half-period used when the header asks for the default, giving SCK at
+// 1/8 of the host clock.
+#define SPIDPI_DEFAULT_HALF_PERIOD 4
+
+// Number of transactions that can be queued between the reader thread and the
+// simulation.
+#define SPIDPI_QUEUE_DEPTH 4
+
+// How long write_response waits for the host to read before dropping data
+#define SPIDPI_WRITE_TIMEOUT_MS 1000
+
+struct spidpi_xact {
+  int cpol;
+  int cpha;
+  int msbfirst;
+  int half_period;
+  int len;
+  uint8_t data[SPIDPI_MAX_TRANSACTION];
+};
+
 struct spidpi_ctx {
   int loglevel;
   char ptyname[64];
@@ -20,26 +69,33 @@ struct spidpi_ctx {
   char mon_pathname[PATH_MAX];
   void *mon;
   int tick;
-  int cpol;
-  int cpha;
-  int msbfirst;  // shift direction
-  int nout;
-  int bout;
-  int nin;
-  int bin;
-  int din;
-  int nmax;
   char driving;
   int state;
-  char buf[MAX_TRANSACTION];
+
+  // Transaction in progress (points into |queue| while active)
+  struct spidpi_xact *xact;
+  int count;     // host clock cycles until the next SCK edge
+  int edge;      // SCK edges so far
+  uint8_t din[SPIDPI_MAX_TRANSACTION];
+
+  // Single producer (reader thread), single consumer (spidpi_tick) queue of
+  // transactions. |qhead| and |qtail| are only ever advanced, with atomic
+  // stores, by the consumer and producer respectively.
+  struct spidpi_xact queue[SPIDPI_QUEUE_DEPTH];
+  unsigned int qhead;
+  unsigned int qtail;
+
+  // Only accessed with __atomic builtins
+  bool reader_run;
+  pthread_t reader;
 };
 
 // SPI Host States
 #define SP_IDLE    0
 #define SP_CSFALL  1
 #define SP_DMOVE   2
-#define SP_LASTBIT 3
 #define SP_CSRISE  4
+#define SP_CSHIGH  5
 #define SP_FINISH  99
 
 // Bits in data to C
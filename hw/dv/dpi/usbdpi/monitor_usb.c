@@ -6,6 +6,7 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "usbdpi.h"
 
@@ -54,6 +55,12 @@ struct mon_ctx {
   int sopAt;
   int lastpid;
   unsigned char bytes[MON_BYTES_SIZE + 2];
+
+  // Last complete packet sent by the device, and how many there were
+  int dev_pkts;
+  int dev_pid;
+  int dev_len;
+  unsigned char dev_bytes[MON_BYTES_SIZE + 2];
 };
 
 void *monitor_usb_init() {
@@ -166,6 +173,13 @@ void monitor_usb(void *mon_void, FILE *mon_file, int loglevel, int tick,
     return;
   }
   if ((mon->line & 0x3f) == ((SE0 << 4) | (SE0 << 2) | (DJ << 0))) {
+    if ((mon->driver == M_DEVICE) && (mon->state == MS_GET_BYTES)) {
+      // Keep a copy before the logging below mangles the bytes
+      mon->dev_pid = mon->lastpid;
+      mon->dev_len = mon->byte;
+      memcpy(mon->dev_bytes, mon->bytes, mon->byte);
+      mon->dev_pkts++;
+    }
     if ((log || compact) && (mon->state == MS_GET_BYTES) && (mon->byte > 0)) {
       int i;
       int text = 1;
@@ -272,3 +286,20 @@ void monitor_usb(void *mon_void, FILE *mon_file, int loglevel, int tick,
       break;
   }
 }
+
+/**
+ * Get the last packet that the device sent
+ *
+ * |bytes| is set to the bytes after the PID (including any CRC16), which stay
+ * valid until the next device packet ends. Returns the number of device
+ * packets seen so far, so callers can tell when a new one has arrived.
+ */
+int monitor_usb_device_packet(void *mon_void, int *pid, const uint8_t **bytes,
+                              int *len) {
+  struct mon_ctx *mon = (struct mon_ctx *)mon_void;
+  assert(mon);
+  *pid = mon->dev_pid;
+  *bytes = mon->dev_bytes;
+  *len = mon->dev_len;
+  return mon->dev_pkts;
+}
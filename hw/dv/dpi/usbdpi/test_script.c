@@ -0,0 +1,103 @@
+// Copyright lowRISC contributors.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+// Checks for the script parser in usbdpi.c. Build with something like
+//
+//   cc -I<verilator>/include/vltstd test_script.c monitor_usb.c usb_crc.c
+//
+// and run with no arguments. Exits with a non-zero status on failure.
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "usbdpi.c"
+
+static int failures;
+
+// Write |text| to a temporary file and parse it as a script. Returns the
+// result of usbdpi_load_script, with the parsed commands left in |ctx|.
+static bool parse(struct usbdpi_ctx *ctx, const char *text) {
+  char path[] = "/tmp/usbdpi_script_XXXXXX";
+  int fd = mkstemp(path);
+  assert(fd >= 0);
+  FILE *f = fdopen(fd, "w");
+  assert(f);
+  fputs(text, f);
+  fclose(f);
+
+  free(ctx->cmds);
+  memset(ctx, 0, sizeof(*ctx));
+  bool ok = usbdpi_load_script(ctx, path);
+  unlink(path);
+  return ok;
+}
+
+static void check(bool cond, const char *what) {
+  if (!cond) {
+    printf("FAIL: %s\n", what);
+    failures++;
+  }
+}
+
+// A line with |nbytes| data bytes after "out 1 1 <nbytes>"
+static char *out_line(int nbytes) {
+  char *line = (char *)malloc(32 + 3 * nbytes);
+  assert(line);
+  int pos = sprintf(line, "out 1 1 %d", nbytes);
+  for (int i = 0; i < nbytes; i++) {
+    pos += sprintf(line + pos, " %02x", i);
+  }
+  sprintf(line + pos, "\n");
+  return line;
+}
+
+int main(int argc, char *argv[]) {
+  struct usbdpi_ctx ctx;
+  memset(&ctx, 0, sizeof(ctx));
+
+  check(parse(&ctx, "setup 0 0 00 05 03 00 00 00 00 00  # set address\n"
+                    "wait 10\n"),
+        "setup and wait parse");
+  check(ctx.ncmds == 2 && ctx.cmds[0].type == CMD_SETUP &&
+            ctx.cmds[0].npattern == 8 && ctx.cmds[0].pattern[2] == 0x03 &&
+            ctx.cmds[1].type == CMD_WAIT && ctx.cmds[1].len == 10,
+        "setup and wait contents");
+
+  check(!parse(&ctx, "setup 0 0 00 05\n"), "short setup is rejected");
+  check(!parse(&ctx, "bogus 1 2 3\n"), "unknown transfer is rejected");
+  check(!parse(&ctx, "out 1 1 4 100\n"), "out of range byte is rejected");
+
+  char *line = out_line(USBDPI_MAX_PACKET);
+  check(parse(&ctx, line), "max packet of data parses");
+  check(ctx.ncmds == 1 && ctx.cmds[0].npattern == USBDPI_MAX_PACKET &&
+            ctx.cmds[0].pattern[USBDPI_MAX_PACKET - 1] ==
+                USBDPI_MAX_PACKET - 1,
+        "max packet of data contents");
+  free(line);
+
+  // One byte too many must be rejected without writing past the pattern
+  // buffer (run under a sanitizer to check the latter).
+  line = out_line(USBDPI_MAX_PACKET + 1);
+  check(!parse(&ctx, line), "more than max packet of data is rejected");
+  free(line);
+
+  // usbdpi_create must clean up after itself if the script doesn't parse (run
+  // under a leak checker to check that).
+  char path[] = "/tmp/usbdpi_script_XXXXXX";
+  int fd = mkstemp(path);
+  assert(fd >= 0);
+  assert(write(fd, "bogus\n", 6) == 6);
+  close(fd);
+  check(usbdpi_create("usb_test", 0, path) == NULL,
+        "usbdpi_create fails on a bad script");
+  unlink(path);
+
+  free(ctx.cmds);
+  if (failures) {
+    printf("%d failures\n", failures);
+    return 1;
+  }
+  printf("PASS\n");
+  return 0;
+}
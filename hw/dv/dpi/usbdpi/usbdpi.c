@@ -14,6 +14,7 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <limits.h>
+#include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -30,7 +31,7 @@
 // #define NEED_SLEEP
 
 static const char *st_states[] = {"ST_IDLE 0", "ST_SEND 1", "ST_GET 2",
-                                  "ST_SYNC 3", "ST_EOP 4",  "ST_EOP0 5"};
+                                  "ST_SYNC 3"};
 
 static const char *hs_states[] = {
     "HS_STARTFRAME 0", "HS_WAITACK 1",   "HS_SET_DATASTAGE 2", "HS_DS_RXDATA 3",
@@ -38,7 +39,9 @@ static const char *hs_states[] = {
     "HS_SENDACK 8",    "HS_WAIT_PKT 9",  "HS_ACKIFDATA 10",    "HS_SENDHI 11",
     "HS_EMPTYDATA 12", "HS_WAITACK2 13", "HS_NEXTFRAME 14"};
 
-void *usbdpi_create(const char *name, int loglevel) {
+static bool usbdpi_load_script(struct usbdpi_ctx *ctx, const char *path);
+
+void *usbdpi_create(const char *name, int loglevel, const char *script_path) {
   struct usbdpi_ctx *ctx =
       (struct usbdpi_ctx *)calloc(1, sizeof(struct usbdpi_ctx));
   assert(ctx);
@@ -55,6 +58,23 @@ void *usbdpi_create(const char *name, int loglevel) {
   ctx->loglevel = loglevel;
   ctx->mon = monitor_usb_init();
   ctx->baudrate_set_successfully = 0;
+  ctx->mps = USBDPI_MAX_PACKET;
+  ctx->xs = XS_START;
+  ctx->stats.start_bits = -1;
+
+  if (strlen(script_path) != 0) {
+    if (!usbdpi_load_script(ctx, script_path)) {
+      free(ctx->cmds);
+      free(ctx->mon);
+      free(ctx);
+      return NULL;
+    }
+    printf("\nUSB: Running %d transfers from %s instead of the test sequence\n",
+           ctx->ncmds, script_path);
+    if (ctx->ncmds == 0) {
+      ctx->xs = XS_DONE;
+    }
+  }
 
   char cwd[PATH_MAX];
   char *cwd_rv;
@@ -82,6 +102,128 @@ void *usbdpi_create(const char *name, int loglevel) {
   return (void *)ctx;
 }
 
+/**
+ * Load the transfers for the script host from |path|
+ *
+ * Each line holds one transfer, with numbers in decimal or 0x-prefixed hex
+ * and data bytes in hex. '#' starts a comment.
+ *
+ *   setup ADDR EP B0 .. B7      SETUP with 8 bytes of data
+ *   out ADDR EP LEN [BYTE ..]   bulk OUT of LEN bytes, repeating the given
+ *                               bytes (an incrementing count by default)
+ *   in ADDR EP LEN              bulk IN until LEN bytes or a short packet
+ *   iso_out ADDR EP LEN [BYTE ..]
+ *   iso_in ADDR EP              one isochronous IN
+ *   wait FRAMES                 wait for a number of SOFs
+ *   mps BYTES                   max packet size for following transfers
+ *
+ * Returns false (after printing why) if the file can't be read or parsed.
+ */
+static bool usbdpi_load_script(struct usbdpi_ctx *ctx, const char *path) {
+  static const struct {
+    const char *name;
+    int type;
+    int nargs;  // before any data bytes
+  } kCmds[] = {
+      {"setup", CMD_SETUP, 2},  {"out", CMD_OUT, 3},
+      {"in", CMD_IN, 3},        {"iso_out", CMD_ISO_OUT, 3},
+      {"iso_in", CMD_ISO_IN, 2}, {"wait", CMD_WAIT, 1},
+      {"mps", CMD_MPS, 1},
+  };
+
+  FILE *f = fopen(path, "r");
+  if (!f) {
+    fprintf(stderr, "USB: Unable to open script %s: %s\n", path,
+            strerror(errno));
+    return false;
+  }
+
+  int cap = 0;
+  char line[1024];
+  int lineno = 0;
+  while (fgets(line, sizeof(line), f)) {
+    lineno++;
+    char *comment = strchr(line, '#');
+    if (comment) {
+      *comment = '\0';
+    }
+    char *save;
+    char *tok = strtok_r(line, " \t\r\n", &save);
+    if (!tok) {
+      continue;
+    }
+
+    struct usbdpi_cmd cmd;
+    memset(&cmd, 0, sizeof(cmd));
+    int nargs = -1;
+    for (size_t i = 0; i < sizeof(kCmds) / sizeof(kCmds[0]); i++) {
+      if (!strcmp(tok, kCmds[i].name)) {
+        cmd.type = kCmds[i].type;
+        nargs = kCmds[i].nargs;
+      }
+    }
+    if (nargs < 0) {
+      fprintf(stderr, "USB: %s:%d: unknown transfer `%s'\n", path, lineno,
+              tok);
+      fclose(f);
+      return false;
+    }
+
+    int args[3] = {0, 0, 0};
+    bool ok = true;
+    for (int i = 0; i < nargs && ok; i++) {
+      tok = strtok_r(NULL, " \t\r\n", &save);
+      char *endp;
+      args[i] = tok ? (int)strtol(tok, &endp, 0) : 0;
+      ok = tok && *endp == '\0' && args[i] >= 0;
+    }
+    while (ok && (tok = strtok_r(NULL, " \t\r\n", &save))) {
+      char *endp;
+      long byte = strtol(tok, &endp, 16);
+      ok = *endp == '\0' && byte >= 0 && byte <= 0xff &&
+           cmd.npattern < USBDPI_MAX_PACKET;
+      if (ok) {
+        cmd.pattern[cmd.npattern++] = byte;
+      }
+    }
+
+    if (cmd.type == CMD_WAIT || cmd.type == CMD_MPS) {
+      cmd.len = args[0];
+      ok = ok && (cmd.type == CMD_WAIT ||
+                  (cmd.len > 0 && cmd.len <= USBDPI_MAX_PACKET));
+    } else {
+      cmd.addr = args[0];
+      cmd.ep = args[1];
+      cmd.len = args[2];
+      ok = ok && cmd.addr < 128 && cmd.ep < 16;
+    }
+    if (cmd.type == CMD_SETUP) {
+      cmd.len = 8;
+      ok = ok && cmd.npattern == 8;
+    }
+    if (!ok) {
+      fprintf(stderr, "USB: %s:%d: bad arguments\n", path, lineno);
+      fclose(f);
+      return false;
+    }
+
+    if (ctx->ncmds == cap) {
+      cap = cap ? 2 * cap : 16;
+      ctx->cmds = (struct usbdpi_cmd *)realloc(ctx->cmds, cap * sizeof(cmd));
+      assert(ctx->cmds);
+    }
+    ctx->cmds[ctx->ncmds++] = cmd;
+  }
+  fclose(f);
+
+  if (!ctx->cmds) {
+    // Keep script mode even with nothing to do
+    ctx->cmds = (struct usbdpi_cmd *)calloc(1, sizeof(struct usbdpi_cmd));
+    assert(ctx->cmds);
+  }
+  return true;
+}
+
 const char *decode_usb[] = {"SE0", "0-K", "1-J", "SE1"};
 
 void usbdpi_device_to_host(void *ctx_void, const svBitVecVal *usb_d2p) {
@@ -183,8 +325,6 @@ void setDeviceAddress(struct usbdpi_ctx *ctx) {
       ctx->state = ST_SYNC;
       ctx->bytes = 14;
       ctx->datastart = 3;
-      ctx->byte = 0;
-      ctx->bit = 1;
       // Setup PID and data to set device 2
       ctx->data[0] = USB_PID_SETUP;
       ctx->data[1] = 0;
@@ -221,8 +361,6 @@ void setDeviceAddress(struct usbdpi_ctx *ctx) {
         ctx->state = ST_SYNC;
         ctx->bytes = 3;
         ctx->datastart = -1;
-        ctx->byte = 0;
-        ctx->bit = 1;
         ctx->data[0] = USB_PID_IN;
         ctx->data[1] = 0;
         ctx->data[2] = 0 | CRC5(0, 11) << 3;
@@ -238,8 +376,6 @@ void setDeviceAddress(struct usbdpi_ctx *ctx) {
         ctx->state = ST_SYNC;
         ctx->bytes = 1;
         ctx->datastart = -1;
-        ctx->byte = 0;
-        ctx->bit = 1;
         ctx->data[0] = USB_PID_ACK;
         ctx->hostSt = HS_NEXTFRAME;
         printf("[usbdpi] setDeviceAddress done\n");
@@ -257,8 +393,6 @@ void readDescriptor(struct usbdpi_ctx *ctx) {
       ctx->state = ST_SYNC;
       ctx->bytes = 14;
       ctx->datastart = 3;
-      ctx->byte = 0;
-      ctx->bit = 1;
       ctx->data[0] = USB_PID_SETUP;
       ctx->data[1] = 2;
       ctx->data[2] = 0 | CRC5(2, 11) << 3;
@@ -285,8 +419,6 @@ void readDescriptor(struct usbdpi_ctx *ctx) {
         ctx->state = ST_SYNC;
         ctx->bytes = 3;
         ctx->datastart = -1;
-        ctx->byte = 0;
-        ctx->bit = 1;
         ctx->data[0] = USB_PID_IN;
         ctx->data[1] = 2;
         ctx->data[2] = 0 | CRC5(2, 11) << 3;
@@ -302,8 +434,6 @@ void readDescriptor(struct usbdpi_ctx *ctx) {
         ctx->state = ST_SYNC;
         ctx->bytes = 1;
         ctx->datastart = -1;
-        ctx->byte = 0;
-        ctx->bit = 1;
         ctx->data[0] = USB_PID_ACK;
         ctx->hostSt = HS_NEXTFRAME;
         printf("[usbdpi] readDescriptor done\n");
@@ -321,8 +451,6 @@ void readBaud(struct usbdpi_ctx *ctx) {
       ctx->state = ST_SYNC;
       ctx->bytes = 14;
       ctx->datastart = 3;
-      ctx->byte = 0;
-      ctx->bit = 1;
       ctx->data[0] = USB_PID_SETUP;
       ctx->data[1] = 0x82;
       ctx->data[2] = 0 | CRC5(0x82, 11) << 3;
@@ -349,8 +477,6 @@ void readBaud(struct usbdpi_ctx *ctx) {
         ctx->state = ST_SYNC;
         ctx->bytes = 3;
         ctx->datastart = -1;
-        ctx->byte = 0;
-        ctx->bit = 1;
         ctx->data[0] = USB_PID_IN;
         ctx->data[1] = 0x82;
         ctx->data[2] = 0 | CRC5(0x82, 11) << 3;
@@ -366,8 +492,6 @@ void readBaud(struct usbdpi_ctx *ctx) {
         ctx->state = ST_SYNC;
         ctx->bytes = 1;
         ctx->datastart = -1;
-        ctx->byte = 0;
-        ctx->bit = 1;
         ctx->data[0] = USB_PID_ACK;
         ctx->hostSt = HS_EMPTYDATA;
       }
@@ -376,8 +500,6 @@ void readBaud(struct usbdpi_ctx *ctx) {
       ctx->state = ST_SYNC;
       ctx->bytes = 6;
       ctx->datastart = 3;
-      ctx->byte = 0;
-      ctx->bit = 1;
       ctx->data[0] = USB_PID_OUT;
       ctx->data[1] = 0x82;
       ctx->data[2] = 0 | CRC5(0x82, 11) << 3;
@@ -403,8 +525,6 @@ void setBaud(struct usbdpi_ctx *ctx) {
       ctx->state = ST_SYNC;
       ctx->bytes = 14;
       ctx->datastart = 3;
-      ctx->byte = 0;
-      ctx->bit = 1;
       ctx->data[0] = USB_PID_SETUP;
       ctx->data[1] = 0x82;
       ctx->data[2] = 0 | CRC5(0x82, 11) << 3;
@@ -431,8 +551,6 @@ void setBaud(struct usbdpi_ctx *ctx) {
         ctx->state = ST_SYNC;
         ctx->bytes = 3;
         ctx->datastart = -1;
-        ctx->byte = 0;
-        ctx->bit = 1;
         ctx->data[0] = USB_PID_IN;
         ctx->data[1] = 0x82;
         ctx->data[2] = 0 | CRC5(0x82, 11) << 3;
@@ -448,8 +566,6 @@ void setBaud(struct usbdpi_ctx *ctx) {
         ctx->state = ST_SYNC;
         ctx->bytes = 1;
         ctx->datastart = -1;
-        ctx->byte = 0;
-        ctx->bit = 1;
         ctx->data[0] = USB_PID_ACK;
         ctx->hostSt = HS_NEXTFRAME;
         ctx->baudrate_set_successfully = 1;
@@ -468,8 +584,6 @@ void testIso(struct usbdpi_ctx *ctx) {
       ctx->state = ST_SYNC;
       ctx->bytes = 14;
       ctx->datastart = 3;
-      ctx->byte = 0;
-      ctx->bit = 1;
       ctx->data[0] = USB_PID_OUT;
       ctx->data[1] = 0x82;
       ctx->data[2] = 1 | CRC5(0x182, 11) << 3;
@@ -498,8 +612,6 @@ void testIso(struct usbdpi_ctx *ctx) {
         ctx->state = ST_SYNC;
         ctx->bytes = 3;
         ctx->datastart = -1;
-        ctx->byte = 0;
-        ctx->bit = 1;
         ctx->data[0] = USB_PID_IN;
         ctx->data[1] = 0x82;
         ctx->data[2] = 1 | CRC5(0x0182, 11) << 3;
@@ -524,8 +636,6 @@ void pollRX(struct usbdpi_ctx *ctx, int sendHi, int nakData) {
       ctx->state = ST_SYNC;
       ctx->bytes = 3;
       ctx->datastart = -1;
-      ctx->byte = 0;
-      ctx->bit = 1;
       ctx->data[0] = USB_PID_IN;
       ctx->data[1] = 0x82;
       ctx->data[2] = 0x00 | CRC5(0x0082, 11) << 3;
@@ -546,8 +656,6 @@ void pollRX(struct usbdpi_ctx *ctx, int sendHi, int nakData) {
           ctx->state = ST_SYNC;
           ctx->bytes = 1;
           ctx->datastart = -1;
-          ctx->byte = 0;
-          ctx->bit = 1;
           ctx->data[0] = nakData ? USB_PID_NAK : USB_PID_ACK;
         }
         if (sendHi) {
@@ -562,8 +670,6 @@ void pollRX(struct usbdpi_ctx *ctx, int sendHi, int nakData) {
       ctx->state = ST_SYNC;
       ctx->bytes = 9;
       ctx->datastart = 3;
-      ctx->byte = 0;
-      ctx->bit = 1;
       ctx->data[0] = USB_PID_OUT;
       ctx->data[1] = 0x82;
       ctx->data[2] = 0 | CRC5(0x82, 11) << 3;
@@ -590,8 +696,6 @@ void testUnimplEp(struct usbdpi_ctx *ctx, uint8_t pid) {
         ctx->state = ST_SYNC;
         ctx->bytes = 14;
         ctx->datastart = 3;
-        ctx->byte = 0;
-        ctx->bit = 1;
         // The bytes are transmitted LSB to MSB
         ctx->data[0] = pid;
         ctx->data[1] =
@@ -617,8 +721,6 @@ void testUnimplEp(struct usbdpi_ctx *ctx, uint8_t pid) {
         ctx->state = ST_SYNC;
         ctx->bytes = 3;
         ctx->datastart = 0;
-        ctx->byte = 0;
-        ctx->bit = 1;
         // The bytes are transmitted LSB to MSB
         ctx->data[0] = pid;
         ctx->data[1] =
@@ -653,6 +755,109 @@ void testUnimplEp(struct usbdpi_ctx *ctx, uint8_t pid) {
   }
 }
 
+// Append the line symbols for one packet: SYNC, the NRZI encoded and bit
+// stuffed bytes (LSB first), then EOP (SE0 SE0 SE0 J) and release the bus.
+static void encode_packet(struct usbdpi_ctx *ctx, const uint8_t *data,
+                          int len) {
+  uint8_t *syms = ctx->syms;
+  int n = ctx->nsyms;
+  int bit;
+
+  // Sync is KJKJKJKK, which leaves the line at K
+  for (bit = 0; bit < 8; bit++) {
+    syms[n++] = (USB_SYNC & (1 << bit)) ? SYM_J : SYM_K;
+  }
+  int line = SYM_K;
+  int ones = 0;
+  for (int i = 0; i < len; i++) {
+    for (bit = 0; bit < 8; bit++) {
+      if (data[i] & (1 << bit)) {
+        ones++;
+      } else {
+        // NRZI: a zero is a transition
+        line ^= SYM_J ^ SYM_K;
+        ones = 0;
+      }
+      syms[n++] = line;
+      if (ones == 6 && !INSERT_ERR_BITSTUFF) {
+        // bit stuff and force a transition
+        line ^= SYM_J ^ SYM_K;
+        syms[n++] = line;
+        ones = 0;
+      }
+    }
+  }
+  syms[n++] = SYM_SE0;
+  syms[n++] = SYM_SE0;
+  syms[n++] = SYM_SE0;
+  syms[n++] = SYM_J;
+  syms[n++] = SYM_IDLE;
+  assert(n <= MAX_SYMS);
+  ctx->nsyms = n;
+}
+
+// Encode the packets in ctx->data, so that sending them only takes one symbol
+// per bit time. If datastart is set the bytes from there on form a second
+// packet, which follows the first one immediately.
+static void encode_packets(struct usbdpi_ctx *ctx) {
+  int split = (ctx->datastart > 0 && ctx->datastart < ctx->bytes)
+                  ? ctx->datastart
+                  : ctx->bytes;
+  assert(ctx->bytes <= SEND_MAX);
+  ctx->nsyms = 0;
+  ctx->sym = 0;
+  encode_packet(ctx, ctx->data, split);
+  if (split < ctx->bytes) {
+    encode_packet(ctx, ctx->data + split, ctx->bytes - split);
+  }
+}
+
+// Queue a packet pair for sending: a token for |cmd|, followed by a data
+// packet for SETUP and OUT transfers.
+static void send_transaction(struct usbdpi_ctx *ctx,
+                             const struct usbdpi_cmd *cmd) {
+  int is_in = (cmd->type == CMD_IN) || (cmd->type == CMD_ISO_IN);
+  int token = (cmd->type == CMD_SETUP) ? USB_PID_SETUP
+                                       : (is_in ? USB_PID_IN : USB_PID_OUT);
+  int addr_ep = (cmd->ep << 7) | cmd->addr;
+
+  ctx->state = ST_SYNC;
+  ctx->data[0] = token;
+  ctx->data[1] = addr_ep & 0xff;
+  ctx->data[2] = (addr_ep >> 8) | CRC5(addr_ep, 11) << 3;
+  if (is_in) {
+    ctx->bytes = 3;
+    ctx->datastart = -1;
+    return;
+  }
+
+  int len = 8;
+  if (cmd->type != CMD_SETUP) {
+    len = cmd->len - ctx->done;
+    len = len < ctx->mps ? len : ctx->mps;
+  }
+  ctx->data[3] = ((cmd->type == CMD_OUT) && ctx->toggle[cmd->ep])
+                     ? USB_PID_DATA1
+                     : USB_PID_DATA0;
+  for (int i = 0; i < len; i++) {
+    int off = ctx->done + i;
+    ctx->data[4 + i] = (cmd->type == CMD_SETUP) ? cmd->pattern[i]
+                       : cmd->npattern ? cmd->pattern[off % cmd->npattern]
+                                       : off & 0xff;
+  }
+  add_crc16(ctx->data, 3, 4 + len);
+  ctx->bytes = 4 + len + 2;
+  ctx->datastart = 3;
+  ctx->pktlen = len;
+}
+
+static void send_handshake(struct usbdpi_ctx *ctx, int pid) {
+  ctx->state = ST_SYNC;
+  ctx->bytes = 1;
+  ctx->datastart = -1;
+  ctx->data[0] = pid;
+}
+
 int set_driving(struct usbdpi_ctx *ctx, int d2p, int newval) {
   if (d2p & D2P_DNPU) {
     if (d2p & D2P_TXMODE_SE) {
@@ -679,9 +884,201 @@ int set_driving(struct usbdpi_ctx *ctx, int d2p, int newval) {
   return (ctx->driving & P2D_SENSE) | P2D_D;
 }
 
-int inv_driving(struct usbdpi_ctx *ctx, int d2p) {
-  // works for either orientation
-  return ctx->driving ^ ((d2p & D2P_TXMODE_SE) ? (P2D_DP | P2D_DN) : P2D_D);
+static void print_stats(struct usbdpi_ctx *ctx, FILE *f) {
+  const struct usbdpi_stats *st = &ctx->stats;
+  int end = (ctx->xs == XS_DONE) ? st->end_bits : ctx->tick_bits;
+  int bits = (st->start_bits < 0) ? 0 : end - st->start_bits;
+  // Scale from bit times to the 12 Mbit/s of a full speed bus
+  double secs = bits / 12e6;
+  fprintf(f,
+          "USB: %d of %d transfers in %d bit times: %llu bytes OUT in %u "
+          "packets, %llu bytes IN in %u packets, %u NAKs, %u STALLs, %u "
+          "timeouts\n",
+          ctx->cmd, ctx->ncmds, bits, (unsigned long long)st->bytes_out,
+          st->packets_out, (unsigned long long)st->bytes_in, st->packets_in,
+          st->naks, st->stalls, st->timeouts);
+  if (secs > 0) {
+    fprintf(f, "USB: throughput OUT %.0f bytes/s, IN %.0f bytes/s\n",
+            st->bytes_out / secs, st->bytes_in / secs);
+  }
+}
+
+static void next_cmd(struct usbdpi_ctx *ctx) {
+  ctx->cmd++;
+  ctx->done = 0;
+  ctx->ntimeouts = 0;
+  ctx->xs = XS_START;
+  if (ctx->cmd == ctx->ncmds) {
+    ctx->xs = XS_DONE;
+    ctx->stats.end_bits = ctx->tick_bits;
+    print_stats(ctx, stdout);
+  }
+}
+
+// Bit times a transaction may take: token, data packet, turnaround and
+// handshake. Only transactions that fit before the next SOF are started.
+static int frame_guard(const struct usbdpi_ctx *ctx) {
+  return 2 * (ctx->mps + 6) * 10 + 2 * RESP_TIMEOUT;
+}
+
+// Act on the device's answer to the current transaction
+static void handle_response(struct usbdpi_ctx *ctx, struct usbdpi_cmd *cmd,
+                            int pid, const uint8_t *bytes, int len) {
+  ctx->ntimeouts = 0;
+  if (pid == USB_PID_NAK) {
+    ctx->stats.naks++;
+    ctx->xs = XS_START;
+    return;
+  }
+  if (pid == USB_PID_STALL) {
+    ctx->stats.stalls++;
+    printf("USB: %4x %8d transfer %d to %d.%d stalled\n", ctx->frame,
+           ctx->tick, ctx->cmd, cmd->addr, cmd->ep);
+    next_cmd(ctx);
+    return;
+  }
+
+  switch (cmd->type) {
+    case CMD_SETUP:
+    case CMD_OUT:
+      if (pid != USB_PID_ACK) {
+        break;
+      }
+      ctx->stats.packets_out++;
+      ctx->stats.bytes_out += ctx->pktlen;
+      ctx->done += ctx->pktlen;
+      // The data stage after a SETUP starts with DATA1
+      ctx->toggle[cmd->ep] =
+          (cmd->type == CMD_SETUP) ? 1 : ctx->toggle[cmd->ep] ^ 1;
+      if ((cmd->type == CMD_SETUP) || (ctx->done >= cmd->len)) {
+        next_cmd(ctx);
+      } else {
+        ctx->xs = XS_START;
+      }
+      return;
+    case CMD_IN:
+    case CMD_ISO_IN:
+      if ((pid != USB_PID_DATA0) && (pid != USB_PID_DATA1)) {
+        break;
+      }
+      if ((len < 2) ||
+          (CRC16((uint8_t *)bytes, len - 2) !=
+           (uint32_t)(bytes[len - 2] | bytes[len - 1] << 8))) {
+        // No handshake, so the device sends the data again
+        printf("USB: %4x %8d CRC16 error in data from %d.%d\n", ctx->frame,
+               ctx->tick, cmd->addr, cmd->ep);
+        ctx->xs = XS_START;
+        return;
+      }
+      ctx->pktlen = len - 2;
+      ctx->stats.packets_in++;
+      ctx->stats.bytes_in += ctx->pktlen;
+      ctx->done += ctx->pktlen;
+      if (cmd->type == CMD_ISO_IN) {
+        next_cmd(ctx);
+      } else {
+        send_handshake(ctx, USB_PID_ACK);
+        ctx->xs = XS_ACKING;
+      }
+      return;
+    default:
+      break;
+  }
+  printf("USB: %4x %8d unexpected PID 0x%02x for transfer %d, retrying\n",
+         ctx->frame, ctx->tick, pid, ctx->cmd);
+  ctx->xs = XS_START;
+}
+
+// Script host, run while the bus is idle
+static void script_host(struct usbdpi_ctx *ctx) {
+  if (ctx->xs == XS_DONE) {
+    return;
+  }
+  struct usbdpi_cmd *cmd = &ctx->cmds[ctx->cmd];
+  int pid, len;
+  const uint8_t *bytes;
+
+  switch (ctx->xs) {
+    case XS_START:
+      if (cmd->type == CMD_MPS) {
+        ctx->mps = cmd->len;
+        next_cmd(ctx);
+        break;
+      }
+      if (cmd->type == CMD_WAIT) {
+        ctx->done = ctx->frame;
+        ctx->xs = XS_WAIT;
+        break;
+      }
+      if ((ctx->frame == 0) || (ctx->tick_bits < ctx->wait) ||
+          (ctx->tick_bits - ctx->lastframe + frame_guard(ctx) >=
+           FRAME_INTERVAL)) {
+        break;
+      }
+      if (ctx->stats.start_bits < 0) {
+        ctx->stats.start_bits = ctx->tick_bits;
+      }
+      ctx->dev_pkts = monitor_usb_device_packet(ctx->mon, &pid, &bytes, &len);
+      send_transaction(ctx, cmd);
+      ctx->xs = XS_SENDING;
+      break;
+    case XS_SENDING:
+      // The bus is idle again, so the packets are out
+      if (cmd->type == CMD_ISO_OUT) {
+        ctx->stats.packets_out++;
+        ctx->stats.bytes_out += ctx->pktlen;
+        ctx->done += ctx->pktlen;
+        if (ctx->done >= cmd->len) {
+          next_cmd(ctx);
+        } else {
+          ctx->xs = XS_START;
+        }
+        break;
+      }
+      ctx->wait = ctx->tick_bits + RESP_TIMEOUT;
+      ctx->xs = XS_RESPONSE;
+      break;
+    case XS_RESPONSE:
+      if (monitor_usb_device_packet(ctx->mon, &pid, &bytes, &len) !=
+          ctx->dev_pkts) {
+        ctx->wait = ctx->tick_bits + 2;
+        ctx->xs = XS_GOT;
+      } else if (ctx->tick_bits >= ctx->wait) {
+        ctx->stats.timeouts++;
+        if (cmd->type == CMD_ISO_IN) {
+          // Nothing to send in this frame
+          next_cmd(ctx);
+        } else if (++ctx->ntimeouts == MAX_TIMEOUTS) {
+          printf("USB: %4x %8d transfer %d to %d.%d timed out\n", ctx->frame,
+                 ctx->tick, ctx->cmd, cmd->addr, cmd->ep);
+          next_cmd(ctx);
+        } else {
+          ctx->xs = XS_START;
+        }
+      }
+      break;
+    case XS_GOT:
+      if (ctx->tick_bits >= ctx->wait) {
+        monitor_usb_device_packet(ctx->mon, &pid, &bytes, &len);
+        handle_response(ctx, cmd, pid, bytes, len);
+      }
+      break;
+    case XS_ACKING:
+      // A short packet ends an IN transfer
+      if ((ctx->pktlen < ctx->mps) || (ctx->done >= cmd->len)) {
+        next_cmd(ctx);
+      } else {
+        ctx->xs = XS_START;
+      }
+      break;
+    case XS_WAIT:
+      if (ctx->frame - ctx->done >= cmd->len) {
+        next_cmd(ctx);
+      }
+      break;
+    default:
+      break;
+  }
 }
 
 char usbdpi_host_to_device(void *ctx_void, const svBitVecVal *usb_d2p) {
@@ -690,7 +1087,6 @@ char usbdpi_host_to_device(void *ctx_void, const svBitVecVal *usb_d2p) {
   int d2p = usb_d2p[0];
   uint32_t last_driving = ctx->driving;
   int force_stat = 0;
-  int dat;
 
   if (ctx->tick == 0) {
     int i;
@@ -741,7 +1137,7 @@ char usbdpi_host_to_device(void *ctx_void, const svBitVecVal *usb_d2p) {
       ctx->frame++;
       ctx->lastframe = ctx->tick_bits;
 
-      if (ctx->frame >= 20 && ctx->frame < 30) {
+      if (!ctx->cmds && ctx->frame >= 20 && ctx->frame < 30) {
         // Test suspend
         ctx->state = ST_IDLE;
         printf("Idle frame %d\n", ctx->frame);
@@ -749,8 +1145,6 @@ char usbdpi_host_to_device(void *ctx_void, const svBitVecVal *usb_d2p) {
         ctx->state = ST_SYNC;
         ctx->bytes = 3;
         ctx->datastart = -1;
-        ctx->byte = 0;
-        ctx->bit = 1;
         ctx->data[0] = USB_PID_SOF;
         ctx->data[1] = ctx->frame & 0xff;
         ctx->data[2] =
@@ -765,6 +1159,10 @@ char usbdpi_host_to_device(void *ctx_void, const svBitVecVal *usb_d2p) {
   }
   switch (ctx->state) {
     case ST_IDLE:
+      if (ctx->cmds) {
+        script_host(ctx);
+        break;
+      }
       switch (ctx->frame) {
         case 1:
           setDeviceAddress(ctx);
@@ -807,69 +1205,25 @@ char usbdpi_host_to_device(void *ctx_void, const svBitVecVal *usb_d2p) {
       break;
 
     case ST_SYNC:
-      dat = ((USB_SYNC & ctx->bit)) ? P2D_DP : P2D_DN;
-      ctx->driving = set_driving(ctx, d2p, dat);
-      force_stat = 1;
-      ctx->bit <<= 1;
-      if (ctx->bit == 0x100) {
-        ctx->bit = 1;
-        ctx->linebits = 0;
-        ctx->state = ST_SEND;
-      }
-      break;
-
-    case ST_SEND:
-      if ((ctx->linebits & 0x3f) == 0x3f &&
-          !INSERT_ERR_BITSTUFF) {  // sent 6 ones
-        // bit stuff and force a transition
-        ctx->driving = inv_driving(ctx, d2p);
-        force_stat = 1;
-        ctx->linebits = (ctx->linebits << 1);
-      } else if (ctx->byte >= ctx->bytes) {
-        ctx->state = ST_EOP;
-        ctx->driving = set_driving(ctx, d2p, 0);  // SE0
-        ctx->bit = 1;
-        force_stat = 1;
-      } else {
-        int nextbit;
-        nextbit = (ctx->data[ctx->byte] & ctx->bit) ? 1 : 0;
-        if (nextbit == 0) {
-          ctx->driving = inv_driving(ctx, d2p);
-        }
-        ctx->linebits = (ctx->linebits << 1) | nextbit;
-        force_stat = 1;
-        ctx->bit <<= 1;
-        if (ctx->bit == 0x100) {
-          ctx->bit = 1;
-          ctx->byte++;
-          if (ctx->byte == ctx->datastart) {
-            ctx->state = ST_EOP0;
-          }
-        }
-      }
-      break;
-
-    case ST_EOP0:
-      ctx->driving = set_driving(ctx, d2p, 0);  // SE0
-      ctx->state = ST_EOP;
-      break;
-
-    case ST_EOP:  // SE0 SE0 J
-      if (ctx->bit == 4) {
-        ctx->driving = set_driving(ctx, d2p, P2D_DP);  // J
-      }
-      if (ctx->bit == 8) {
+      encode_packets(ctx);
+      ctx->state = ST_SEND;
+      // fallthrough
+    case ST_SEND: {
+      int sym = ctx->syms[ctx->sym++];
+      if (sym == SYM_IDLE) {
         // Stop driving: host pulldown to SE0 unless there is a pullup on DP
         ctx->driving = set_driving(ctx, d2p, (d2p & D2P_PU) ? P2D_DP : 0);
-        if (ctx->byte == ctx->datastart) {
-          ctx->bit = 1;
-          ctx->state = ST_SYNC;
-        } else {
-          ctx->state = ST_IDLE;
-        }
+      } else {
+        ctx->driving = set_driving(
+            ctx, d2p,
+            (sym == SYM_J) ? P2D_DP : ((sym == SYM_K) ? P2D_DN : 0));
+      }
+      force_stat = 1;
+      if (ctx->sym == ctx->nsyms) {
+        ctx->state = ST_IDLE;
       }
-      ctx->bit <<= 1;
       break;
+    }
   }
   if ((ctx->loglevel & LOG_BIT) &&
       (force_stat || (ctx->driving != last_driving))) {
@@ -892,6 +1246,11 @@ void usbdpi_close(void *ctx_void) {
   if (!ctx) {
     return;
   }
+  if (ctx->cmds && ctx->xs != XS_DONE) {
+    print_stats(ctx, stdout);
+  }
+  free(ctx->cmds);
   fclose(ctx->mon_file);
+  free(ctx->mon);
   free(ctx);
 }
@@ -57,8 +57,6 @@
 #define ST_SEND 1
 #define ST_GET 2
 #define ST_SYNC 3
-#define ST_EOP 4
-#define ST_EOP0 5
 
 /* Remember these go LSB first */
 
@@ -92,13 +90,66 @@
 #define HS_WAITACK2 13
 #define HS_NEXTFRAME 14
 
-#define SEND_MAX 32
+// Largest data payload the script host sends or accepts in one packet
+#define USBDPI_MAX_PACKET 64
+
+// Largest packet pair (token and data packet) the host sends: a token, then
+// the DATA PID, up to USBDPI_MAX_PACKET bytes and the CRC16.
+#define SEND_MAX (3 + 1 + USBDPI_MAX_PACKET + 2)
+
+// Line symbols of an encoded packet, one per bit time
+#define SYM_J 0
+#define SYM_K 1
+#define SYM_SE0 2
+#define SYM_IDLE 3  // stop driving
+
+// Enough symbols for SEND_MAX bytes with worst case bit stuffing, plus two
+// SYNC and EOP sequences
+#define MAX_SYMS (SEND_MAX * 8 * 7 / 6 + 2 * (8 + 5) + 8)
+
+// Script host transfer types (see usbdpi_load_script())
+#define CMD_SETUP 0
+#define CMD_OUT 1
+#define CMD_IN 2
+#define CMD_ISO_OUT 3
+#define CMD_ISO_IN 4
+#define CMD_WAIT 5
+#define CMD_MPS 6
+
+// Bit times to wait for the device to answer a token or data packet
+#define RESP_TIMEOUT 64
+
+// Times to retry a transaction that timed out before giving up on a transfer
+#define MAX_TIMEOUTS 4
+
 #include <stdint.h>
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+struct usbdpi_cmd {
+  int type;
+  int addr;
+  int ep;
+  int len;  // bytes to transfer, frames to wait or max packet size
+  int npattern;
+  uint8_t pattern[USBDPI_MAX_PACKET];
+};
+
+// Throughput counters of the script host
+struct usbdpi_stats {
+  uint64_t bytes_out;  // payload bytes the device accepted
+  uint64_t bytes_in;   // payload bytes received from the device
+  uint32_t packets_out;
+  uint32_t packets_in;
+  uint32_t naks;
+  uint32_t stalls;
+  uint32_t timeouts;
+  int start_bits;  // bit time of the first transaction
+  int end_bits;    // bit time at which the last transfer finished
+};
+
 struct usbdpi_ctx {
   int loglevel;
   FILE *mon_file;
@@ -116,17 +167,41 @@ struct usbdpi_ctx {
   int state;
   int wait;
   uint32_t driving;
-  int linebits;
-  int bit;
-  int byte;
   int bytes;
   int datastart;
   int hostSt;
   uint8_t data[SEND_MAX];
   int baudrate_set_successfully;
+
+  // Packets in |data| encoded as line symbols, and the next one to send
+  uint8_t syms[MAX_SYMS];
+  int nsyms;
+  int sym;
+
+  // Script host: transfers to run instead of the built-in test sequence
+  struct usbdpi_cmd *cmds;
+  int ncmds;
+  int cmd;       // transfer in progress
+  int xs;        // transfer state, see XS_*
+  int done;      // bytes done (or frames waited) in the current transfer
+  int pktlen;    // payload bytes of the data packet in flight
+  int mps;       // max packet size
+  int dev_pkts;  // device packets seen by the monitor when the token went out
+  int ntimeouts;
+  uint8_t toggle[16];  // DATA0/1 toggle for OUT and SETUP per endpoint
+  struct usbdpi_stats stats;
 };
 
-void *usbdpi_create(const char *name, int loglevel);
+// Script host transfer states
+#define XS_START 0     // start the next transaction when the bus allows
+#define XS_SENDING 1   // token (and data) going out
+#define XS_RESPONSE 2  // waiting for the device
+#define XS_GOT 3       // device answered, waiting out the inter-packet gap
+#define XS_ACKING 4    // ACK to an IN going out
+#define XS_WAIT 5      // waiting for frames
+#define XS_DONE 6      // no transfers left
+
+void *usbdpi_create(const char *name, int loglevel, const char *script_path);
 void usbdpi_device_to_host(void *ctx_void, const svBitVecVal *usb_d2p);
 char usbdpi_host_to_device(void *ctx_void, const svBitVecVal *usb_d2p);
 void usbdpi_close(void *ctx_void);
@@ -136,6 +211,8 @@ uint32_t CRC16(uint8_t *data, int bytes);
 void *monitor_usb_init(void);
 void monitor_usb(void *mon, FILE *mon_file, int log, int tick, int hdrive,
                  int p2d, int d2p, int *lastpid);
+int monitor_usb_device_packet(void *mon, int *pid, const uint8_t **bytes,
+                              int *len);
 
 #ifdef __cplusplus
 }
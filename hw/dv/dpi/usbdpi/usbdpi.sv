@@ -8,6 +8,11 @@
 // 0x01 -- monitor_usb (packet level)
 // 0x02 -- more verbose monitor
 // 0x08 -- bit level
+//
+// By default the host runs a fixed test sequence for usbdev_test. Pass the
+// `USBDPI_SCRIPT_<NAME>` plusarg to run the transfers in a script file
+// instead (see usbdpi_load_script() in usbdpi.c), e.g.
+// +USBDPI_SCRIPT_usb0=hw/dv/dpi/usbdpi/script-simpleserial-bulk.txt
 
 module usbdpi #(
   parameter string NAME = "usb0",
@@ -37,7 +42,8 @@ module usbdpi #(
   input  logic pullupdn_en_d2p
 );
   import "DPI-C" function
-    chandle usbdpi_create(input string name, input int loglevel);
+    chandle usbdpi_create(input string name, input int loglevel,
+                          input string script_path);
 
   import "DPI-C" function
     void usbdpi_device_to_host(input chandle ctx, input bit [10:0] d2p);
@@ -50,8 +56,14 @@ module usbdpi #(
 
   chandle ctx;
 
+  string script_path = "";
+
   initial begin
-    ctx = usbdpi_create(NAME, LOG_LEVEL);
+    $value$plusargs({"USBDPI_SCRIPT_", NAME, "=%s"}, script_path);
+    ctx = usbdpi_create(NAME, LOG_LEVEL, script_path);
+    if (ctx == null) begin
+      $fatal(1, "USB: Failed to create USB DPI instance %s (see above for details).", NAME);
+    end
   end
 
   final begin
@@ -147,8 +147,6 @@ package sram_scrambler_pkg;
   // Should not be called directly.
   function automatic state_t gen_keystream(logic addr[], int addr_width,
                                            logic key[], logic nonce[]);
-    logic [NUM_ROUNDS-1:0][SRAM_BLOCK_WIDTH-1:0] prince_result_arr;
-
     logic [SRAM_BLOCK_WIDTH-1:0]  prince_plaintext;
     logic [SRAM_KEY_WIDTH-1:0]    prince_key;
     logic [SRAM_BLOCK_WIDTH-1:0]  prince_result;
@@ -178,17 +176,52 @@ package sram_scrambler_pkg;
       prince_key[i] = key[i];
     end
 
-    crypto_dpi_prince_pkg::sv_dpi_prince_encrypt(.plaintext(prince_plaintext),
-                                                 .key(prince_key),
-                                                 .old_key_schedule(0),
-                                                 .ciphertext(prince_result_arr));
-    prince_result = prince_result_arr[NUM_ROUNDS-1];
+    // Only the result after NUM_ROUNDS half-rounds is needed, so call the DPI model directly
+    // rather than computing the results for all numbers of half-rounds.
+    prince_result = crypto_dpi_prince_pkg::c_dpi_prince_encrypt(prince_plaintext,
+                                                                prince_key[127:64],
+                                                                prince_key[63:0],
+                                                                NUM_ROUNDS,
+                                                                0);
 
     key_out = {<< {prince_result}};
 
     return key_out;
   endfunction : gen_keystream
 
+  // Generates the keystreams of addresses 0 to `num_words - 1` in a single batched call to the
+  // PRINCE DPI model, e.g. to precompute the keystreams of an entire memory.
+  //
+  // Bit i of `keystreams[addr]` corresponds to index i of the array returned by
+  // `gen_keystream()` for the same address.
+  function automatic void gen_keystreams(int num_words, int addr_width, logic key[],
+                                         logic nonce[],
+                                         output bit [SRAM_BLOCK_WIDTH-1:0] keystreams[]);
+    bit [SRAM_BLOCK_WIDTH-1:0]  prince_plaintext[] = new[num_words];
+    bit [SRAM_KEY_WIDTH-1:0]    prince_key;
+    bit [SRAM_BLOCK_WIDTH-1:0]  iv_nonce;
+
+    // The upper IV bits are the same for all addresses.
+    for (int i = 0; i < SRAM_BLOCK_WIDTH - addr_width; i++) begin
+      iv_nonce[addr_width + i] = nonce[i];
+    end
+    foreach (prince_plaintext[addr]) begin
+      prince_plaintext[addr] = iv_nonce;
+      for (int i = 0; i < addr_width; i++) begin
+        prince_plaintext[addr][i] = addr[i];
+      end
+    end
+    for (int i = 0; i < SRAM_KEY_WIDTH; i++) begin
+      prince_key[i] = key[i];
+    end
+
+    crypto_dpi_prince_pkg::sv_dpi_prince_encrypt_batch(.plaintext(prince_plaintext),
+                                                       .key(prince_key),
+                                                       .num_half_rounds(NUM_ROUNDS),
+                                                       .old_key_schedule(0),
+                                                       .ciphertext(keystreams));
+  endfunction : gen_keystreams
+
   // Encrypts the target SRAM address using the custom S&P network.
   function automatic state_t encrypt_sram_addr(logic addr[], int addr_width,
                                                logic full_nonce[]);
@@ -4,16 +4,23 @@
 
 #include "dpi_memutil.h"
 
+#include <algorithm>
 #include <cassert>
+#include <chrono>
 #include <cstring>
 #include <fcntl.h>
+#include <gelf.h>
 #include <iostream>
 #include <libelf.h>
+#include <mutex>
 #include <sstream>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <unistd.h>
 #include <vector>
 
+#include "dv_log_sink.h"
+#include "mem_image.h"
 #include "sv_scoped.h"
 
 namespace {
@@ -32,37 +39,70 @@ class ElfError : public std::exception {
   std::string msg_;
 };
 
+// A private, memory-mapped copy of a file. This is shared by the ElfFile that
+// parses it and by any MemSpan objects that point at segment data inside it.
+class MappedFile {
+ public:
+  MappedFile(const std::string &path) : data_(nullptr), size_(0) {
+    int fd = open(path.c_str(), O_RDONLY, 0);
+    if (fd < 0) {
+      throw ElfError(path, "could not open file.");
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+      close(fd);
+      throw ElfError(path, "could not stat file.");
+    }
+    if (st.st_size == 0) {
+      close(fd);
+      throw ElfError(path, "not an ELF file.");
+    }
+    size_ = st.st_size;
+
+    // libelf wants a writable image for elf_memory(). A private mapping gives
+    // it one without touching the file, and pages it doesn't write to stay
+    // shared with the page cache.
+    void *addr =
+        mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) {
+      throw ElfError(path, "could not map file.");
+    }
+    data_ = static_cast<char *>(addr);
+  }
+
+  ~MappedFile() { munmap(data_, size_); }
+
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  char *data_;
+  size_t size_;
+};
+
 // Class wrapping an open ELF file
 class ElfFile {
  public:
-  ElfFile(const std::string &path) : path_(path) {
+  ElfFile(const std::string &path)
+      : path_(path), map_(std::make_shared<MappedFile>(path)) {
     (void)elf_errno();
     if (elf_version(EV_CURRENT) == EV_NONE) {
       throw std::runtime_error(elf_errmsg(-1));
     }
 
-    fd_ = open(path.c_str(), O_RDONLY, 0);
-    if (fd_ < 0) {
-      throw ElfError(path, "could not open file.");
-    }
-
-    ptr_ = elf_begin(fd_, ELF_C_READ, NULL);
+    ptr_ = elf_memory(map_->data_, map_->size_);
     if (!ptr_) {
-      close(fd_);
       throw ElfError(path, elf_errmsg(-1));
     }
 
     if (elf_kind(ptr_) != ELF_K_ELF) {
       elf_end(ptr_);
-      close(fd_);
       throw ElfError(path, "not an ELF file.");
     }
   }
 
-  ~ElfFile() {
-    elf_end(ptr_);
-    close(fd_);
-  }
+  ~ElfFile() { elf_end(ptr_); }
 
   size_t GetPhdrNum() {
     size_t phnum;
@@ -79,10 +119,63 @@ class ElfFile {
     return phdrs;
   }
 
+  size_t GetSize() const { return map_->size_; }
+
+  // Return a span of len bytes, starting at offset in the file. The span
+  // points into the mapped file, which it keeps alive.
+  MemSpan GetSpan(size_t offset, size_t len) const {
+    assert(offset + len <= map_->size_);
+    const uint8_t *data = reinterpret_cast<const uint8_t *>(map_->data_);
+    return MemSpan(map_, data + offset, len);
+  }
+
   std::string path_;
-  int fd_;
+  std::shared_ptr<MappedFile> map_;
   Elf *ptr_;
 };
+
+// Statistics about writing staged data to a memory. These get printed when
+// loading with --verbose-mem-load.
+struct MemLoadStats {
+  size_t num_segs;
+  size_t data_bytes;
+  size_t gap_bytes;
+  size_t words;
+  double seconds;
+
+  void Print(const std::string &path, const std::string &mem_name) const {
+    std::cout << "Loaded " << num_segs << " segment(s) from `" << path
+              << "' into memory `" << mem_name << "': " << data_bytes
+              << " bytes in " << words << " words, skipped " << gap_bytes
+              << " gap bytes, took " << seconds * 1e3 << " ms";
+    if (seconds > 0) {
+      std::cout << " (" << data_bytes / seconds / (1 << 20) << " MiB/s)";
+    }
+    std::cout << "." << std::endl;
+  }
+};
+
+// Write staged_mem to mem_area, returning statistics about the write.
+static MemLoadStats WriteStagedMem(const MemArea &mem_area,
+                                   const StagedMem &staged_mem) {
+  auto start = std::chrono::steady_clock::now();
+
+  MemLoadStats stats;
+  stats.num_segs = staged_mem.GetSegs().size();
+  stats.data_bytes = staged_mem.GetDataSize();
+  stats.gap_bytes = 0;
+  if (stats.num_segs) {
+    auto bounds = staged_mem.GetBounds();
+    stats.gap_bytes =
+        (size_t)1 + (bounds.second - bounds.first) - stats.data_bytes;
+  }
+  stats.words = staged_mem.WriteTo(mem_area);
+
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  stats.seconds = elapsed.count();
+  return stats;
+}
 }  // namespace
 
 // Convert a string to a MemImageType, throwing a std::runtime_error
@@ -92,6 +185,10 @@ static MemImageType GetMemImageTypeByName(const std::string &name) {
     return kMemImageElf;
   if (name == "vmem")
     return kMemImageVmem;
+  if (name == "bin")
+    return kMemImageBin;
+  if (name == "ihex" || name == "hex")
+    return kMemImageIhex;
 
   std::ostringstream oss;
   oss << "Unknown image type: `" << name << "'.";
@@ -119,24 +216,64 @@ static MemImageType DetectMemImageType(const std::string &filepath) {
   return image_type;
 }
 
-// Generate a single array of bytes representing the contents of PT_LOAD
-// segments of the ELF file. Like objcopy, this generates a single "giant
-// segment" whose first byte corresponds to the first byte of the lowest
-// addressed segment and whose last byte corresponds to the last byte of the
-// highest address.
-static std::vector<uint8_t> FlattenElfFile(const std::string &filepath) {
-  ElfFile elf(filepath);
+// Add the function symbols of elf to syms. A symbol with a size replaces one
+// without at the same address, so that aliases (like an assembly label and the
+// function that follows it) don't hide the more precise symbol.
+static void AddFuncSymbols(Elf *elf, std::map<uint32_t, ElfFuncSymbol> *syms) {
+  Elf_Scn *scn = nullptr;
+  while ((scn = elf_nextscn(elf, scn))) {
+    Elf32_Shdr *shdr = elf32_getshdr(scn);
+    if (!shdr || shdr->sh_type != SHT_SYMTAB || !shdr->sh_entsize)
+      continue;
+
+    Elf_Data *sec_data = elf_getdata(scn, nullptr);
+    if (!sec_data)
+      continue;
+
+    std::map<uint32_t, ElfFuncSymbol> file_syms;
+    int num_syms = shdr->sh_size / shdr->sh_entsize;
+    for (int i = 0; i < num_syms; ++i) {
+      GElf_Sym sym;
+      if (!gelf_getsym(sec_data, i, &sym) ||
+          GELF_ST_TYPE(sym.st_info) != STT_FUNC)
+        continue;
+
+      const char *name = elf_strptr(elf, shdr->sh_link, sym.st_name);
+      if (!name || !*name)
+        continue;
+
+      ElfFuncSymbol func{.addr = (uint32_t)sym.st_value,
+                         .size = (uint32_t)sym.st_size,
+                         .name = name};
+      auto pr = file_syms.emplace(func.addr, func);
+      if (!pr.second && !pr.first->second.size && func.size) {
+        pr.first->second = func;
+      }
+    }
+
+    for (auto &pr : file_syms) {
+      (*syms)[pr.first] = std::move(pr.second);
+    }
+    break;
+  }
+}
 
+// Stage the contents of PT_LOAD segments of the ELF file. Like objcopy, the
+// segments are placed relative to the lowest addressed segment, so the first
+// byte of that segment has offset zero. The staged segments point into the
+// mapped file.
+static StagedMem StageElfFileFlat(ElfFile &elf) {
+  const std::string &filepath = elf.path_;
   size_t phnum = elf.GetPhdrNum();
   const Elf32_Phdr *phdrs = elf.GetPhdrs();
 
   // To mimic what objcopy does (that is, the binary target of BFD), we need to
   // iterate over all loadable program headers, find the lowest address, and
-  // then copy in our loadable data based on their offset with respect to the
+  // then place our loadable data based on their offset with respect to the
   // found base address.
 
   bool any = false;
-  Elf32_Addr low = 0, high = 0;
+  Elf32_Addr low = 0;
   for (size_t i = 0; i < phnum; i++) {
     const Elf32_Phdr &phdr = phdrs[i];
 
@@ -163,28 +300,19 @@ static std::vector<uint8_t> FlattenElfFile(const std::string &filepath) {
       throw ElfError(filepath, oss.str());
     }
 
-    if (!any || seg_top > high) {
-      high = seg_top;
-    }
-
     any = true;
   }
 
+  StagedMem ret;
+
   // If any is false, there were no segments that contributed to the
   // file. Return nothing.
   if (!any)
-    return std::vector<uint8_t>();
-
-  // Otherwise, we know every valid byte of data has an address in the
-  // range [low, high] (inclusive).
-  assert(low <= high);
-
-  size_t file_size;
-  const char *file_data = elf_rawfile(elf.ptr_, &file_size);
-  assert(file_data);
+    return ret;
 
-  StagedMem ret;
+  size_t file_size = elf.GetSize();
 
+  std::vector<std::pair<uint32_t, MemSpan>> segs;
   for (size_t i = 0; i < phnum; i++) {
     const Elf32_Phdr &phdr = phdrs[i];
 
@@ -193,10 +321,10 @@ static std::vector<uint8_t> FlattenElfFile(const std::string &filepath) {
     }
 
     // Check the segment actually fits in the file
-    if (file_size < phdr.p_offset + phdr.p_filesz) {
+    if (file_size < (size_t)phdr.p_offset + phdr.p_filesz) {
       std::ostringstream oss;
       oss << "phdr for segment " << i << " claims to end at offset 0x"
-          << std::hex << phdr.p_offset + phdr.p_filesz
+          << std::hex << (size_t)phdr.p_offset + phdr.p_filesz
           << ", but the file only has size 0x" << file_size << ".";
       throw ElfError(filepath, oss.str());
     }
@@ -205,27 +333,60 @@ static std::vector<uint8_t> FlattenElfFile(const std::string &filepath) {
       continue;
 
     uint32_t off = phdr.p_paddr - low;
-    std::vector<uint8_t> seg(phdr.p_filesz, 0);
-    memcpy(&seg[0], file_data + phdr.p_offset, phdr.p_filesz);
-    ret.AddSegment(off, std::move(seg));
+    segs.emplace_back(off, elf.GetSpan(phdr.p_offset, phdr.p_filesz));
+  }
+
+  ret.AddSegments(std::move(segs));
+  return ret;
+}
+
+// Stage the contents of a byte-addressed image (from an Intel HEX or binary
+// file). If rebase is true, the segments are placed relative to the lowest
+// addressed segment, like StageElfFileFlat.
+static StagedMem StageByteImage(MemImage &&img, bool rebase) {
+  assert(img.word_bytes == 1);
+
+  uint32_t low = 0;
+  if (rebase && !img.segs.empty()) {
+    low = img.segs[0].addr;
+    for (const MemImageSeg &seg : img.segs) {
+      low = std::min(low, seg.addr);
+    }
+  }
+
+  std::vector<std::pair<uint32_t, MemSpan>> segs;
+  for (MemImageSeg &seg : img.segs) {
+    uint32_t off = seg.addr - low;
+    if (seg.data.empty())
+      continue;
+    if ((uint32_t)(off + (seg.data.size() - 1)) < off) {
+      std::ostringstream oss;
+      oss << "Image segment at 0x" << std::hex << seg.addr << " with size 0x"
+          << seg.data.size() << " overflows the address space.";
+      throw std::runtime_error(oss.str());
+    }
+    segs.emplace_back(off, MemSpan(std::move(seg.data)));
   }
 
-  return ret.GetFlat();
+  StagedMem ret;
+  ret.AddSegments(std::move(segs));
+  return ret;
 }
 
 // Merge seg0 and seg1, overwriting any overlapping data in seg0 with
 // that from seg1. rng0/rng1 is the base and top address of seg0/seg1,
 // respectively.
-static std::vector<uint8_t> MergeSegments(const AddrRange<uint32_t> &rng0,
-                                          std::vector<uint8_t> &&seg0,
-                                          const AddrRange<uint32_t> &rng1,
-                                          std::vector<uint8_t> &&seg1) {
+static MemSpan MergeSegments(const AddrRange<uint32_t> &rng0, MemSpan &&seg0,
+                             const AddrRange<uint32_t> &rng1, MemSpan &&seg1) {
   // First, deal with the special case where seg1 completely contains
   // seg0 (since there's no copying needed at all).
   if (rng1.lo <= rng0.lo && rng0.hi <= rng1.hi) {
     return std::move(seg1);
   }
 
+  // Otherwise, the segments might point into a mapped file, which we mustn't
+  // modify, so copy both of them into a new buffer. Overlapping segments are
+  // unusual, so this isn't worth optimising further.
   uint32_t new_bot = std::min(rng0.lo, rng1.lo);
   uint32_t new_top = std::max(rng0.hi, rng1.hi);
   assert(new_bot <= new_top);
@@ -233,49 +394,20 @@ static std::vector<uint8_t> MergeSegments(const AddrRange<uint32_t> &rng0,
   assert(seg0.size() <= new_len);
   assert(seg1.size() <= new_len);
 
-  // We want to avoid copying if possible. The next most efficient
-  // case (after just returning seg1) is when seg0 doesn't stick out
-  // the left hand end. In this case, we can extend seg1 to the right
-  // (which might not cause a copy) and then copy just the bytes we
-  // need from seg0.
-  if (rng1.lo <= rng0.lo) {
-    assert(rng1.hi < rng0.hi);
-    assert(new_len == seg1.size() + (rng0.hi - rng1.hi));
-
-    size_t old_len = seg1.size();
-    std::vector<uint8_t> ret = std::move(seg1);
-    ret.resize(new_len);
-
-    // We know that that rng0 isn't completely contained in rng1 and
-    // that rng0 doesn't stick out of the left hand end. That means it
-    // must stick out of the right (so rng1.hi < rng0.hi). However, we
-    // also know that the two ranges overlap, so rng0.lo <= rng1.hi.
-    assert(rng0.lo <= rng1.hi);
-
-    // src_off is the index of the first byte that needs copying from
-    // seg0. Note that this is always at least 1 (because there is an
-    // actual overlap).
-    uint32_t src_off = 1 + (rng1.hi - rng0.lo);
-
-    assert(seg0.size() == src_off + (rng0.hi - rng1.hi));
-
-    memcpy(&ret[old_len], &seg0[src_off], rng0.hi - rng1.hi);
-    return ret;
-  }
-
-  // In this final case, seg0 sticks out the left hand end. That means
-  // we'll have to copy seg1 whatever happens (because we have to
-  // shuffle its elements to the right). Work by resizing seg0 and
-  // then writing seg1 where it's needed.
-  std::vector<uint8_t> ret = std::move(seg0);
-  ret.resize(new_len);
+  std::vector<uint8_t> ret(new_len);
+  memcpy(&ret[rng0.lo - new_bot], seg0.data(), seg0.size());
+  memcpy(&ret[rng1.lo - new_bot], seg1.data(), seg1.size());
+  return MemSpan(std::move(ret));
+}
 
-  uint32_t off = rng1.lo - rng0.lo;
-  memcpy(&ret[off], &seg1[0], seg1.size());
-  return ret;
+MemSpan::MemSpan(std::vector<uint8_t> &&buf) {
+  auto owned = std::make_shared<std::vector<uint8_t>>(std::move(buf));
+  data_ = owned->data();
+  size_ = owned->size();
+  owner_ = std::move(owned);
 }
 
-void StagedMem::AddSegment(uint32_t offset, std::vector<uint8_t> &&seg) {
+void StagedMem::AddSegment(uint32_t offset, MemSpan &&seg) {
   if (seg.empty())
     return;
 
@@ -284,7 +416,41 @@ void StagedMem::AddSegment(uint32_t offset, std::vector<uint8_t> &&seg) {
 
   min_addr_ = std::min(min_addr_, offset);
   max_addr_ = std::max(max_addr_, seg_top);
-  segs_.Emplace(offset, seg_top, std::move(seg), MergeSegments);
+  size_t seg_size = seg.size();
+  if (!segs_.Emplace(offset, seg_top, std::move(seg), MergeSegments)) {
+    data_size_ += seg_size;
+    return;
+  }
+
+  // Merging may have replaced overlapping bytes, so recount.
+  data_size_ = 0;
+  for (const auto &pr : segs_) {
+    data_size_ += pr.second.size();
+  }
+}
+
+void StagedMem::AddSegments(std::vector<std::pair<uint32_t, MemSpan>> &&segs) {
+  std::vector<SegMap::entry_t> entries;
+  entries.reserve(segs.size());
+  for (auto &pr : segs) {
+    if (pr.second.empty())
+      continue;
+
+    uint32_t seg_top = pr.first + pr.second.size() - 1;
+    assert(seg_top >= pr.first);
+
+    min_addr_ = std::min(min_addr_, pr.first);
+    max_addr_ = std::max(max_addr_, seg_top);
+    entries.emplace_back(AddrRange<uint32_t>{.lo = pr.first, .hi = seg_top},
+                         std::move(pr.second));
+  }
+
+  segs_.EmplaceMany(std::move(entries), MergeSegments);
+
+  data_size_ = 0;
+  for (const auto &pr : segs_) {
+    data_size_ += pr.second.size();
+  }
 }
 
 std::vector<uint8_t> StagedMem::GetFlat() const {
@@ -296,18 +462,262 @@ std::vector<uint8_t> StagedMem::GetFlat() const {
 
   for (const auto &pr : segs_) {
     const AddrRange<uint32_t> &rng = pr.first;
-    const std::vector<uint8_t> &seg = pr.second;
+    const MemSpan &seg = pr.second;
     assert(seg.size() == 1 + (rng.hi - rng.lo));
     assert(min_addr_ <= rng.lo);
 
     uint32_t off = rng.lo - min_addr_;
     assert(off + seg.size() <= ret.size());
 
-    memcpy(&ret[off], &seg[0], seg.size());
+    memcpy(&ret[off], seg.data(), seg.size());
   }
   return ret;
 }
 
+size_t StagedMem::WriteTo(const MemArea &mem_area) const {
+  const uint32_t width = mem_area.GetWidthByte();
+  size_t words = 0;
+
+  // Segments aren't necessarily aligned to the memory width, so two of them
+  // might share a word. Partial words are collected in edge_buf and written
+  // once we get to a segment that doesn't touch them.
+  uint8_t edge_buf[SV_MEM_WIDTH_BYTES];
+  bool have_edge = false;
+  uint32_t edge_word = 0;
+
+  auto flush_edge = [&]() {
+    if (have_edge) {
+      mem_area.Write(edge_word, edge_buf, width);
+      ++words;
+      have_edge = false;
+    }
+  };
+  auto add_to_edge = [&](uint32_t addr, const uint8_t *src, size_t len) {
+    uint32_t word = addr / width;
+    if (have_edge && edge_word != word) {
+      flush_edge();
+    }
+    if (!have_edge) {
+      memset(edge_buf, 0, width);
+      edge_word = word;
+      have_edge = true;
+    }
+    memcpy(&edge_buf[addr % width], src, len);
+  };
+
+  for (const auto &pr : segs_) {
+    uint32_t addr = pr.first.lo;
+    const uint8_t *src = pr.second.data();
+    size_t left = pr.second.size();
+
+    // A leading partial word
+    if (addr % width) {
+      size_t len = std::min(left, (size_t)(width - addr % width));
+      add_to_edge(addr, src, len);
+      addr += len;
+      src += len;
+      left -= len;
+      if (!left)
+        continue;
+    }
+
+    // addr is now aligned, so any partial word is strictly below it.
+    flush_edge();
+
+    // Write whole words straight from the segment, and keep any ragged end
+    // back in case the next segment starts in the same word.
+    size_t whole = left - left % width;
+    if (whole) {
+      mem_area.Write(addr / width, src, whole);
+      words += whole / width;
+    }
+    if (left > whole) {
+      add_to_edge(addr + whole, src + whole, left - whole);
+    }
+  }
+  flush_edge();
+
+  return words;
+}
+
+// DPI exports, defined in prim_util_memload.svh when SIMUTIL_LAZY_LOAD is
+// defined. They are weak so that simulations built without lazy loading still
+// link: the functions are null in that case.
+extern "C" {
+void simutil_lazy_enable(void) __attribute__((weak));
+void simutil_lazy_get_stats(int *page_words, unsigned long long *hits,
+                            unsigned long long *misses) __attribute__((weak));
+}
+
+struct LazyMem {
+  std::string name;
+  const MemArea *mem_area;
+  StagedMem image;
+  svScope scope;
+  uint64_t pages_loaded;
+  uint64_t words_written;
+
+  // Get the part of the image that lies in the num_words words starting at
+  // word index.
+  StagedMem GetPage(uint32_t index, uint32_t num_words) const;
+};
+
+StagedMem LazyMem::GetPage(uint32_t index, uint32_t num_words) const {
+  uint32_t width = mem_area->GetWidthByte();
+  uint64_t lo = (uint64_t)index * width;
+  uint64_t hi = lo + (uint64_t)num_words * width - 1;
+
+  // Pages start on word boundaries, so clipping segments to the page doesn't
+  // split any words.
+  StagedMem page;
+  for (const auto &pr : image.GetSegs()) {
+    if (pr.first.hi < lo)
+      continue;
+    if (hi < pr.first.lo)
+      break;
+    uint32_t seg_lo = std::max<uint64_t>(lo, pr.first.lo);
+    uint32_t seg_hi = std::min<uint64_t>(hi, pr.first.hi);
+    page.AddSegment(seg_lo,
+                    pr.second.Sub(seg_lo - pr.first.lo, 1 + seg_hi - seg_lo));
+  }
+
+  return page;
+}
+
+// Lazily loaded memories by SystemVerilog scope, for simutil_lazy_fill. The
+// mutex guards the map and the LazyMem objects, since Verilator may call
+// simutil_lazy_fill from several threads.
+static std::map<svScope, LazyMem *> lazy_by_scope;
+static std::mutex lazy_mutex;
+
+// DPI import, called by prim_util_memload.svh the first time a page of a
+// lazily loaded memory is accessed.
+extern "C" void simutil_lazy_fill(int index, int num_words) {
+  if (index < 0 || num_words <= 0)
+    return;
+
+  LazyMem *lazy_mem;
+  StagedMem page;
+  {
+    std::lock_guard<std::mutex> guard(lazy_mutex);
+    auto it = lazy_by_scope.find(svGetScope());
+    if (it == lazy_by_scope.end())
+      return;
+    lazy_mem = it->second;
+    page = lazy_mem->GetPage(index, num_words);
+  }
+
+  // Write the page without holding lazy_mutex: the writes go through
+  // simutil_set_mem, which calls back into simutil_lazy_fill if it touches a
+  // page that hasn't been loaded yet. We can't throw an exception back
+  // through the simulator.
+  uint64_t words_written = 0;
+  try {
+    words_written = page.WriteTo(*lazy_mem->mem_area);
+  } catch (const std::exception &err) {
+    std::cerr << "ERROR: Failed to load page at word 0x" << std::hex << index
+              << std::dec << " of memory `" << lazy_mem->name
+              << "': " << err.what() << std::endl;
+  }
+
+  std::lock_guard<std::mutex> guard(lazy_mutex);
+  lazy_mem->words_written += words_written;
+  ++lazy_mem->pages_loaded;
+}
+
+DpiMemUtil::DpiMemUtil() : lazy_(false) {}
+
+DpiMemUtil::~DpiMemUtil() {
+  std::lock_guard<std::mutex> guard(lazy_mutex);
+  for (const auto &pr : lazy_mems_) {
+    lazy_by_scope.erase(pr.second->scope);
+  }
+}
+
+void DpiMemUtil::WriteOrRegister(bool verbose, const std::string &path,
+                                 size_t mem_idx, const StagedMem &staged) {
+  const MemArea &mem_area = *mem_areas_[mem_idx];
+  const std::string &name = names_[mem_idx];
+
+  if (!lazy_) {
+    MemLoadStats stats = WriteStagedMem(mem_area, staged);
+    if (verbose) {
+      stats.Print(path, name);
+    }
+    return;
+  }
+
+  if (!simutil_lazy_enable) {
+    std::ostringstream oss;
+    oss << "Cannot load `" << path << "' into memory `" << name
+        << "' lazily: the simulation was built without SIMUTIL_LAZY_LOAD.";
+    throw std::runtime_error(oss.str());
+  }
+
+  // The SystemVerilog side tracks pages by physical word index, so a memory
+  // that moves words around (like a scrambled memory) can't be paged in.
+  if (!mem_area.HasLinearAddrMap()) {
+    std::ostringstream oss;
+    oss << "Cannot load `" << path << "' into memory `" << name
+        << "' lazily: the memory maps logical to physical addresses.";
+    throw std::runtime_error(oss.str());
+  }
+
+  std::unique_ptr<LazyMem> lazy_mem(
+      new LazyMem{name, &mem_area, staged, nullptr, 0, 0});
+  {
+    SVScoped scoped(mem_area.GetScope());
+    lazy_mem->scope = svGetScope();
+    simutil_lazy_enable();
+  }
+
+  std::lock_guard<std::mutex> guard(lazy_mutex);
+  lazy_by_scope[lazy_mem->scope] = lazy_mem.get();
+  lazy_mems_[name] = std::move(lazy_mem);
+
+  if (verbose) {
+    std::cout << "Registered " << staged.GetDataSize() << " bytes from `"
+              << path << "' for lazy loading into memory `" << name << "'."
+              << std::endl;
+  }
+}
+
+bool DpiMemUtil::PrintLazyLoadStats() const {
+  bool ok = true;
+  std::lock_guard<std::mutex> guard(lazy_mutex);
+  for (const auto &pr : lazy_mems_) {
+    const LazyMem &lazy_mem = *pr.second;
+
+    int page_words = 1;
+    unsigned long long hits = 0, misses = 0;
+    {
+      SVScoped scoped(lazy_mem.mem_area->GetScope());
+      simutil_lazy_get_stats(&page_words, &hits, &misses);
+    }
+
+    uint32_t num_words = lazy_mem.mem_area->GetSizeWords();
+    uint32_t num_pages = (num_words + page_words - 1) / page_words;
+
+    std::cout << "Lazy loading of memory `" << pr.first << "': "
+              << lazy_mem.pages_loaded << "/" << num_pages
+              << " pages loaded (" << lazy_mem.words_written
+              << " words written), " << hits << " hits, " << misses
+              << " misses." << std::endl;
+
+    // An image that was registered but never paged in means that lazy
+    // loading was switched off again (or the memory doesn't call
+    // simutil_lazy_touch), so the design ran without its contents.
+    if (lazy_mem.image.GetDataSize() && !lazy_mem.pages_loaded) {
+      std::cerr << "ERROR: No pages of memory `" << pr.first
+                << "' were loaded, although an image was registered for "
+                   "lazy loading."
+                << std::endl;
+      ok = false;
+    }
+  }
+  return ok;
+}
+
 void DpiMemUtil::RegisterMemoryArea(const std::string &name, uint32_t base,
                                     const MemArea *mem_area) {
   assert(mem_area);
@@ -349,6 +759,8 @@ void DpiMemUtil::RegisterMemoryArea(const std::string &name, uint32_t base,
   mem_areas_.push_back(mem_area);
   base_addrs_.push_back(base);
   names_.push_back(name);
+
+  addr_to_mem_flat_ = FlatRangedMap<uint32_t, size_t>(addr_to_mem_);
 }
 
 MemImageType DpiMemUtil::GetMemImageType(const std::string &path,
@@ -370,15 +782,45 @@ void DpiMemUtil::PrintMemRegions() const {
   }
 }
 
+MemSnapshot DpiMemUtil::TakeSnapshot() const {
+  MemSnapshot snap;
+  for (const auto &pr : name_to_mem_) {
+    snap.AddMemory(pr.first, base_addrs_[pr.second], *mem_areas_[pr.second]);
+  }
+  return snap;
+}
+
+const ElfFuncSymbol *DpiMemUtil::FindFuncSymbol(uint32_t addr) const {
+  auto it = func_syms_.upper_bound(addr);
+  if (it == func_syms_.begin()) {
+    return nullptr;
+  }
+  auto next = it--;
+
+  const ElfFuncSymbol &func = it->second;
+  if (func.size ? (addr - func.addr < func.size)
+                : (next == func_syms_.end() || addr < next->first)) {
+    return &func;
+  }
+  return nullptr;
+}
+
 void DpiMemUtil::LoadFileToNamedMem(bool verbose, const std::string &name,
                                     const std::string &filepath,
-                                    MemImageType type) {
+                                    MemImageType type, uint32_t offset) {
   // If the image type isn't specified, try to figure it out from the file name
   if (type == kMemImageUnknown) {
     type = DetectMemImageType(filepath);
   }
   assert(type != kMemImageUnknown);
 
+  if (offset && type != kMemImageBin) {
+    std::ostringstream oss;
+    oss << "Cannot load `" << filepath
+        << "' at an offset: offsets are only supported for binary images.";
+    throw std::runtime_error(oss.str());
+  }
+
   // Search for corresponding registered memory based on the name
   auto it = name_to_mem_.find(name);
   if (it == name_to_mem_.end()) {
@@ -397,16 +839,48 @@ void DpiMemUtil::LoadFileToNamedMem(bool verbose, const std::string &name,
   const MemArea &m = *mem_areas_[it->second];
 
   try {
+    // vmem files are written word by word by the MemArea itself.
+    if (type == kMemImageVmem) {
+      m.LoadVmem(filepath);
+      return;
+    }
+
+    StagedMem staged;
     switch (type) {
-      case kMemImageElf:
-        m.Write(0, FlattenElfFile(filepath));
+      case kMemImageElf: {
+        ElfFile elf(filepath);
+        DvLogSink::GetInstance().AddElf(elf.ptr_, filepath);
+        AddFuncSymbols(elf.ptr_, &func_syms_);
+        staged = StageElfFileFlat(elf);
         break;
-      case kMemImageVmem:
-        m.LoadVmem(filepath);
+      }
+      case kMemImageBin:
+        if (offset % m.GetWidthByte()) {
+          std::ostringstream oss;
+          oss << "Offset 0x" << std::hex << offset << " for `" << filepath
+              << "' is not aligned to the " << std::dec << m.GetWidth()
+              << "-bit words of memory `" << name << "'.";
+          throw std::runtime_error(oss.str());
+        }
+        staged = StageByteImage(ReadBinFile(filepath, offset), false);
+        break;
+      case kMemImageIhex:
+        staged = StageByteImage(ReadIhexFile(filepath), true);
         break;
       default:
         assert(0);
     }
+
+    if (staged.GetSegs().size() &&
+        m.GetSizeBytes() <= staged.GetBounds().second) {
+      std::ostringstream oss;
+      oss << "Image `" << filepath << "' spans 0x" << std::hex
+          << (size_t)1 + staged.GetBounds().second << " bytes, but memory `"
+          << name << "' is only 0x" << m.GetSizeBytes() << " bytes long.";
+      throw std::runtime_error(oss.str());
+    }
+
+    WriteOrRegister(verbose, filepath, it->second, staged);
   } catch (const SVScoped::Error &err) {
     std::ostringstream oss;
     oss << "No memory found at `" << err.scope_name_
@@ -426,25 +900,16 @@ void DpiMemUtil::LoadElfToMemories(bool verbose, const std::string &filepath) {
     auto mem_area_it = name_to_mem_.find(mem_name);
     assert(mem_area_it != name_to_mem_.end());
 
-    const MemArea &mem_area = *mem_areas_[mem_area_it->second];
-
-    for (const auto &seg_pr : staged_mem.GetSegs()) {
-      const AddrRange<uint32_t> &seg_rng = seg_pr.first;
-      const std::vector<uint8_t> &seg_data = seg_pr.second;
-
-      assert(seg_rng.lo % mem_area.GetWidthByte() == 0);
-      uint32_t lo_word = seg_rng.lo / mem_area.GetWidthByte();
-
-      try {
-        mem_area.Write(lo_word, seg_data);
-      } catch (const SVScoped::Error &err) {
-        std::ostringstream oss;
-        oss << "No memory found at `" << err.scope_name_
-            << "' (the scope associated with region `" << mem_name
-            << "', used by a segment that starts at LMA 0x" << std::hex
-            << base_addrs_[mem_area_it->second] + seg_rng.lo << ").";
-        throw std::runtime_error(oss.str());
-      }
+    try {
+      WriteOrRegister(verbose, filepath, mem_area_it->second, staged_mem);
+    } catch (const SVScoped::Error &err) {
+      std::ostringstream oss;
+      oss << "No memory found at `" << err.scope_name_
+          << "' (the scope associated with region `" << mem_name
+          << "', used by a segment that starts at LMA 0x" << std::hex
+          << base_addrs_[mem_area_it->second] + staged_mem.GetBounds().first
+          << ").";
+      throw std::runtime_error(oss.str());
     }
   }
 }
@@ -458,13 +923,21 @@ void DpiMemUtil::StageElf(bool verbose, const std::string &path) {
   // Allow subclasses to get at the loaded ELF data if they need it
   OnElfLoaded(elf.ptr_);
 
-  size_t file_size;
-  const char *file_data = elf_rawfile(elf.ptr_, &file_size);
-  assert(file_data);
+  // Pick up any log fields for logs that bypass the UART
+  DvLogSink::GetInstance().AddElf(elf.ptr_, path);
+
+  // Keep the function symbols, for software profiling
+  AddFuncSymbols(elf.ptr_, &func_syms_);
+
+  size_t file_size = elf.GetSize();
 
   size_t phnum = elf.GetPhdrNum();
   const Elf32_Phdr *phdrs = elf.GetPhdrs();
 
+  // Segments for each memory, keyed by memory name. These are added to the
+  // staging area in one go at the end.
+  std::map<std::string, std::vector<std::pair<uint32_t, MemSpan>>> segs;
+
   for (size_t i = 0; i < phnum; ++i) {
     const Elf32_Phdr &phdr = phdrs[i];
     if (phdr.p_type != PT_LOAD)
@@ -510,15 +983,12 @@ void DpiMemUtil::StageElf(bool verbose, const std::string &path) {
                 << "' into memory `" << name << "'." << std::endl;
     }
 
-    // Get the StagedMem object associated with this memory area. If
-    // there isn't one, make a new empty one.
-    StagedMem &staged_mem = staging_area_[name];
-
-    const char *seg_data = file_data + phdr.p_offset;
-    std::vector<uint8_t> vec(phdr.p_filesz, 0);
-    memcpy(&vec[0], seg_data, phdr.p_filesz);
+    segs[name].emplace_back(local_base,
+                            elf.GetSpan(phdr.p_offset, phdr.p_filesz));
+  }
 
-    staged_mem.AddSegment(local_base, std::move(vec));
+  for (auto &pr : segs) {
+    staging_area_[pr.first].AddSegments(std::move(pr.second));
   }
 }
 
@@ -531,15 +1001,15 @@ size_t DpiMemUtil::GetRegionForSegment(const std::string &path, int seg_idx,
                                        uint32_t lma, uint32_t mem_sz) const {
   assert(mem_sz > 0);
 
-  auto mem_area_it = addr_to_mem_.find(lma);
-  if (mem_area_it == addr_to_mem_.end()) {
+  const size_t *mem_area_idx_ptr = addr_to_mem_flat_.find(lma);
+  if (!mem_area_idx_ptr) {
     std::ostringstream oss;
     oss << "No memory region is registered that contains the address 0x"
         << std::hex << lma << " (the base address of segment " << seg_idx
         << ").";
     throw ElfError(path, oss.str());
   }
-  size_t mem_area_idx = mem_area_it->second;
+  size_t mem_area_idx = *mem_area_idx_ptr;
 
   const MemArea &mem_area = *mem_areas_[mem_area_idx];
   uint32_t base_addr = base_addrs_[mem_area_idx];
@@ -567,5 +1037,5 @@ size_t DpiMemUtil::GetRegionForSegment(const std::string &path, int seg_idx,
     throw ElfError(path, oss.str());
   }
 
-  return mem_area_it->second;
+  return mem_area_idx;
 }
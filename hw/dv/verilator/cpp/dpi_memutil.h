@@ -11,15 +11,51 @@
 #include <vector>
 
 #include "mem_area.h"
+#include "mem_snapshot.h"
 #include "ranged_map.h"
 
 // Forward declaration for the Elf type from libelf.
 struct Elf;
 
+// State for a lazily loaded memory (defined in dpi_memutil.cc)
+struct LazyMem;
+
 enum MemImageType {
   kMemImageUnknown = 0,
   kMemImageElf,
   kMemImageVmem,
+  kMemImageBin,
+  kMemImageIhex,
+};
+
+// A read-only run of bytes from a memory image.
+//
+// When an ELF file is staged, segments point straight into the memory-mapped
+// file and |owner| keeps the mapping alive for as long as any span refers to
+// it. A span made from a vector (as happens when overlapping segments are
+// merged) takes ownership of that vector instead.
+class MemSpan {
+ public:
+  MemSpan() : data_(nullptr), size_(0) {}
+  MemSpan(std::shared_ptr<const void> owner, const uint8_t *data, size_t size)
+      : owner_(std::move(owner)), data_(data), size_(size) {}
+  explicit MemSpan(std::vector<uint8_t> &&buf);
+
+  const uint8_t *data() const { return data_; }
+  size_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+  const uint8_t &operator[](size_t idx) const { return data_[idx]; }
+
+  // Return a span for len bytes starting at off, sharing ownership with this
+  // span.
+  MemSpan Sub(size_t off, size_t len) const {
+    return MemSpan(owner_, data_ + off, len);
+  }
+
+ private:
+  std::shared_ptr<const void> owner_;
+  const uint8_t *data_;
+  size_t size_;
 };
 
 // Staged data for a given memory area.
@@ -34,35 +70,59 @@ class StagedMem {
   StagedMem() : min_addr_(~(uint32_t)0), max_addr_(0) {}
 
   // Add a segment to the tracked memory
-  void AddSegment(uint32_t offset, std::vector<uint8_t> &&seg);
+  void AddSegment(uint32_t offset, MemSpan &&seg);
+
+  // Add several segments, given as (offset, segment) pairs. This has the
+  // same result as calling AddSegment() for each in turn, but sorts and
+  // coalesces them in a single pass, which is much faster for images with
+  // thousands of segments.
+  void AddSegments(std::vector<std::pair<uint32_t, MemSpan>> &&segs);
 
   // Glob together the tracked segments, interspersing them with
   // zeros, and return as a single flat array.
   std::vector<uint8_t> GetFlat() const;
 
-  typedef RangedMap<uint32_t, std::vector<uint8_t>> SegMap;
+  // Write the tracked segments to mem_area, where segment addresses are byte
+  // offsets into the memory. Only words that contain segment data are
+  // written: gaps between segments are skipped rather than being filled with
+  // zeros. Returns the number of words written.
+  size_t WriteTo(const MemArea &mem_area) const;
+
+  typedef RangedMap<uint32_t, MemSpan> SegMap;
 
   std::pair<uint32_t, uint32_t> GetBounds() const {
     return std::make_pair(min_addr_, max_addr_);
   }
   const SegMap &GetSegs() const { return segs_; }
 
+  // The number of bytes of segment data (not counting gaps)
+  size_t GetDataSize() const { return data_size_; }
+
  private:
   uint32_t min_addr_, max_addr_;
+  size_t data_size_ = 0;
   SegMap segs_;
 };
 
+// A function symbol from a loaded ELF file
+struct ElfFuncSymbol {
+  uint32_t addr;
+  uint32_t size;  // Zero if the symbol didn't give a size
+  std::string name;
+};
+
 /**
  * Provide various memory loading utilities for verilog simulations
  *
  * These utilities require the corresponding DPI functions:
- * simutil_memload()
  * simutil_set_mem()
+ * simutil_get_mem()
  * to be defined somewhere as SystemVerilog functions.
  */
 class DpiMemUtil {
  public:
-  virtual ~DpiMemUtil() {}
+  DpiMemUtil();
+  virtual ~DpiMemUtil();
 
   /**
    * Register a memory as instantiated by generic ram
@@ -108,21 +168,61 @@ class DpiMemUtil {
   /**
    * Load the file at filepath into the named memory. If type is
    * kMemImageUnknown, the file type is determined from the path.
+   *
+   * ELF and Intel HEX data is written at its offset from the lowest addressed
+   * segment (like objcopy's binary output), but gaps between segments are left
+   * untouched. A binary image is written starting at byte offset |offset| in
+   * the memory, which must be word aligned; other image types must have a zero
+   * offset. If verbose is true, this prints load statistics.
    */
   void LoadFileToNamedMem(bool verbose, const std::string &name,
-                          const std::string &filepath, MemImageType type);
+                          const std::string &filepath, MemImageType type,
+                          uint32_t offset = 0);
 
   /**
    * Load an ELF file, placing segments in memories by LMA.
    *
-   * Replaces any data currently in the staging area.
+   * Replaces any data currently in the staging area. If verbose is true, this
+   * prints load statistics for each memory that is written.
    */
   void LoadElfToMemories(bool verbose, const std::string &filepath);
 
+  /**
+   * Enable or disable lazy loading
+   *
+   * When lazy loading is enabled, LoadFileToNamedMem() and LoadElfToMemories()
+   * register ELF, binary and Intel HEX images with the memories rather than
+   * writing them. Each page of a memory is then written the first time that it
+   * is accessed. This needs memories built with SIMUTIL_LAZY_LOAD defined (see
+   * prim_util_memload.svh) that map logical to physical addresses one to one
+   * (see MemArea::HasLinearAddrMap()): loading throws a std::runtime_error
+   * otherwise. vmem files are always loaded eagerly.
+   */
+  void SetLazyLoad(bool lazy) { lazy_ = lazy; }
+
+  /**
+   * Print page, hit and miss counts for each lazily loaded memory
+   *
+   * Returns false (after printing an error) if an image was registered for a
+   * memory but none of its pages were ever loaded.
+   */
+  bool PrintLazyLoadStats() const;
+
+  /**
+   * Take a snapshot of the contents of all registered memories
+   *
+   * Each memory is read in full over DPI, so this takes a while for large
+   * memories. Throws a std::runtime_error if a memory can't be read.
+   */
+  MemSnapshot TakeSnapshot() const;
+
   /**
    * Load an ELF file into a staging area in this object, which can then be
    * accessed with GetMemoryData().
    *
+   * The file is memory-mapped and the staged segments point into the mapping,
+   * which stays alive until the staging area is next replaced.
+   *
    * If the load fails, raises a std::exception with information about what
    * happened.
    */
@@ -133,6 +233,16 @@ class DpiMemUtil {
    */
   const StagedMem &GetMemoryData(const std::string &mem_name) const;
 
+  /**
+   * Find the function containing |addr| in the ELF files loaded so far
+   *
+   * Function symbols from every ELF file that is loaded or staged are kept,
+   * with later files replacing symbols at the same address. A function whose
+   * symbol has no size is assumed to extend to the next function. Returns null
+   * if no function contains |addr|.
+   */
+  const ElfFuncSymbol *FindFuncSymbol(uint32_t addr) const;
+
  protected:
   /**
    * A hook for subclasses to do extra computations with loaded ELF data. This
@@ -152,6 +262,9 @@ class DpiMemUtil {
   std::map<std::string, size_t> name_to_mem_;
   RangedMap<uint32_t, size_t> addr_to_mem_;
 
+  // A copy of addr_to_mem_ for lookups, rebuilt when a memory is registered
+  FlatRangedMap<uint32_t, size_t> addr_to_mem_flat_;
+
   // Staging area, loaded by StageElf. The map is keyed by names of memories
   // stored in name_to_mem_. We also ensure that every segment in a StagedMem
   // for a memory starts at an address that's aligned for the word width of
@@ -159,6 +272,21 @@ class DpiMemUtil {
   std::map<std::string, StagedMem> staging_area_;
   const StagedMem empty_;
 
+  // Function symbols of loaded ELF files, keyed by address
+  std::map<uint32_t, ElfFuncSymbol> func_syms_;
+
+  // Lazily loaded memories, keyed by memory name. See SetLazyLoad().
+  bool lazy_;
+  std::map<std::string, std::unique_ptr<LazyMem>> lazy_mems_;
+
+  /**
+   * Write staged to the memory with index mem_idx or, if lazy loading is
+   * enabled, register it for lazy loading. Prints statistics if verbose is
+   * true.
+   */
+  void WriteOrRegister(bool verbose, const std::string &path, size_t mem_idx,
+                       const StagedMem &staged);
+
   /**
    * Find the index of a memory area containing the given segment's addresses.
    * Raises a std::exception if none is found.
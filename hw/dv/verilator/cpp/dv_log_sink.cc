@@ -0,0 +1,342 @@
+// Copyright lowRISC contributors.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+#include "dv_log_sink.h"
+
+#include <cstring>
+#include <iostream>
+#include <libelf.h>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+// The section holding log_fields_t structs (see sw/device/info_sections.ld)
+const char kLogsFieldsSection[] = ".logs.fields";
+
+// sizeof(log_fields_t) on the device: five 32-bit words holding the severity,
+// a pointer to the file name, the line number, the number of arguments and a
+// pointer to the format string.
+const size_t kLogFieldsSize = 20;
+
+const char *const kSeverityNames[] = {"I", "W", "E", "F"};
+
+uint32_t ReadWord(const char *data) {
+  const uint8_t *bytes = reinterpret_cast<const uint8_t *>(data);
+  return bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) |
+         ((uint32_t)bytes[3] << 24);
+}
+
+// Append the digits of |value| in |base|, zero-padded to at least |width|
+// characters (like write_digits() in sw/device/lib/runtime/print.c).
+void AppendDigits(std::string *out, uint32_t value, size_t width,
+                  uint32_t base, const char *glyphs) {
+  char buf[32];
+  size_t len = 0;
+  while (value > 0) {
+    buf[sizeof(buf) - 1 - len++] = glyphs[value % base];
+    value /= base;
+  }
+  width = width == 0 ? 1 : width;
+  width = width > sizeof(buf) ? sizeof(buf) : width;
+  while (len < width) {
+    buf[sizeof(buf) - 1 - len++] = '0';
+  }
+  out->append(buf + sizeof(buf) - len, len);
+}
+
+void AppendHex(std::string *out, uint32_t value) {
+  std::ostringstream oss;
+  oss << "0x" << std::hex << value;
+  out->append(oss.str());
+}
+}  // namespace
+
+DvLogSink::DvLogSink() : pending_(nullptr), pending_addr_(0), counter_(0) {}
+
+DvLogSink &DvLogSink::GetInstance() {
+  static DvLogSink instance;
+  return instance;
+}
+
+void DvLogSink::AddElf(Elf *elf, const std::string &path) {
+  size_t shstrndx;
+  if (elf_getshdrstrndx(elf, &shstrndx) != 0) {
+    return;
+  }
+
+  // Find the log fields first: most ELF files loaded into a simulation don't
+  // use DV logging, and there's no need to copy anything out of those.
+  const char *fields_data = nullptr;
+  size_t fields_size = 0;
+  uint32_t fields_base = 0;
+  for (Elf_Scn *scn = elf_nextscn(elf, nullptr); scn;
+       scn = elf_nextscn(elf, scn)) {
+    const Elf32_Shdr *shdr = elf32_getshdr(scn);
+    if (!shdr || shdr->sh_type != SHT_PROGBITS || shdr->sh_size == 0)
+      continue;
+
+    const char *name = elf_strptr(elf, shstrndx, shdr->sh_name);
+    if (!name || strcmp(name, kLogsFieldsSection))
+      continue;
+
+    Elf_Data *data = elf_getdata(scn, nullptr);
+    if (!data || !data->d_buf || data->d_size != shdr->sh_size)
+      continue;
+
+    fields_data = static_cast<const char *>(data->d_buf);
+    fields_size = data->d_size;
+    fields_base = shdr->sh_addr;
+    break;
+  }
+
+  if (!fields_data) {
+    return;
+  }
+
+  if (fields_size % kLogFieldsSize) {
+    std::ostringstream oss;
+    oss << "The " << kLogsFieldsSection << " section of `" << path
+        << "' has size " << fields_size << ", which is not a multiple of "
+        << kLogFieldsSize << " bytes.";
+    throw std::runtime_error(oss.str());
+  }
+
+  // Copy out the allocated sections that might contain strings. Section data
+  // points into the ELF image, which doesn't outlive the load.
+  std::map<uint32_t, std::vector<char>> sections;
+  for (Elf_Scn *scn = elf_nextscn(elf, nullptr); scn;
+       scn = elf_nextscn(elf, scn)) {
+    const Elf32_Shdr *shdr = elf32_getshdr(scn);
+    if (!shdr || shdr->sh_type != SHT_PROGBITS || shdr->sh_size == 0 ||
+        !(shdr->sh_flags & SHF_ALLOC) || (shdr->sh_flags & SHF_EXECINSTR))
+      continue;
+
+    Elf_Data *data = elf_getdata(scn, nullptr);
+    if (!data || !data->d_buf || data->d_size != shdr->sh_size)
+      continue;
+
+    const char *bytes = static_cast<const char *>(data->d_buf);
+    sections[shdr->sh_addr].assign(bytes, bytes + data->d_size);
+  }
+
+  for (auto &pr : sections) {
+    sections_[pr.first] = std::move(pr.second);
+  }
+
+  for (size_t off = 0; off < fields_size; off += kLogFieldsSize) {
+    const char *entry = fields_data + off;
+    LogFields fields;
+    fields.severity = ReadWord(entry);
+    fields.line = ReadWord(entry + 8);
+    fields.nargs = ReadWord(entry + 12);
+
+    uint32_t file_addr = ReadWord(entry + 4);
+    uint32_t format_addr = ReadWord(entry + 16);
+    if (!GetString(file_addr, &fields.file_name) ||
+        !GetString(format_addr, &fields.format)) {
+      std::ostringstream oss;
+      oss << "The log fields at 0x" << std::hex << fields_base + off << " in `"
+          << path << "' point at strings that aren't in any loaded section.";
+      throw std::runtime_error(oss.str());
+    }
+
+    // Only keep the base name, like base_log_internal_core()
+    size_t slash = fields.file_name.rfind('/');
+    if (slash != std::string::npos) {
+      fields.file_name.erase(0, slash + 1);
+    }
+
+    fields_[fields_base + off] = std::move(fields);
+  }
+
+  // Anything half-received refers to the old tables
+  pending_ = nullptr;
+  args_.clear();
+}
+
+void DvLogSink::Write(uint32_t data) {
+  if (!pending_) {
+    auto it = fields_.find(data);
+    if (it == fields_.end()) {
+      std::cerr << "WARNING: DV log write of 0x" << std::hex << data << std::dec
+                << " doesn't match any known log fields." << std::endl;
+      return;
+    }
+    pending_ = &it->second;
+    pending_addr_ = data;
+    args_.clear();
+  } else {
+    args_.push_back(data);
+  }
+
+  if (args_.size() < pending_->nargs) {
+    return;
+  }
+
+  std::string line;
+  Format(pending_addr_, args_, &line);
+  std::cout << line << std::endl;
+  ++counter_;
+  pending_ = nullptr;
+}
+
+bool DvLogSink::Format(uint32_t fields_addr, const std::vector<uint32_t> &args,
+                       std::string *line) const {
+  auto it = fields_.find(fields_addr);
+  if (it == fields_.end()) {
+    return false;
+  }
+  const LogFields &fields = it->second;
+
+  // Match the prefix that base_log_internal_core() prints
+  line->clear();
+  line->append(fields.severity < 4 ? kSeverityNames[fields.severity] : "?");
+  std::string counter;
+  AppendDigits(&counter, counter_, 5, 10, "0123456789");
+  line->append(counter);
+  line->append(" ");
+  line->append(fields.file_name);
+  line->append(":");
+  line->append(std::to_string(fields.line));
+  line->append("] ");
+
+  FormatArgs(fields.format, args, line);
+  return true;
+}
+
+bool DvLogSink::GetString(uint32_t addr, std::string *str) const {
+  auto it = sections_.upper_bound(addr);
+  if (it == sections_.begin()) {
+    return false;
+  }
+  --it;
+  uint32_t off = addr - it->first;
+  const std::vector<char> &data = it->second;
+  if (off >= data.size()) {
+    return false;
+  }
+
+  const char *start = &data[off];
+  const void *nul = memchr(start, '\0', data.size() - off);
+  size_t len = nul ? static_cast<const char *>(nul) - start : data.size() - off;
+  str->assign(start, len);
+  return true;
+}
+
+// Format |args| according to |format|, following base_vfprintf() in
+// sw/device/lib/runtime/print.c. Arguments that are missing (because nargs in
+// the log fields was wrong) are treated as zero.
+void DvLogSink::FormatArgs(const std::string &format,
+                           const std::vector<uint32_t> &args,
+                           std::string *out) const {
+  static const char kDigitsLow[] = "0123456789abcdef";
+  static const char kDigitsHigh[] = "0123456789ABCDEF";
+
+  size_t arg_idx = 0;
+  auto next_arg = [&]() -> uint32_t {
+    return arg_idx < args.size() ? args[arg_idx++] : 0;
+  };
+
+  size_t pos = 0;
+  while (pos < format.size()) {
+    size_t pct = format.find('%', pos);
+    if (pct == std::string::npos) {
+      out->append(format, pos, std::string::npos);
+      return;
+    }
+    out->append(format, pos, pct - pos);
+    pos = pct + 1;
+
+    size_t width = 0;
+    bool has_width = false;
+    while (pos < format.size() && format[pos] >= '0' && format[pos] <= '9') {
+      has_width = true;
+      width = width * 10 + (format[pos] - '0');
+      ++pos;
+    }
+    if (pos == format.size()) {
+      out->append("%<unexpected nul>");
+      return;
+    }
+    if ((width == 0 && has_width) || width > 32) {
+      out->append("%<bad width>");
+      return;
+    }
+
+    char type = format[pos++];
+    switch (type) {
+      case '%':
+        out->push_back('%');
+        break;
+      case 'c':
+        out->push_back(static_cast<char>(next_arg()));
+        break;
+      case 's': {
+        uint32_t addr = next_arg();
+        std::string str;
+        if (GetString(addr, &str)) {
+          out->append(str);
+        } else {
+          out->append("%<string at ");
+          AppendHex(out, addr);
+          out->append(">");
+        }
+        break;
+      }
+      case 'z': {
+        uint32_t len = next_arg();
+        uint32_t addr = next_arg();
+        std::string str;
+        if (GetString(addr, &str)) {
+          out->append(str, 0, len);
+        } else {
+          out->append("%<buffer at ");
+          AppendHex(out, addr);
+          out->append(">");
+        }
+        break;
+      }
+      case 'd':
+      case 'i': {
+        uint32_t value = next_arg();
+        if (static_cast<int32_t>(value) < 0) {
+          out->push_back('-');
+          value = -value;
+        }
+        AppendDigits(out, value, width, 10, kDigitsLow);
+        break;
+      }
+      case 'u':
+        AppendDigits(out, next_arg(), width, 10, kDigitsLow);
+        break;
+      case 'o':
+        AppendDigits(out, next_arg(), width, 8, kDigitsLow);
+        break;
+      case 'p':
+        out->append("0x");
+        AppendDigits(out, next_arg(), 8, 16, kDigitsLow);
+        break;
+      case 'x':
+      case 'h':
+        AppendDigits(out, next_arg(), width, 16, kDigitsLow);
+        break;
+      case 'X':
+      case 'H':
+        AppendDigits(out, next_arg(), width, 16, kDigitsHigh);
+        break;
+      case 'b':
+        AppendDigits(out, next_arg(), width, 2, kDigitsLow);
+        break;
+      default:
+        out->append("%<unknown spec>");
+        break;
+    }
+  }
+}
+
+// Called by the testbench for each word that software writes to the log
+// bypass address.
+extern "C" void dv_log_sink_write(unsigned int data) {
+  DvLogSink::GetInstance().Write(data);
+}
@@ -0,0 +1,99 @@
+// Copyright lowRISC contributors.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+#ifndef OPENTITAN_HW_DV_VERILATOR_CPP_DV_LOG_SINK_H_
+#define OPENTITAN_HW_DV_VERILATOR_CPP_DV_LOG_SINK_H_
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+// Forward declaration for the Elf type from libelf.
+struct Elf;
+
+/**
+ * Host-side decoder for software logs that bypass the UART
+ *
+ * When kDeviceLogBypassUartAddress is nonzero, the LOG_* macros in
+ * sw/device/lib/runtime/log.h don't format anything on the device. Instead,
+ * base_log_internal_dv() writes the address of a log_fields_t followed by the
+ * raw format arguments to the bypass address. The log_fields_t structs live in
+ * the .logs.fields section of the ELF file, which is never loaded into a
+ * memory.
+ *
+ * This class collects the log fields and read-only strings of each ELF file
+ * that DpiMemUtil loads, and turns the stream of words written to the bypass
+ * address (passed in by the dv_log_sink_write() DPI function) back into log
+ * lines. These are printed to stdout in the same format as
+ * base_log_internal_core() uses on the UART.
+ */
+class DvLogSink {
+ public:
+  static DvLogSink &GetInstance();
+
+  /**
+   * Add the log fields and strings of an ELF file
+   *
+   * Does nothing if the file has no .logs.fields section. Fields from later
+   * files replace any earlier ones at the same address. Throws a
+   * std::runtime_error if the section is malformed.
+   */
+  void AddElf(Elf *elf, const std::string &path);
+
+  /**
+   * Handle a word written to the log bypass address
+   */
+  void Write(uint32_t data);
+
+  /**
+   * Format a log line (without a trailing newline)
+   *
+   * |fields_addr| is the address of a log_fields_t and |args| holds its
+   * arguments. Returns false if no log fields are known at |fields_addr|.
+   */
+  bool Format(uint32_t fields_addr, const std::vector<uint32_t> &args,
+              std::string *line) const;
+
+ private:
+  // Contents of a log_fields_t, with the strings resolved
+  struct LogFields {
+    uint32_t severity;
+    std::string file_name;
+    uint32_t line;
+    uint32_t nargs;
+    std::string format;
+  };
+
+  DvLogSink();
+
+  /**
+   * Get the NUL-terminated string at |addr|
+   *
+   * Returns false if |addr| isn't inside a section that was loaded with
+   * AddElf().
+   */
+  bool GetString(uint32_t addr, std::string *str) const;
+
+  void FormatArgs(const std::string &format, const std::vector<uint32_t> &args,
+                  std::string *out) const;
+
+  // Log fields, keyed by the address of their log_fields_t
+  std::map<uint32_t, LogFields> fields_;
+
+  // Contents of allocated, non-executable sections, keyed by base address.
+  // These hold the file names and format strings, as well as any constant
+  // strings that are passed for %s.
+  std::map<uint32_t, std::vector<char>> sections_;
+
+  // The log line being received: the fields (null when waiting for a new
+  // line) and the arguments received so far.
+  const LogFields *pending_;
+  uint32_t pending_addr_;
+  std::vector<uint32_t> args_;
+
+  // Counts log lines, like the counter in base_log_internal_core()
+  uint16_t counter_;
+};
+
+#endif  // OPENTITAN_HW_DV_VERILATOR_CPP_DV_LOG_SINK_H_
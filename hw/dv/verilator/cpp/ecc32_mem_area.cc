@@ -30,8 +30,7 @@ void Ecc32MemArea::LoadVmem(const std::string &path) const {
 }
 
 void Ecc32MemArea::WriteBuffer(uint8_t buf[SV_MEM_WIDTH_BYTES],
-                               const std::vector<uint8_t> &data,
-                               size_t start_idx, uint32_t dst_word) const {
+                               const uint8_t *data, uint32_t dst_word) const {
   int log_width_32 = width_byte_ / 4;
   int phy_width_bits = 39 * log_width_32;
   int phy_width_bytes = (phy_width_bits + 7) / 8;
@@ -51,7 +50,7 @@ void Ecc32MemArea::WriteBuffer(uint8_t buf[SV_MEM_WIDTH_BYTES],
     // Store things little-endian, so the "real bits" go in bytes 0 to 3 and
     // the check bits go in byte 4. Bytes 5 to 7 are zero.
     expanded_t next;
-    memcpy(next.bytes, &data[start_idx + 4 * i], 4);
+    memcpy(next.bytes, &data[4 * i], 4);
     next.bytes[4] = enc_secded_39_32(next.bytes);
     expanded[i] = next;
   }
@@ -25,8 +25,7 @@ class Ecc32MemArea : public MemArea {
   void LoadVmem(const std::string &path) const override;
 
  protected:
-  void WriteBuffer(uint8_t buf[SV_MEM_WIDTH_BYTES],
-                   const std::vector<uint8_t> &data, size_t start_idx,
+  void WriteBuffer(uint8_t buf[SV_MEM_WIDTH_BYTES], const uint8_t *data,
                    uint32_t dst_word) const override;
 
   void ReadBuffer(std::vector<uint8_t> &data,
@@ -9,11 +9,11 @@
 #include <cstring>
 #include <sstream>
 
+#include "mem_image.h"
 #include "sv_scoped.h"
 
 // DPI exports, defined in prim_util_memload.svh
 extern "C" {
-void simutil_memload(const char *file);
 int simutil_set_mem(int index, const svBitVecVal *val);
 int simutil_get_mem(int index, svBitVecVal *val);
 }
@@ -25,8 +25,8 @@ MemArea::MemArea(const std::string &scope, uint32_t num_words,
   assert(width_byte <= SV_MEM_WIDTH_BYTES);
 }
 
-void MemArea::Write(uint32_t word_offset,
-                    const std::vector<uint8_t> &data) const {
+void MemArea::Write(uint32_t word_offset, const uint8_t *data,
+                    size_t len) const {
   // This "mini buffer" is used to transfer each write to SystemVerilog.
   // `simutil_set_mem` takes a fixed SV_MEM_WIDTH_BITS-bit vector but it will
   // only use the bits required for the RAM width. As an example, for a 32-bit
@@ -38,14 +38,26 @@ void MemArea::Write(uint32_t word_offset,
   memset(minibuf, 0, sizeof minibuf);
   assert(width_byte_ <= sizeof minibuf);
 
-  uint32_t data_words = (data.size() + width_byte_ - 1) / width_byte_;
+  uint32_t data_words = (len + width_byte_ - 1) / width_byte_;
   assert(word_offset + data_words <= num_words_);
 
+  // If len isn't a multiple of the word width, the last word is zero-extended
+  // in here so that WriteBuffer can always read a full word.
+  uint8_t last_word[SV_MEM_WIDTH_BYTES];
+
   for (uint32_t i = 0; i < data_words; ++i) {
     uint32_t dst_word = word_offset + i;
     uint32_t phys_addr = ToPhysAddr(dst_word);
 
-    WriteBuffer(minibuf, data, i * width_byte_, dst_word);
+    const uint8_t *src = data + (size_t)i * width_byte_;
+    size_t avail = len - (size_t)i * width_byte_;
+    if (avail < width_byte_) {
+      memset(last_word, 0, width_byte_);
+      memcpy(last_word, src, avail);
+      src = last_word;
+    }
+
+    WriteBuffer(minibuf, src, dst_word);
 
     // Both ToPhysAddr and WriteBuffer might set the scope with `SVScoped` so
     // only construct `SVScoped` once they've both been called so they don't
@@ -103,20 +115,38 @@ std::vector<uint8_t> MemArea::Read(uint32_t word_offset,
 }
 
 void MemArea::LoadVmem(const std::string &path) const {
-  SVScoped scoped(scope_.c_str());
-  // TODO: Add error handling.
-  simutil_memload(path.c_str());
+  MemImage img = ReadVmemFile(path);
+  if (img.word_bytes > SV_MEM_WIDTH_BYTES) {
+    std::ostringstream oss;
+    oss << "vmem file `" << path << "' has " << img.word_bytes * 8
+        << "-bit words, but at most " << SV_MEM_WIDTH_BITS
+        << " bits are supported.";
+    throw std::runtime_error(oss.str());
+  }
+
+  // Like $readmemh, this writes the words from the file to the physical
+  // memory as they are, with no address translation.
+  uint8_t minibuf[SV_MEM_WIDTH_BYTES];
+  memset(minibuf, 0, sizeof minibuf);
+
+  SVScoped scoped(scope_);
+  for (const MemImageSeg &seg : img.segs) {
+    uint32_t num_words = seg.data.size() / img.word_bytes;
+    for (uint32_t i = 0; i < num_words; ++i) {
+      memcpy(minibuf, &seg.data[i * img.word_bytes], img.word_bytes);
+      if (!simutil_set_mem(seg.addr + i, (svBitVecVal *)minibuf)) {
+        std::ostringstream oss;
+        oss << "Could not set memory at word offset 0x" << std::hex
+            << seg.addr + i << " when loading `" << path << "'.";
+        throw std::runtime_error(oss.str());
+      }
+    }
+  }
 }
 
-void MemArea::WriteBuffer(uint8_t buf[SV_MEM_WIDTH_BYTES],
-                          const std::vector<uint8_t> &data, size_t start_idx,
+void MemArea::WriteBuffer(uint8_t buf[SV_MEM_WIDTH_BYTES], const uint8_t *data,
                           uint32_t dst_word) const {
-  size_t words_left = data.size() - start_idx;
-  size_t to_copy = std::min(words_left, (size_t)width_byte_);
-  if (to_copy < width_byte_) {
-    memset(buf, 0, SV_MEM_WIDTH_BYTES);
-  }
-  memcpy(buf, &data[start_idx], to_copy);
+  memcpy(buf, data, width_byte_);
 }
 
 void MemArea::ReadBuffer(std::vector<uint8_t> &data,
@@ -5,6 +5,7 @@
 #ifndef OPENTITAN_HW_DV_VERILATOR_CPP_MEM_AREA_H_
 #define OPENTITAN_HW_DV_VERILATOR_CPP_MEM_AREA_H_
 
+#include <cstddef>
 #include <cstdint>
 #include <string>
 #include <vector>
@@ -27,8 +28,7 @@ class MemArea {
    *
    * @param scope  The SystemVerilog scope where the instantiated memory can be
    *               found. This needs to support the DPI-C interfaces \c
-   *               simutil_memload and \c simutil_set_mem (used for vmem and
-   *               ELF files, respectively).
+   *               simutil_set_mem and \c simutil_get_mem.
    *
    * @param size   The size of the memory in bytes (must be positive and a
    *               multiple of \p width_byte)
@@ -49,11 +49,22 @@ class MemArea {
    *                    written.
    *
    * @param data        The data that should be written. If the length is not a
-   *                    multiple of \p word_offset, the last word will be
+   *                    multiple of \p width_byte, the last word will be
    *                    zero-extended.
    */
-  virtual void Write(uint32_t word_offset,
-                     const std::vector<uint8_t> &data) const;
+  void Write(uint32_t word_offset, const std::vector<uint8_t> &data) const {
+    Write(word_offset, data.data(), data.size());
+  }
+
+  /** Write \p len bytes starting at \p data to this memory area at the given
+   * word offset
+   *
+   * This behaves like the std::vector overload above, but lets callers pass
+   * data that they don't own (such as a segment in a memory-mapped ELF file)
+   * without copying it first.
+   */
+  virtual void Write(uint32_t word_offset, const uint8_t *data,
+                     size_t len) const;
 
   /** Read data from this memory area, starting at the given offset.
    *
@@ -71,7 +82,13 @@ class MemArea {
   virtual std::vector<uint8_t> Read(uint32_t word_offset,
                                     uint32_t num_words) const;
 
-  /** Use \c simutil_memload to load a vmem file into the memory */
+  /** Load a vmem file into the memory
+   *
+   * The file is parsed in C++ (see ReadVmemFile()) and each word is written to
+   * the physical memory with \c simutil_set_mem. Throws an SVScoped::Error if
+   * the scope cannot be set and a \c std::runtime_error if the file can't be
+   * parsed or a word can't be written.
+   */
   virtual void LoadVmem(const std::string &path) const;
 
   const std::string &GetScope() const { return scope_; }
@@ -80,6 +97,13 @@ class MemArea {
   uint32_t GetWidthByte() const { return width_byte_; }
   uint32_t GetWidth() const { return 8 * width_byte_; }
 
+  /** Return true if logical word N is stored at physical word N
+   *
+   * Subclasses that override ToPhysAddr() should override this to return
+   * false.
+   */
+  virtual bool HasLinearAddrMap() const { return true; }
+
  protected:
   std::string scope_;    ///< Design scope (used for accesses over DPI)
   uint32_t num_words_;   ///< Size of the memory area in words
@@ -94,12 +118,12 @@ class MemArea {
    * further up (this is done outside of the loop).
    *
    * @param buf       Destination buffer
-   * @param data      A large buffer that contains the data to be written
-   * @param start_idx An offset into \p data for the start of the memory word
+   * @param data      The \p width_byte_ bytes of logical data for the word. If
+   *                  the data passed to Write() has a ragged end, the last word
+   *                  is zero-extended before calling this.
    * @param dst_word  Logical address of the location being written
    */
-  virtual void WriteBuffer(uint8_t buf[SV_MEM_WIDTH_BYTES],
-                           const std::vector<uint8_t> &data, size_t start_idx,
+  virtual void WriteBuffer(uint8_t buf[SV_MEM_WIDTH_BYTES], const uint8_t *data,
                            uint32_t dst_word) const;
 
   /** Extract the logical memory contents corresponding to the physical
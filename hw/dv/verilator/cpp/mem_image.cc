@@ -0,0 +1,414 @@
+// Copyright lowRISC contributors.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+#include "mem_image.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+// Convenience class for runtime errors when parsing an image file
+class ImageError : public std::runtime_error {
+ public:
+  ImageError(const std::string &path, size_t line, const std::string &msg)
+      : std::runtime_error(MakeMsg(path, line, msg)) {}
+
+ private:
+  static std::string MakeMsg(const std::string &path, size_t line,
+                             const std::string &msg) {
+    std::ostringstream oss;
+    oss << "Failed to parse `" << path << "' at line " << line << ": " << msg;
+    return oss.str();
+  }
+};
+}  // namespace
+
+// The cache directory, as set by SetMemImageCacheDir
+static std::string cache_dir;
+
+// Bump this if the format of cached images (or the parsers) change, so that
+// stale cache entries are ignored.
+static const uint32_t kCacheVersion = 1;
+static const char kCacheMagic[8] = {'O', 'T', 'M', 'E', 'M', 'I', 'M', 'G'};
+
+void SetMemImageCacheDir(const std::string &dir) { cache_dir = dir; }
+
+// Read the whole file at path into a string
+static std::string ReadFile(const std::string &path) {
+  std::ifstream is(path, std::ios::binary | std::ios::ate);
+  if (!is) {
+    std::ostringstream oss;
+    oss << "Could not open file `" << path << "'.";
+    throw std::runtime_error(oss.str());
+  }
+
+  std::string ret(is.tellg(), '\0');
+  is.seekg(0);
+  if (!is.read(&ret[0], ret.size())) {
+    std::ostringstream oss;
+    oss << "Could not read file `" << path << "'.";
+    throw std::runtime_error(oss.str());
+  }
+  return ret;
+}
+
+// 64-bit FNV-1a hash. This is only used to name cache entries (which also
+// record the file size), so it doesn't need to be cryptographically strong.
+static uint64_t HashContents(const std::string &data) {
+  uint64_t hash = 0xcbf29ce484222325ULL;
+  for (unsigned char c : data) {
+    hash = (hash ^ c) * 0x100000001b3ULL;
+  }
+  return hash;
+}
+
+static int HexDigit(char c) {
+  if ('0' <= c && c <= '9')
+    return c - '0';
+  if ('a' <= c && c <= 'f')
+    return c - 'a' + 10;
+  if ('A' <= c && c <= 'F')
+    return c - 'A' + 10;
+  return -1;
+}
+
+// Call fn(is_addr, begin, end, line) for each token in the vmem file text.
+// Address tokens are passed without their leading '@'. Skips whitespace and
+// C/C++ style comments.
+template <typename Fn>
+static void ForEachVmemToken(const std::string &path, const std::string &text,
+                             Fn fn) {
+  const char *p = text.data();
+  const char *end = p + text.size();
+  size_t line = 1;
+
+  while (p < end) {
+    char c = *p;
+    if (c == '\n') {
+      ++line;
+      ++p;
+    } else if (isspace((unsigned char)c)) {
+      ++p;
+    } else if (c == '/' && p + 1 < end && p[1] == '/') {
+      while (p < end && *p != '\n')
+        ++p;
+    } else if (c == '/' && p + 1 < end && p[1] == '*') {
+      size_t start_line = line;
+      p += 2;
+      while (p + 1 < end && !(p[0] == '*' && p[1] == '/')) {
+        if (*p == '\n')
+          ++line;
+        ++p;
+      }
+      if (p + 1 >= end) {
+        throw ImageError(path, start_line, "unterminated comment.");
+      }
+      p += 2;
+    } else {
+      bool is_addr = (c == '@');
+      const char *tok = is_addr ? p + 1 : p;
+      const char *tok_end = tok;
+      while (tok_end < end && !isspace((unsigned char)*tok_end) &&
+             *tok_end != '/')
+        ++tok_end;
+      if (tok == tok_end) {
+        throw ImageError(path, line, "unexpected character.");
+      }
+      fn(is_addr, tok, tok_end, line);
+      p = tok_end;
+    }
+  }
+}
+
+static MemImage ParseVmem(const std::string &path, const std::string &text) {
+  // The first pass finds the widest data word, which gives the word size.
+  size_t max_digits = 1;
+  ForEachVmemToken(path, text,
+                   [&](bool is_addr, const char *tok, const char *tok_end,
+                       size_t line) {
+                     if (is_addr)
+                       return;
+                     size_t digits = 0;
+                     for (const char *q = tok; q < tok_end; ++q) {
+                       if (*q == '_')
+                         continue;
+                       if (HexDigit(*q) < 0) {
+                         std::ostringstream oss;
+                         oss << "invalid data word `"
+                             << std::string(tok, tok_end) << "'.";
+                         throw ImageError(path, line, oss.str());
+                       }
+                       ++digits;
+                     }
+                     max_digits = std::max(max_digits, digits);
+                   });
+
+  MemImage img;
+  img.word_bytes = (max_digits + 1) / 2;
+
+  // The second pass converts the data. Addresses start at zero, like
+  // $readmemh.
+  MemImageSeg *seg = nullptr;
+  uint32_t next_addr = 0;
+  ForEachVmemToken(
+      path, text,
+      [&](bool is_addr, const char *tok, const char *tok_end, size_t line) {
+        if (is_addr) {
+          uint64_t addr = 0;
+          for (const char *q = tok; q < tok_end; ++q) {
+            int d = HexDigit(*q);
+            if (*q == '_')
+              continue;
+            if (d < 0 || (addr << 4) >> 32) {
+              std::ostringstream oss;
+              oss << "invalid address `@" << std::string(tok, tok_end)
+                  << "'.";
+              throw ImageError(path, line, oss.str());
+            }
+            addr = (addr << 4) | d;
+          }
+          next_addr = addr;
+          seg = nullptr;
+          return;
+        }
+
+        if (!seg) {
+          img.segs.push_back({next_addr, {}});
+          seg = &img.segs.back();
+        }
+
+        // Convert the word, least significant digit first
+        size_t base = seg->data.size();
+        seg->data.resize(base + img.word_bytes, 0);
+        size_t nibble = 0;
+        for (const char *q = tok_end; q > tok; --q) {
+          if (q[-1] == '_')
+            continue;
+          uint8_t d = HexDigit(q[-1]);
+          seg->data[base + nibble / 2] |= d << (4 * (nibble % 2));
+          ++nibble;
+        }
+        ++next_addr;
+      });
+
+  return img;
+}
+
+// Parse the hex digits at p[0] and p[1] as a byte, or return -1
+static int HexByte(const char *p) {
+  int hi = HexDigit(p[0]), lo = HexDigit(p[1]);
+  return (hi < 0 || lo < 0) ? -1 : (hi << 4) | lo;
+}
+
+static MemImage ParseIhex(const std::string &path, const std::string &text) {
+  MemImage img;
+  img.word_bytes = 1;
+
+  const char *p = text.data();
+  const char *end = p + text.size();
+  size_t line = 0;
+  uint32_t base = 0;
+  uint8_t rec[255 + 5];
+
+  while (p < end) {
+    const char *eol = static_cast<const char *>(memchr(p, '\n', end - p));
+    if (!eol)
+      eol = end;
+    const char *line_end = eol;
+    ++line;
+
+    // Skip surrounding whitespace (including \r from DOS line endings)
+    while (p < line_end && isspace((unsigned char)*p))
+      ++p;
+    while (line_end > p && isspace((unsigned char)line_end[-1]))
+      --line_end;
+
+    if (p == line_end) {
+      p = eol + 1;
+      continue;
+    }
+
+    if (*p != ':' || (line_end - p) % 2 != 1 || line_end - p < 11) {
+      throw ImageError(path, line, "malformed record.");
+    }
+
+    size_t rec_len = (line_end - p - 1) / 2;
+    if (rec_len > sizeof rec) {
+      throw ImageError(path, line, "record too long.");
+    }
+    uint8_t sum = 0;
+    for (size_t i = 0; i < rec_len; ++i) {
+      int b = HexByte(p + 1 + 2 * i);
+      if (b < 0) {
+        throw ImageError(path, line, "invalid hex digit.");
+      }
+      rec[i] = b;
+      sum += b;
+    }
+    if (rec[0] + 5u != rec_len) {
+      throw ImageError(path, line, "record length doesn't match byte count.");
+    }
+    if (sum != 0) {
+      throw ImageError(path, line, "bad checksum.");
+    }
+
+    uint32_t offset = (rec[1] << 8) | rec[2];
+    const uint8_t *data = &rec[4];
+    size_t data_len = rec[0];
+
+    switch (rec[3]) {
+      case 0x00: {  // Data
+        uint32_t addr = base + offset;
+        MemImageSeg *last = img.segs.empty() ? nullptr : &img.segs.back();
+        if (last && last->addr + last->data.size() == addr) {
+          last->data.insert(last->data.end(), data, data + data_len);
+        } else if (data_len) {
+          img.segs.push_back(
+              {addr, std::vector<uint8_t>(data, data + data_len)});
+        }
+        break;
+      }
+      case 0x01:  // End of file
+        return img;
+      case 0x02:  // Extended segment address
+      case 0x04:  // Extended linear address
+        if (data_len != 2) {
+          throw ImageError(path, line, "bad extended address record.");
+        }
+        base = ((data[0] << 8) | data[1]) << (rec[3] == 0x02 ? 4 : 16);
+        break;
+      case 0x03:  // Start segment address
+      case 0x05:  // Start linear address
+        break;
+      default: {
+        std::ostringstream oss;
+        oss << "unknown record type 0x" << std::hex << (int)rec[3] << ".";
+        throw ImageError(path, line, oss.str());
+      }
+    }
+
+    p = eol + 1;
+  }
+
+  return img;
+}
+
+// Try to load a cached image from cache_path. Returns false (leaving img in an
+// unspecified state) if there is no valid entry.
+static bool LoadCachedImage(const std::string &cache_path, MemImage &img) {
+  std::ifstream is(cache_path, std::ios::binary);
+  if (!is)
+    return false;
+
+  char magic[sizeof kCacheMagic];
+  uint32_t hdr[3];
+  if (!is.read(magic, sizeof magic) ||
+      memcmp(magic, kCacheMagic, sizeof magic) != 0 ||
+      !is.read(reinterpret_cast<char *>(hdr), sizeof hdr) ||
+      hdr[0] != kCacheVersion) {
+    return false;
+  }
+
+  img.word_bytes = hdr[1];
+  img.segs.resize(hdr[2]);
+  for (MemImageSeg &seg : img.segs) {
+    uint32_t seg_hdr[2];
+    if (!is.read(reinterpret_cast<char *>(seg_hdr), sizeof seg_hdr))
+      return false;
+    seg.addr = seg_hdr[0];
+    seg.data.resize(seg_hdr[1]);
+    if (!is.read(reinterpret_cast<char *>(seg.data.data()), seg_hdr[1]))
+      return false;
+  }
+  return true;
+}
+
+// Write img to cache_path. The cache is just an optimisation, so failures are
+// ignored. The entry is written to a temporary file and then renamed, so
+// concurrent simulations never see a partial entry.
+static void StoreCachedImage(const std::string &cache_path,
+                             const MemImage &img) {
+  if (mkdir(cache_dir.c_str(), 0777) != 0 && errno != EEXIST)
+    return;
+
+  std::ostringstream tmp_oss;
+  tmp_oss << cache_path << ".tmp." << getpid();
+  std::string tmp_path = tmp_oss.str();
+
+  {
+    std::ofstream os(tmp_path, std::ios::binary);
+    uint32_t hdr[3] = {kCacheVersion, img.word_bytes,
+                       (uint32_t)img.segs.size()};
+    os.write(kCacheMagic, sizeof kCacheMagic);
+    os.write(reinterpret_cast<const char *>(hdr), sizeof hdr);
+    for (const MemImageSeg &seg : img.segs) {
+      uint32_t seg_hdr[2] = {seg.addr, (uint32_t)seg.data.size()};
+      os.write(reinterpret_cast<const char *>(seg_hdr), sizeof seg_hdr);
+      os.write(reinterpret_cast<const char *>(seg.data.data()),
+               seg.data.size());
+    }
+    if (!os) {
+      os.close();
+      unlink(tmp_path.c_str());
+      return;
+    }
+  }
+
+  if (rename(tmp_path.c_str(), cache_path.c_str()) != 0) {
+    unlink(tmp_path.c_str());
+  }
+}
+
+// Read and parse the file at path, going through the cache if there is one.
+// tag names the file format and is part of the cache key.
+static MemImage ReadCached(const std::string &path, const char *tag,
+                           MemImage (*parse)(const std::string &,
+                                             const std::string &)) {
+  std::string text = ReadFile(path);
+  if (cache_dir.empty())
+    return parse(path, text);
+
+  std::ostringstream oss;
+  oss << cache_dir << "/" << tag << "-" << std::hex << std::setw(16)
+      << std::setfill('0') << HashContents(text) << "-" << std::dec
+      << text.size() << ".img";
+  std::string cache_path = oss.str();
+
+  MemImage img;
+  if (LoadCachedImage(cache_path, img))
+    return img;
+
+  img = parse(path, text);
+  StoreCachedImage(cache_path, img);
+  return img;
+}
+
+MemImage ReadVmemFile(const std::string &path) {
+  return ReadCached(path, "vmem", ParseVmem);
+}
+
+MemImage ReadIhexFile(const std::string &path) {
+  return ReadCached(path, "ihex", ParseIhex);
+}
+
+MemImage ReadBinFile(const std::string &path, uint32_t offset) {
+  std::string data = ReadFile(path);
+
+  MemImage img;
+  img.word_bytes = 1;
+  if (!data.empty()) {
+    img.segs.push_back(
+        {offset, std::vector<uint8_t>(data.begin(), data.end())});
+  }
+  return img;
+}
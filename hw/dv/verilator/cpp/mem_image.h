@@ -0,0 +1,61 @@
+// Copyright lowRISC contributors.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+#ifndef OPENTITAN_HW_DV_VERILATOR_CPP_MEM_IMAGE_H_
+#define OPENTITAN_HW_DV_VERILATOR_CPP_MEM_IMAGE_H_
+
+// Readers for memory image files (vmem, Intel HEX and raw binary)
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// A run of consecutive words in a memory image
+struct MemImageSeg {
+  uint32_t addr;              // Address of the first word, in words
+  std::vector<uint8_t> data;  // word_bytes bytes per word, little-endian
+};
+
+// A parsed memory image. Segments appear in file order and may overlap, in
+// which case later segments take precedence.
+struct MemImage {
+  uint32_t word_bytes;
+  std::vector<MemImageSeg> segs;
+};
+
+/**
+ * Set a directory for caching parsed vmem and Intel HEX files
+ *
+ * Parsed images are stored in |dir| under a hash of the file contents, so that
+ * later loads of an identical file skip parsing. The directory is created if
+ * it doesn't exist. An empty |dir| (the default) disables the cache.
+ */
+void SetMemImageCacheDir(const std::string &dir);
+
+/**
+ * Read a vmem file
+ *
+ * Addresses in the file are word addresses. Each data word becomes
+ * word_bytes bytes in the image, where word_bytes is enough to hold the widest
+ * word in the file. Throws a std::runtime_error if the file can't be read or
+ * parsed.
+ */
+MemImage ReadVmemFile(const std::string &path);
+
+/**
+ * Read an Intel HEX file
+ *
+ * The result has byte addresses (word_bytes is 1). Supports data, end of file
+ * and extended segment/linear address records; start address records are
+ * ignored. Throws a std::runtime_error if the file can't be read or parsed.
+ */
+MemImage ReadIhexFile(const std::string &path);
+
+/**
+ * Read a raw binary file as a single segment starting at byte offset |offset|
+ *
+ * Throws a std::runtime_error if the file can't be read.
+ */
+MemImage ReadBinFile(const std::string &path, uint32_t offset);
+
+#endif  // OPENTITAN_HW_DV_VERILATOR_CPP_MEM_IMAGE_H_
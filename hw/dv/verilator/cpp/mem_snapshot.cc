@@ -0,0 +1,435 @@
+// Copyright lowRISC contributors.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+#include "mem_snapshot.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <stdexcept>
+
+// Bump this if the file format changes.
+static const uint32_t kSnapshotVersion = 1;
+static const char kSnapshotMagic[8] = {'O', 'T', 'M', 'E', 'M', 'S', 'N', 'P'};
+
+// Encodings of a stored page in a snapshot file
+enum PageEncoding : uint32_t {
+  kPageRaw = 0,
+  kPageRle = 1,
+};
+
+const uint32_t MemSnapshot::kPageBytes;
+const uint32_t MemSnapshot::kZeroPage;
+const uint32_t MemSnapshot::kOnesPage;
+
+static const uint8_t kZeroBytes[MemSnapshot::kPageBytes] = {0};
+
+static const uint8_t *GetOnesBytes() {
+  static uint8_t ones[MemSnapshot::kPageBytes];
+  static bool init = false;
+  if (!init) {
+    memset(ones, 0xff, sizeof ones);
+    init = true;
+  }
+  return ones;
+}
+
+// 64-bit FNV-1a hash, used to find duplicate pages (which are then compared
+// in full).
+static uint64_t HashPage(const uint8_t *data, size_t len) {
+  uint64_t hash = 0xcbf29ce484222325ULL;
+  for (size_t i = 0; i < len; ++i) {
+    hash = (hash ^ data[i]) * 0x100000001b3ULL;
+  }
+  return hash;
+}
+
+static bool AllBytes(const uint8_t *data, size_t len, uint8_t value) {
+  for (size_t i = 0; i < len; ++i) {
+    if (data[i] != value)
+      return false;
+  }
+  return true;
+}
+
+// Run-length encode data in the PackBits format. A control byte c < 128 is
+// followed by c + 1 literal bytes; a control byte c >= 128 is followed by a
+// single byte that is repeated 257 - c times.
+static std::vector<uint8_t> RleEncode(const std::vector<uint8_t> &data) {
+  std::vector<uint8_t> out;
+  size_t i = 0;
+  while (i < data.size()) {
+    size_t run = 1;
+    while (i + run < data.size() && run < 128 && data[i + run] == data[i])
+      ++run;
+
+    if (run >= 3) {
+      out.push_back(257 - run);
+      out.push_back(data[i]);
+      i += run;
+      continue;
+    }
+
+    // Collect literals until the next run of at least three bytes
+    size_t start = i;
+    while (i < data.size() && i - start < 128) {
+      if (i + 2 < data.size() && data[i] == data[i + 1] &&
+          data[i] == data[i + 2])
+        break;
+      ++i;
+    }
+    out.push_back(i - start - 1);
+    out.insert(out.end(), data.begin() + start, data.begin() + i);
+  }
+  return out;
+}
+
+// Decode len bytes of PackBits data. Returns false if the data is malformed.
+static bool RleDecode(const uint8_t *data, size_t enc_len, size_t len,
+                      std::vector<uint8_t> &out) {
+  out.clear();
+  out.reserve(len);
+  size_t i = 0;
+  while (i < enc_len) {
+    uint8_t ctrl = data[i++];
+    if (ctrl < 128) {
+      size_t n = ctrl + 1;
+      if (i + n > enc_len)
+        return false;
+      out.insert(out.end(), data + i, data + i + n);
+      i += n;
+    } else {
+      if (i >= enc_len)
+        return false;
+      out.insert(out.end(), 257 - ctrl, data[i++]);
+    }
+  }
+  return out.size() == len;
+}
+
+void MemSnapshot::AddMemory(const std::string &name, uint32_t base,
+                            const MemArea &mem_area) {
+  if (mems_.count(name)) {
+    std::ostringstream oss;
+    oss << "A memory called `" << name << "' is already in the snapshot.";
+    throw std::runtime_error(oss.str());
+  }
+
+  // Read in page-sized chunks, which keeps the vector growing smoothly.
+  uint32_t width_byte = mem_area.GetWidthByte();
+  uint32_t chunk_words = std::max<uint32_t>(1, kPageBytes / width_byte);
+  std::vector<uint8_t> data;
+  data.reserve(mem_area.GetSizeBytes());
+  for (uint32_t word = 0; word < mem_area.GetSizeWords();
+       word += chunk_words) {
+    uint32_t n = std::min(chunk_words, mem_area.GetSizeWords() - word);
+    std::vector<uint8_t> chunk = mem_area.Read(word, n);
+    data.insert(data.end(), chunk.begin(), chunk.end());
+  }
+
+  AddMemory(name, base, width_byte, data);
+}
+
+void MemSnapshot::AddMemory(const std::string &name, uint32_t base,
+                            uint32_t width_byte,
+                            const std::vector<uint8_t> &data) {
+  Memory &mem = mems_[name];
+  mem.base = base;
+  mem.width_byte = width_byte;
+  mem.size_bytes = data.size();
+  mem.pages.clear();
+  for (size_t off = 0; off < data.size(); off += kPageBytes) {
+    size_t len = std::min<size_t>(kPageBytes, data.size() - off);
+    mem.pages.push_back(AddPage(&data[off], len));
+  }
+}
+
+uint32_t MemSnapshot::AddPage(const uint8_t *data, size_t len) {
+  if (AllBytes(data, len, 0))
+    return kZeroPage;
+  if (AllBytes(data, len, 0xff))
+    return kOnesPage;
+
+  uint64_t hash = HashPage(data, len);
+  auto range = pool_index_.equal_range(hash);
+  for (auto it = range.first; it != range.second; ++it) {
+    const std::vector<uint8_t> &page = pool_[it->second];
+    if (page.size() == len && memcmp(page.data(), data, len) == 0)
+      return it->second;
+  }
+
+  uint32_t ref = pool_.size();
+  pool_.emplace_back(data, data + len);
+  pool_hashes_.push_back(hash);
+  pool_index_.emplace(hash, ref);
+  return ref;
+}
+
+const uint8_t *MemSnapshot::GetPage(uint32_t ref) const {
+  if (ref == kZeroPage)
+    return kZeroBytes;
+  if (ref == kOnesPage)
+    return GetOnesBytes();
+  return pool_[ref].data();
+}
+
+std::vector<uint8_t> MemSnapshot::GetContents(const std::string &name) const {
+  auto it = mems_.find(name);
+  if (it == mems_.end()) {
+    std::ostringstream oss;
+    oss << "No memory called `" << name << "' in the snapshot.";
+    throw std::runtime_error(oss.str());
+  }
+
+  const Memory &mem = it->second;
+  std::vector<uint8_t> data;
+  data.reserve(mem.size_bytes);
+  for (size_t i = 0; i < mem.pages.size(); ++i) {
+    size_t len = std::min<size_t>(kPageBytes, mem.size_bytes - i * kPageBytes);
+    const uint8_t *page = GetPage(mem.pages[i]);
+    data.insert(data.end(), page, page + len);
+  }
+  return data;
+}
+
+size_t MemSnapshot::GetNumPages() const {
+  size_t num_pages = 0;
+  for (const auto &pr : mems_) {
+    num_pages += pr.second.pages.size();
+  }
+  return num_pages;
+}
+
+static void WriteWord(std::ofstream &os, uint32_t word) {
+  os.write(reinterpret_cast<const char *>(&word), sizeof word);
+}
+
+void MemSnapshot::Save(const std::string &path) const {
+  std::ofstream os(path, std::ios::binary);
+  if (!os) {
+    std::ostringstream oss;
+    oss << "Could not open `" << path << "' for writing.";
+    throw std::runtime_error(oss.str());
+  }
+
+  os.write(kSnapshotMagic, sizeof kSnapshotMagic);
+  WriteWord(os, kSnapshotVersion);
+  WriteWord(os, kPageBytes);
+  WriteWord(os, pool_.size());
+  WriteWord(os, mems_.size());
+
+  for (const std::vector<uint8_t> &page : pool_) {
+    std::vector<uint8_t> rle = RleEncode(page);
+    bool use_rle = rle.size() < page.size();
+    const std::vector<uint8_t> &enc = use_rle ? rle : page;
+    WriteWord(os, page.size());
+    WriteWord(os, use_rle ? kPageRle : kPageRaw);
+    WriteWord(os, enc.size());
+    os.write(reinterpret_cast<const char *>(enc.data()), enc.size());
+  }
+
+  for (const auto &pr : mems_) {
+    const Memory &mem = pr.second;
+    WriteWord(os, pr.first.size());
+    os.write(pr.first.data(), pr.first.size());
+    WriteWord(os, mem.base);
+    WriteWord(os, mem.width_byte);
+    WriteWord(os, mem.size_bytes);
+    os.write(reinterpret_cast<const char *>(mem.pages.data()),
+             mem.pages.size() * sizeof(uint32_t));
+  }
+
+  if (!os) {
+    std::ostringstream oss;
+    oss << "Failed to write snapshot to `" << path << "'.";
+    throw std::runtime_error(oss.str());
+  }
+}
+
+namespace {
+// Reads little-endian fields from a snapshot file held in memory, throwing a
+// std::runtime_error if the file is too short.
+class SnapshotReader {
+ public:
+  SnapshotReader(const std::string &path, std::vector<char> &&data)
+      : path_(path), data_(std::move(data)), pos_(0) {}
+
+  const uint8_t *Bytes(size_t len) {
+    if (data_.size() - pos_ < len)
+      Fail("the file is truncated");
+    const uint8_t *ret = reinterpret_cast<const uint8_t *>(&data_[pos_]);
+    pos_ += len;
+    return ret;
+  }
+
+  uint32_t Word() {
+    uint32_t word;
+    memcpy(&word, Bytes(sizeof word), sizeof word);
+    return word;
+  }
+
+  [[noreturn]] void Fail(const std::string &msg) const {
+    std::ostringstream oss;
+    oss << "Failed to load snapshot from `" << path_ << "': " << msg << ".";
+    throw std::runtime_error(oss.str());
+  }
+
+ private:
+  std::string path_;
+  std::vector<char> data_;
+  size_t pos_;
+};
+}  // namespace
+
+MemSnapshot MemSnapshot::Load(const std::string &path) {
+  std::ifstream is(path, std::ios::binary);
+  if (!is) {
+    std::ostringstream oss;
+    oss << "Could not open snapshot file `" << path << "'.";
+    throw std::runtime_error(oss.str());
+  }
+  SnapshotReader rd(path, std::vector<char>(std::istreambuf_iterator<char>(is),
+                                            std::istreambuf_iterator<char>()));
+
+  if (memcmp(rd.Bytes(sizeof kSnapshotMagic), kSnapshotMagic,
+             sizeof kSnapshotMagic) != 0)
+    rd.Fail("it is not a memory snapshot");
+  if (rd.Word() != kSnapshotVersion)
+    rd.Fail("unsupported version");
+  if (rd.Word() != kPageBytes)
+    rd.Fail("unsupported page size");
+
+  MemSnapshot snap;
+  uint32_t num_stored = rd.Word();
+  uint32_t num_mems = rd.Word();
+
+  std::vector<uint8_t> page;
+  for (uint32_t i = 0; i < num_stored; ++i) {
+    uint32_t len = rd.Word();
+    uint32_t encoding = rd.Word();
+    uint32_t enc_len = rd.Word();
+    const uint8_t *enc = rd.Bytes(enc_len);
+    if (len == 0 || len > kPageBytes)
+      rd.Fail("bad page size");
+
+    if (encoding == kPageRaw && enc_len == len) {
+      page.assign(enc, enc + len);
+    } else if (encoding != kPageRle || !RleDecode(enc, enc_len, len, page)) {
+      rd.Fail("bad page encoding");
+    }
+
+    uint64_t hash = HashPage(page.data(), len);
+    snap.pool_.push_back(page);
+    snap.pool_hashes_.push_back(hash);
+    snap.pool_index_.emplace(hash, i);
+  }
+
+  for (uint32_t i = 0; i < num_mems; ++i) {
+    uint32_t name_len = rd.Word();
+    const uint8_t *name_bytes = rd.Bytes(name_len);
+    std::string name(reinterpret_cast<const char *>(name_bytes), name_len);
+
+    Memory &mem = snap.mems_[name];
+    mem.base = rd.Word();
+    mem.width_byte = rd.Word();
+    mem.size_bytes = rd.Word();
+    size_t num_pages = (mem.size_bytes + kPageBytes - 1) / kPageBytes;
+    mem.pages.resize(num_pages);
+    for (size_t j = 0; j < num_pages; ++j) {
+      uint32_t ref = rd.Word();
+      if (ref != kZeroPage && ref != kOnesPage &&
+          (ref >= num_stored ||
+           snap.pool_[ref].size() !=
+               std::min<size_t>(kPageBytes, mem.size_bytes - j * kPageBytes)))
+        rd.Fail("bad page reference");
+      mem.pages[j] = ref;
+    }
+  }
+
+  return snap;
+}
+
+// Append a difference of size bytes at offset in mem, merging it with the
+// previous one if they touch.
+static void AddDiff(std::vector<MemSnapshotDiff> &diffs, const std::string &mem,
+                    uint32_t offset, uint32_t size) {
+  if (!diffs.empty()) {
+    MemSnapshotDiff &last = diffs.back();
+    if (last.mem == mem && last.offset + last.size == offset) {
+      last.size += size;
+      return;
+    }
+  }
+  diffs.push_back({mem, offset, size});
+}
+
+std::vector<MemSnapshotDiff> MemSnapshot::Diff(const MemSnapshot &other) const {
+  std::vector<MemSnapshotDiff> diffs;
+
+  auto a_it = mems_.begin();
+  auto b_it = other.mems_.begin();
+  while (a_it != mems_.end() || b_it != other.mems_.end()) {
+    // Memories that only appear on one side differ as a whole
+    if (b_it == other.mems_.end() ||
+        (a_it != mems_.end() && a_it->first < b_it->first)) {
+      AddDiff(diffs, a_it->first, 0, a_it->second.size_bytes);
+      ++a_it;
+      continue;
+    }
+    if (a_it == mems_.end() || b_it->first < a_it->first) {
+      AddDiff(diffs, b_it->first, 0, b_it->second.size_bytes);
+      ++b_it;
+      continue;
+    }
+
+    const std::string &name = a_it->first;
+    const Memory &a = a_it->second;
+    const Memory &b = b_it->second;
+    uint32_t common = std::min(a.size_bytes, b.size_bytes);
+    size_t common_pages = (common + kPageBytes - 1) / kPageBytes;
+    for (size_t i = 0; i < common_pages; ++i) {
+      uint32_t ref_a = a.pages[i], ref_b = b.pages[i];
+      bool blank_a = ref_a == kZeroPage || ref_a == kOnesPage;
+      bool blank_b = ref_b == kZeroPage || ref_b == kOnesPage;
+
+      // Blank pages are equal exactly if they're the same kind of blank, and
+      // a stored page is never blank. Stored pages can only be equal if their
+      // hashes match, so only those are compared in full.
+      if (blank_a && blank_b && ref_a == ref_b)
+        continue;
+
+      uint32_t off = i * kPageBytes;
+      uint32_t len = std::min<uint32_t>(kPageBytes, common - off);
+      const uint8_t *pa = GetPage(ref_a);
+      const uint8_t *pb = other.GetPage(ref_b);
+      bool same_hash = !blank_a && !blank_b &&
+                       pool_hashes_[ref_a] == other.pool_hashes_[ref_b];
+      if (same_hash && memcmp(pa, pb, len) == 0)
+        continue;
+
+      uint32_t j = 0;
+      while (j < len) {
+        if (pa[j] == pb[j]) {
+          ++j;
+          continue;
+        }
+        uint32_t start = j;
+        while (j < len && pa[j] != pb[j])
+          ++j;
+        AddDiff(diffs, name, off + start, j - start);
+      }
+    }
+
+    uint32_t larger = std::max(a.size_bytes, b.size_bytes);
+    if (larger > common)
+      AddDiff(diffs, name, common, larger - common);
+
+    ++a_it;
+    ++b_it;
+  }
+
+  return diffs;
+}
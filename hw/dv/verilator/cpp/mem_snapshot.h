@@ -0,0 +1,113 @@
+// Copyright lowRISC contributors.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+#ifndef OPENTITAN_HW_DV_VERILATOR_CPP_MEM_SNAPSHOT_H_
+#define OPENTITAN_HW_DV_VERILATOR_CPP_MEM_SNAPSHOT_H_
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "mem_area.h"
+
+// A run of bytes that differs between two snapshots
+struct MemSnapshotDiff {
+  std::string mem;  // Name of the memory
+  uint32_t offset;  // Byte offset in the memory
+  uint32_t size;    // Number of bytes
+};
+
+/**
+ * A snapshot of the logical contents of some memories
+ *
+ * Memories are split into pages of kPageBytes. Pages that are all zeros or all
+ * ones aren't stored at all, and identical pages (in any memory) are only
+ * stored once. When saved to a file, each stored page is also run-length
+ * encoded. This keeps snapshots of large, mostly empty memories small enough to
+ * keep one per test.
+ */
+class MemSnapshot {
+ public:
+  static const uint32_t kPageBytes = 4096;
+
+  /**
+   * Read the whole of |mem_area| and add it to the snapshot as |name|
+   *
+   * Throws a std::runtime_error if a memory called |name| was already added,
+   * or if reading the memory fails.
+   */
+  void AddMemory(const std::string &name, uint32_t base,
+                 const MemArea &mem_area);
+
+  /**
+   * Add |data| to the snapshot as the contents of a memory called |name|
+   */
+  void AddMemory(const std::string &name, uint32_t base, uint32_t width_byte,
+                 const std::vector<uint8_t> &data);
+
+  /**
+   * Get the contents of the memory called |name|
+   *
+   * Throws a std::runtime_error if there is no such memory.
+   */
+  std::vector<uint8_t> GetContents(const std::string &name) const;
+
+  /**
+   * Write the snapshot to a file, throwing a std::runtime_error on failure
+   */
+  void Save(const std::string &path) const;
+
+  /**
+   * Read a snapshot written by Save()
+   *
+   * Throws a std::runtime_error if the file can't be read or is malformed.
+   */
+  static MemSnapshot Load(const std::string &path);
+
+  /**
+   * Find the bytes that differ between this snapshot and |other|
+   *
+   * Memories are matched by name. A memory that only appears in one of the
+   * snapshots, or the end of a memory that is larger in one of them, is
+   * reported as differing. Ranges are returned in order of memory name and
+   * offset, with adjacent differences merged.
+   */
+  std::vector<MemSnapshotDiff> Diff(const MemSnapshot &other) const;
+
+  // The number of memory pages, and the number of pages that are stored
+  // (neither blank nor duplicates)
+  size_t GetNumPages() const;
+  size_t GetNumStoredPages() const { return pool_.size(); }
+
+ private:
+  // Page references for blank pages
+  static const uint32_t kZeroPage = 0xffffffff;
+  static const uint32_t kOnesPage = 0xfffffffe;
+
+  struct Memory {
+    uint32_t base;
+    uint32_t width_byte;
+    uint32_t size_bytes;
+    // An index into |pool_| or a blank page reference for each page
+    std::vector<uint32_t> pages;
+  };
+
+  // Find or add a page, returning its reference
+  uint32_t AddPage(const uint8_t *data, size_t len);
+
+  // Get the contents of a page (which may be shorter than kPageBytes at the
+  // end of a memory)
+  const uint8_t *GetPage(uint32_t ref) const;
+
+  // Memories, keyed by name
+  std::map<std::string, Memory> mems_;
+
+  // Stored pages and their hashes, and an index from hash to page
+  std::vector<std::vector<uint8_t>> pool_;
+  std::vector<uint64_t> pool_hashes_;
+  std::unordered_multimap<uint64_t, uint32_t> pool_index_;
+};
+
+#endif  // OPENTITAN_HW_DV_VERILATOR_CPP_MEM_SNAPSHOT_H_
@@ -6,8 +6,11 @@
 
 // Utility class representing disjoint segments of memory
 
+#include <algorithm>
 #include <cassert>
 #include <map>
+#include <utility>
+#include <vector>
 
 // The type used to represent address ranges. This is essentially a std::pair,
 // but we need a operator< custom for the internal map.
@@ -32,9 +35,13 @@ class RangedMap {
   typedef val_t (*MergeFun)(const rng_t &rng0, val_t &&val0, const rng_t &rng1,
                             val_t &&val1);
 
+  // An entry for EmplaceMany(): an address range and its value
+  using entry_t = std::pair<rng_t, val_t>;
+
   // Insert an entry that covers the address range [min_addr, max_addr]
-  // (inclusive) with value val.
-  void Emplace(addr_t min_addr, addr_t max_addr, val_t &&new_val,
+  // (inclusive) with value val. Returns true if it was merged with existing
+  // entries.
+  bool Emplace(addr_t min_addr, addr_t max_addr, val_t &&new_val,
                MergeFun merge) {
     assert(min_addr <= max_addr);
 
@@ -72,7 +79,7 @@ class RangedMap {
     // case, we can just insert it.
     if (hit_lo == hit_hi) {
       map_.insert(std::make_pair(rng, std::move(new_val)));
-      return;
+      return false;
     }
 
     // Otherwise, we use the merge function to merge everything together.
@@ -97,6 +104,73 @@ class RangedMap {
     map_.erase(hit_lo, hit_hi);
     rng_t rng1 = {.lo = min_addr, .hi = max_addr};
     map_.insert(std::make_pair(rng1, std::move(acc)));
+    return true;
+  }
+
+  // Insert all of entries, with the same result as calling Emplace() for each
+  // of them in order (so later entries take precedence where they overlap).
+  //
+  // If the map is empty, this sorts the entries by address and coalesces
+  // overlapping ones in a single pass, taking O(n log n) time rather than
+  // walking the map for every entry. Returns true if any entries were merged.
+  bool EmplaceMany(std::vector<entry_t> &&entries, MergeFun merge) {
+    if (!map_.empty()) {
+      bool merged = false;
+      for (entry_t &entry : entries) {
+        merged |= Emplace(entry.first.lo, entry.first.hi,
+                          std::move(entry.second), merge);
+      }
+      return merged;
+    }
+
+    // Sort indices by base address, so that we can still tell which of two
+    // overlapping entries came later.
+    std::vector<size_t> order(entries.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+      assert(entries[i].first.lo <= entries[i].first.hi);
+      order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+      return entries[a].first.lo < entries[b].first.lo ||
+             (entries[a].first.lo == entries[b].first.lo && a < b);
+    });
+
+    // Sweep through in address order, collecting each group of overlapping
+    // entries. A group of one is inserted as it is. Otherwise, its entries are
+    // merged in their original order. Two entries that are merged early on
+    // needn't overlap each other, but the group as a whole covers the gap
+    // between them, so the merge function will see it filled in later.
+    bool merged = false;
+    std::vector<size_t> group;
+    for (size_t pos = 0; pos < order.size();) {
+      group.assign(1, order[pos]);
+      addr_t group_hi = entries[order[pos]].first.hi;
+      ++pos;
+      while (pos < order.size() && entries[order[pos]].first.lo <= group_hi) {
+        group.push_back(order[pos]);
+        group_hi = std::max(group_hi, entries[order[pos]].first.hi);
+        ++pos;
+      }
+
+      if (group.size() > 1) {
+        std::sort(group.begin(), group.end());
+        merged = true;
+      }
+
+      rng_t acc_rng = entries[group[0]].first;
+      val_t acc = std::move(entries[group[0]].second);
+      for (size_t i = 1; i < group.size(); ++i) {
+        entry_t &entry = entries[group[i]];
+        acc = merge(acc_rng, std::move(acc), entry.first,
+                    std::move(entry.second));
+        acc_rng.lo = std::min(acc_rng.lo, entry.first.lo);
+        acc_rng.hi = std::max(acc_rng.hi, entry.first.hi);
+      }
+
+      // Groups come in address order, so each one goes at the end.
+      map_.emplace_hint(map_.end(), acc_rng, std::move(acc));
+    }
+    return merged;
   }
 
   // Try to insert an entry that covers the address range [min_addr, max_addr]
@@ -180,4 +254,47 @@ class RangedMap {
   std::map<rng_t, val_t> map_;
 };
 
+// A read-only copy of a RangedMap, stored in sorted vectors.
+//
+// Looking up an address is a binary search over contiguous base addresses,
+// which avoids chasing pointers through the tree nodes of a std::map. Use this
+// for maps that are built once and then looked up many times.
+template <typename addr_t, typename val_t>
+class FlatRangedMap {
+ public:
+  using rng_t = AddrRange<addr_t>;
+
+  FlatRangedMap() {}
+  explicit FlatRangedMap(const RangedMap<addr_t, val_t> &map) {
+    los_.reserve(map.size());
+    his_.reserve(map.size());
+    vals_.reserve(map.size());
+    for (const auto &pr : map) {
+      los_.push_back(pr.first.lo);
+      his_.push_back(pr.first.hi);
+      vals_.push_back(pr.second);
+    }
+  }
+
+  size_t size() const { return vals_.size(); }
+
+  // Return the value of the entry containing addr, or nullptr if there is
+  // none.
+  const val_t *find(addr_t addr) const {
+    // Find the first entry that starts strictly above addr, then step back
+    // (like RangedMap::find).
+    auto it = std::upper_bound(los_.begin(), los_.end(), addr);
+    if (it == los_.begin())
+      return nullptr;
+
+    size_t idx = (it - los_.begin()) - 1;
+    return (addr <= his_[idx]) ? &vals_[idx] : nullptr;
+  }
+
+ private:
+  std::vector<addr_t> los_;
+  std::vector<addr_t> his_;
+  std::vector<val_t> vals_;
+};
+
 #endif  // OPENTITAN_HW_DV_VERILATOR_CPP_RANGED_MAP_H_
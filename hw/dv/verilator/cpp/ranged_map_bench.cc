@@ -0,0 +1,135 @@
+// Copyright lowRISC contributors.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+// Host benchmark for RangedMap.
+//
+// Models staging an image with many small segments (like an OTBN binary with
+// a section per function, or a coverage-instrumented image), some of which
+// overlap. It compares
+//  - inserting the segments one at a time with Emplace() against inserting
+//    them all at once with EmplaceMany(), checking that both give the same
+//    result, and
+//  - looking up random addresses with RangedMap::find() against
+//    FlatRangedMap::find().
+//
+// RangedMap is header-only, so this builds on its own:
+//
+//   g++ -O2 -std=c++14 -o ranged_map_bench ranged_map_bench.cc
+//   ./ranged_map_bench [num_segments] [num_lookups]
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "ranged_map.h"
+
+using Bytes = std::vector<uint8_t>;
+using Map = RangedMap<uint32_t, Bytes>;
+
+// Merge two segments, with seg1 taking precedence (like MergeSegments() in
+// dpi_memutil.cc)
+static Bytes Merge(const AddrRange<uint32_t> &rng0, Bytes &&seg0,
+                   const AddrRange<uint32_t> &rng1, Bytes &&seg1) {
+  uint32_t lo = std::min(rng0.lo, rng1.lo);
+  uint32_t hi = std::max(rng0.hi, rng1.hi);
+  Bytes ret(1 + hi - lo);
+  memcpy(&ret[rng0.lo - lo], seg0.data(), seg0.size());
+  memcpy(&ret[rng1.lo - lo], seg1.data(), seg1.size());
+  return ret;
+}
+
+static double Seconds(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                       start)
+      .count();
+}
+
+int main(int argc, char **argv) {
+  size_t num_segs = argc > 1 ? strtoul(argv[1], nullptr, 0) : 10000;
+  size_t num_lookups = argc > 2 ? strtoul(argv[2], nullptr, 0) : 1000000;
+
+  // Segments of 4 to 256 bytes, spread over an address space with room for
+  // about twice their total size. Their order is shuffled, and about one in
+  // twenty lands on top of its neighbour.
+  std::mt19937 rng(1);
+  std::vector<Map::entry_t> segs;
+  uint32_t addr = 0;
+  for (size_t i = 0; i < num_segs; ++i) {
+    uint32_t len = 4 + rng() % 253;
+    uint32_t gap = rng() % 20 == 0 ? 0 : rng() % (2 * len);
+    addr = gap ? addr + gap : addr - (addr ? 1 : 0);
+    Bytes data(len, (uint8_t)i);
+    segs.emplace_back(AddrRange<uint32_t>{.lo = addr, .hi = addr + len - 1},
+                      std::move(data));
+    addr += len;
+  }
+  std::shuffle(segs.begin(), segs.end(), rng);
+  uint32_t top = addr;
+
+  std::vector<Map::entry_t> copy = segs;
+  auto start = std::chrono::steady_clock::now();
+  Map one_by_one;
+  for (auto &pr : copy) {
+    one_by_one.Emplace(pr.first.lo, pr.first.hi, std::move(pr.second), Merge);
+  }
+  double emplace_time = Seconds(start);
+
+  copy = segs;
+  start = std::chrono::steady_clock::now();
+  Map bulk;
+  bulk.EmplaceMany(std::move(copy), Merge);
+  double bulk_time = Seconds(start);
+
+  bool same = one_by_one.size() == bulk.size();
+  auto b = bulk.begin();
+  for (auto a = one_by_one.begin(); same && a != one_by_one.end(); ++a, ++b) {
+    same = a->first.lo == b->first.lo && a->first.hi == b->first.hi &&
+           a->second == b->second;
+  }
+  if (!same) {
+    std::cerr << "ERROR: Emplace() and EmplaceMany() disagree." << std::endl;
+    return 1;
+  }
+
+  std::vector<uint32_t> addrs(num_lookups);
+  for (uint32_t &a : addrs) {
+    a = rng() % top;
+  }
+
+  start = std::chrono::steady_clock::now();
+  size_t tree_hits = 0;
+  for (uint32_t a : addrs) {
+    tree_hits += bulk.find(a) != bulk.end();
+  }
+  double tree_time = Seconds(start);
+
+  FlatRangedMap<uint32_t, Bytes> flat(bulk);
+  start = std::chrono::steady_clock::now();
+  size_t flat_hits = 0;
+  for (uint32_t a : addrs) {
+    flat_hits += flat.find(a) != nullptr;
+  }
+  double flat_time = Seconds(start);
+
+  if (tree_hits != flat_hits) {
+    std::cerr << "ERROR: RangedMap and FlatRangedMap disagree." << std::endl;
+    return 1;
+  }
+
+  std::cout << num_segs << " segments, coalesced into " << bulk.size()
+            << " ranges:\n"
+            << "  Emplace():     " << emplace_time * 1e3 << " ms\n"
+            << "  EmplaceMany(): " << bulk_time * 1e3 << " ms\n"
+            << num_lookups << " lookups (" << tree_hits << " hits):\n"
+            << "  RangedMap:     " << tree_time * 1e9 / num_lookups
+            << " ns per lookup\n"
+            << "  FlatRangedMap: " << flat_time * 1e9 / num_lookups
+            << " ns per lookup" << std::endl;
+  return 0;
+}
@@ -151,11 +151,10 @@ uint32_t ScrambledEcc32MemArea::GetNonceWidthByte() const {
 }
 
 void ScrambledEcc32MemArea::WriteBuffer(uint8_t buf[SV_MEM_WIDTH_BYTES],
-                                        const std::vector<uint8_t> &data,
-                                        size_t start_idx,
+                                        const uint8_t *data,
                                         uint32_t dst_word) const {
   // Compute integrity
-  Ecc32MemArea::WriteBuffer(buf, data, start_idx, dst_word);
+  Ecc32MemArea::WriteBuffer(buf, data, dst_word);
 
   std::vector<uint8_t> scramble_buf =
       std::vector<uint8_t>(buf, buf + GetPhysWidthByte());
@@ -0,0 +1,263 @@
+// Copyright lowRISC contributors.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+#include "sw_profiler.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdlib>
+#include <fstream>
+#include <getopt.h>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+#include "verilator_sim_ctrl.h"
+
+// The profiler that the DPI functions report to (see the class comment)
+static SwProfiler *active_profiler = nullptr;
+
+// The number of functions to list at the end of the simulation
+static const size_t kTopFuncsShown = 10;
+
+const uint32_t SwProfiler::kDefaultPeriod;
+const size_t SwProfiler::kMaxDepth;
+const uint32_t SwProfiler::kUnknownFunc;
+const uint32_t SwProfiler::kNoReturn;
+
+// Print a usage message to stdout
+static void PrintHelp() {
+  std::cout << "Software profiling:\n\n"
+               "--sw-profile=FILE\n"
+               "  Sample the PC of the simulated core and write a profile to\n"
+               "  FILE as folded stacks (needs a simulation built with\n"
+               "  RVFI)\n\n"
+               "--sw-profile-period=N\n"
+               "  Take a sample every N cycles (default: "
+            << SwProfiler::kDefaultPeriod
+            << ")\n\n"
+               "-h|--help\n"
+               "  Show help\n\n";
+}
+
+SwProfiler::SwProfiler(const DpiMemUtil *mem_util)
+    : mem_util_(mem_util),
+      period_(kDefaultPeriod),
+      overflow_depth_(0),
+      num_samples_(0) {
+  assert(mem_util);
+  active_profiler = this;
+}
+
+SwProfiler::~SwProfiler() {
+  if (active_profiler == this) {
+    active_profiler = nullptr;
+  }
+}
+
+bool SwProfiler::ParseCLIArguments(int argc, char **argv, bool &exit_app) {
+  const struct option long_options[] = {
+      {"sw-profile", required_argument, nullptr, 'P'},
+      {"sw-profile-period", required_argument, nullptr, 'N'},
+      {"help", no_argument, nullptr, 'h'},
+      {nullptr, no_argument, nullptr, 0}};
+
+  // Reset the command parsing index in-case other utils have already parsed
+  // some arguments
+  optind = 1;
+  while (1) {
+    int c = getopt_long(argc, argv, ":h", long_options, nullptr);
+    if (c == -1) {
+      break;
+    }
+
+    // Disable error reporting by getopt
+    opterr = 0;
+
+    switch (c) {
+      case 0:
+        break;
+      case 'P':
+        out_path_ = optarg;
+        break;
+      case 'N': {
+        char *end;
+        unsigned long val = strtoul(optarg, &end, 0);
+        if (*end || val == 0 || val > UINT32_MAX) {
+          std::cerr << "ERROR: invalid sample period: `" << optarg << "'."
+                    << std::endl;
+          return false;
+        }
+        period_ = val;
+        break;
+      }
+      case 'h':
+        PrintHelp();
+        return true;
+      case ':':  // missing argument
+        std::cerr << "ERROR: Missing argument." << std::endl << std::endl;
+        return false;
+      case '?':
+      default:;
+        // Ignore unrecognized options since they might be consumed by
+        // other utils
+    }
+  }
+
+  return true;
+}
+
+uint32_t SwProfiler::GetFunc(uint32_t addr, uint32_t fallback) const {
+  const ElfFuncSymbol *sym = mem_util_->FindFuncSymbol(addr);
+  return sym ? sym->addr : fallback;
+}
+
+std::string SwProfiler::GetFuncName(uint32_t func) const {
+  if (func == kUnknownFunc) {
+    return "[unknown]";
+  }
+
+  const ElfFuncSymbol *sym = mem_util_->FindFuncSymbol(func);
+  if (sym && sym->addr == func) {
+    return sym->name;
+  }
+
+  std::ostringstream oss;
+  oss << "0x" << std::hex << std::setw(8) << std::setfill('0') << func;
+  return oss.str();
+}
+
+void SwProfiler::OnCall(uint32_t target, uint32_t ret_addr) {
+  if (stack_.size() == kMaxDepth) {
+    ++overflow_depth_;
+    return;
+  }
+
+  // The first call needs a frame for its caller too, which we can find from
+  // the return address (just after the call instruction). This frame is never
+  // returned from.
+  if (stack_.empty()) {
+    stack_.push_back(
+        {.func = GetFunc(ret_addr - 1, kUnknownFunc), .ret_addr = kNoReturn});
+  }
+
+  // Name a call to code outside any function by its target, so that it still
+  // shows up as a separate frame.
+  stack_.push_back({.func = GetFunc(target, target), .ret_addr = ret_addr});
+}
+
+void SwProfiler::OnReturn(uint32_t target) {
+  if (overflow_depth_) {
+    --overflow_depth_;
+    return;
+  }
+
+  // Pop the frame that returns to target, along with any frames above it.
+  // Those were left by calls that never returned (to noreturn functions, or
+  // out of a longjmp). A return that doesn't match any frame, like an
+  // interrupt handler returning, leaves the stack alone.
+  for (size_t i = stack_.size(); i > 0; --i) {
+    if (stack_[i - 1].ret_addr == target) {
+      stack_.resize(i - 1);
+      return;
+    }
+  }
+}
+
+void SwProfiler::OnSample(uint32_t pc) {
+  std::vector<uint32_t> key;
+  key.reserve(stack_.size() + 1);
+  for (const Frame &frame : stack_) {
+    key.push_back(frame.func);
+  }
+
+  // The innermost frame is usually the function containing pc, in which case
+  // there's no need to add it again.
+  uint32_t leaf = GetFunc(pc, kUnknownFunc);
+  if (key.empty() || key.back() != leaf) {
+    key.push_back(leaf);
+  }
+
+  ++samples_[key];
+  ++num_samples_;
+}
+
+void SwProfiler::WriteFolded(std::ostream &os) const {
+  for (const auto &pr : samples_) {
+    const std::vector<uint32_t> &funcs = pr.first;
+    for (size_t i = 0; i < funcs.size(); ++i) {
+      os << (i ? ";" : "") << GetFuncName(funcs[i]);
+    }
+    os << " " << pr.second << "\n";
+  }
+}
+
+void SwProfiler::PostExec() {
+  if (out_path_.empty()) {
+    return;
+  }
+
+  if (!num_samples_) {
+    std::cout << "No software profile samples were taken. Was the simulation "
+                 "built with RVFI?"
+              << std::endl;
+    return;
+  }
+
+  std::ofstream os(out_path_);
+  WriteFolded(os);
+  os.close();
+  if (!os) {
+    std::cerr << "ERROR: Failed to write software profile to `" << out_path_
+              << "'." << std::endl;
+    VerilatorSimCtrl::GetInstance().RequestStop(false);
+    return;
+  }
+
+  std::cout << "Wrote software profile with " << num_samples_
+            << " samples to `" << out_path_ << "'." << std::endl;
+
+  // Print the functions with the most samples of their own (where the PC was
+  // in the function, rather than in something it called)
+  std::map<uint32_t, uint64_t> self;
+  for (const auto &pr : samples_) {
+    self[pr.first.back()] += pr.second;
+  }
+  std::vector<std::pair<uint64_t, uint32_t>> top;
+  for (const auto &pr : self) {
+    top.emplace_back(pr.second, pr.first);
+  }
+  size_t num_shown = std::min(top.size(), kTopFuncsShown);
+  std::partial_sort(top.begin(), top.begin() + num_shown, top.end(),
+                    std::greater<std::pair<uint64_t, uint32_t>>());
+
+  std::cout << "Functions with the most samples:" << std::endl;
+  for (size_t i = 0; i < num_shown; ++i) {
+    std::cout << "  " << std::fixed << std::setprecision(1) << std::setw(5)
+              << 100.0 * top[i].first / num_samples_ << "%  "
+              << GetFuncName(top[i].second) << std::endl;
+  }
+}
+
+extern "C" unsigned sw_profiler_period() {
+  return active_profiler ? active_profiler->GetPeriod() : 0;
+}
+
+extern "C" void sw_profiler_call(unsigned target, unsigned ret_addr) {
+  if (active_profiler) {
+    active_profiler->OnCall(target, ret_addr);
+  }
+}
+
+extern "C" void sw_profiler_return(unsigned target) {
+  if (active_profiler) {
+    active_profiler->OnReturn(target);
+  }
+}
+
+extern "C" void sw_profiler_sample(unsigned pc) {
+  if (active_profiler) {
+    active_profiler->OnSample(pc);
+  }
+}
@@ -0,0 +1,112 @@
+// Copyright lowRISC contributors.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+#ifndef OPENTITAN_HW_DV_VERILATOR_CPP_SW_PROFILER_H_
+#define OPENTITAN_HW_DV_VERILATOR_CPP_SW_PROFILER_H_
+
+#include <cstdint>
+#include <iosfwd>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "dpi_memutil.h"
+#include "sim_ctrl_extension.h"
+
+/**
+ * A sampling profiler for software running on the simulated core
+ *
+ * The testbench reports calls and returns of the core (by watching its retire
+ * interface) to keep a shadow call stack, and samples the PC of the last
+ * retired instruction every few cycles. Each sample is counted against its
+ * call stack, symbolised with the function symbols of the ELF files that the
+ * DpiMemUtil has loaded.
+ *
+ * At the end of the simulation, the counts are written out as "folded stacks"
+ * (one line per stack, with frames separated by semicolons and followed by a
+ * count), which flamegraph.pl, speedscope and similar tools read directly.
+ *
+ * The testbench talks to the profiler through the sw_profiler_* DPI functions
+ * below. Only one profiler can be active at once: the last one constructed.
+ */
+class SwProfiler : public SimCtrlExtension {
+ public:
+  // The default number of cycles between samples
+  static const uint32_t kDefaultPeriod = 1000;
+
+  // The deepest call stack that is tracked. Calls beyond this depth are
+  // counted against the deepest frame.
+  static const size_t kMaxDepth = 256;
+
+  // Make a profiler that symbolises with mem_util, which must outlive it
+  explicit SwProfiler(const DpiMemUtil *mem_util);
+  ~SwProfiler() override;
+
+  // Declared in SimCtrlExtension
+  bool ParseCLIArguments(int argc, char **argv, bool &exit_app) override;
+  void PostExec() override;
+
+  // The number of cycles between samples, or zero if profiling is disabled
+  uint32_t GetPeriod() const { return out_path_.empty() ? 0 : period_; }
+
+  // Handle a call to target, which will return to ret_addr
+  void OnCall(uint32_t target, uint32_t ret_addr);
+
+  // Handle a return to target
+  void OnReturn(uint32_t target);
+
+  // Take a sample with pc as the current PC
+  void OnSample(uint32_t pc);
+
+  // Write the samples so far to os as folded stacks
+  void WriteFolded(std::ostream &os) const;
+
+ private:
+  // Stands in for the function of a PC that isn't in any function symbol
+  static const uint32_t kUnknownFunc = 0xffffffff;
+
+  // The return address of the outermost frame, which doesn't match any return
+  static const uint32_t kNoReturn = 0xffffffff;
+
+  struct Frame {
+    uint32_t func;  // Start of the called function, or the call target
+    uint32_t ret_addr;
+  };
+
+  // Get the address of the function containing addr, or |fallback| if there
+  // is none
+  uint32_t GetFunc(uint32_t addr, uint32_t fallback) const;
+
+  // Get the name of a function returned by GetFunc()
+  std::string GetFuncName(uint32_t func) const;
+
+  const DpiMemUtil *mem_util_;
+
+  std::string out_path_;
+  uint32_t period_;
+
+  std::vector<Frame> stack_;
+  size_t overflow_depth_;
+
+  // Sample counts, keyed by the function addresses of each stack (outermost
+  // first, ending with the function containing the sampled PC)
+  std::map<std::vector<uint32_t>, uint64_t> samples_;
+  uint64_t num_samples_;
+};
+
+extern "C" {
+// The number of cycles between samples, or zero if profiling is disabled
+unsigned sw_profiler_period();
+
+// Report a call to target (the PC of the next instruction) that links
+// ret_addr
+void sw_profiler_call(unsigned target, unsigned ret_addr);
+
+// Report a return to target
+void sw_profiler_return(unsigned target);
+
+// Take a sample with pc as the current PC
+void sw_profiler_sample(unsigned pc);
+}
+
+#endif  // OPENTITAN_HW_DV_VERILATOR_CPP_SW_PROFILER_H_
@@ -6,6 +6,8 @@
 
 #include <array>
 #include <cassert>
+#include <cstdint>
+#include <cstdlib>
 #include <cstring>
 #include <getopt.h>
 #include <iostream>
@@ -13,6 +15,9 @@
 #include <string>
 #include <vector>
 
+#include "mem_image.h"
+#include "verilator_sim_ctrl.h"
+
 namespace {
 // An instruction to load the file at filepath to the memory called name. If
 // name is the empty string then type must be kMemImageElf and this is an
@@ -21,18 +26,20 @@ struct LoadArg {
   std::string name;
   std::string filepath;
   MemImageType type;
+  uint32_t offset;
 };
 }  // namespace
 
 // Parse a meminit command-line argument. This should be of the form
-// mem_area,file[,type]. Throw a std::runtime_error if something looks wrong.
+// mem_area,file[,type[,offset]]. Throw a std::runtime_error if something looks
+// wrong.
 static LoadArg ParseMemArg(std::string mem_argument) {
-  std::array<std::string, 3> args;
+  std::array<std::string, 4> args;
   size_t pos = 0;
   size_t end_pos = 0;
   size_t i;
 
-  for (i = 0; i < 3; ++i) {
+  for (i = 0; i < 4; ++i) {
     end_pos = mem_argument.find(",", pos);
     // Check for possible exit conditions
     if (pos == end_pos) {
@@ -49,9 +56,9 @@ static LoadArg ParseMemArg(std::string mem_argument) {
   }
   // mem_argument is not empty as getopt requires an argument,
   // but not a valid argument for memory initialization
-  if (i == 0) {
+  if (i == 0 || i == 4) {
     std::ostringstream oss;
-    oss << "meminit must be in the format `name,file[,type]'. Got: `"
+    oss << "meminit must be in the format `name,file[,type[,offset]]'. Got: `"
         << mem_argument << "'.";
     throw std::runtime_error(oss.str());
   }
@@ -59,27 +66,102 @@ static LoadArg ParseMemArg(std::string mem_argument) {
   const char *str_type = (2 <= i) ? args[2].c_str() : nullptr;
   MemImageType type = DpiMemUtil::GetMemImageType(args[1], str_type);
 
-  return {.name = args[0], .filepath = args[1], .type = type};
+  uint32_t offset = 0;
+  if (3 <= i) {
+    char *end;
+    unsigned long val = strtoul(args[3].c_str(), &end, 0);
+    if (*end || val > UINT32_MAX) {
+      std::ostringstream oss;
+      oss << "invalid offset: `" << args[3] << "'.";
+      throw std::runtime_error(oss.str());
+    }
+    offset = val;
+  }
+
+  return {.name = args[0], .filepath = args[1], .type = type, .offset = offset};
+}
+
+// The largest number of differences to list when comparing snapshots
+static const size_t kMaxDiffsShown = 16;
+
+// Print the differences between two snapshots to stdout
+static void PrintSnapshotDiffs(const std::vector<MemSnapshotDiff> &diffs) {
+  for (size_t i = 0; i < diffs.size() && i < kMaxDiffsShown; ++i) {
+    const MemSnapshotDiff &diff = diffs[i];
+    std::cout << "  " << diff.mem << ": " << std::dec << diff.size
+              << " bytes differ at offset 0x" << std::hex << diff.offset
+              << std::dec << std::endl;
+  }
+  if (diffs.size() > kMaxDiffsShown) {
+    std::cout << "  ... and " << diffs.size() - kMaxDiffsShown
+              << " more differences." << std::endl;
+  }
+}
+
+// Handle --mem-snapshot-diff, comparing the two snapshot files in arg (of the
+// form file_a,file_b). Returns true if they match.
+static bool DiffSnapshotFiles(const std::string &arg) {
+  size_t comma = arg.find(',');
+  if (comma == std::string::npos) {
+    std::cerr << "ERROR: mem-snapshot-diff must be in the format "
+                 "`file_a,file_b'. Got: `"
+              << arg << "'." << std::endl;
+    return false;
+  }
+
+  std::string path_a = arg.substr(0, comma), path_b = arg.substr(comma + 1);
+  std::vector<MemSnapshotDiff> diffs;
+  try {
+    diffs = MemSnapshot::Load(path_a).Diff(MemSnapshot::Load(path_b));
+  } catch (const std::exception &err) {
+    std::cerr << "ERROR: " << err.what() << std::endl;
+    return false;
+  }
+
+  if (diffs.empty()) {
+    std::cout << "Memory snapshots `" << path_a << "' and `" << path_b
+              << "' match." << std::endl;
+    return true;
+  }
+  std::cout << "Memory snapshots `" << path_a << "' and `" << path_b
+            << "' differ:" << std::endl;
+  PrintSnapshotDiffs(diffs);
+  return false;
 }
 
 // Print a usage message to stdout
 static void PrintHelp() {
   std::cout << "Simulation memory utilities:\n\n"
                "-r|--rominit=FILE\n"
-               "  Initialize the ROM with FILE (elf/vmem)\n\n"
+               "  Initialize the ROM with FILE (elf/vmem/bin/ihex)\n\n"
                "-m|--raminit=FILE\n"
-               "  Initialize the RAM with FILE (elf/vmem)\n\n"
+               "  Initialize the RAM with FILE (elf/vmem/bin/ihex)\n\n"
                "-f|--flashinit=FILE\n"
-               "  Initialize the FLASH with FILE (elf/vmem)\n\n"
-               "-l|--meminit=NAME,FILE[,TYPE]\n"
+               "  Initialize the FLASH with FILE (elf/vmem/bin/ihex)\n\n"
+               "-l|--meminit=NAME,FILE[,TYPE[,OFFSET]]\n"
                "  Initialize memory region NAME with FILE [of TYPE]\n"
-               "  TYPE is either 'elf' or 'vmem'\n\n"
+               "  TYPE is one of 'elf', 'vmem', 'bin' or 'ihex'\n"
+               "  OFFSET is a byte offset in NAME (only for 'bin')\n\n"
                "-E|--load-elf=FILE\n"
                "  Load ELF file, using segment LMAs to pick memory regions\n\n"
                "-l list|--meminit=list\n"
                "  Print registered memory regions\n\n"
+               "--mem-image-cache=DIR\n"
+               "  Cache parsed vmem and Intel HEX files in DIR\n\n"
+               "--lazy-mem-load\n"
+               "  Load elf/bin/ihex images into memories page by page, the\n"
+               "  first time that each page is accessed (needs a simulation\n"
+               "  built with SIMUTIL_LAZY_LOAD)\n\n"
                "--verbose-mem-load\n"
-               "  Print a message for each memory load\n\n"
+               "  Print a message and load statistics for each memory load\n\n"
+               "--mem-snapshot=FILE\n"
+               "  Write a snapshot of all memories to FILE at the end of the\n"
+               "  simulation\n\n"
+               "--mem-snapshot-check=FILE\n"
+               "  Compare all memories with the snapshot in FILE at the end\n"
+               "  of the simulation, and fail if they differ\n\n"
+               "--mem-snapshot-diff=FILE_A,FILE_B\n"
+               "  Compare two snapshot files and exit\n\n"
                "-h|--help\n"
                "  Show help\n\n";
 }
@@ -101,7 +183,12 @@ bool VerilatorMemUtil::ParseCLIArguments(int argc, char **argv,
       {"otpinit", required_argument, nullptr, 'o'},
       {"meminit", required_argument, nullptr, 'l'},
       {"verbose-mem-load", no_argument, nullptr, 'V'},
+      {"mem-image-cache", required_argument, nullptr, 'C'},
+      {"lazy-mem-load", no_argument, nullptr, 'L'},
       {"load-elf", required_argument, nullptr, 'E'},
+      {"mem-snapshot", required_argument, nullptr, 'S'},
+      {"mem-snapshot-check", required_argument, nullptr, 'K'},
+      {"mem-snapshot-diff", required_argument, nullptr, 'D'},
       {"help", no_argument, nullptr, 'h'},
       {nullptr, no_argument, nullptr, 0}};
 
@@ -157,10 +244,25 @@ bool VerilatorMemUtil::ParseCLIArguments(int argc, char **argv,
       case 'V':
         verbose = true;
         break;
+      case 'C':
+        SetMemImageCacheDir(optarg);
+        break;
+      case 'L':
+        mem_util_->SetLazyLoad(true);
+        break;
       case 'E':
         load_args.push_back(
             {.name = "", .filepath = optarg, .type = kMemImageElf});
         break;
+      case 'S':
+        snapshot_path_ = optarg;
+        break;
+      case 'K':
+        snapshot_check_path_ = optarg;
+        break;
+      case 'D':
+        exit_app = true;
+        return DiffSnapshotFiles(optarg);
       case 'h':
         PrintHelp();
         return true;
@@ -178,7 +280,7 @@ bool VerilatorMemUtil::ParseCLIArguments(int argc, char **argv,
     try {
       if (!arg.name.empty()) {
         mem_util_->LoadFileToNamedMem(verbose, arg.name, arg.filepath,
-                                      arg.type);
+                                      arg.type, arg.offset);
       } else {
         assert(arg.type == kMemImageElf);
         mem_util_->LoadElfToMemories(verbose, arg.filepath);
@@ -191,3 +293,41 @@ bool VerilatorMemUtil::ParseCLIArguments(int argc, char **argv,
 
   return true;
 }
+
+void VerilatorMemUtil::PostExec() {
+  if (!mem_util_->PrintLazyLoadStats()) {
+    VerilatorSimCtrl::GetInstance().RequestStop(false);
+  }
+
+  if (snapshot_path_.empty() && snapshot_check_path_.empty()) {
+    return;
+  }
+
+  try {
+    MemSnapshot snap = mem_util_->TakeSnapshot();
+
+    if (!snapshot_path_.empty()) {
+      snap.Save(snapshot_path_);
+      std::cout << "Wrote memory snapshot to `" << snapshot_path_ << "' ("
+                << snap.GetNumStoredPages() << " of " << snap.GetNumPages()
+                << " pages stored)." << std::endl;
+    }
+
+    if (!snapshot_check_path_.empty()) {
+      std::vector<MemSnapshotDiff> diffs =
+          MemSnapshot::Load(snapshot_check_path_).Diff(snap);
+      if (diffs.empty()) {
+        std::cout << "Memories match snapshot `" << snapshot_check_path_
+                  << "'." << std::endl;
+      } else {
+        std::cout << "Memories differ from snapshot `" << snapshot_check_path_
+                  << "':" << std::endl;
+        PrintSnapshotDiffs(diffs);
+        VerilatorSimCtrl::GetInstance().RequestStop(false);
+      }
+    }
+  } catch (const std::exception &err) {
+    std::cerr << "ERROR: " << err.what() << std::endl;
+    VerilatorSimCtrl::GetInstance().RequestStop(false);
+  }
+}
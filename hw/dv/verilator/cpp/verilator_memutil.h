@@ -9,6 +9,7 @@
 //
 
 #include <memory>
+#include <string>
 
 #include "dpi_memutil.h"
 #include "sim_ctrl_extension.h"
@@ -22,6 +23,7 @@ class VerilatorMemUtil : public SimCtrlExtension {
 
   // Declared in SimCtrlExtension
   bool ParseCLIArguments(int argc, char **argv, bool &exit_app) override;
+  void PostExec() override;
 
   // Get underlying DpiMemUtil object
   DpiMemUtil *GetUnderlying() { return mem_util_; }
@@ -35,6 +37,11 @@ class VerilatorMemUtil : public SimCtrlExtension {
  private:
   DpiMemUtil *mem_util_;
   std::unique_ptr<DpiMemUtil> allocation_;
+
+  // Snapshot files to write, and to compare the memories with, at the end of
+  // the simulation (unused if empty)
+  std::string snapshot_path_;
+  std::string snapshot_check_path_;
 };
 
 #endif  // OPENTITAN_HW_DV_VERILATOR_CPP_VERILATOR_MEMUTIL_H_
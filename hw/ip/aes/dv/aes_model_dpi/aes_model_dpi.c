@@ -8,6 +8,7 @@
 #include <string.h>
 
 #include "aes.h"
+#include "aes_fast.h"
 #include "crypto.h"
 #include "svdpi.h"
 
@@ -55,9 +56,20 @@ void c_dpi_aes_crypt_block(const unsigned char impl_i, const unsigned char op_i,
   assert(ref_out);
 
   if (impl == 0) {
-    // The C model does ECB only. We "emulate" other modes here.
+    // The C model does ECB only. We "emulate" other modes here. The
+    // table-based cipher computes the same function as aes_encrypt_block() /
+    // aes_decrypt_block() at a fraction of the cost.
     unsigned char data_in[16];
     unsigned char data_out[16];
+    aes_fast_key_t ks;
+    if (aes_fast_key_init(&ks, key, key_len)) {
+      printf("ERROR: Key expansion failed in c_dpi_aes_crypt_block\n");
+      free(ref_out);
+      free(iv);
+      free(key);
+      free(ref_in);
+      return;
+    }
 
     if (mode == kCryptoAesCbc) {
       if (!op) {
@@ -65,9 +77,9 @@ void c_dpi_aes_crypt_block(const unsigned char impl_i, const unsigned char op_i,
         for (int i = 0; i < 16; ++i) {
           data_in[i] = ref_in[i] ^ iv[i];
         }
-        aes_encrypt_block(data_in, key, key_len, ref_out);
+        aes_fast_encrypt_block(&ks, data_in, ref_out);
       } else {
-        aes_decrypt_block(ref_in, key, key_len, data_out);
+        aes_fast_decrypt_block(&ks, ref_in, data_out);
         // ref_out = data_out XOR iv (or previous data_out)
         for (int i = 0; i < 16; ++i) {
           ref_out[i] = data_out[i] ^ iv[i];
@@ -78,7 +90,7 @@ void c_dpi_aes_crypt_block(const unsigned char impl_i, const unsigned char op_i,
       for (int i = 0; i < 16; ++i) {
         data_in[i] = iv[i];
       }
-      aes_encrypt_block(data_in, key, key_len, data_out);
+      aes_fast_encrypt_block(&ks, data_in, data_out);
       // ref_out = data_out XOR ref_in
       for (int i = 0; i < 16; ++i) {
         ref_out[i] = data_out[i] ^ ref_in[i];
@@ -88,15 +100,15 @@ void c_dpi_aes_crypt_block(const unsigned char impl_i, const unsigned char op_i,
       for (int i = 0; i < 16; ++i) {
         data_in[i] = iv[i];
       }
-      aes_encrypt_block(data_in, key, key_len, data_out);
+      aes_fast_encrypt_block(&ks, data_in, data_out);
       for (int i = 0; i < 16; ++i) {
         ref_out[i] = data_out[i] ^ ref_in[i];
       }
     } else {  // ECB
       if (!op) {
-        aes_encrypt_block(ref_in, key, key_len, ref_out);
+        aes_fast_encrypt_block(&ks, ref_in, ref_out);
       } else {
-        aes_decrypt_block(ref_in, key, key_len, ref_out);
+        aes_fast_decrypt_block(&ks, ref_in, ref_out);
       }
     }
   } else {  // OpenSSL/BoringSSL
@@ -144,11 +156,12 @@ void c_dpi_aes_crypt_message(unsigned char impl_i, unsigned char op_i,
     key_len = 32;
   }
 
-  if (impl == 0) {
-    // The C model is currently not supported.
+  // Get message length.
+  int data_len = svSize(data_i, 1);
+  if ((int)data_len % 16) {
     printf(
-        "ERROR: c_dpi_aes_crypt_message() currently supports OpenSSL/BoringSSL "
-        "only\n");
+        "ERROR: Message length must be a multiple of 16 bytes (the block "
+        "size).\n");
     return;
   }
 
@@ -172,9 +185,6 @@ void c_dpi_aes_crypt_message(unsigned char impl_i, unsigned char op_i,
     memset(iv, 0, 16);
   }
 
-  // Get message length.
-  int data_len = svSize(data_i, 1);
-
   // Get input data from simulator.
   unsigned char *ref_in = aes_data_unpacked_get(data_i);
 
@@ -183,19 +193,14 @@ void c_dpi_aes_crypt_message(unsigned char impl_i, unsigned char op_i,
       (unsigned char *)malloc(data_len * sizeof(unsigned char));
   assert(ref_out);
 
-  // OpenSSL/BoringSSL
-  if ((int)data_len % 16) {
-    printf(
-        "ERROR: Message length must be a multiple of 16 bytes (the block "
-        "size).\n");
-    return;
-  }
-
   if (impl == 0) {
-    // The C model is currently not supported.
-    printf(
-        "ERROR: c_dpi_aes_crypt_message() currently supports OpenSSL/BoringSSL "
-        "only\n");
+    // The whole message is processed by the table-based implementation of the
+    // C model in a single call.
+    if (!op) {
+      aes_fast_encrypt(ref_out, iv, ref_in, data_len, key, key_len, mode);
+    } else {
+      aes_fast_decrypt(ref_out, iv, ref_in, data_len, key, key_len, mode);
+    }
   } else {  // OpenSSL/BoringSSL
     if (!op) {
       crypto_encrypt(ref_out, iv, ref_in, data_len, key, key_len, mode);
@@ -210,6 +215,7 @@ void c_dpi_aes_crypt_message(unsigned char impl_i, unsigned char op_i,
   // Free memory.
   free(iv);
   free(key);
+  free(ref_in);
 }
 
 void c_dpi_aes_sub_bytes(const unsigned char op_i, const svBitVecVal *data_i,
@@ -352,10 +358,17 @@ unsigned char *aes_data_unpacked_get(const svOpenArrayHandle data_i) {
   data = (unsigned char *)malloc(len * sizeof(unsigned char));
   assert(data);
 
-  // get data from simulator
-  for (int i = 0; i < len; i++) {
-    svGetBitArrElem1VecVal(&value, data_i, i);
-    data[i] = (unsigned char)value;
+  // get data from simulator, directly from its storage if it is contiguous
+  const svBitVecVal *arr = (const svBitVecVal *)svGetArrayPtr(data_i);
+  if (arr != NULL && svSizeOfArray(data_i) == len * (int)sizeof(svBitVecVal)) {
+    for (int i = 0; i < len; i++) {
+      data[i] = (unsigned char)arr[i];
+    }
+  } else {
+    for (int i = 0; i < len; i++) {
+      svGetBitArrElem1VecVal(&value, data_i, i);
+      data[i] = (unsigned char)value;
+    }
   }
 
   return data;
@@ -369,10 +382,18 @@ void aes_data_unpacked_put(const svOpenArrayHandle data_o,
   // get size of data buffer
   len = svSize(data_o, 1);
 
-  // write output data to simulation
-  for (int i = 0; i < len; i++) {
-    value = (svBitVecVal)data[i];
-    svPutBitArrElem1VecVal(data_o, &value, i);
+  // write output data to simulation, directly to its storage if it is
+  // contiguous
+  svBitVecVal *arr = (svBitVecVal *)svGetArrayPtr(data_o);
+  if (arr != NULL && svSizeOfArray(data_o) == len * (int)sizeof(svBitVecVal)) {
+    for (int i = 0; i < len; i++) {
+      arr[i] = (svBitVecVal)data[i];
+    }
+  } else {
+    for (int i = 0; i < len; i++) {
+      value = (svBitVecVal)data[i];
+      svPutBitArrElem1VecVal(data_o, &value, i);
+    }
   }
 
   // free data
@@ -0,0 +1,304 @@
+// Copyright lowRISC contributors.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+#include "aes_fast.h"
+
+#include <errno.h>
+#include <string.h>
+
+#include "aes.h"
+
+// NOTE: The state is handled as four 32-bit words, one per column, with the
+// byte in row r at bit position 8 * r, i.e., word c holds bytes
+// [4 * c, 4 * c + 3] of the block in little-endian order.
+
+// Forward tables: te[r][x] is the column contribution of SubBytes(x) in row r
+// after MixColumns.
+static uint32_t te[4][256];
+// Inverse tables: td[r][x] is the column contribution of InvSubBytes(x) in row
+// r after InvMixColumns.
+static uint32_t td[4][256];
+static int tables_ready;
+
+static unsigned char aes_fast_mul2(unsigned char in) {
+  return (unsigned char)((in << 1) ^ ((in & 0x80) ? 0x1b : 0x00));
+}
+
+static unsigned char aes_fast_mul(unsigned char a, unsigned char b) {
+  unsigned char res = 0;
+  while (b) {
+    if (b & 0x1) {
+      res ^= a;
+    }
+    a = aes_fast_mul2(a);
+    b >>= 1;
+  }
+  return res;
+}
+
+static uint32_t aes_fast_col(unsigned char b0, unsigned char b1,
+                             unsigned char b2, unsigned char b3) {
+  return (uint32_t)b0 | ((uint32_t)b1 << 8) | ((uint32_t)b2 << 16) |
+         ((uint32_t)b3 << 24);
+}
+
+static uint32_t aes_fast_rotl8(uint32_t x) { return (x << 8) | (x >> 24); }
+
+static void aes_fast_tables_init(void) {
+  if (tables_ready) {
+    return;
+  }
+
+  for (int x = 0; x < 256; ++x) {
+    unsigned char s = sbox[x];
+    unsigned char i = inv_sbox[x];
+    te[0][x] = aes_fast_col(aes_fast_mul(s, 2), s, s, aes_fast_mul(s, 3));
+    td[0][x] = aes_fast_col(aes_fast_mul(i, 14), aes_fast_mul(i, 9),
+                            aes_fast_mul(i, 13), aes_fast_mul(i, 11));
+    for (int r = 1; r < 4; ++r) {
+      te[r][x] = aes_fast_rotl8(te[r - 1][x]);
+      td[r][x] = aes_fast_rotl8(td[r - 1][x]);
+    }
+  }
+
+  tables_ready = 1;
+}
+
+static uint32_t aes_fast_sub_word(uint32_t w) {
+  return aes_fast_col(sbox[w & 0xFF], sbox[(w >> 8) & 0xFF],
+                      sbox[(w >> 16) & 0xFF], sbox[w >> 24]);
+}
+
+static uint32_t aes_fast_inv_mix_column(uint32_t w) {
+  // InvMixColumns(w) = InvMixColumns(InvSubBytes(SubBytes(w)))
+  return td[0][sbox[w & 0xFF]] ^ td[1][sbox[(w >> 8) & 0xFF]] ^
+         td[2][sbox[(w >> 16) & 0xFF]] ^ td[3][sbox[w >> 24]];
+}
+
+static uint32_t aes_fast_load(const unsigned char *in) {
+  return aes_fast_col(in[0], in[1], in[2], in[3]);
+}
+
+static void aes_fast_store(unsigned char *out, uint32_t w) {
+  out[0] = (unsigned char)w;
+  out[1] = (unsigned char)(w >> 8);
+  out[2] = (unsigned char)(w >> 16);
+  out[3] = (unsigned char)(w >> 24);
+}
+
+int aes_fast_key_init(aes_fast_key_t *key, const unsigned char *key_in,
+                      const int key_len) {
+  int num_rounds = aes_get_num_rounds(key_len);
+  if (num_rounds < 0) {
+    return -EINVAL;
+  }
+
+  aes_fast_tables_init();
+
+  const int nk = key_len / 4;
+  const int num_words = 4 * (num_rounds + 1);
+  uint32_t *w = key->enc;
+  unsigned char rcon = 0x1;
+
+  key->num_rounds = num_rounds;
+
+  // Forward key schedule (FIPS-197, Section 5.2)
+  for (int i = 0; i < nk; ++i) {
+    w[i] = aes_fast_load(&key_in[4 * i]);
+  }
+  for (int i = nk; i < num_words; ++i) {
+    uint32_t temp = w[i - 1];
+    if (i % nk == 0) {
+      // RotWord, SubWord, Rcon
+      temp = aes_fast_sub_word((temp >> 8) | (temp << 24)) ^ rcon;
+      rcon = aes_fast_mul2(rcon);
+    } else if (nk > 6 && i % nk == 4) {
+      temp = aes_fast_sub_word(temp);
+    }
+    w[i] = w[i - nk] ^ temp;
+  }
+
+  // Equivalent Inverse Cipher key schedule (FIPS-197, Section 5.3.5): reverse
+  // the round order and apply InvMixColumns to all but the first and last
+  // round keys.
+  for (int rnd = 0; rnd <= num_rounds; ++rnd) {
+    for (int c = 0; c < 4; ++c) {
+      uint32_t rk = w[4 * (num_rounds - rnd) + c];
+      key->dec[4 * rnd + c] = (rnd == 0 || rnd == num_rounds)
+                                  ? rk
+                                  : aes_fast_inv_mix_column(rk);
+    }
+  }
+
+  return 0;
+}
+
+void aes_fast_encrypt_block(const aes_fast_key_t *key,
+                            const unsigned char *plain_text,
+                            unsigned char *cipher_text) {
+  const uint32_t *rk = key->enc;
+  uint32_t s[4], t[4];
+
+  for (int c = 0; c < 4; ++c) {
+    s[c] = aes_fast_load(&plain_text[4 * c]) ^ rk[c];
+  }
+
+  // SubBytes, ShiftRows, MixColumns and AddRoundKey. Row r of column c comes
+  // from column c + r after ShiftRows.
+  for (int rnd = 1; rnd < key->num_rounds; ++rnd) {
+    rk += 4;
+    for (int c = 0; c < 4; ++c) {
+      t[c] = te[0][s[c] & 0xFF] ^ te[1][(s[(c + 1) & 3] >> 8) & 0xFF] ^
+             te[2][(s[(c + 2) & 3] >> 16) & 0xFF] ^ te[3][s[(c + 3) & 3] >> 24] ^
+             rk[c];
+    }
+    memcpy(s, t, sizeof(s));
+  }
+
+  // Final round without MixColumns
+  rk += 4;
+  for (int c = 0; c < 4; ++c) {
+    t[c] = aes_fast_col(sbox[s[c] & 0xFF], sbox[(s[(c + 1) & 3] >> 8) & 0xFF],
+                        sbox[(s[(c + 2) & 3] >> 16) & 0xFF],
+                        sbox[s[(c + 3) & 3] >> 24]) ^
+           rk[c];
+  }
+
+  for (int c = 0; c < 4; ++c) {
+    aes_fast_store(&cipher_text[4 * c], t[c]);
+  }
+}
+
+void aes_fast_decrypt_block(const aes_fast_key_t *key,
+                            const unsigned char *cipher_text,
+                            unsigned char *plain_text) {
+  const uint32_t *rk = key->dec;
+  uint32_t s[4], t[4];
+
+  for (int c = 0; c < 4; ++c) {
+    s[c] = aes_fast_load(&cipher_text[4 * c]) ^ rk[c];
+  }
+
+  // InvSubBytes, InvShiftRows, InvMixColumns and AddRoundKey. Row r of column c
+  // comes from column c - r after InvShiftRows.
+  for (int rnd = 1; rnd < key->num_rounds; ++rnd) {
+    rk += 4;
+    for (int c = 0; c < 4; ++c) {
+      t[c] = td[0][s[c] & 0xFF] ^ td[1][(s[(c + 3) & 3] >> 8) & 0xFF] ^
+             td[2][(s[(c + 2) & 3] >> 16) & 0xFF] ^ td[3][s[(c + 1) & 3] >> 24] ^
+             rk[c];
+    }
+    memcpy(s, t, sizeof(s));
+  }
+
+  // Final round without InvMixColumns
+  rk += 4;
+  for (int c = 0; c < 4; ++c) {
+    t[c] = aes_fast_col(inv_sbox[s[c] & 0xFF],
+                        inv_sbox[(s[(c + 3) & 3] >> 8) & 0xFF],
+                        inv_sbox[(s[(c + 2) & 3] >> 16) & 0xFF],
+                        inv_sbox[s[(c + 1) & 3] >> 24]) ^
+           rk[c];
+  }
+
+  for (int c = 0; c < 4; ++c) {
+    aes_fast_store(&plain_text[4 * c], t[c]);
+  }
+}
+
+static void aes_fast_xor_block(unsigned char *out, const unsigned char *a,
+                               const unsigned char *b) {
+  for (int i = 0; i < 16; ++i) {
+    out[i] = a[i] ^ b[i];
+  }
+}
+
+static void aes_fast_ctr_inc(unsigned char *ctr) {
+  for (int i = 15; i >= 0; --i) {
+    if (++ctr[i]) {
+      break;
+    }
+  }
+}
+
+/**
+ * Encrypt or decrypt a message.
+ *
+ * @param  op 0 = encrypt, 1 = decrypt
+ */
+static int aes_fast_crypt(int op, unsigned char *output,
+                          const unsigned char *iv, const unsigned char *input,
+                          int input_len, const unsigned char *key, int key_len,
+                          crypto_mode_t mode) {
+  aes_fast_key_t ks;
+  unsigned char chain[16];
+  unsigned char buf[16];
+
+  if (input_len < 0 || input_len % 16 || mode == kCryptoAesNone) {
+    return -1;
+  }
+  if (aes_fast_key_init(&ks, key, key_len)) {
+    return -1;
+  }
+  if (mode != kCryptoAesEcb) {
+    memcpy(chain, iv, 16);
+  }
+
+  // All modes read an input block completely before writing the
+  // corresponding output block, so input and output may alias.
+  for (int i = 0; i < input_len; i += 16) {
+    const unsigned char *in = &input[i];
+    unsigned char *out = &output[i];
+
+    if (mode == kCryptoAesCbc) {
+      if (!op) {
+        aes_fast_xor_block(buf, in, chain);
+        aes_fast_encrypt_block(&ks, buf, out);
+        memcpy(chain, out, 16);
+      } else {
+        aes_fast_decrypt_block(&ks, in, buf);
+        aes_fast_xor_block(buf, buf, chain);
+        memcpy(chain, in, 16);
+        memcpy(out, buf, 16);
+      }
+    } else if (mode == kCryptoAesCfb) {
+      aes_fast_encrypt_block(&ks, chain, buf);
+      // The cipher text is fed back.
+      memcpy(chain, in, 16);
+      aes_fast_xor_block(out, in, buf);
+      if (!op) {
+        memcpy(chain, out, 16);
+      }
+    } else if (mode == kCryptoAesOfb) {
+      aes_fast_encrypt_block(&ks, chain, chain);
+      aes_fast_xor_block(out, in, chain);
+    } else if (mode == kCryptoAesCtr) {
+      aes_fast_encrypt_block(&ks, chain, buf);
+      aes_fast_ctr_inc(chain);
+      aes_fast_xor_block(out, in, buf);
+    } else {  // ECB
+      if (!op) {
+        aes_fast_encrypt_block(&ks, in, out);
+      } else {
+        aes_fast_decrypt_block(&ks, in, out);
+      }
+    }
+  }
+
+  return input_len;
+}
+
+int aes_fast_encrypt(unsigned char *output, const unsigned char *iv,
+                     const unsigned char *input, int input_len,
+                     const unsigned char *key, int key_len,
+                     crypto_mode_t mode) {
+  return aes_fast_crypt(0, output, iv, input, input_len, key, key_len, mode);
+}
+
+int aes_fast_decrypt(unsigned char *output, const unsigned char *iv,
+                     const unsigned char *input, int input_len,
+                     const unsigned char *key, int key_len,
+                     crypto_mode_t mode) {
+  return aes_fast_crypt(1, output, iv, input, input_len, key, key_len, mode);
+}
@@ -0,0 +1,108 @@
+// Copyright lowRISC contributors.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef OPENTITAN_HW_IP_AES_MODEL_AES_FAST_H_
+#define OPENTITAN_HW_IP_AES_MODEL_AES_FAST_H_
+
+#include <stdint.h>
+
+#include "crypto.h"
+
+/**
+ * Table-based implementation of the AES cipher.
+ *
+ * Computes the same function as aes_encrypt_block()/aes_decrypt_block() but
+ * merges SubBytes, ShiftRows and MixColumns into four 32-bit table lookups per
+ * column and round, and expands the key only once per message. Use this for
+ * bulk data. The round-by-round functions in aes.h remain the reference for
+ * inspecting intermediate states.
+ */
+
+#define AES_FAST_MAX_ROUNDS 14
+
+/**
+ * Expanded key
+ */
+typedef struct aes_fast_key {
+  /** Number of cipher rounds. */
+  int num_rounds;
+  /** Round keys of the forward cipher, one word per state column. */
+  uint32_t enc[4 * (AES_FAST_MAX_ROUNDS + 1)];
+  /** Round keys of the Equivalent Inverse Cipher. */
+  uint32_t dec[4 * (AES_FAST_MAX_ROUNDS + 1)];
+} aes_fast_key_t;
+
+/**
+ * Expand a key for use with the table-based cipher.
+ *
+ * @param  key     Expanded key
+ * @param  key_in  Initial key
+ * @param  key_len Key length in bytes (16, 24, 32)
+ * @return 0 on success, -EINVAL for unsupported key lengths
+ */
+int aes_fast_key_init(aes_fast_key_t *key, const unsigned char *key_in,
+                      const int key_len);
+
+/**
+ * Encrypt one data block (16 Bytes) in ECB mode.
+ *
+ * @param  key         Expanded key
+ * @param  plain_text  Input block to encrypt
+ * @param  cipher_text Encrypted output block, may alias plain_text
+ */
+void aes_fast_encrypt_block(const aes_fast_key_t *key,
+                            const unsigned char *plain_text,
+                            unsigned char *cipher_text);
+
+/**
+ * Decrypt one data block (16 Bytes) in ECB mode.
+ *
+ * @param  key         Expanded key
+ * @param  cipher_text Encrypted input block
+ * @param  plain_text  Decrypted output block, may alias cipher_text
+ */
+void aes_fast_decrypt_block(const aes_fast_key_t *key,
+                            const unsigned char *cipher_text,
+                            unsigned char *plain_text);
+
+/**
+ * Encrypt a message with the table-based cipher.
+ *
+ * Same interface and results as crypto_encrypt(). CFB is CFB-128 and CTR
+ * increments the entire 128-bit counter block as a big-endian integer.
+ *
+ * @param  output    Output cipher text, may alias input
+ * @param  iv        16-byte initialization vector, ignored for ECB
+ * @param  input     Input plain text to encode
+ * @param  input_len Length of the input plain text in bytes, must be a multiple
+ *                   of 16
+ * @param  key       Encryption key
+ * @param  key_len   Encryption key length in bytes (16, 24, 32)
+ * @param  mode      AES cipher mode @see crypto_mode.
+ * @return Length of the output cipher text in bytes, -1 in case of error
+ */
+int aes_fast_encrypt(unsigned char *output, const unsigned char *iv,
+                     const unsigned char *input, int input_len,
+                     const unsigned char *key, int key_len, crypto_mode_t mode);
+
+/**
+ * Decrypt a message with the table-based cipher.
+ *
+ * Same interface and results as crypto_decrypt().
+ *
+ * @param  output    Output plain text, may alias input
+ * @param  iv        16-byte initialization vector, ignored for ECB
+ * @param  input     Input cipher text to decode
+ * @param  input_len Length of the input cipher text in bytes, must be a
+ *                   multiple of 16
+ * @param  key       Encryption key, decryption key is derived internally
+ * @param  key_len   Encryption key length in bytes (16, 24, 32)
+ * @param  mode      AES cipher mode @see crypto_mode.
+ * @return Length of the output plain text in bytes, -1 in case of error
+ */
+int aes_fast_decrypt(unsigned char *output, const unsigned char *iv,
+                     const unsigned char *input, int input_len,
+                     const unsigned char *key, int key_len, crypto_mode_t mode);
+
+#endif  // OPENTITAN_HW_IP_AES_MODEL_AES_FAST_H_
@@ -0,0 +1,210 @@
+// Copyright lowRISC contributors.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "aes.h"
+#include "aes_fast.h"
+#include "aes_modes.h"
+
+#include "crypto.h"
+
+// Differential test of the table-based cipher (aes_fast.c) against the
+// round-by-round C model (aes.c) and BoringSSL/OpenSSL (crypto.c).
+
+#define NUM_RANDOM_BLOCKS 10000
+#define NUM_RANDOM_MESSAGES 200
+#define MAX_MESSAGE_BLOCKS 64
+#define BENCH_BYTES (1 << 20)
+
+static const int kKeyLens[3] = {16, 24, 32};
+
+static const crypto_mode_t kModes[5] = {kCryptoAesEcb, kCryptoAesCbc,
+                                        kCryptoAesCfb, kCryptoAesOfb,
+                                        kCryptoAesCtr};
+static const char *const kModeNames[5] = {"ECB", "CBC", "CFB", "OFB", "CTR"};
+
+static void random_bytes(unsigned char *data, int len) {
+  for (int i = 0; i < len; ++i) {
+    data[i] = (unsigned char)rand();
+  }
+}
+
+static int check_data(const char *what, const unsigned char *actual,
+                      const unsigned char *expected, int len) {
+  if (memcmp(actual, expected, len)) {
+    printf("ERROR: %s mismatch\n", what);
+    printf("Output: \t");
+    aes_print_block(actual, len < 16 ? len : 16);
+    printf("Expected: \t");
+    aes_print_block(expected, len < 16 ? len : 16);
+    return 1;
+  }
+  return 0;
+}
+
+static double now_sec(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/**
+ * Compare single blocks against the round-by-round C model.
+ */
+static int test_blocks(void) {
+  unsigned char key[32];
+  unsigned char in[16], out[16], out_ref[16];
+  aes_fast_key_t ks;
+
+  for (int k = 0; k < 3; ++k) {
+    const int key_len = kKeyLens[k];
+    for (int n = 0; n < NUM_RANDOM_BLOCKS; ++n) {
+      random_bytes(key, key_len);
+      random_bytes(in, 16);
+      aes_fast_key_init(&ks, key, key_len);
+
+      aes_encrypt_block(in, key, key_len, out_ref);
+      aes_fast_encrypt_block(&ks, in, out);
+      if (check_data("block encrypt", out, out_ref, 16)) {
+        return 1;
+      }
+
+      aes_decrypt_block(in, key, key_len, out_ref);
+      aes_fast_decrypt_block(&ks, in, out);
+      if (check_data("block decrypt", out, out_ref, 16)) {
+        return 1;
+      }
+    }
+    printf("SUCCESS: AES-%d blocks match the C model\n", key_len * 8);
+  }
+
+  return 0;
+}
+
+/**
+ * Check the mode functions against the NIST SP 800-38A examples.
+ */
+static int test_nist(void) {
+  const unsigned char *keys[3] = {kAesModesKey128, kAesModesKey192,
+                                  kAesModesKey256};
+  const unsigned char *ivs[5] = {kAesModesIvEcb, kAesModesIvCbc,
+                                 kAesModesIvCfb, kAesModesIvOfb,
+                                 kAesModesIvCtr};
+  const unsigned char *cipher_texts[5][3] = {
+      {kAesModesCipherTextEcb128, kAesModesCipherTextEcb192,
+       kAesModesCipherTextEcb256},
+      {kAesModesCipherTextCbc128, kAesModesCipherTextCbc192,
+       kAesModesCipherTextCbc256},
+      {kAesModesCipherTextCfb128, kAesModesCipherTextCfb192,
+       kAesModesCipherTextCfb256},
+      {kAesModesCipherTextOfb128, kAesModesCipherTextOfb192,
+       kAesModesCipherTextOfb256},
+      {kAesModesCipherTextCtr128, kAesModesCipherTextCtr192,
+       kAesModesCipherTextCtr256}};
+  unsigned char data[64];
+
+  for (int m = 0; m < 5; ++m) {
+    for (int k = 0; k < 3; ++k) {
+      aes_fast_encrypt(data, ivs[m], kAesModesPlainText, 64, keys[k],
+                       kKeyLens[k], kModes[m]);
+      if (check_data("NIST encrypt", data, cipher_texts[m][k], 64)) {
+        return 1;
+      }
+      // Decrypt in place.
+      aes_fast_decrypt(data, ivs[m], data, 64, keys[k], kKeyLens[k],
+                       kModes[m]);
+      if (check_data("NIST decrypt", data, kAesModesPlainText, 64)) {
+        return 1;
+      }
+    }
+    printf("SUCCESS: %s output matches NIST examples\n", kModeNames[m]);
+  }
+
+  return 0;
+}
+
+/**
+ * Compare random messages against BoringSSL/OpenSSL.
+ */
+static int test_messages(void) {
+  unsigned char key[32];
+  unsigned char iv[16];
+  unsigned char in[16 * MAX_MESSAGE_BLOCKS];
+  unsigned char out[16 * MAX_MESSAGE_BLOCKS];
+  unsigned char out_ref[16 * MAX_MESSAGE_BLOCKS];
+
+  for (int m = 0; m < 5; ++m) {
+    for (int n = 0; n < NUM_RANDOM_MESSAGES; ++n) {
+      const int key_len = kKeyLens[n % 3];
+      const int len = 16 * (1 + rand() % MAX_MESSAGE_BLOCKS);
+      random_bytes(key, key_len);
+      random_bytes(iv, 16);
+      random_bytes(in, len);
+      if (n % 4 == 0) {
+        // Let the CTR counter wrap around within the message.
+        memset(iv, 0xFF, 16);
+      }
+
+      crypto_encrypt(out_ref, iv, in, len, key, key_len, kModes[m]);
+      if (aes_fast_encrypt(out, iv, in, len, key, key_len, kModes[m]) != len ||
+          check_data("message encrypt", out, out_ref, len)) {
+        return 1;
+      }
+
+      crypto_decrypt(out_ref, iv, in, len, key, key_len, kModes[m]);
+      if (aes_fast_decrypt(out, iv, in, len, key, key_len, kModes[m]) != len ||
+          check_data("message decrypt", out, out_ref, len)) {
+        return 1;
+      }
+    }
+    printf("SUCCESS: %s messages match crypto library\n", kModeNames[m]);
+  }
+
+  return 0;
+}
+
+/**
+ * Report the throughput of both C implementations in ECB mode.
+ */
+static void bench(void) {
+  unsigned char *data = (unsigned char *)malloc(BENCH_BYTES);
+  unsigned char key[32];
+  double t;
+
+  if (data == NULL) {
+    printf("ERROR: malloc() failed\n");
+    return;
+  }
+  random_bytes(data, BENCH_BYTES);
+  random_bytes(key, 32);
+
+  t = now_sec();
+  for (int i = 0; i < BENCH_BYTES; i += 16) {
+    aes_encrypt_block(&data[i], key, 32, &data[i]);
+  }
+  t = now_sec() - t;
+  printf("C model:     AES-256 ECB %8.2f MB/s\n", BENCH_BYTES / t / 1e6);
+
+  t = now_sec();
+  aes_fast_encrypt(data, NULL, data, BENCH_BYTES, key, 32, kCryptoAesEcb);
+  t = now_sec() - t;
+  printf("Table-based: AES-256 ECB %8.2f MB/s\n", BENCH_BYTES / t / 1e6);
+
+  free(data);
+}
+
+int main(int argc, char *argv[]) {
+  srand(argc > 1 ? atoi(argv[1]) : 1);
+
+  if (test_blocks() || test_nist() || test_messages()) {
+    return 1;
+  }
+  bench();
+
+  return 0;
+}
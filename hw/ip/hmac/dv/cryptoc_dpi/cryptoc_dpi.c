@@ -4,6 +4,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "hmac.h"
 #include "hmac_wrap.h"
@@ -123,3 +124,125 @@ extern void c_dpi_HMAC_SHA256(const svOpenArrayHandle key, ull_t key_len,
 
   free(key_arr);
 }
+
+// Persistent hashing contexts.
+//
+// A context is allocated by one of the *_init functions and handed to SV as a
+// chandle. Message bytes can then be pushed incrementally with
+// c_dpi_cryptoc_update (bit [7:0] arrays, one 32-bit word per byte on the DPI
+// side) or c_dpi_cryptoc_update_bytes (byte unsigned arrays, one byte per byte
+// on the DPI side). c_dpi_cryptoc_digest computes the digest of everything
+// absorbed so far without finalizing the context, so long messages can be
+// checked at many intermediate points in linear total time.
+typedef struct cryptoc_dpi_ctx {
+  int is_hmac;
+  // For plain SHA256 only `hmac.hash` is used.
+  LITE_HMAC_CTX hmac;
+} cryptoc_dpi_ctx_t;
+
+// Size of the stack buffer used to narrow word-per-byte arrays in chunks.
+#define CRYPTOC_DPI_CHUNK_BYTES 1024
+
+static void cryptoc_dpi_update(cryptoc_dpi_ctx_t *ctx, const void *data,
+                               size_t len) {
+  if (ctx->is_hmac) {
+    HMAC_update(&ctx->hmac, data, len);
+  } else {
+    SHA256_update(&ctx->hmac.hash, data, len);
+  }
+}
+
+// Narrows `len` elements of a word-per-byte array into a fixed-size buffer and
+// feeds it to `ctx` chunk by chunk, without allocating a copy of the message.
+static void cryptoc_dpi_update_words(cryptoc_dpi_ctx_t *ctx,
+                                     const unsigned int *arr_ptr, ull_t len) {
+  unsigned char buf[CRYPTOC_DPI_CHUNK_BYTES];
+  ull_t i;
+  size_t n = 0;
+
+  for (i = 0; i < len; i++) {
+    buf[n++] = arr_ptr[i];
+    if (n == sizeof(buf)) {
+      cryptoc_dpi_update(ctx, buf, n);
+      n = 0;
+    }
+  }
+  if (n > 0) {
+    cryptoc_dpi_update(ctx, buf, n);
+  }
+}
+
+extern void *c_dpi_SHA256_init(void) {
+  cryptoc_dpi_ctx_t *ctx = (cryptoc_dpi_ctx_t *)malloc(sizeof(*ctx));
+  ctx->is_hmac = 0;
+  SHA256_init(&ctx->hmac.hash);
+  return ctx;
+}
+
+extern void *c_dpi_HMAC_SHA256_init(const svOpenArrayHandle key,
+                                    ull_t key_len) {
+  cryptoc_dpi_ctx_t *ctx = (cryptoc_dpi_ctx_t *)malloc(sizeof(*ctx));
+  unsigned char *key_arr;
+  unsigned int *key_arr_ptr;
+  ull_t i;
+
+  key_arr = (unsigned char *)malloc(key_len > 0 ? key_len : 1);
+  key_arr_ptr = (unsigned int *)svGetArrayPtr(key);
+
+  for (i = 0; i < key_len; i++) {
+    key_arr[i] = key_arr_ptr[i];
+  }
+
+  ctx->is_hmac = 1;
+  HMAC_SHA256_init(&ctx->hmac, key_arr, key_len);
+
+  free(key_arr);
+  return ctx;
+}
+
+extern void c_dpi_cryptoc_update(void *ctx, const svOpenArrayHandle msg,
+                                 ull_t len) {
+  if (len == 0) {
+    return;
+  }
+  cryptoc_dpi_update_words((cryptoc_dpi_ctx_t *)ctx,
+                           (const unsigned int *)svGetArrayPtr(msg), len);
+}
+
+extern void c_dpi_cryptoc_update_bytes(void *ctx, const svOpenArrayHandle msg,
+                                       ull_t len) {
+  if (len == 0) {
+    return;
+  }
+  cryptoc_dpi_update((cryptoc_dpi_ctx_t *)ctx, svGetArrayPtr(msg), len);
+}
+
+extern void c_dpi_cryptoc_digest(void *ctx, unsigned int digest[8]) {
+  // Finalize a copy so that the context can keep absorbing data.
+  cryptoc_dpi_ctx_t tmp = *(cryptoc_dpi_ctx_t *)ctx;
+  const uint8_t *res;
+
+  if (tmp.is_hmac) {
+    res = HMAC_final(&tmp.hmac);
+  } else {
+    res = SHA256_final(&tmp.hmac.hash);
+  }
+  memcpy(digest, res, SHA256_DIGEST_SIZE);
+}
+
+extern void c_dpi_cryptoc_free(void *ctx) { free(ctx); }
+
+// One-shot variants of c_dpi_SHA256_hash and c_dpi_HMAC_SHA256 for
+// byte unsigned arrays, which are hashed in place without any copy.
+extern void c_dpi_SHA256_hash_bytes(const svOpenArrayHandle msg, ull_t len,
+                                    unsigned int hash[8]) {
+  SHA256_hash(len > 0 ? svGetArrayPtr(msg) : NULL, len, (uint8_t *)hash);
+}
+
+extern void c_dpi_HMAC_SHA256_bytes(const svOpenArrayHandle key, ull_t key_len,
+                                    const svOpenArrayHandle msg, ull_t msg_len,
+                                    unsigned int hmac[8]) {
+  HMAC_SHA256(key_len > 0 ? svGetArrayPtr(key) : NULL, key_len,
+              msg_len > 0 ? svGetArrayPtr(msg) : NULL, msg_len,
+              (uint8_t *)hmac);
+}
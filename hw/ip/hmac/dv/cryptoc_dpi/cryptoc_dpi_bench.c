@@ -0,0 +1,187 @@
+// Copyright lowRISC contributors.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+// Host benchmark for the cryptoc DPI functions.
+//
+// Models a testbench that streams a long message into the DUT and checks the
+// expected digest every `check_bytes` bytes. It compares the cost per check of
+//  - the one-shot functions, which rehash the whole prefix on every check, and
+//  - the persistent contexts, which absorb only the new bytes on every check,
+// both for word-per-byte (`bit [7:0]`) and byte (`byte unsigned`) arrays.
+//
+// The simulator is replaced by a minimal open array implementation, so this
+// only needs the standard svdpi.h header, e.g. from Verilator:
+//
+//   gcc -O2 -I$VERILATOR_ROOT/include/vltstd -o cryptoc_dpi_bench
+//     cryptoc_dpi_bench.c cryptoc_dpi.c hmac.c hmac_wrap.c sha.c sha256.c
+//     util.c
+//   ./cryptoc_dpi_bench [msg_bytes] [check_bytes]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "svdpi.h"
+
+typedef unsigned long long ull_t;
+
+extern void c_dpi_SHA256_hash(const svOpenArrayHandle msg, ull_t len,
+                              uint8_t hash[8]);
+extern void c_dpi_HMAC_SHA256(const svOpenArrayHandle key, ull_t key_len,
+                              const svOpenArrayHandle msg, ull_t msg_len,
+                              uint8_t hmac[8]);
+extern void *c_dpi_SHA256_init(void);
+extern void *c_dpi_HMAC_SHA256_init(const svOpenArrayHandle key,
+                                    ull_t key_len);
+extern void c_dpi_cryptoc_update(void *ctx, const svOpenArrayHandle msg,
+                                 ull_t len);
+extern void c_dpi_cryptoc_update_bytes(void *ctx, const svOpenArrayHandle msg,
+                                       ull_t len);
+extern void c_dpi_cryptoc_digest(void *ctx, unsigned int digest[8]);
+extern void c_dpi_cryptoc_free(void *ctx);
+
+// Open array handles as seen by the DPI functions: a pointer to contiguous
+// elements. Only the accessors used by cryptoc_dpi.c are implemented.
+typedef struct bench_array {
+  void *data;
+  int size;
+} bench_array_t;
+
+void *svGetArrayPtr(const svOpenArrayHandle h) {
+  return ((const bench_array_t *)h)->data;
+}
+
+int svSizeOfArray(const svOpenArrayHandle h) {
+  return ((const bench_array_t *)h)->size;
+}
+
+static double now_sec(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static const unsigned int kKey[8] = {0x01234567, 0x89abcdef, 0xdeadbeef,
+                                     0xcafef00d, 0x0badc0de, 0x600dd00d,
+                                     0x13579bdf, 0x2468ace0};
+
+typedef enum bench_mode {
+  kModeOneShot,
+  kModeStream,
+  kModeStreamBytes,
+} bench_mode_t;
+
+static const char *const kModeNames[] = {
+    [kModeOneShot] = "one-shot bit[7:0]",
+    [kModeStream] = "stream bit[7:0]",
+    [kModeStreamBytes] = "stream byte",
+};
+
+// Runs one benchmark and stores the digest of every check in `digests`.
+static double run(bench_mode_t mode, int hmac, const unsigned int *msg_words,
+                  const unsigned char *msg_bytes, size_t msg_len,
+                  size_t check_bytes, unsigned int (*digests)[8]) {
+  unsigned int key_words[sizeof(kKey)];
+  bench_array_t key = {key_words, sizeof(kKey)};
+  void *ctx = NULL;
+  size_t pos = 0;
+  size_t check = 0;
+  double start;
+
+  // The DPI key is a word-per-byte array, as with the message.
+  for (size_t i = 0; i < sizeof(kKey); ++i) {
+    key_words[i] = ((const unsigned char *)kKey)[i];
+  }
+
+  start = now_sec();
+  if (mode != kModeOneShot) {
+    ctx = hmac ? c_dpi_HMAC_SHA256_init(&key, sizeof(kKey))
+               : c_dpi_SHA256_init();
+  }
+  while (pos < msg_len) {
+    size_t end = pos + check_bytes < msg_len ? pos + check_bytes : msg_len;
+    switch (mode) {
+      case kModeOneShot: {
+        bench_array_t msg = {(void *)msg_words, (int)end};
+        if (hmac) {
+          c_dpi_HMAC_SHA256(&key, sizeof(kKey), &msg, end,
+                            (uint8_t *)digests[check]);
+        } else {
+          c_dpi_SHA256_hash(&msg, end, (uint8_t *)digests[check]);
+        }
+        break;
+      }
+      case kModeStream: {
+        bench_array_t msg = {(void *)&msg_words[pos], (int)(end - pos)};
+        c_dpi_cryptoc_update(ctx, &msg, end - pos);
+        c_dpi_cryptoc_digest(ctx, digests[check]);
+        break;
+      }
+      case kModeStreamBytes: {
+        bench_array_t msg = {(void *)&msg_bytes[pos], (int)(end - pos)};
+        c_dpi_cryptoc_update_bytes(ctx, &msg, end - pos);
+        c_dpi_cryptoc_digest(ctx, digests[check]);
+        break;
+      }
+    }
+    pos = end;
+    ++check;
+  }
+  if (ctx != NULL) {
+    c_dpi_cryptoc_free(ctx);
+  }
+  return now_sec() - start;
+}
+
+int main(int argc, char **argv) {
+  size_t msg_len = argc > 1 ? strtoull(argv[1], NULL, 0) : 1 << 20;
+  size_t check_bytes = argc > 2 ? strtoull(argv[2], NULL, 0) : 4096;
+  size_t num_checks;
+  unsigned int *msg_words;
+  unsigned char *msg_bytes;
+  unsigned int(*ref)[8];
+  unsigned int(*digests)[8];
+  int fail = 0;
+
+  if (msg_len == 0 || check_bytes == 0) {
+    fprintf(stderr, "usage: %s [msg_bytes > 0] [check_bytes > 0]\n", argv[0]);
+    return 2;
+  }
+  num_checks = (msg_len + check_bytes - 1) / check_bytes;
+
+  msg_words = malloc(msg_len * sizeof(*msg_words));
+  msg_bytes = malloc(msg_len);
+  ref = malloc(num_checks * sizeof(*ref));
+  digests = malloc(num_checks * sizeof(*digests));
+  srand(1);
+  for (size_t i = 0; i < msg_len; ++i) {
+    msg_bytes[i] = rand();
+    msg_words[i] = msg_bytes[i];
+  }
+
+  printf("msg_bytes: %zu, check_bytes: %zu, checks: %zu\n", msg_len,
+         check_bytes, num_checks);
+  for (int hmac = 0; hmac <= 1; ++hmac) {
+    for (bench_mode_t mode = kModeOneShot; mode <= kModeStreamBytes; ++mode) {
+      double t = run(mode, hmac, msg_words, msg_bytes, msg_len, check_bytes,
+                     mode == kModeOneShot ? ref : digests);
+      if (mode != kModeOneShot &&
+          memcmp(ref, digests, num_checks * sizeof(*ref)) != 0) {
+        printf("MISMATCH: %s %s\n", hmac ? "hmac-sha256" : "sha256",
+               kModeNames[mode]);
+        fail = 1;
+      }
+      printf("%-12s %-18s total %10.3f ms, per check %10.3f us\n",
+             hmac ? "hmac-sha256" : "sha256", kModeNames[mode], t * 1e3,
+             t * 1e6 / num_checks);
+    }
+  }
+
+  free(digests);
+  free(ref);
+  free(msg_bytes);
+  free(msg_words);
+  return fail;
+}
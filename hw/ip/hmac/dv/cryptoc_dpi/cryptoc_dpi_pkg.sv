@@ -30,6 +30,42 @@ package cryptoc_dpi_pkg;
                                                          input longint unsigned msg_len,
                                                          output int unsigned hmac[8]);
 
+  // One-shot variants taking `byte unsigned` arrays, which the simulator passes
+  // to C as one byte per element rather than one 32-bit word per element.
+  import "DPI-C" context function void c_dpi_SHA256_hash_bytes(input byte unsigned msg[],
+                                                               input longint unsigned len,
+                                                               output int unsigned hash[8]);
+
+  import "DPI-C" context function void c_dpi_HMAC_SHA256_bytes(input byte unsigned key[],
+                                                               input longint unsigned key_len,
+                                                               input byte unsigned msg[],
+                                                               input longint unsigned msg_len,
+                                                               output int unsigned hmac[8]);
+
+  // Persistent SHA256 / HMAC-SHA256 contexts. A context returned by one of the
+  // *_init functions absorbs message bytes incrementally with
+  // c_dpi_cryptoc_update(_bytes). c_dpi_cryptoc_digest returns the digest of
+  // all bytes absorbed so far and leaves the context usable, so intermediate
+  // digests of a long message do not require rehashing it from the start.
+  // Contexts must be released with c_dpi_cryptoc_free.
+  import "DPI-C" context function chandle c_dpi_SHA256_init();
+
+  import "DPI-C" context function chandle c_dpi_HMAC_SHA256_init(input bit[7:0] key[],
+                                                                 input longint unsigned key_len);
+
+  import "DPI-C" context function void c_dpi_cryptoc_update(input chandle ctx,
+                                                            input bit[7:0] msg[],
+                                                            input longint unsigned len);
+
+  import "DPI-C" context function void c_dpi_cryptoc_update_bytes(input chandle ctx,
+                                                                  input byte unsigned msg[],
+                                                                  input longint unsigned len);
+
+  import "DPI-C" context function void c_dpi_cryptoc_digest(input chandle ctx,
+                                                            output int unsigned digest[8]);
+
+  import "DPI-C" context function void c_dpi_cryptoc_free(input chandle ctx);
+
   // sv wrapper functions
   function automatic void sv_dpi_get_sha_digest(input bit[7:0] msg[],
                                                 output int unsigned hash[8]);
@@ -61,4 +97,22 @@ package cryptoc_dpi_pkg;
     c_dpi_HMAC_SHA256(ckey, ckey.size(), msg, msg.size(), hmac);
   endfunction
 
+  function automatic chandle sv_dpi_hmac_sha256_init(input bit[31:0] key[]);
+    bit [7:0] ckey[];
+    int ckey_size_bytes = $bits(key) / 8;
+    ckey = new[ckey_size_bytes];
+    {>>{ckey}} = key;
+    return c_dpi_HMAC_SHA256_init(ckey, ckey.size());
+  endfunction
+
+  function automatic void sv_dpi_cryptoc_update(input chandle ctx,
+                                                input bit[7:0] msg[]);
+    c_dpi_cryptoc_update(ctx, msg, msg.size());
+  endfunction
+
+  function automatic void sv_dpi_cryptoc_update_bytes(input chandle ctx,
+                                                      input byte unsigned msg[]);
+    c_dpi_cryptoc_update_bytes(ctx, msg, msg.size());
+  endfunction
+
 endpackage
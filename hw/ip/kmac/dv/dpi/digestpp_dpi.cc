@@ -6,15 +6,16 @@
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <exception>
 #include <list>
+#include <stdexcept>
+#include <vector>
 
 #include "svdpi.h"
 #include "vendor/kerukuro_digestpp/algorithm/kmac.hpp"
 #include "vendor/kerukuro_digestpp/algorithm/sha3.hpp"
 #include "vendor/kerukuro_digestpp/algorithm/shake.hpp"
 
-extern "C" {
-
 // TODO(udi) might need to implement endian conversion
 
 //////////////////////
@@ -22,30 +23,75 @@ extern "C" {
 //////////////////////
 
 /**
- * Generic function to load an unsized array from SV memory into C memory.
+ * Generic function to get the contents of an unsized byte array in SV memory.
+ *
+ * If the simulator stores the array contiguously (as returned by
+ * `svGetArrayPtr`), the data is either used in place (one byte per element)
+ * or copied in bulk (one `svBitVecVal` per element). Otherwise it is copied
+ * element by element into `buf`.
+ *
+ * @param arr SV array handle.
+ * @param array_len Number of elements to get.
+ * @param buf Buffer used if the data can't be used in place.
+ * @return Pointer to `array_len` bytes, valid until `buf` or `arr` change.
  */
-static void load_arr_from_simulator(const svOpenArrayHandle arr,
-                                    uint8_t *array_out, uint64_t array_len) {
-  svBitVecVal val;
-
+static const uint8_t *get_arr_from_simulator(const svOpenArrayHandle arr,
+                                             uint64_t array_len,
+                                             std::vector<uint8_t> *buf) {
   if (array_len == 0) {
-    return;
+    return nullptr;
   }
 
-  uint8_t *arr_ptr = (uint8_t *)svGetArrayPtr(arr);
-  for (int i = 0; i < array_len; i++) {
+  const uint8_t *arr_ptr = (const uint8_t *)svGetArrayPtr(arr);
+  if (arr_ptr != nullptr) {
+    int arr_size = svSizeOfArray(arr);
+    if (arr_size == svSize(arr, 1)) {
+      return arr_ptr;
+    }
+    if (arr_size == svSize(arr, 1) * sizeof(svBitVecVal)) {
+      const svBitVecVal *vals = (const svBitVecVal *)arr_ptr;
+      buf->resize(array_len);
+      for (uint64_t i = 0; i < array_len; ++i) {
+        (*buf)[i] = (uint8_t)vals[i];
+      }
+      return buf->data();
+    }
+  }
+
+  svBitVecVal val;
+  buf->resize(array_len);
+  for (uint64_t i = 0; i < array_len; ++i) {
     svGetBitArrElem1VecVal(&val, arr, i);
-    array_out[i] = (uint8_t)val;
+    (*buf)[i] = (uint8_t)val;
   }
+  return buf->data();
 }
 
 /**
  * Generic function to write an unsized array from C memory into SV memory.
+ *
+ * Uses a bulk copy if the simulator stores the array contiguously.
  */
 static void write_array_to_simulator(const svOpenArrayHandle arr,
-                                     uint8_t *data) {
+                                     const uint8_t *data) {
   uint64_t arr_len = svSize(arr, 1);
 
+  uint8_t *arr_ptr = (uint8_t *)svGetArrayPtr(arr);
+  if (arr_ptr != nullptr) {
+    int arr_size = svSizeOfArray(arr);
+    if (arr_size == arr_len) {
+      memcpy(arr_ptr, data, arr_len);
+      return;
+    }
+    if (arr_size == arr_len * sizeof(svBitVecVal)) {
+      svBitVecVal *vals = (svBitVecVal *)arr_ptr;
+      for (uint64_t i = 0; i < arr_len; ++i) {
+        vals[i] = data[i];
+      }
+      return;
+    }
+  }
+
   for (uint64_t i = 0; i < arr_len; ++i) {
     svBitVecVal data_val = (svBitVecVal)data[i];
     svPutBitArrElem1VecVal(arr, &data_val, i);
@@ -67,22 +113,187 @@ static void get_sha3_digest(uint64_t sha_len, const svOpenArrayHandle msg,
   uint8_t digest_arr[digest_len];
 
   // Load message from SV memory
-  uint8_t *msg_arr = (uint8_t *)malloc(msg_len * sizeof(uint8_t));
-  load_arr_from_simulator(msg, msg_arr, msg_len);
+  std::vector<uint8_t> msg_buf;
+  const uint8_t *msg_arr = get_arr_from_simulator(msg, msg_len, &msg_buf);
 
   // Compute the digest
   digestpp::sha3 sha3(sha_len);
   sha3.absorb(msg_arr, msg_len);
   sha3.digest(digest_arr, sizeof(digest_arr));
 
-  if (msg_arr != nullptr) {
-    free(msg_arr);
-  }
-
   // Return the digest array so that SV can access it
   write_array_to_simulator(digest, digest_arr);
 }
 
+/**
+ * Helper function to calculate an XOF digest of a message.
+ */
+template <typename Xof>
+static void get_xof_digest(Xof *xof, const svOpenArrayHandle msg,
+                           uint64_t msg_len, uint64_t output_len,
+                           svOpenArrayHandle digest) {
+  // Load message from SV memory
+  std::vector<uint8_t> msg_buf;
+  const uint8_t *msg_arr = get_arr_from_simulator(msg, msg_len, &msg_buf);
+
+  uint8_t digest_arr[output_len];
+
+  // Compute the digest
+  xof->absorb(msg_arr, msg_len);
+  xof->squeeze(digest_arr, output_len);
+
+  // Return the digest array to SV code
+  write_array_to_simulator(digest, digest_arr);
+}
+
+/**
+ * Helper function to calculate a fixed length KMAC digest.
+ */
+template <typename Kmac>
+static void get_kmac_digest(const svOpenArrayHandle msg, uint64_t msg_len,
+                            const svOpenArrayHandle key, uint64_t key_len,
+                            const char *customization_str, uint64_t output_len,
+                            svOpenArrayHandle digest) {
+  uint64_t output_len_bits = output_len * 8;
+
+  // Load message and key from SV memory
+  std::vector<uint8_t> msg_buf;
+  const uint8_t *msg_arr = get_arr_from_simulator(msg, msg_len, &msg_buf);
+  std::vector<uint8_t> key_buf;
+  const uint8_t *key_arr = get_arr_from_simulator(key, key_len, &key_buf);
+
+  uint8_t digest_arr[output_len];
+
+  // Compute the digest
+  Kmac kmac(output_len_bits);
+  kmac.set_customization(customization_str, strlen(customization_str));
+  kmac.set_key(key_arr, key_len);
+  kmac.absorb(msg_arr, msg_len);
+  kmac.digest(digest_arr, sizeof(digest_arr));
+
+  // Return the digest array to SV code
+  write_array_to_simulator(digest, digest_arr);
+}
+
+/**
+ * Helper function to calculate a KMAC-XOF digest.
+ */
+template <typename KmacXof>
+static void get_kmac_xof_digest(const svOpenArrayHandle msg, uint64_t msg_len,
+                                const svOpenArrayHandle key, uint64_t key_len,
+                                const char *customization_str,
+                                uint64_t output_len, svOpenArrayHandle digest) {
+  // Load key from SV memory
+  std::vector<uint8_t> key_buf;
+  const uint8_t *key_arr = get_arr_from_simulator(key, key_len, &key_buf);
+
+  KmacXof kmac;
+  kmac.set_customization(customization_str, strlen(customization_str));
+  kmac.set_key(key_arr, key_len);
+  get_xof_digest(&kmac, msg, msg_len, output_len, digest);
+}
+
+/**
+ * Streaming hash context, passed to SV as a `chandle`.
+ *
+ * Lets the testbench absorb a message in pieces as the RTL consumes it, so
+ * that long messages are hashed once in total instead of once per check.
+ */
+class DigestppContext {
+ public:
+  virtual ~DigestppContext() = default;
+
+  /**
+   * Absorbs `len` bytes of `data`.
+   */
+  virtual void Absorb(const uint8_t *data, uint64_t len) = 0;
+
+  /**
+   * Writes `len` bytes of output to `out`.
+   *
+   * For fixed length functions, this is the digest of the data absorbed so
+   * far and more data can be absorbed afterwards. For XOFs, this is the next
+   * `len` bytes of output and no more data can be absorbed afterwards.
+   */
+  virtual void Squeeze(uint8_t *out, uint64_t len) = 0;
+
+  /**
+   * Buffer for messages that can't be used in place.
+   */
+  std::vector<uint8_t> msg_buf;
+};
+
+/**
+ * Streaming context for fixed length functions (SHA3, KMAC).
+ */
+template <typename Hasher>
+class FixedContext : public DigestppContext {
+ public:
+  template <typename... Args>
+  explicit FixedContext(Args... args) : hasher(args...) {}
+
+  void Absorb(const uint8_t *data, uint64_t len) override {
+    hasher.absorb(data, len);
+  }
+
+  void Squeeze(uint8_t *out, uint64_t len) override { hasher.digest(out, len); }
+
+  Hasher hasher;
+};
+
+/**
+ * Streaming context for extendable output functions (SHAKE, cSHAKE,
+ * KMAC-XOF).
+ */
+template <typename Hasher>
+class XofContext : public DigestppContext {
+ public:
+  void Absorb(const uint8_t *data, uint64_t len) override {
+    // The hasher doesn't check this itself: absorbing more data would corrupt
+    // the sponge state.
+    if (squeezed_) {
+      throw std::logic_error("cannot absorb data into an XOF after squeezing");
+    }
+    hasher.absorb(data, len);
+  }
+
+  void Squeeze(uint8_t *out, uint64_t len) override {
+    hasher.squeeze(out, len);
+    squeezed_ = true;
+  }
+
+  Hasher hasher;
+
+ private:
+  bool squeezed_ = false;
+};
+
+/**
+ * Create a cSHAKE streaming context.
+ */
+template <typename CShake>
+static void *cshake_init(const char *function_name,
+                         const char *customization_str) {
+  auto *ctx = new XofContext<CShake>();
+  ctx->hasher.set_function_name(function_name, strlen(function_name));
+  ctx->hasher.set_customization(customization_str, strlen(customization_str));
+  return ctx;
+}
+
+/**
+ * Create a KMAC streaming context.
+ */
+template <typename Context, typename... Args>
+static void *kmac_init(const uint8_t *key, uint64_t key_len,
+                       const char *customization_str, Args... args) {
+  auto *ctx = new Context(args...);
+  ctx->hasher.set_customization(customization_str, strlen(customization_str));
+  ctx->hasher.set_key(key, key_len);
+  return ctx;
+}
+
+extern "C" {
+
 //////////////
 // SHA3-224 //
 //////////////
@@ -120,23 +331,8 @@ extern void c_dpi_sha3_512(const svOpenArrayHandle msg, uint64_t msg_len,
 //////////////
 extern void c_dpi_shake128(const svOpenArrayHandle msg, uint64_t msg_len,
                            uint64_t output_len, svOpenArrayHandle digest) {
-  // Load message from SV memory
-  uint8_t *msg_arr = (uint8_t *)malloc(msg_len * sizeof(uint8_t));
-  load_arr_from_simulator(msg, msg_arr, msg_len);
-
-  uint8_t digest_arr[output_len];
-
-  // Compute the digest
   digestpp::shake128 shake;
-  shake.absorb(msg_arr, msg_len);
-  shake.squeeze(digest_arr, output_len);
-
-  if (msg_arr != nullptr) {
-    free(msg_arr);
-  }
-
-  // Return the digest array to SV code
-  write_array_to_simulator(digest, digest_arr);
+  get_xof_digest(&shake, msg, msg_len, output_len, digest);
 }
 
 //////////////
@@ -144,23 +340,8 @@ extern void c_dpi_shake128(const svOpenArrayHandle msg, uint64_t msg_len,
 //////////////
 extern void c_dpi_shake256(const svOpenArrayHandle msg, uint64_t msg_len,
                            uint64_t output_len, svOpenArrayHandle digest) {
-  // Load message from SV memory
-  uint8_t *msg_arr = (uint8_t *)malloc(msg_len * sizeof(uint8_t));
-  load_arr_from_simulator(msg, msg_arr, msg_len);
-
-  uint8_t digest_arr[output_len];
-
-  // Compute the digest
   digestpp::shake256 shake;
-  shake.absorb(msg_arr, msg_len);
-  shake.squeeze(digest_arr, output_len);
-
-  if (msg_arr != nullptr) {
-    free(msg_arr);
-  }
-
-  // Return the digest array to SV code
-  write_array_to_simulator(digest, digest_arr);
+  get_xof_digest(&shake, msg, msg_len, output_len, digest);
 }
 
 ///////////////
@@ -170,25 +351,10 @@ extern void c_dpi_cshake128(const svOpenArrayHandle msg,
                             const char *function_name,
                             const char *customization_str, uint64_t msg_len,
                             uint64_t output_len, svOpenArrayHandle digest) {
-  // Load message from SV memory
-  uint8_t *msg_arr = (uint8_t *)malloc(msg_len * sizeof(uint8_t));
-  load_arr_from_simulator(msg, msg_arr, msg_len);
-
-  uint8_t digest_arr[output_len];
-
-  // Compute the digest
   digestpp::cshake128 shake;
   shake.set_function_name(function_name, strlen(function_name));
   shake.set_customization(customization_str, strlen(customization_str));
-  shake.absorb(msg_arr, msg_len);
-  shake.squeeze(digest_arr, output_len);
-
-  if (msg_arr != nullptr) {
-    free(msg_arr);
-  }
-
-  // Return the digest array to SV code
-  write_array_to_simulator(digest, digest_arr);
+  get_xof_digest(&shake, msg, msg_len, output_len, digest);
 }
 
 ///////////////
@@ -198,25 +364,10 @@ extern void c_dpi_cshake256(const svOpenArrayHandle msg,
                             const char *function_name,
                             const char *customization_str, uint64_t msg_len,
                             uint64_t output_len, svOpenArrayHandle digest) {
-  // Load message from SV memory
-  uint8_t *msg_arr = (uint8_t *)malloc(msg_len * sizeof(uint8_t));
-  load_arr_from_simulator(msg, msg_arr, msg_len);
-
-  uint8_t digest_arr[output_len];
-
-  // Compute the digest
   digestpp::cshake256 shake;
   shake.set_function_name(function_name, strlen(function_name));
   shake.set_customization(customization_str, strlen(customization_str));
-  shake.absorb(msg_arr, msg_len);
-  shake.squeeze(digest_arr, output_len);
-
-  if (msg_arr != nullptr) {
-    free(msg_arr);
-  }
-
-  // Return the digest array to SV code
-  write_array_to_simulator(digest, digest_arr);
+  get_xof_digest(&shake, msg, msg_len, output_len, digest);
 }
 
 /////////////
@@ -225,36 +376,9 @@ extern void c_dpi_cshake256(const svOpenArrayHandle msg,
 extern void c_dpi_kmac128(const svOpenArrayHandle msg, uint64_t msg_len,
                           const svOpenArrayHandle key, uint64_t key_len,
                           const char *customization_str, uint64_t output_len,
-                          svBitVecVal *digest) {
-  uint64_t output_len_bits = output_len * 8;
-
-  // Load message from SV memory
-  uint8_t *msg_arr = (uint8_t *)malloc(msg_len * sizeof(uint8_t));
-  load_arr_from_simulator(msg, msg_arr, msg_len);
-
-  // Load key from SV memory
-  uint8_t *key_arr = (uint8_t *)malloc(key_len * sizeof(uint8_t));
-  load_arr_from_simulator(key, key_arr, key_len);
-
-  uint8_t digest_arr[output_len];
-
-  // Compute the digest
-  digestpp::kmac128 kmac(output_len_bits);
-  kmac.set_customization(customization_str, strlen(customization_str));
-  kmac.set_key(key_arr, key_len);
-  kmac.absorb(msg_arr, msg_len);
-  kmac.digest(digest_arr, sizeof(digest_arr));
-
-  if (msg_arr != nullptr) {
-    free(msg_arr);
-  }
-
-  if (key_arr != nullptr) {
-    free(key_arr);
-  }
-
-  // Return the digest array to SV code
-  write_array_to_simulator(digest, digest_arr);
+                          svOpenArrayHandle digest) {
+  get_kmac_digest<digestpp::kmac128>(msg, msg_len, key, key_len,
+                                     customization_str, output_len, digest);
 }
 
 /////////////////
@@ -263,34 +387,9 @@ extern void c_dpi_kmac128(const svOpenArrayHandle msg, uint64_t msg_len,
 extern void c_dpi_kmac128_xof(const svOpenArrayHandle msg, uint64_t msg_len,
                               const svOpenArrayHandle key, uint64_t key_len,
                               const char *customization_str,
-                              uint64_t output_len, svBitVecVal *digest) {
-  // Load message from SV memory
-  uint8_t *msg_arr = (uint8_t *)malloc(msg_len * sizeof(uint8_t));
-  load_arr_from_simulator(msg, msg_arr, msg_len);
-
-  // Load key from SV memory
-  uint8_t *key_arr = (uint8_t *)malloc(key_len * sizeof(uint8_t));
-  load_arr_from_simulator(key, key_arr, key_len);
-
-  uint8_t digest_arr[output_len];
-
-  // Compute the digest
-  digestpp::kmac128_xof kmac;
-  kmac.set_customization(customization_str, strlen(customization_str));
-  kmac.set_key(key_arr, key_len);
-  kmac.absorb(msg_arr, msg_len);
-  kmac.squeeze(digest_arr, sizeof(digest_arr));
-
-  if (msg_arr != nullptr) {
-    free(msg_arr);
-  }
-
-  if (key_arr != nullptr) {
-    free(key_arr);
-  }
-
-  // Return the digest array to SV code
-  write_array_to_simulator(digest, digest_arr);
+                              uint64_t output_len, svOpenArrayHandle digest) {
+  get_kmac_xof_digest<digestpp::kmac128_xof>(
+      msg, msg_len, key, key_len, customization_str, output_len, digest);
 }
 
 /////////////
@@ -299,36 +398,9 @@ extern void c_dpi_kmac128_xof(const svOpenArrayHandle msg, uint64_t msg_len,
 extern void c_dpi_kmac256(const svOpenArrayHandle msg, uint64_t msg_len,
                           const svOpenArrayHandle key, uint64_t key_len,
                           const char *customization_str, uint64_t output_len,
-                          svBitVecVal *digest) {
-  uint64_t output_len_bits = output_len * 8;
-
-  // Load message from SV memory
-  uint8_t *msg_arr = (uint8_t *)malloc(msg_len * sizeof(uint8_t));
-  load_arr_from_simulator(msg, msg_arr, msg_len);
-
-  // Load key from SV memory
-  uint8_t *key_arr = (uint8_t *)malloc(key_len * sizeof(uint8_t));
-  load_arr_from_simulator(key, key_arr, key_len);
-
-  uint8_t digest_arr[output_len];
-
-  // Compute the digest
-  digestpp::kmac256 kmac(output_len_bits);
-  kmac.set_customization(customization_str, strlen(customization_str));
-  kmac.set_key(key_arr, key_len);
-  kmac.absorb(msg_arr, msg_len);
-  kmac.digest(digest_arr, sizeof(digest_arr));
-
-  if (msg_arr != nullptr) {
-    free(msg_arr);
-  }
-
-  if (key_arr != nullptr) {
-    free(key_arr);
-  }
-
-  // Return the digest array to SV code
-  write_array_to_simulator(digest, digest_arr);
+                          svOpenArrayHandle digest) {
+  get_kmac_digest<digestpp::kmac256>(msg, msg_len, key, key_len,
+                                     customization_str, output_len, digest);
 }
 
 /////////////////
@@ -337,33 +409,148 @@ extern void c_dpi_kmac256(const svOpenArrayHandle msg, uint64_t msg_len,
 extern void c_dpi_kmac256_xof(const svOpenArrayHandle msg, uint64_t msg_len,
                               const svOpenArrayHandle key, uint64_t key_len,
                               const char *customization_str,
-                              uint64_t output_len, svBitVecVal *digest) {
-  // Load message from SV memory
-  uint8_t *msg_arr = (uint8_t *)malloc(msg_len * sizeof(uint8_t));
-  load_arr_from_simulator(msg, msg_arr, msg_len);
+                              uint64_t output_len, svOpenArrayHandle digest) {
+  get_kmac_xof_digest<digestpp::kmac256_xof>(
+      msg, msg_len, key, key_len, customization_str, output_len, digest);
+}
 
-  // Load key from SV memory
-  uint8_t *key_arr = (uint8_t *)malloc(key_len * sizeof(uint8_t));
-  load_arr_from_simulator(key, key_arr, key_len);
+////////////////////////
+// STREAMING CONTEXTS //
+////////////////////////
 
-  uint8_t digest_arr[output_len];
+/**
+ * Create a SHA3 streaming context.
+ *
+ * @param sha_len Digest length in bits, one of {224, 256, 384, 512}.
+ * @return Context handle, to be released with `c_dpi_digestpp_free()`.
+ */
+extern void *c_dpi_sha3_init(uint32_t sha_len) {
+  return new FixedContext<digestpp::sha3>(sha_len);
+}
 
-  // Compute the digest
-  digestpp::kmac256_xof kmac;
-  kmac.set_customization(customization_str, strlen(customization_str));
-  kmac.set_key(key_arr, key_len);
-  kmac.absorb(msg_arr, msg_len);
-  kmac.squeeze(digest_arr, sizeof(digest_arr));
+/**
+ * Create a SHAKE streaming context.
+ *
+ * @param strength Security strength, one of {128, 256}.
+ * @return Context handle, or NULL if `strength` is invalid.
+ */
+extern void *c_dpi_shake_init(uint32_t strength) {
+  switch (strength) {
+    case 128:
+      return new XofContext<digestpp::shake128>();
+    case 256:
+      return new XofContext<digestpp::shake256>();
+    default:
+      fprintf(stderr, "c_dpi_shake_init: invalid strength %u\n", strength);
+      return nullptr;
+  }
+}
+
+/**
+ * Create a cSHAKE streaming context.
+ *
+ * @param strength Security strength, one of {128, 256}.
+ * @param function_name Function name string.
+ * @param customization_str Customization string.
+ * @return Context handle, or NULL if `strength` is invalid.
+ */
+extern void *c_dpi_cshake_init(uint32_t strength, const char *function_name,
+                               const char *customization_str) {
+  switch (strength) {
+    case 128:
+      return cshake_init<digestpp::cshake128>(function_name, customization_str);
+    case 256:
+      return cshake_init<digestpp::cshake256>(function_name, customization_str);
+    default:
+      fprintf(stderr, "c_dpi_cshake_init: invalid strength %u\n", strength);
+      return nullptr;
+  }
+}
+
+/**
+ * Create a KMAC or KMAC-XOF streaming context.
+ *
+ * @param strength Security strength, one of {128, 256}.
+ * @param xof Whether to create a KMAC-XOF context.
+ * @param key Key bytes.
+ * @param key_len Number of key bytes.
+ * @param customization_str Customization string.
+ * @param output_len Number of digest bytes, ignored for KMAC-XOF.
+ * @return Context handle, or NULL if `strength` is invalid.
+ */
+extern void *c_dpi_kmac_init(uint32_t strength, svBit xof,
+                             const svOpenArrayHandle key, uint64_t key_len,
+                             const char *customization_str,
+                             uint64_t output_len) {
+  std::vector<uint8_t> key_buf;
+  const uint8_t *key_arr = get_arr_from_simulator(key, key_len, &key_buf);
+  uint64_t output_len_bits = output_len * 8;
 
-  if (msg_arr != nullptr) {
-    free(msg_arr);
+  switch (strength) {
+    case 128:
+      if (xof) {
+        return kmac_init<XofContext<digestpp::kmac128_xof>>(key_arr, key_len,
+                                                            customization_str);
+      }
+      return kmac_init<FixedContext<digestpp::kmac128>>(
+          key_arr, key_len, customization_str, output_len_bits);
+    case 256:
+      if (xof) {
+        return kmac_init<XofContext<digestpp::kmac256_xof>>(key_arr, key_len,
+                                                            customization_str);
+      }
+      return kmac_init<FixedContext<digestpp::kmac256>>(
+          key_arr, key_len, customization_str, output_len_bits);
+    default:
+      fprintf(stderr, "c_dpi_kmac_init: invalid strength %u\n", strength);
+      return nullptr;
+  }
+}
+
+/**
+ * Absorb `msg_len` bytes of `msg` into a streaming context.
+ */
+extern void c_dpi_digestpp_absorb(void *ctx_handle,
+                                  const svOpenArrayHandle msg,
+                                  uint64_t msg_len) {
+  auto *ctx = static_cast<DigestppContext *>(ctx_handle);
+  if (ctx == nullptr || msg_len == 0) {
+    return;
+  }
+  const uint8_t *msg_arr = get_arr_from_simulator(msg, msg_len, &ctx->msg_buf);
+  try {
+    ctx->Absorb(msg_arr, msg_len);
+  } catch (const std::exception &e) {
+    fprintf(stderr, "c_dpi_digestpp_absorb: %s\n", e.what());
   }
+}
 
-  if (key_arr != nullptr) {
-    free(key_arr);
+/**
+ * Squeeze `output_len` bytes from a streaming context into `digest`.
+ *
+ * See `DigestppContext::Squeeze()` for the semantics of fixed length and XOF
+ * contexts.
+ */
+extern void c_dpi_digestpp_squeeze(void *ctx_handle, uint64_t output_len,
+                                   svOpenArrayHandle digest) {
+  auto *ctx = static_cast<DigestppContext *>(ctx_handle);
+  if (ctx == nullptr) {
+    return;
   }
+  std::vector<uint8_t> digest_arr(output_len);
+  try {
+    ctx->Squeeze(digest_arr.data(), output_len);
+  } catch (const std::exception &e) {
+    fprintf(stderr, "c_dpi_digestpp_squeeze: %s\n", e.what());
+    return;
+  }
+  write_array_to_simulator(digest, digest_arr.data());
+}
 
-  // Return the digest array to SV code
-  write_array_to_simulator(digest, digest_arr);
+/**
+ * Release a streaming context.
+ */
+extern void c_dpi_digestpp_free(void *ctx_handle) {
+  delete static_cast<DigestppContext *>(ctx_handle);
 }
 }
@@ -107,4 +107,52 @@ package digestpp_dpi_pkg;
     output bit[7:0]         digest[]
   );
 
+  // Streaming contexts.
+  //
+  // These let the testbench absorb a message as the RTL consumes it instead of
+  // re-hashing the whole message for every check. For fixed length functions
+  // (SHA3, KMAC), c_dpi_digestpp_squeeze() returns the digest of the data
+  // absorbed so far and more data can be absorbed afterwards. For XOFs (SHAKE,
+  // cSHAKE, KMAC-XOF), it returns the next output_len bytes of output and no
+  // more data can be absorbed afterwards. Contexts must be released with
+  // c_dpi_digestpp_free().
+  import "DPI-C" function chandle c_dpi_sha3_init(
+    input int unsigned      sha_len
+  );
+
+  import "DPI-C" function chandle c_dpi_shake_init(
+    input int unsigned      strength
+  );
+
+  import "DPI-C" function chandle c_dpi_cshake_init(
+    input int unsigned      strength,
+    input string            function_name,
+    input string            customization_str
+  );
+
+  import "DPI-C" context function chandle c_dpi_kmac_init(
+    input int unsigned      strength,
+    input bit               xof,
+    input bit[7:0]          key[],
+    input longint unsigned  key_len,
+    input string            customization_str,
+    input longint unsigned  output_len
+  );
+
+  import "DPI-C" context function void c_dpi_digestpp_absorb(
+    input chandle           ctx,
+    input bit[7:0]          msg[],
+    input longint unsigned  msg_len
+  );
+
+  import "DPI-C" context function void c_dpi_digestpp_squeeze(
+    input chandle           ctx,
+    input longint unsigned  output_len,
+    output bit[7:0]         digest[]
+  );
+
+  import "DPI-C" function void c_dpi_digestpp_free(
+    input chandle           ctx
+  );
+
 endpackage
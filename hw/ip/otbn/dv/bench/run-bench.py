@@ -0,0 +1,524 @@
+#!/usr/bin/env python3
+# Copyright lowRISC contributors.
+# Licensed under the Apache License, Version 2.0, see LICENSE for details.
+# SPDX-License-Identifier: Apache-2.0
+
+'''Run OTBN programs on the ISS and the Verilated RTL and report performance
+
+Use this with a command line like
+
+    run-bench.py --json=bench.json --csv=bench.csv XXX
+
+which builds the code snippets in sw/otbn/code-snippets and a Verilated model
+of OTBN (using otbn_top_sim) in the directory XXX. It then runs each benchmark
+program on the standalone ISS and on the Verilated model, checks that both
+runs finished at the expected address and agree on the final register values,
+and reports the cycles, instructions, stall cycles and host wall time of each
+run.
+
+Pass --rig-count=N to benchmark N random programs from the random instruction
+generator too (see ../uvm/gen-binaries.py, which needs the toolchain
+configuration from meson_init.sh).
+
+The cycle counts are deterministic, so any change across commits is a change
+in OTBN performance. The wall times measure the speed of the simulators
+themselves. Pass --baseline with the JSON report of an earlier run to compare
+against it.
+
+'''
+
+import argparse
+import csv
+import json
+import os
+import platform
+import re
+import shlex
+import subprocess
+import sys
+import time
+from typing import Dict, List, Optional, TextIO, Tuple
+
+_SCRIPT_DIR = os.path.dirname(__file__)
+
+# Programs from sw/otbn/code-snippets that run to completion on their own.
+# The library snippets (modexp.s, p256.s, p384_sign.s, rsa_verify_3072.s and
+# so on) are run through the tests that link against them.
+DEFAULT_SNIPPETS = [
+    'mul256',
+    'mul384',
+    'barrett384',
+    'rsa_1024_enc_test',
+    'rsa_1024_dec_test',
+    'rsa_verify_test',
+    'rsa_verify_3072_test',
+    'p256_ecdsa_sign_test',
+    'p256_ecdsa_verify_test',
+    'p384_ecdsa_sign_test',
+    'p384_ecdsa_verify_test',
+]
+
+TB_PATH = 'build/lowrisc_ip_otbn_top_sim_0.1/sim-verilator/Votbn_top_sim'
+
+CSV_FIELDS = ['name',
+              'iss_insns', 'iss_cycles', 'iss_stalls', 'iss_cpi',
+              'iss_wall_s',
+              'rtl_insns', 'rtl_cycles', 'rtl_stalls', 'rtl_cpi',
+              'rtl_wall_s', 'rtl_khz',
+              'passed', 'error']
+
+_ISS_STATS_RE = re.compile(r'OTBN executed ([0-9]+) instructions '
+                           r'in ([0-9]+) cycles')
+_ISS_STALLS_RE = re.compile(r'The execution stalled for ([0-9]+) cycles')
+_ISS_REG_RE = re.compile(r'^\s*([xw][0-9]+)\s*= 0x([0-9a-f]+)$')
+
+_RTL_PROFILE_RE = re.compile(r'OTBN profile: ([0-9]+) cycles '
+                             r'\(([0-9]+) stalled\), ([0-9]+) instructions')
+_RTL_REG_RE = re.compile(r'^([xw][0-9]+)\s*\| 0x([0-9a-f_]+)$')
+
+
+def get_projdir() -> str:
+    '''Return the path to the top of the project'''
+    path = os.path.join(_SCRIPT_DIR, '../../../../..')
+    assert os.path.exists(os.path.join(path, '.git'))
+    return os.path.normpath(path)
+
+
+def read_positive(val: str) -> int:
+    ival = -1
+    try:
+        ival = int(val, 0)
+    except ValueError:
+        pass
+
+    if ival <= 0:
+        raise argparse.ArgumentTypeError('{!r} is not a positive integer.'
+                                         .format(val))
+    return ival
+
+
+class RunResult:
+    '''The result of running a program on the ISS or on the RTL'''
+    def __init__(self) -> None:
+        self.insns = None  # type: Optional[int]
+        self.cycles = None  # type: Optional[int]
+        self.stalls = None  # type: Optional[int]
+        self.wall_s = None  # type: Optional[float]
+        self.regs = {}  # type: Dict[str, int]
+        self.error = None  # type: Optional[str]
+
+    def cpi(self) -> Optional[float]:
+        if not self.insns or self.cycles is None:
+            return None
+        return self.cycles / self.insns
+
+    def khz(self) -> Optional[float]:
+        '''Simulated cycles per second of host wall time, in kHz'''
+        if not self.wall_s or self.cycles is None:
+            return None
+        return self.cycles / self.wall_s / 1e3
+
+
+class Benchmark:
+    def __init__(self, name: str, elf: str) -> None:
+        self.name = name
+        self.elf = elf
+        self.iss = None  # type: Optional[RunResult]
+        self.rtl = None  # type: Optional[RunResult]
+        self.errors = []  # type: List[str]
+
+    def check(self) -> None:
+        '''Check the ISS and RTL runs against each other'''
+        runs = [('ISS', self.iss), ('RTL', self.rtl)]
+        for engine, res in runs:
+            if res is not None and res.error is not None:
+                self.errors.append('{}: {}'.format(engine, res.error))
+        if self.errors or self.iss is None or self.rtl is None:
+            return
+
+        # otbn_top_sim already runs the ISS in lockstep with the RTL, checking
+        # their state as it goes. This checks the standalone ISS run (which
+        # gives the ISS figures) against the RTL too. The RTL simulation
+        # prints x2 upwards (x0 is zero and x1 is the call stack), so only
+        # compare those.
+        for reg, rtl_val in self.rtl.regs.items():
+            iss_val = self.iss.regs.get(reg)
+            if iss_val != rtl_val:
+                self.errors.append('Final value of {} differs: ISS has {}, '
+                                   'RTL has {:#x}.'
+                                   .format(reg,
+                                           'nothing' if iss_val is None
+                                           else hex(iss_val),
+                                           rtl_val))
+                break
+
+    def passed(self) -> bool:
+        return not self.errors
+
+    def to_dict(self) -> Dict[str, object]:
+        ret = {'name': self.name,
+               'passed': self.passed(),
+               'error': ' '.join(self.errors)}  # type: Dict[str, object]
+        for prefix, res in [('iss', self.iss), ('rtl', self.rtl)]:
+            if res is None:
+                continue
+            ret[prefix + '_insns'] = res.insns
+            ret[prefix + '_cycles'] = res.cycles
+            ret[prefix + '_stalls'] = res.stalls
+            ret[prefix + '_cpi'] = res.cpi()
+            ret[prefix + '_wall_s'] = res.wall_s
+            if prefix == 'rtl':
+                ret['rtl_khz'] = res.khz()
+        return ret
+
+
+def run_cmd(cmd: List[str], timeout: int,
+            log_path: str) -> Tuple[Optional[str], float]:
+    '''Run cmd, writing its output to log_path
+
+    Returns (error, wall_s) where error is None on success.
+
+    '''
+    start = time.monotonic()
+    with open(log_path, 'w') as log:
+        log.write('# {}\n'.format(' '.join(shlex.quote(a) for a in cmd)))
+        log.flush()
+        try:
+            proc = subprocess.run(cmd, stdout=log, stderr=subprocess.STDOUT,
+                                  timeout=timeout, check=False)
+        except subprocess.TimeoutExpired:
+            return ('Timed out after {} seconds.'.format(timeout),
+                    time.monotonic() - start)
+    wall_s = time.monotonic() - start
+
+    if proc.returncode:
+        return ('Exited with status {} (see {}).'
+                .format(proc.returncode, log_path), wall_s)
+    return (None, wall_s)
+
+
+def run_iss(bench: Benchmark, destdir: str, timeout: int) -> RunResult:
+    '''Run a benchmark on the standalone ISS'''
+    standalone = os.path.join(_SCRIPT_DIR, '../otbnsim/standalone.py')
+    regs_path = os.path.join(destdir, bench.name + '.iss.regs')
+    stats_path = os.path.join(destdir, bench.name + '.iss.stats')
+    cmd = [sys.executable, standalone,
+           '--dump-regs', regs_path,
+           '--dump-stats', stats_path,
+           bench.elf]
+
+    res = RunResult()
+    res.error, res.wall_s = run_cmd(cmd, timeout,
+                                    os.path.join(destdir,
+                                                 bench.name + '.iss.log'))
+    if res.error is not None:
+        return res
+
+    with open(stats_path) as stats_file:
+        stats = stats_file.read()
+    match = _ISS_STATS_RE.search(stats)
+    stalls_match = _ISS_STALLS_RE.search(stats)
+    if match is None or stalls_match is None:
+        res.error = 'No execution time in {}.'.format(stats_path)
+        return res
+    res.insns = int(match.group(1))
+    res.cycles = int(match.group(2))
+    res.stalls = int(stalls_match.group(1))
+
+    with open(regs_path) as regs_file:
+        for line in regs_file:
+            reg_match = _ISS_REG_RE.match(line)
+            if reg_match is not None:
+                res.regs[reg_match.group(1)] = int(reg_match.group(2), 16)
+
+    return res
+
+
+def run_rtl(bench: Benchmark, destdir: str, tb: str,
+            timeout: int) -> RunResult:
+    '''Run a benchmark on the Verilated RTL (otbn_top_sim)'''
+    profile_path = os.path.join(destdir, bench.name + '.rtl.profile')
+    log_path = os.path.join(destdir, bench.name + '.rtl.log')
+    cmd = [tb,
+           '--load-elf={}'.format(bench.elf),
+           '--otbn-profile={}'.format(profile_path)]
+
+    res = RunResult()
+    res.error, res.wall_s = run_cmd(cmd, timeout, log_path)
+    if res.error is not None:
+        return res
+
+    with open(profile_path) as profile_file:
+        match = _RTL_PROFILE_RE.search(profile_file.readline())
+    if match is None:
+        res.error = 'No cycle counts in {}.'.format(profile_path)
+        return res
+    res.cycles = int(match.group(1))
+    res.stalls = int(match.group(2))
+    res.insns = int(match.group(3))
+
+    with open(log_path) as log:
+        for line in log:
+            reg_match = _RTL_REG_RE.match(line.strip())
+            if reg_match is not None:
+                res.regs[reg_match.group(1)] = \
+                    int(reg_match.group(2).replace('_', ''), 16)
+
+    return res
+
+
+def build_snippets(destdir: str, names: List[str]) -> Dict[str, str]:
+    '''Build the named code snippets, returning a map from name to ELF path'''
+    projdir = get_projdir()
+    snippets_dir = os.path.join(projdir, 'sw/otbn/code-snippets')
+    bin_dir = os.path.abspath(os.path.join(destdir, 'build-bin'))
+    obj_dir = os.path.abspath(os.path.join(destdir, 'build-out'))
+
+    # The Makefile in code-snippets knows which snippets link against which
+    # libraries, so ask it for the ELF files we need.
+    elfs = {name: os.path.join(bin_dir, 'sw/otbn/code-snippets',
+                               name + '.elf')
+            for name in names}
+    cmd = (['make', '-C', snippets_dir,
+            'BIN_DIR={}'.format(bin_dir), 'OBJ_DIR={}'.format(obj_dir)] +
+           list(elfs.values()))
+    if subprocess.run(cmd, check=False).returncode:
+        raise RuntimeError('Failed to build code snippets (command: {})'
+                           .format(' '.join(shlex.quote(a) for a in cmd)))
+    return elfs
+
+
+def build_rig(destdir: str, obj_dir: Optional[str],
+              count: int, seed: int, size: int) -> Dict[str, str]:
+    '''Generate and build random programs with gen-binaries.py'''
+    gen_binaries = os.path.join(_SCRIPT_DIR, '../uvm/gen-binaries.py')
+    rig_dir = os.path.join(destdir, 'rig')
+    cmd = [gen_binaries,
+           '--count={}'.format(count),
+           '--seed={}'.format(seed),
+           '--size={}'.format(size)]
+    if obj_dir is not None:
+        cmd.append('--obj-dir={}'.format(obj_dir))
+    cmd.append(rig_dir)
+    if subprocess.run(cmd, check=False).returncode:
+        raise RuntimeError('Failed to generate random binaries (command: {})'
+                           .format(' '.join(shlex.quote(a) for a in cmd)))
+
+    return {'rig-{}'.format(s): os.path.join(rig_dir, '{}.elf'.format(s))
+            for s in range(seed, seed + count)}
+
+
+def build_tb(destdir: str) -> str:
+    '''Build the Verilated model in destdir, returning the path to it'''
+    projdir = os.path.relpath(get_projdir(), destdir)
+    cmd = ['fusesoc', '--cores-root={}'.format(projdir),
+           'run', '--target=sim', '--setup', '--build',
+           'lowrisc:ip:otbn_top_sim']
+    with open(os.path.join(destdir, 'fusesoc.log'), 'w') as log:
+        if subprocess.run(cmd, cwd=destdir, stdout=log,
+                          stderr=subprocess.STDOUT, check=False).returncode:
+            raise RuntimeError('Failed to build otbn_top_sim (see {}).'
+                               .format(os.path.join(destdir, 'fusesoc.log')))
+    return os.path.abspath(os.path.join(destdir, TB_PATH))
+
+
+def fmt_num(val: object, places: int = 0) -> str:
+    if val is None:
+        return '-'
+    if isinstance(val, float):
+        return '{:.{}f}'.format(val, places)
+    return str(val)
+
+
+def print_table(results: List[Dict[str, object]], handle: TextIO) -> None:
+    cols = [('Program', 'name', 0),
+            ('ISS insns', 'iss_insns', 0),
+            ('ISS cycles', 'iss_cycles', 0),
+            ('Stalls', 'iss_stalls', 0),
+            ('CPI', 'iss_cpi', 3),
+            ('ISS s', 'iss_wall_s', 2),
+            ('RTL cycles', 'rtl_cycles', 0),
+            ('RTL s', 'rtl_wall_s', 2),
+            ('RTL kHz', 'rtl_khz', 1),
+            ('Result', 'passed', 0)]
+    rows = [[title for title, _, _ in cols]]
+    for res in results:
+        row = [fmt_num(res.get(key), places) for _, key, places in cols[:-1]]
+        row.append('PASS' if res['passed'] else 'FAIL')
+        rows.append(row)
+
+    widths = [max(len(row[i]) for row in rows) for i in range(len(cols))]
+    for row in rows:
+        handle.write('  '.join(val.rjust(width) if idx else val.ljust(width)
+                               for idx, (val, width)
+                               in enumerate(zip(row, widths))).rstrip())
+        handle.write('\n')
+
+    for res in results:
+        if not res['passed']:
+            handle.write('\n{}: {}'.format(res['name'], res['error']))
+    handle.write('\n')
+
+
+def compare_baseline(results: List[Dict[str, object]],
+                     baseline_path: str, handle: TextIO) -> bool:
+    '''Compare results with an earlier report
+
+    Returns True if any program took more cycles than in the baseline.
+
+    '''
+    with open(baseline_path) as baseline_file:
+        baseline = json.load(baseline_file)
+    old_results = {res['name']: res for res in baseline['results']}
+
+    handle.write('\nChanges from {} ({}):\n'
+                 .format(baseline_path, baseline.get('git_version', '?')))
+    regressed = False
+    changes = 0
+    for res in results:
+        old = old_results.get(str(res['name']))
+        if old is None:
+            continue
+        for key in ['iss_cycles', 'rtl_cycles', 'iss_wall_s', 'rtl_wall_s']:
+            new_val = res.get(key)
+            old_val = old.get(key)
+            if not isinstance(new_val, (int, float)) or not old_val:
+                continue
+            ratio = new_val / old_val
+            # Cycle counts are exact, but wall times are noisy: only report
+            # those that changed by more than 10%.
+            if key.endswith('_cycles'):
+                if new_val == old_val:
+                    continue
+                regressed = regressed or new_val > old_val
+            elif abs(ratio - 1) < 0.1:
+                continue
+            handle.write('  {}: {} {} -> {} ({:+.1f}%)\n'
+                         .format(res['name'], key,
+                                 fmt_num(old_val, 2), fmt_num(new_val, 2),
+                                 100 * (ratio - 1)))
+            changes += 1
+    if not changes:
+        handle.write('  (none)\n')
+    return regressed
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser()
+    parser.add_argument('--program', action='append', metavar='NAME',
+                        help=('Code snippet to run (may be given more than '
+                              'once). Unless this or --elf is supplied, '
+                              'runs: {}.'
+                              .format(', '.join(DEFAULT_SNIPPETS))))
+    parser.add_argument('--elf', action='append', default=[],
+                        help='Run this prebuilt ELF file too')
+    parser.add_argument('--rig-count', type=int, default=0,
+                        help=('Number of random programs to generate and '
+                              'run (default: 0)'))
+    parser.add_argument('--rig-seed', type=read_positive, default=1)
+    parser.add_argument('--rig-size', type=read_positive, default=1000)
+    parser.add_argument('--obj-dir',
+                        help=('Object directory configured with Meson, '
+                              'for --rig-count (see gen-binaries.py)'))
+    parser.add_argument('--tb',
+                        help=('Path to an existing Votbn_top_sim binary. If '
+                              'not supplied, it is built in destdir.'))
+    parser.add_argument('--no-rtl', action='store_true',
+                        help="Only run the ISS")
+    parser.add_argument('--no-iss', action='store_true',
+                        help="Only run the RTL")
+    parser.add_argument('--timeout', type=read_positive, default=3600,
+                        help='Timeout for each run, in seconds')
+    parser.add_argument('--json', type=argparse.FileType('w'),
+                        help='Write a JSON report to this file')
+    parser.add_argument('--csv', type=argparse.FileType('w'),
+                        help='Write a CSV report to this file')
+    parser.add_argument('--baseline',
+                        help='Compare with this earlier JSON report')
+    parser.add_argument('--fail-on-regression', action='store_true',
+                        help=('Exit with an error if a program takes more '
+                              'cycles than in the baseline'))
+    parser.add_argument('destdir', help='Destination directory')
+
+    args = parser.parse_args()
+    if args.no_rtl and args.no_iss:
+        print('Nothing to do: --no-rtl and --no-iss both supplied.',
+              file=sys.stderr)
+        return 1
+
+    os.makedirs(args.destdir, exist_ok=True)
+    run_dir = os.path.join(args.destdir, 'runs')
+    os.makedirs(run_dir, exist_ok=True)
+
+    # Build everything before running anything, so that the runs aren't
+    # slowed down by a build in the background.
+    try:
+        snippets = args.program or ([] if args.elf else DEFAULT_SNIPPETS)
+        elfs = {}  # type: Dict[str, str]
+        if snippets:
+            elfs = build_snippets(args.destdir, snippets)
+        if args.rig_count > 0:
+            elfs.update(build_rig(args.destdir, args.obj_dir,
+                                  args.rig_count, args.rig_seed,
+                                  args.rig_size))
+        tb = None  # type: Optional[str]
+        if not args.no_rtl:
+            tb = args.tb or build_tb(args.destdir)
+    except RuntimeError as err:
+        print(err, file=sys.stderr)
+        return 1
+
+    for elf in args.elf:
+        elfs[os.path.splitext(os.path.basename(elf))[0]] = \
+            os.path.abspath(elf)
+
+    # Run the benchmarks one at a time, so that the wall times are
+    # comparable.
+    benchmarks = [Benchmark(name, elf) for name, elf in elfs.items()]
+    for bench in benchmarks:
+        print('Running {}...'.format(bench.name), file=sys.stderr)
+        if not args.no_iss:
+            bench.iss = run_iss(bench, run_dir, args.timeout)
+        if tb is not None:
+            bench.rtl = run_rtl(bench, run_dir, tb, args.timeout)
+        bench.check()
+
+    results = [bench.to_dict() for bench in benchmarks]
+
+    git_version = subprocess.run(['git', 'describe', '--always', '--dirty'],
+                                 cwd=get_projdir(), stdout=subprocess.PIPE,
+                                 stderr=subprocess.DEVNULL,
+                                 universal_newlines=True,
+                                 check=False).stdout.strip()
+
+    if args.json is not None:
+        json.dump({'git_version': git_version,
+                   'host': platform.node(),
+                   'python': platform.python_version(),
+                   'time': time.strftime('%Y-%m-%dT%H:%M:%S%z'),
+                   'results': results},
+                  args.json, indent=2)
+        args.json.write('\n')
+
+    if args.csv is not None:
+        writer = csv.DictWriter(args.csv, CSV_FIELDS, extrasaction='ignore')
+        writer.writeheader()
+        for res in results:
+            writer.writerow(res)
+
+    print()
+    print_table(results, sys.stdout)
+
+    regressed = False
+    if args.baseline is not None:
+        regressed = compare_baseline(results, args.baseline, sys.stdout)
+
+    if not all(bench.passed() for bench in benchmarks):
+        return 1
+    if regressed and args.fail_on_regression:
+        return 1
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -4,6 +4,7 @@
 
 #include "otbn_memutil.h"
 
+#include <algorithm>
 #include <cassert>
 #include <cstring>
 #include <gelf.h>
@@ -11,8 +12,10 @@
 #include <libelf.h>
 #include <limits>
 #include <regex>
+#include <set>
 #include <sstream>
 #include <stdexcept>
+#include <sys/stat.h>
 
 #include "scrambled_ecc32_mem_area.h"
 #include "sv_scoped.h"
@@ -21,13 +24,69 @@
 OtbnMemUtil::OtbnMemUtil(const std::string &top_scope)
     : imem_(SVScoped::join_sv_scopes(top_scope, "u_imem"), 4096 / 4, 4 / 4),
       dmem_(SVScoped::join_sv_scopes(top_scope, "u_dmem"), 4096 / 32, 32 / 4),
-      expected_end_addr_(-1) {
+      expected_end_addr_(-1),
+      view_(std::make_shared<ElfView>()) {
   RegisterMemoryArea("imem", 0x4000, &imem_);
   RegisterMemoryArea("dmem", 0x8000, &dmem_);
 }
 
 void OtbnMemUtil::LoadElf(const std::string &elf_path) {
   LoadElfToMemories(false, elf_path);
+  view_ = MakeElfView();
+}
+
+void OtbnMemUtil::StageElfCached(const std::string &elf_path) {
+  struct stat st;
+  if (stat(elf_path.c_str(), &st) != 0) {
+    std::ostringstream oss;
+    oss << "Cannot stat ELF file: " << strerror(errno) << ".";
+    throw std::runtime_error(oss.str());
+  }
+
+  auto it = elf_cache_.find(elf_path);
+  if (it != elf_cache_.end()) {
+    const CachedElf &cached = it->second;
+    if (cached.dev == st.st_dev && cached.ino == st.st_ino &&
+        cached.size == st.st_size &&
+        cached.mtime.tv_sec == st.st_mtim.tv_sec &&
+        cached.mtime.tv_nsec == st.st_mtim.tv_nsec) {
+      view_ = cached.view;
+      loop_warp_ = view_->loop_warps;
+      expected_end_addr_ = view_->expected_end_addr;
+      code_syms_ = view_->code_syms;
+      return;
+    }
+  }
+
+  StageElf(false, elf_path);
+  view_ = MakeElfView();
+  elf_cache_[elf_path] =
+      CachedElf{st.st_dev, st.st_ino, st.st_size, st.st_mtim, view_};
+}
+
+std::shared_ptr<const OtbnMemUtil::ElfView> OtbnMemUtil::MakeElfView() const {
+  auto view = std::make_shared<ElfView>();
+  for (bool is_imem : {true, false}) {
+    std::vector<Segment> &dst = is_imem ? view->imem_segs : view->dmem_segs;
+    for (const auto &pr : GetSegs(is_imem)) {
+      // DpiMemUtil checks that segments are aligned to the memory word size,
+      // which is at least 32 bits for both memories.
+      assert(pr.first.lo % 4 == 0);
+
+      // Round the size up to whole words, padding a ragged edge with zeros.
+      // (This is valid because any next range is also 32 bit aligned).
+      const MemSpan &bytes = pr.second;
+      Segment seg;
+      seg.word_off = pr.first.lo / 4;
+      seg.words.resize((bytes.size() + 3) / 4);
+      memcpy(seg.words.data(), bytes.data(), bytes.size());
+      dst.push_back(std::move(seg));
+    }
+  }
+  view->loop_warps = loop_warp_;
+  view->expected_end_addr = expected_end_addr_;
+  view->code_syms = code_syms_;
+  return view;
 }
 
 const StagedMem::SegMap &OtbnMemUtil::GetSegs(bool is_imem) const {
@@ -45,9 +104,10 @@ void OtbnMemUtil::OnElfLoaded(Elf *elf_file) {
 
   expected_end_addr_ = -1;
   loop_warp_.clear();
+  code_syms_.clear();
 
   // Look through the symbol table of elf_file for an expected end
-  // address and any loop warping symbols.
+  // address, any loop warping symbols and the code labels.
   Elf_Scn *scn = nullptr;
   while ((scn = elf_nextscn(elf_file, scn))) {
     Elf32_Shdr *shdr = elf32_getshdr(scn);
@@ -58,6 +118,9 @@ void OtbnMemUtil::OnElfLoaded(Elf *elf_file) {
     Elf_Data *sec_data = elf_getdata(scn, nullptr);
     assert(sec_data);
 
+    // Addresses in code_syms_ that have a global label
+    std::set<uint32_t> global_addrs;
+
     int num_syms = shdr->sh_size / shdr->sh_entsize;
     for (int i = 0; i < num_syms; ++i) {
       GElf_Sym sym;
@@ -68,6 +131,23 @@ void OtbnMemUtil::OnElfLoaded(Elf *elf_file) {
         continue;
 
       OnSymbol(sym_name, sym.st_value);
+
+      // Keep code labels, except those that OnSymbol handles
+      if (!*sym_name || sym.st_shndx == SHN_UNDEF ||
+          sym.st_shndx >= SHN_LORESERVE ||
+          !strncmp(sym_name, "_loop_warp_", 11))
+        continue;
+      Elf32_Shdr *sym_shdr = elf32_getshdr(elf_getscn(elf_file, sym.st_shndx));
+      if (!sym_shdr || !(sym_shdr->sh_flags & SHF_EXECINSTR))
+        continue;
+      bool is_global = GELF_ST_BIND(sym.st_info) == STB_GLOBAL;
+      auto pr = code_syms_.emplace(sym.st_value, sym_name);
+      if (!pr.second && is_global && !global_addrs.count(sym.st_value)) {
+        pr.first->second = sym_name;
+      }
+      if (is_global) {
+        global_addrs.insert(sym.st_value);
+      }
     }
     break;
   }
@@ -157,7 +237,7 @@ extern "C" svBit OtbnMemUtilStageElf(OtbnMemUtil *mem_util,
   assert(mem_util);
   assert(elf_path);
   try {
-    mem_util->StageElf(false, elf_path);
+    mem_util->StageElfCached(elf_path);
     return sv_1;
   } catch (const std::exception &err) {
     std::cerr << "Failed to load ELF file from `" << elf_path
@@ -168,8 +248,7 @@ extern "C" svBit OtbnMemUtilStageElf(OtbnMemUtil *mem_util,
 
 extern "C" int OtbnMemUtilGetSegCount(OtbnMemUtil *mem_util, svBit is_imem) {
   assert(mem_util);
-  const StagedMem::SegMap &segs = mem_util->GetSegs(is_imem);
-  size_t num_segs = segs.size();
+  size_t num_segs = mem_util->GetElfView().GetSegs(is_imem).size();
 
   // Since the segments are disjoint and 32-bit aligned, there are at most 2^30
   // of them (this, admittedly, would mean an ELF file with a billion segments,
@@ -181,6 +260,20 @@ extern "C" int OtbnMemUtilGetSegCount(OtbnMemUtil *mem_util, svBit is_imem) {
   return num_segs;
 }
 
+// Look up a segment by index, printing a message to stderr and returning null
+// if there is no such segment.
+static const OtbnMemUtil::Segment *GetSegByIdx(const OtbnMemUtil *mem_util,
+                                               svBit is_imem, int seg_idx) {
+  const auto &segs = mem_util->GetElfView().GetSegs(is_imem);
+  if ((seg_idx < 0) || ((unsigned)seg_idx >= segs.size())) {
+    std::cerr << "Invalid segment index: " << seg_idx << ". "
+              << (is_imem ? 'I' : 'D') << "MEM has " << segs.size()
+              << " segments.\n";
+    return nullptr;
+  }
+  return &segs[seg_idx];
+}
+
 extern "C" svBit OtbnMemUtilGetSegInfo(OtbnMemUtil *mem_util, svBit is_imem,
                                        int seg_idx, svBitVecVal *seg_off,
                                        svBitVecVal *seg_size) {
@@ -188,43 +281,17 @@ extern "C" svBit OtbnMemUtilGetSegInfo(OtbnMemUtil *mem_util, svBit is_imem,
   assert(seg_off);
   assert(seg_size);
 
-  const StagedMem::SegMap &segs = mem_util->GetSegs(is_imem);
-
-  // Make sure there is such an index.
-  if ((seg_idx < 0) || ((unsigned)seg_idx > segs.size())) {
-    std::cerr << "Invalid segment index: " << seg_idx << ". "
-              << (is_imem ? 'I' : 'D') << "MEM has " << segs.size()
-              << " segments.\n";
+  const OtbnMemUtil::Segment *seg = GetSegByIdx(mem_util, is_imem, seg_idx);
+  if (!seg) {
     return sv_0;
   }
 
-  // Walk to the desired segment (which we know is safe because we just checked
-  // the index was valid).
-  auto it = std::next(segs.begin(), seg_idx);
-
-  uint32_t seg_addr = it->first.lo;
-
-  // We know that seg_addr must be 32 bit aligned because DpiMemUtil checks its
-  // segments are aligned to the memory word size (which is 32 or 256 bits for
-  // imem/dmem, respectively).
-  assert(seg_addr % 4 == 0);
-
-  uint32_t word_seg_addr = seg_addr / 4;
-
-  size_t size_bytes = it->second.size();
-
   // We know the size can't be too enormous, because the segment fits in a
   // 32-bit address space.
-  assert(size_bytes < std::numeric_limits<uint32_t>::max());
-
-  // Divide by 4 to get the number of 32 bit words. Round up: we'll pad out the
-  // data with zeros if there's a ragged edge. (We know this is valid because
-  // any next range is also 32 bit aligned).
-  uint32_t size_words = ((uint64_t)size_bytes + 3) / 4;
-
-  memcpy(seg_off, &word_seg_addr, sizeof(uint32_t));
-  memcpy(seg_size, &size_words, sizeof(uint32_t));
+  assert(seg->words.size() <= std::numeric_limits<uint32_t>::max() / 4);
 
+  set_sv_u32(seg_off, seg->word_off);
+  set_sv_u32(seg_size, seg->words.size());
   return sv_1;
 }
 
@@ -234,42 +301,50 @@ extern "C" svBit OtbnMemUtilGetSegData(
   assert(mem_util);
   assert(data_value);
 
-  if ((word_off < 0) ||
-      ((unsigned)word_off > std::numeric_limits<uint32_t>::max() / 4)) {
+  if (word_off < 0) {
     std::cerr << "Invalid word offset: " << word_off << ".\n";
     return sv_0;
   }
 
-  uint32_t byte_addr = (unsigned)word_off * 4;
-
-  const StagedMem::SegMap &segs = mem_util->GetSegs(is_imem);
-
-  auto it = segs.find(byte_addr);
-  if (it == segs.end()) {
+  // Find the last segment that starts at or below word_off. Segments are
+  // disjoint and sorted by address, so this is the only one that might
+  // contain it.
+  const auto &segs = mem_util->GetElfView().GetSegs(is_imem);
+  auto it = std::upper_bound(
+      segs.begin(), segs.end(), (uint32_t)word_off,
+      [](uint32_t off, const OtbnMemUtil::Segment &seg) {
+        return off < seg.word_off;
+      });
+  if (it == segs.begin()) {
     return sv_0;
   }
+  --it;
 
-  uint32_t seg_addr = it->first.lo;
-  assert(seg_addr <= byte_addr);
+  uint32_t idx = (uint32_t)word_off - it->word_off;
+  if (idx >= it->words.size()) {
+    return sv_0;
+  }
 
-  // The offset within the segment
-  uint32_t seg_off = byte_addr - seg_addr;
-  assert(seg_off < it->second.size());
+  set_sv_u32(data_value, it->words[idx]);
+  return sv_1;
+}
 
-  // How many bytes are available in the segment, starting at seg_off? We know
-  // this will be positive (because RangeMap::find finds us a range that
-  // includes seg_addr and then DpiMemUtil makes sure that the value at that
-  // range is the right length).
-  size_t avail = it->second.size() - seg_off;
-  size_t to_copy = std::min(avail, (size_t)4);
+extern "C" svBit OtbnMemUtilGetSegWords(OtbnMemUtil *mem_util, svBit is_imem,
+                                        int seg_idx,
+                                        const svOpenArrayHandle words) {
+  assert(mem_util);
 
-  // Copy data from the segment into a uint32_t. Zero-initialize it, in case
-  // to_copy < 4.
-  uint32_t data = 0;
-  memcpy(&data, &it->second[seg_off], to_copy);
+  const OtbnMemUtil::Segment *seg = GetSegByIdx(mem_util, is_imem, seg_idx);
+  if (!seg) {
+    return sv_0;
+  }
 
-  // Now copy that uint32_t into data_value and return success.
-  memcpy(data_value, &data, 4);
+  if (!put_sv_u32_array(words, seg->words.data(), seg->words.size())) {
+    std::cerr << "Wrong size of array for segment " << seg_idx << ": got "
+              << svSize(words, 1) << " elements, but the segment has "
+              << seg->words.size() << " words.\n";
+    return sv_0;
+  }
   return sv_1;
 }
 
@@ -320,3 +395,30 @@ void OtbnMemUtilGetLoopWarpByIndex(
   set_sv_u32(from_cnt, from32);
   set_sv_u32(to_cnt, to32);
 }
+
+svBit OtbnMemUtilGetLoopWarps(OtbnMemUtil *mem_util,
+                              const svOpenArrayHandle addrs,
+                              const svOpenArrayHandle from_cnts,
+                              const svOpenArrayHandle to_cnts) {
+  assert(mem_util);
+
+  auto &warps = mem_util->GetLoopWarps();
+  std::vector<uint32_t> addr32s, from32s, to32s;
+  addr32s.reserve(warps.size());
+  from32s.reserve(warps.size());
+  to32s.reserve(warps.size());
+  for (const auto &pr : warps) {
+    addr32s.push_back(pr.first.first);
+    from32s.push_back(pr.first.second);
+    to32s.push_back(pr.second);
+  }
+
+  if (!put_sv_u32_array(addrs, addr32s.data(), warps.size()) ||
+      !put_sv_u32_array(from_cnts, from32s.data(), warps.size()) ||
+      !put_sv_u32_array(to_cnts, to32s.data(), warps.size())) {
+    std::cerr << "Wrong size of array for loop warps: there are "
+              << warps.size() << " of them.\n";
+    return sv_0;
+  }
+  return sv_1;
+}
@@ -5,7 +5,9 @@
 #define OPENTITAN_HW_IP_OTBN_DV_MEMUTIL_OTBN_MEMUTIL_H_
 
 #include <map>
+#include <memory>
 #include <svdpi.h>
+#include <sys/stat.h>
 #include <vector>
 
 #include "dpi_memutil.h"
@@ -15,6 +17,26 @@ class OtbnMemUtil : public DpiMemUtil {
  public:
   typedef std::map<std::pair<uint32_t, uint32_t>, uint32_t> LoopWarps;
 
+  // A segment of IMEM or DMEM, flattened into 32-bit words
+  struct Segment {
+    uint32_t word_off;
+    std::vector<uint32_t> words;
+  };
+
+  // The contents of a loaded ELF file, as needed by a testbench: the segments
+  // for each memory (in address order), the loop warps and the expected end
+  // address.
+  struct ElfView {
+    std::vector<Segment> imem_segs, dmem_segs;
+    LoopWarps loop_warps;
+    int expected_end_addr;
+    std::map<uint32_t, std::string> code_syms;
+
+    const std::vector<Segment> &GetSegs(bool is_imem) const {
+      return is_imem ? imem_segs : dmem_segs;
+    }
+  };
+
   // Constructor. top_scope is the SV scope that contains IMEM and
   // DMEM memories as u_imem and u_dmem, respectively.
   OtbnMemUtil(const std::string &top_scope);
@@ -25,7 +47,21 @@ class OtbnMemUtil : public DpiMemUtil {
   // If something goes wrong, throws a std::exception.
   void LoadElf(const std::string &elf_path);
 
-  // Get access to the segments currently staged for imem/dmem
+  // Stage the ELF file at the given path without touching the memories (like
+  // DpiMemUtil::StageElf), making it available with GetElfView().
+  //
+  // The flattened contents of each ELF file are cached by path, so staging the
+  // same file again skips reading and parsing it, as long as it hasn't changed
+  // on disk. If something goes wrong, throws a std::exception.
+  void StageElfCached(const std::string &elf_path);
+
+  // Get the contents of the ELF file that was last loaded or staged. If there
+  // was none, all the segment lists are empty.
+  const ElfView &GetElfView() const { return *view_; }
+
+  // Get access to the segments currently staged for imem/dmem. Note that
+  // StageElfCached() doesn't touch the staging area when it finds a cached
+  // view: use GetElfView() to see what it staged.
   const StagedMem::SegMap &GetSegs(bool is_imem) const;
 
   // Get access to a memory area
@@ -43,6 +79,13 @@ class OtbnMemUtil : public DpiMemUtil {
   // Read-only access to the table of loop warps
   const LoopWarps &GetLoopWarps() const { return loop_warp_; }
 
+  // Named symbols in executable sections of the last ELF file (the code
+  // labels), keyed by their address in IMEM. Where several labels share an
+  // address, a global one is preferred.
+  const std::map<uint32_t, std::string> &GetCodeSymbols() const {
+    return code_syms_;
+  }
+
  private:
   void OnElfLoaded(Elf *elf_file) override;
 
@@ -52,9 +95,29 @@ class OtbnMemUtil : public DpiMemUtil {
   // Add an entry to loop_warp_
   void AddLoopWarp(uint32_t addr, uint32_t from_cnt, uint32_t to_cnt);
 
+  // Make an ElfView from the staging area, loop_warp_, expected_end_addr_ and
+  // code_syms_
+  std::shared_ptr<const ElfView> MakeElfView() const;
+
   ScrambledEcc32MemArea imem_, dmem_;
   int expected_end_addr_;
   LoopWarps loop_warp_;
+  std::map<uint32_t, std::string> code_syms_;
+
+  // A cached ElfView and the identity of the file it was made from
+  struct CachedElf {
+    dev_t dev;
+    ino_t ino;
+    off_t size;
+    struct timespec mtime;
+    std::shared_ptr<const ElfView> view;
+  };
+
+  // The view of the last ELF file, and cached views keyed by path. OTBN
+  // images are small (at most the 4 KiB of each memory), so every file that a
+  // test loads is kept.
+  std::shared_ptr<const ElfView> view_;
+  std::map<std::string, CachedElf> elf_cache_;
 };
 
 // DPI-accessible wrappers
@@ -68,7 +131,8 @@ svBit OtbnMemUtilLoadElf(OtbnMemUtil *mem_util, const char *elf_path);
 
 // Loads an ELF file into the OtbnMemUtil object, but doesn't touch the
 // simulated memory. Returns 1'b1 on success. Prints a message to stderr and
-// returns 1'b0 on failure.
+// returns 1'b0 on failure. The file's contents are cached (see
+// OtbnMemUtil::StageElfCached), so staging the same file repeatedly is cheap.
 svBit OtbnMemUtilStageElf(OtbnMemUtil *mem_util, const char *elf_path);
 
 // Returns the number of segments currently staged in imem/dmem.
@@ -91,6 +155,15 @@ svBit OtbnMemUtilGetSegInfo(OtbnMemUtil *mem_util, svBit is_imem, int seg_idx,
 svBit OtbnMemUtilGetSegData(OtbnMemUtil *mem_util, svBit is_imem, int word_off,
                             /* output bit[31:0] */ svBitVecVal *data_value);
 
+// Gets all the data of a segment currently staged in imem/dmem in one call.
+// The words output argument is an open array of "bit [31:0]", which must
+// already have as many elements as the segment size returned by
+// OtbnMemUtilGetSegInfo. Returns 1'b1 on success. Prints a message to stderr
+// and returns 1'b0 if the index or the array size is wrong.
+svBit OtbnMemUtilGetSegWords(OtbnMemUtil *mem_util, svBit is_imem, int seg_idx,
+                             /* output bit [31:0] words[] */
+                             const svOpenArrayHandle words);
+
 // Get an "expected end address". This is a belt-and-braces check, where the
 // producer of the ELF file knows what address they expect to finish at (either
 // an ECALL or a known-bad faulting instruction). They can put this as a magic
@@ -125,6 +198,19 @@ void OtbnMemUtilGetLoopWarpByIndex(
     /* output bit [31:0] */ svBitVecVal *addr,
     /* output bit [31:0] */ svBitVecVal *from_cnt,
     /* output bit [31:0] */ svBitVecVal *to_cnt);
+
+// Get all loop warps in one call. Each argument is an open array of
+// "bit [31:0]", which must already have as many elements as returned by
+// OtbnMemUtilGetNumLoopWarps. Entry i of each array describes the i'th warp,
+// in the same order as OtbnMemUtilGetLoopWarpByIndex. Returns 1'b1 on success.
+// Prints a message to stderr and returns 1'b0 if an array has the wrong size.
+svBit OtbnMemUtilGetLoopWarps(OtbnMemUtil *mem_util,
+                              /* output bit [31:0] addrs[] */
+                              const svOpenArrayHandle addrs,
+                              /* output bit [31:0] from_cnts[] */
+                              const svOpenArrayHandle from_cnts,
+                              /* output bit [31:0] to_cnts[] */
+                              const svOpenArrayHandle to_cnts);
 }
 
 #endif  // OPENTITAN_HW_IP_OTBN_DV_MEMUTIL_OTBN_MEMUTIL_H_
@@ -24,6 +24,9 @@ package otbn_memutil_pkg;
   import "DPI-C" function bit OtbnMemUtilGetSegData(chandle mem_util, bit is_imem, int word_off,
                                                     output bit [31:0] data_value);
 
+  import "DPI-C" function bit OtbnMemUtilGetSegWords(chandle mem_util, bit is_imem, int seg_idx,
+                                                     output bit [31:0] words[]);
+
   import "DPI-C" function int OtbnMemUtilGetExpEndAddr(chandle mem_util);
 
   import "DPI-C" function bit OtbnMemUtilGetLoopWarp(chandle           mem_util,
@@ -38,5 +41,10 @@ package otbn_memutil_pkg;
                                                              output bit [31:0] addr,
                                                              output bit [31:0] from_cnt,
                                                              output bit [31:0] to_cnt);
+
+  import "DPI-C" function bit OtbnMemUtilGetLoopWarps(chandle           mem_util,
+                                                      output bit [31:0] addrs[],
+                                                      output bit [31:0] from_cnts[],
+                                                      output bit [31:0] to_cnts[]);
 endpackage
 `endif // SYNTHESIS
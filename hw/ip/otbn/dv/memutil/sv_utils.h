@@ -4,6 +4,7 @@
 #ifndef OPENTITAN_HW_IP_OTBN_DV_MEMUTIL_SV_UTILS_H_
 #define OPENTITAN_HW_IP_OTBN_DV_MEMUTIL_SV_UTILS_H_
 
+#include <cstring>
 #include <svdpi.h>
 
 // Utility function that packs a uint8_t into a SystemVerilog bit vector that
@@ -34,4 +35,29 @@ inline uint32_t get_sv_u32(const svBitVecVal *src) {
   return ret;
 }
 
+// Utility function that copies len words into an open array of "bit [31:0]".
+// Returns false (leaving the array untouched) unless the array has exactly len
+// elements.
+inline bool put_sv_u32_array(const svOpenArrayHandle dst, const uint32_t *src,
+                             size_t len) {
+  if (svSize(dst, 1) < 0 || (size_t)svSize(dst, 1) != len) {
+    return false;
+  }
+
+  // Each element of a "bit [31:0]" array is a single svBitVecVal. If the
+  // simulator stores the array contiguously, copy it all at once.
+  void *ptr = svGetArrayPtr(dst);
+  if (ptr) {
+    memcpy(ptr, src, len * sizeof(uint32_t));
+    return true;
+  }
+
+  int low = svLow(dst, 1);
+  for (size_t i = 0; i < len; ++i) {
+    svBitVecVal val = src[i];
+    svPutBitArrElem1VecVal(dst, &val, low + (int)i);
+  }
+  return true;
+}
+
 #endif  // OPENTITAN_HW_IP_OTBN_DV_MEMUTIL_SV_UTILS_H_
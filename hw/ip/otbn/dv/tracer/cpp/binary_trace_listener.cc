@@ -0,0 +1,215 @@
+// Copyright lowRISC contributors.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+#include <cassert>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+#include "binary_trace_listener.h"
+
+const char BinaryTraceListener::kMagic[8] = {'O', 'T', 'B', 'N',
+                                             'T', 'R', 'C', '1'};
+const size_t BinaryTraceListener::kBufferSize;
+const size_t BinaryTraceListener::kMaxPendingBuffers;
+const size_t BinaryTraceListener::kMaxStrings;
+
+static bool EndsWith(const std::string &str, const std::string &suffix) {
+  return str.size() >= suffix.size() &&
+         str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+// Quote a path for the shell
+static std::string ShellQuote(const std::string &str) {
+  std::string ret = "'";
+  for (char c : str) {
+    if (c == '\'') {
+      ret += "'\\''";
+    } else {
+      ret += c;
+    }
+  }
+  return ret + "'";
+}
+
+// Parse a value like 0xHHHHHHHH_HHHHHHHH (as written by otbn_tracer.sv) into
+// 32-bit words, most significant first. Returns false if the value isn't in
+// exactly that form, so that it can be written back out unchanged.
+static bool ParseHexWords(const char *str, size_t len,
+                          std::vector<uint32_t> *words) {
+  if (len < 10 || (len - 10) % 9 || str[0] != '0' || str[1] != 'x') {
+    return false;
+  }
+
+  words->clear();
+  for (size_t pos = 2; pos < len; pos += 9) {
+    if (pos > 2 && str[pos - 1] != '_') {
+      return false;
+    }
+    uint32_t word = 0;
+    for (size_t i = 0; i < 8; ++i) {
+      char c = str[pos + i];
+      uint32_t digit;
+      if ('0' <= c && c <= '9') {
+        digit = c - '0';
+      } else if ('a' <= c && c <= 'f') {
+        digit = c - 'a' + 10;
+      } else {
+        return false;
+      }
+      word = (word << 4) | digit;
+    }
+    words->push_back(word);
+  }
+  return true;
+}
+
+BinaryTraceListener::BinaryTraceListener(const std::string &filename)
+    : last_cycle_(0), done_(false), write_failed_(false) {
+  is_pipe_ = EndsWith(filename, ".zst");
+  if (is_pipe_) {
+    std::string cmd = "zstd -q -f -o " + ShellQuote(filename);
+    file_ = popen(cmd.c_str(), "w");
+  } else {
+    file_ = fopen(filename.c_str(), "wb");
+  }
+  if (!file_) {
+    std::ostringstream oss;
+    oss << "Could not open trace file: " << filename;
+    throw std::runtime_error(oss.str());
+  }
+
+  buf_.reserve(kBufferSize);
+  WriteBytes(kMagic, sizeof(kMagic));
+  writer_ = std::thread(&BinaryTraceListener::WriterLoop, this);
+}
+
+BinaryTraceListener::~BinaryTraceListener() {
+  Flush();
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    done_ = true;
+  }
+  cond_.notify_all();
+  writer_.join();
+
+  int err = is_pipe_ ? pclose(file_) : fclose(file_);
+  if (err || write_failed_) {
+    std::cerr << "ERROR: Failed to write binary OTBN trace." << std::endl;
+  }
+}
+
+void BinaryTraceListener::WriteVarint(uint64_t val) {
+  while (val >= 0x80) {
+    buf_.push_back((val & 0x7f) | 0x80);
+    val >>= 7;
+  }
+  buf_.push_back(val);
+}
+
+void BinaryTraceListener::WriteBytes(const char *data, size_t len) {
+  buf_.insert(buf_.end(), data, data + len);
+}
+
+bool BinaryTraceListener::WriteInterned(const char *str, size_t len,
+                                        LineKind interned_kind,
+                                        LineKind new_kind) {
+  std::string key(str, len);
+  auto it = strings_.find(key);
+  if (it != strings_.end()) {
+    WriteVarint((uint64_t)it->second << 3 | interned_kind);
+    return true;
+  }
+
+  if (strings_.size() >= kMaxStrings) {
+    return false;
+  }
+
+  strings_.emplace(std::move(key), strings_.size());
+  WriteVarint(new_kind);
+  WriteVarint(len);
+  WriteBytes(str, len);
+  return true;
+}
+
+void BinaryTraceListener::WriteLine(const std::string &line) {
+  // Register and memory accesses have a hex value after the first ": ".
+  // Intern the part before the value and write the value in binary.
+  size_t sep = line.find(": 0x");
+  std::vector<uint32_t> words;
+  if (sep != std::string::npos &&
+      ParseHexWords(line.data() + sep + 2, line.size() - sep - 2, &words) &&
+      WriteInterned(line.data(), sep + 2, kLineHexInterned, kLineHexNew)) {
+    WriteVarint(words.size());
+    for (uint32_t word : words) {
+      uint8_t le[4] = {(uint8_t)word, (uint8_t)(word >> 8),
+                       (uint8_t)(word >> 16), (uint8_t)(word >> 24)};
+      buf_.insert(buf_.end(), le, le + 4);
+    }
+    return;
+  }
+
+  if (WriteInterned(line.data(), line.size(), kLineInterned, kLineNew)) {
+    return;
+  }
+
+  WriteVarint(kLineLiteral);
+  WriteVarint(line.size());
+  WriteBytes(line.data(), line.size());
+}
+
+void BinaryTraceListener::AcceptTraceString(const std::string &trace,
+                                            unsigned int cycle_count) {
+  auto trace_lines = SplitTraceLines(trace);
+
+  WriteVarint((uint32_t)(cycle_count - last_cycle_));
+  last_cycle_ = cycle_count;
+  WriteVarint(trace_lines.size());
+  for (const std::string &line : trace_lines) {
+    WriteLine(line);
+  }
+
+  if (buf_.size() >= kBufferSize) {
+    Flush();
+  }
+}
+
+void BinaryTraceListener::Flush() {
+  if (buf_.empty()) {
+    return;
+  }
+
+  std::vector<uint8_t> full;
+  full.reserve(kBufferSize);
+  full.swap(buf_);
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  cond_.wait(lock, [this] { return pending_.size() < kMaxPendingBuffers; });
+  pending_.push_back(std::move(full));
+  lock.unlock();
+  cond_.notify_all();
+}
+
+void BinaryTraceListener::WriterLoop() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    cond_.wait(lock, [this] { return done_ || !pending_.empty(); });
+    if (pending_.empty()) {
+      assert(done_);
+      return;
+    }
+
+    std::vector<uint8_t> data = std::move(pending_.front());
+    pending_.pop_front();
+    lock.unlock();
+    cond_.notify_all();
+
+    if (fwrite(data.data(), 1, data.size(), file_) != data.size()) {
+      write_failed_ = true;
+    }
+
+    lock.lock();
+  }
+}
@@ -0,0 +1,114 @@
+// Copyright lowRISC contributors.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef OPENTITAN_HW_IP_OTBN_DV_TRACER_CPP_BINARY_TRACE_LISTENER_H_
+#define OPENTITAN_HW_IP_OTBN_DV_TRACER_CPP_BINARY_TRACE_LISTENER_H_
+
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "otbn_trace_listener.h"
+
+/**
+ * An OtbnTraceListener that writes the trace to a file in a compact binary
+ * format. decode_binary_trace.py turns this back into the text format written
+ * by LogTraceListener.
+ *
+ * The file starts with the 8 byte magic "OTBNTRC1". Each trace record follows,
+ * as a varint (LEB128) cycle count delta (modulo 2^32, from the previous
+ * record or from zero), a varint line count and then the lines. Each line
+ * starts with a varint header, (id << 3) | kind, where kind is one of the
+ * LineKind values below:
+ *
+ *  - Lines that look like "KEY: 0xHHHHHHHH[_HHHHHHHH...]" (register and memory
+ *    accesses) are split into KEY (an interned string) and the value, which is
+ *    a varint count of 32-bit words and then the words, most significant first,
+ *    as little-endian uint32s.
+ *
+ *  - Other lines (instruction, flags and error lines) are interned whole.
+ *
+ * An interned string is given by its id. The first time that a string is
+ * used, it is defined inline instead (with the "New" kinds): a varint length
+ * and the bytes, after which it has the next id (counting from zero). Once
+ * kMaxStrings strings have been defined, any other lines are written as
+ * literals.
+ *
+ * Encoded records are collected in large buffers, which a background thread
+ * writes out. If the file name ends with ".zst", the data is compressed by
+ * piping it through the zstd command.
+ */
+class BinaryTraceListener : public OtbnTraceListener {
+ public:
+  enum LineKind {
+    kLineInterned = 0,
+    kLineNew = 1,
+    kLineHexInterned = 2,
+    kLineHexNew = 3,
+    kLineLiteral = 4,
+  };
+
+  static const char kMagic[8];
+
+  // The size of each buffer handed to the writer thread, and how many
+  // buffers may be waiting to be written before the simulation waits for the
+  // writer.
+  static const size_t kBufferSize = 4 << 20;
+  static const size_t kMaxPendingBuffers = 4;
+
+  // The largest number of interned strings (keeping memory use bounded if a
+  // trace has very many distinct lines)
+  static const size_t kMaxStrings = 1 << 20;
+
+  /**
+   * Constructor that takes a filename to write trace output to. It throws
+   * std::runtime_error if the file cannot be opened.
+   */
+  BinaryTraceListener(const std::string &filename);
+  ~BinaryTraceListener() override;
+
+  void AcceptTraceString(const std::string &trace,
+                         unsigned int cycle_count) override;
+
+ private:
+  void WriteVarint(uint64_t val);
+  void WriteBytes(const char *data, size_t len);
+
+  // Write a line whose kind is interned_kind if str has been interned, or
+  // new_kind if it is interned now. Returns false (writing nothing) if str
+  // hasn't been interned and the string table is full.
+  bool WriteInterned(const char *str, size_t len, LineKind interned_kind,
+                     LineKind new_kind);
+
+  void WriteLine(const std::string &line);
+
+  // Hand the current buffer to the writer thread
+  void Flush();
+
+  // The writer thread's main loop
+  void WriterLoop();
+
+  FILE *file_;
+  bool is_pipe_;
+
+  uint32_t last_cycle_;
+  std::unordered_map<std::string, uint32_t> strings_;
+  std::vector<uint8_t> buf_;
+
+  // Buffers waiting to be written, protected by mutex_
+  std::mutex mutex_;
+  std::condition_variable cond_;
+  std::deque<std::vector<uint8_t>> pending_;
+  bool done_;
+  bool write_failed_;
+  std::thread writer_;
+};
+
+#endif  // OPENTITAN_HW_IP_OTBN_DV_TRACER_CPP_BINARY_TRACE_LISTENER_H_
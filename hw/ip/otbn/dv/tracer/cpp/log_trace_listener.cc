@@ -3,8 +3,7 @@
 // SPDX-License-Identifier: Apache-2.0
 
 #include <cassert>
-#include <iomanip>
-#include <ios>
+#include <cstdio>
 #include <sstream>
 #include <stdexcept>
 #include <string>
@@ -38,12 +37,13 @@ void LogTraceListener::AcceptTraceString(const std::string &trace,
 
         // Output the beginning of the first line adding a cycle count. A
         // special '!' line, only giving the cycle count, is output if the first
-        // line isn't an 'E' or 'S' line.
-        std::ios old_state(nullptr);
-        old_state.copyfmt(trace_log);
-        trace_log << (is_e_or_s_line ? line[0] : '!') << " " << std::setw(9)
-                  << std::setfill('0') << cycle_count;
-        trace_log.copyfmt(old_state);
+        // line isn't an 'E' or 'S' line. This is formatted with snprintf
+        // rather than by changing the stream's formatting state for every
+        // trace.
+        char prefix[16];
+        snprintf(prefix, sizeof(prefix), "%c %09u",
+                 is_e_or_s_line ? line[0] : '!', cycle_count);
+        trace_log << prefix;
 
         if (is_e_or_s_line) {
           // If this is an expected 'E' or 'S' line write the rest of it out
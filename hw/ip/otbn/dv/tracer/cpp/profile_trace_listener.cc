@@ -0,0 +1,334 @@
+// Copyright lowRISC contributors.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+#include <algorithm>
+#include <cstdio>
+#include <iomanip>
+#include <sstream>
+
+#include "profile_trace_listener.h"
+
+namespace {
+// Major opcodes (bits 6-0 of the instruction)
+const uint32_t kOpLoad = 0x03;
+const uint32_t kOpCustom0 = 0x0b;
+const uint32_t kOpOpImm = 0x13;
+const uint32_t kOpStore = 0x23;
+const uint32_t kOpCustom1 = 0x2b;
+const uint32_t kOpOp = 0x33;
+const uint32_t kOpLui = 0x37;
+const uint32_t kOpCustom2 = 0x3b;
+const uint32_t kOpBranch = 0x63;
+const uint32_t kOpJalr = 0x67;
+const uint32_t kOpJal = 0x6f;
+const uint32_t kOpSystem = 0x73;
+const uint32_t kOpCustom3 = 0x7b;
+
+// The number of PCs to list in the summary
+const size_t kHotPcsShown = 20;
+
+uint32_t Opcode(uint32_t insn) { return insn & 0x7f; }
+uint32_t Funct3(uint32_t insn) { return (insn >> 12) & 0x7; }
+uint32_t Rd(uint32_t insn) { return (insn >> 7) & 0x1f; }
+uint32_t Rs1(uint32_t insn) { return (insn >> 15) & 0x1f; }
+
+bool IsLoop(uint32_t insn) {
+  return Opcode(insn) == kOpCustom3 && Funct3(insn) <= 1;
+}
+
+// Get the class of an instruction, for the summary (see bignum-insns.yml and
+// base-insns.yml for the encodings)
+const char *InsnClass(uint32_t insn) {
+  switch (Opcode(insn)) {
+    case kOpOpImm:
+    case kOpOp:
+    case kOpLui:
+      return "base ALU";
+    case kOpLoad:
+    case kOpStore:
+      return "base load/store";
+    case kOpBranch:
+    case kOpJal:
+    case kOpJalr:
+      return "branch/jump";
+    case kOpSystem:
+      return "CSR/ECALL";
+    case kOpCustom0:
+      switch (Funct3(insn)) {
+        case 4:
+        case 5:
+          return "bignum load/store";
+        case 6:
+        case 7:
+          return "bignum move/WSR";
+        default:
+          return "bignum ALU";
+      }
+    case kOpCustom1:
+      return "bignum ALU";
+    case kOpCustom2:
+      return "bignum MULQACC";
+    case kOpCustom3:
+      return IsLoop(insn) ? "loop" : "bignum ALU";
+    default:
+      return "unknown";
+  }
+}
+
+// Name the code at addr, as "symbol" or "symbol+0xoff" (or just the address if
+// there's no symbol at or below it)
+std::string AddrName(uint32_t addr, const ProfileTraceListener::Symbols &syms,
+                     bool exact) {
+  std::ostringstream oss;
+  auto it = syms.upper_bound(addr);
+  if (it != syms.begin()) {
+    --it;
+    if (it->first == addr) {
+      return it->second;
+    }
+    if (!exact) {
+      oss << it->second << "+0x" << std::hex << (addr - it->first);
+      return oss.str();
+    }
+  }
+  oss << "0x" << std::hex << std::setw(8) << std::setfill('0') << addr;
+  return oss.str();
+}
+
+double Percent(uint64_t num, uint64_t den) {
+  return den ? 100.0 * num / den : 0.0;
+}
+}  // namespace
+
+ProfileTraceListener::ProfileTraceListener() { Reset(); }
+
+void ProfileTraceListener::Reset() {
+  pcs_.clear();
+  stacks_.clear();
+  calls_.clear();
+  loops_.clear();
+  frames_.clear();
+  active_loops_.clear();
+  pending_call_ = false;
+  stack_counts_ = nullptr;
+  unknown_records_ = 0;
+}
+
+void ProfileTraceListener::AcceptTraceString(const std::string &trace,
+                                             unsigned int cycle_count) {
+  // Only the first line matters: it should be an 'E' or 'S' line (see
+  // LogTraceListener).
+  size_t eol = trace.find('\n');
+  std::string line = trace.substr(0, eol);
+
+  unsigned pc, insn = 0;
+  if (line.size() < 2 || (line[0] != 'E' && line[0] != 'S') ||
+      sscanf(line.c_str() + 1, " PC: 0x%x, insn: 0x%x", &pc, &insn) < 1) {
+    ++unknown_records_;
+    return;
+  }
+
+  OnInsn(pc, insn, line[0] == 'S');
+}
+
+ProfileTraceListener::Counts *ProfileTraceListener::GetStackCounts() {
+  if (!stack_counts_) {
+    stack_counts_ = &stacks_[frames_];
+  }
+  return stack_counts_;
+}
+
+void ProfileTraceListener::OnInsn(uint32_t pc, uint32_t insn, bool stall) {
+  // The first instruction of the run starts the outermost function, and the
+  // first instruction after a call starts a new one.
+  if (frames_.empty() || pending_call_) {
+    frames_.push_back(pc);
+    stack_counts_ = nullptr;
+    if (pending_call_) {
+      ++calls_[pc];
+      pending_call_ = false;
+    }
+  }
+
+  // Leave any loops that have finished: those started at this call depth
+  // whose body doesn't contain pc, or those started in a function that has
+  // returned. The body of a loop runs from the instruction after the loop
+  // instruction to its end.
+  while (!active_loops_.empty()) {
+    const ActiveLoop &loop = active_loops_.back();
+    const LoopCounts &counts = loops_[loop.pc];
+    bool in_body = loop.pc < pc && pc <= counts.end;
+    if (loop.depth < frames_.size() ||
+        (loop.depth == frames_.size() && in_body)) {
+      break;
+    }
+    active_loops_.pop_back();
+  }
+
+  PcCounts &pc_counts = pcs_[pc];
+  pc_counts.insn = insn;
+  pc_counts.Add(stall);
+  GetStackCounts()->Add(stall);
+  for (const ActiveLoop &loop : active_loops_) {
+    LoopCounts &counts = loops_[loop.pc];
+    counts.Add(stall);
+    if (!stall && pc == counts.end && loop.depth == frames_.size()) {
+      ++counts.iters;
+    }
+  }
+
+  if (stall) {
+    return;
+  }
+  ++pc_counts.execs;
+
+  if (IsLoop(insn)) {
+    uint32_t body_size = insn >> 20;
+    LoopCounts &counts = loops_[pc];
+    counts.end = pc + 4 * body_size;
+    counts.func = frames_.back();
+    ++counts.entries;
+    active_loops_.push_back({pc, frames_.size()});
+  }
+
+  bool is_jump = Opcode(insn) == kOpJal || Opcode(insn) == kOpJalr;
+  if (is_jump && Rd(insn) == 1) {
+    pending_call_ = true;
+  } else if (Opcode(insn) == kOpJalr && Rd(insn) == 0 && Rs1(insn) == 1 &&
+             frames_.size() > 1) {
+    frames_.pop_back();
+    stack_counts_ = nullptr;
+  }
+}
+
+void ProfileTraceListener::WriteSummary(std::ostream &os,
+                                        const Symbols &symbols) const {
+  Counts total;
+  uint64_t num_execs = 0;
+  for (const auto &pr : pcs_) {
+    total.cycles += pr.second.cycles;
+    total.stalls += pr.second.stalls;
+    num_execs += pr.second.execs;
+  }
+
+  os << "OTBN profile: " << total.cycles << " cycles (" << total.stalls
+     << " stalled), " << num_execs << " instructions\n";
+  if (unknown_records_) {
+    os << "Trace records with no instruction: " << unknown_records_ << "\n";
+  }
+  std::ios old_state(nullptr);
+  old_state.copyfmt(os);
+  os << std::fixed << std::setprecision(1);
+
+  // Functions, with inclusive counts (for every function on a stack, counted
+  // once even if it's recursive) and self counts (for the innermost function)
+  std::map<uint32_t, Counts> incl, self;
+  for (const auto &pr : stacks_) {
+    const std::vector<uint32_t> &stack = pr.first;
+    const Counts &counts = pr.second;
+    std::vector<uint32_t> funcs(stack);
+    std::sort(funcs.begin(), funcs.end());
+    funcs.erase(std::unique(funcs.begin(), funcs.end()), funcs.end());
+    for (uint32_t func : funcs) {
+      incl[func].cycles += counts.cycles;
+      incl[func].stalls += counts.stalls;
+    }
+    self[stack.back()].cycles += counts.cycles;
+    self[stack.back()].stalls += counts.stalls;
+  }
+
+  std::vector<std::pair<uint64_t, uint32_t>> order;
+  for (const auto &pr : incl) {
+    order.emplace_back(pr.second.cycles, pr.first);
+  }
+  std::sort(order.rbegin(), order.rend());
+
+  os << "\nFunctions:\n"
+     << std::setw(10) << "Cycles" << std::setw(7) << "%" << std::setw(10)
+     << "Self" << std::setw(7) << "%" << std::setw(10) << "Stalls"
+     << std::setw(8) << "Calls"
+     << "  Function\n";
+  for (const auto &pr : order) {
+    uint32_t func = pr.second;
+    const Counts &fi = incl.at(func);
+    auto self_it = self.find(func);
+    Counts fs = self_it == self.end() ? Counts() : self_it->second;
+    auto calls_it = calls_.find(func);
+    uint64_t calls = calls_it == calls_.end() ? 0 : calls_it->second;
+    os << std::setw(10) << fi.cycles << std::setw(7)
+       << Percent(fi.cycles, total.cycles) << std::setw(10) << fs.cycles
+       << std::setw(7) << Percent(fs.cycles, total.cycles) << std::setw(10)
+       << fs.stalls << std::setw(8) << calls << "  "
+       << AddrName(func, symbols, true) << "\n";
+  }
+
+  // Instruction classes
+  std::map<std::string, PcCounts> classes;
+  for (const auto &pr : pcs_) {
+    PcCounts &counts = classes[InsnClass(pr.second.insn)];
+    counts.cycles += pr.second.cycles;
+    counts.stalls += pr.second.stalls;
+    counts.execs += pr.second.execs;
+  }
+  os << "\nInstruction classes:\n"
+     << std::setw(10) << "Cycles" << std::setw(7) << "%" << std::setw(10)
+     << "Stalls" << std::setw(10) << "Insns"
+     << "  Class\n";
+  for (const auto &pr : classes) {
+    os << std::setw(10) << pr.second.cycles << std::setw(7)
+       << Percent(pr.second.cycles, total.cycles) << std::setw(10)
+       << pr.second.stalls << std::setw(10) << pr.second.execs << "  "
+       << pr.first << "\n";
+  }
+
+  // Loops, in address order
+  if (!loops_.empty()) {
+    os << "\nLoops:\n"
+       << std::setw(10) << "Cycles" << std::setw(7) << "%" << std::setw(10)
+       << "Stalls" << std::setw(8) << "Entries" << std::setw(10) << "Iters"
+       << "  Loop\n";
+    for (const auto &pr : loops_) {
+      const LoopCounts &counts = pr.second;
+      os << std::setw(10) << counts.cycles << std::setw(7)
+         << Percent(counts.cycles, total.cycles) << std::setw(10)
+         << counts.stalls << std::setw(8) << counts.entries << std::setw(10)
+         << counts.iters << "  " << AddrName(pr.first, symbols, false)
+         << " (in " << AddrName(counts.func, symbols, true) << ")\n";
+    }
+  }
+
+  // The PCs with the most cycles
+  order.clear();
+  for (const auto &pr : pcs_) {
+    order.emplace_back(pr.second.cycles, pr.first);
+  }
+  size_t num_shown = std::min(order.size(), kHotPcsShown);
+  std::partial_sort(order.begin(), order.begin() + num_shown, order.end(),
+                    std::greater<std::pair<uint64_t, uint32_t>>());
+  os << "\nHottest PCs:\n"
+     << std::setw(10) << "Cycles" << std::setw(7) << "%" << std::setw(10)
+     << "Stalls" << std::setw(10) << "Insns"
+     << "  PC\n";
+  for (size_t i = 0; i < num_shown; ++i) {
+    const PcCounts &counts = pcs_.at(order[i].second);
+    os << std::setw(10) << counts.cycles << std::setw(7)
+       << Percent(counts.cycles, total.cycles) << std::setw(10)
+       << counts.stalls << std::setw(10) << counts.execs << "  "
+       << AddrName(order[i].second, symbols, false) << " ("
+       << InsnClass(counts.insn) << ")\n";
+  }
+
+  os.copyfmt(old_state);
+}
+
+void ProfileTraceListener::WriteFolded(std::ostream &os,
+                                       const Symbols &symbols) const {
+  for (const auto &pr : stacks_) {
+    const std::vector<uint32_t> &stack = pr.first;
+    for (size_t i = 0; i < stack.size(); ++i) {
+      os << (i ? ";" : "") << AddrName(stack[i], symbols, true);
+    }
+    os << " " << pr.second.cycles << "\n";
+  }
+}
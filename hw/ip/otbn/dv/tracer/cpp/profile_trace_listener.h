@@ -0,0 +1,99 @@
+// Copyright lowRISC contributors.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+#ifndef OPENTITAN_HW_IP_OTBN_DV_TRACER_CPP_PROFILE_TRACE_LISTENER_H_
+#define OPENTITAN_HW_IP_OTBN_DV_TRACER_CPP_PROFILE_TRACE_LISTENER_H_
+
+#include <cstdint>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "otbn_trace_listener.h"
+
+/**
+ * An OtbnTraceListener that profiles the program that OTBN runs.
+ *
+ * Every trace record that starts with an 'E' or 'S' line is one cycle spent on
+ * the instruction at that PC ('S' records are stall cycles). The listener
+ * counts these cycles per PC and, by watching for calls (JAL or JALR that link
+ * to x1) and returns (JALR x0, x1), keeps a shadow call stack so that it can
+ * count cycles per stack too. Cycles are also counted against every hardware
+ * loop (LOOP or LOOPI) whose body is running.
+ *
+ * Functions are identified by their entry address: the first PC of the run for
+ * the outermost function, and the target of each call. When writing the
+ * profile, these are named with a table of code symbols.
+ */
+class ProfileTraceListener : public OtbnTraceListener {
+ public:
+  // Code symbols (as addresses in IMEM) keyed by address
+  typedef std::map<uint32_t, std::string> Symbols;
+
+  ProfileTraceListener();
+
+  void AcceptTraceString(const std::string &trace,
+                         unsigned int cycle_count) override;
+
+  // Forget everything counted so far, ready for a new run
+  void Reset();
+
+  // Write tables of cycles per function, instruction class, loop and PC
+  void WriteSummary(std::ostream &os, const Symbols &symbols) const;
+
+  // Write the cycles of each call stack as folded stacks, which
+  // flamegraph.pl, speedscope and similar tools read directly
+  void WriteFolded(std::ostream &os, const Symbols &symbols) const;
+
+ private:
+  struct Counts {
+    uint64_t cycles = 0;
+    uint64_t stalls = 0;
+
+    void Add(bool stall) {
+      ++cycles;
+      stalls += stall;
+    }
+  };
+
+  struct PcCounts : Counts {
+    uint32_t insn = 0;
+    uint64_t execs = 0;
+  };
+
+  struct LoopCounts : Counts {
+    uint32_t end = 0;    // PC of the last instruction in the body
+    uint32_t func = 0;   // The function containing the loop
+    uint64_t entries = 0;
+    uint64_t iters = 0;  // Executions of the last instruction in the body
+  };
+
+  // A loop whose body is running, and the call depth that it started at
+  struct ActiveLoop {
+    uint32_t pc;
+    size_t depth;
+  };
+
+  // Count a cycle spent on the instruction at pc
+  void OnInsn(uint32_t pc, uint32_t insn, bool stall);
+
+  // Get the counts for the current call stack. These are cached in
+  // stack_counts_ (which is cleared whenever the stack changes) to avoid
+  // looking up the stack every cycle.
+  Counts *GetStackCounts();
+
+  std::map<uint32_t, PcCounts> pcs_;
+  std::map<std::vector<uint32_t>, Counts> stacks_;
+  std::map<uint32_t, uint64_t> calls_;
+  std::map<uint32_t, LoopCounts> loops_;
+
+  std::vector<uint32_t> frames_;
+  std::vector<ActiveLoop> active_loops_;
+  bool pending_call_;
+  Counts *stack_counts_;
+  uint64_t unknown_records_;
+};
+
+#endif  // OPENTITAN_HW_IP_OTBN_DV_TRACER_CPP_PROFILE_TRACE_LISTENER_H_
@@ -0,0 +1,173 @@
+#!/usr/bin/env python3
+# Copyright lowRISC contributors.
+# Licensed under the Apache License, Version 2.0, see LICENSE for details.
+# SPDX-License-Identifier: Apache-2.0
+'''Convert a binary OTBN trace to the text format of LogTraceListener
+
+The binary format is written by BinaryTraceListener (see
+cpp/binary_trace_listener.h for a description). If the input file name ends
+with ".zst", it is decompressed with the zstd command.
+
+'''
+
+import argparse
+import subprocess
+import sys
+from typing import BinaryIO, List, Tuple
+
+MAGIC = b'OTBNTRC1'
+
+LINE_INTERNED = 0
+LINE_NEW = 1
+LINE_HEX_INTERNED = 2
+LINE_HEX_NEW = 3
+LINE_LITERAL = 4
+
+
+class TraceDecodeError(Exception):
+    pass
+
+
+class Decoder:
+    def __init__(self, data: bytes):
+        self.data = data
+        self.pos = 0
+        self.strings = []  # type: List[str]
+
+    def at_end(self) -> bool:
+        return self.pos == len(self.data)
+
+    def varint(self) -> int:
+        val = 0
+        shift = 0
+        while True:
+            if self.pos >= len(self.data):
+                raise TraceDecodeError('Truncated varint at end of trace.')
+            byte = self.data[self.pos]
+            self.pos += 1
+            val |= (byte & 0x7f) << shift
+            shift += 7
+            if not byte & 0x80:
+                return val
+
+    def raw(self, length: int) -> bytes:
+        if self.pos + length > len(self.data):
+            raise TraceDecodeError('Truncated data at end of trace.')
+        ret = self.data[self.pos:self.pos + length]
+        self.pos += length
+        return ret
+
+    def string(self) -> str:
+        return self.raw(self.varint()).decode('utf-8', errors='replace')
+
+    def interned(self, header: int) -> str:
+        idx = header >> 3
+        if idx >= len(self.strings):
+            raise TraceDecodeError('Unknown string id {} at offset {}.'
+                                   .format(idx, self.pos))
+        return self.strings[idx]
+
+    def new_string(self) -> str:
+        ret = self.string()
+        self.strings.append(ret)
+        return ret
+
+    def hex_value(self) -> str:
+        num_words = self.varint()
+        words = []
+        for _ in range(num_words):
+            words.append('{:08x}'.format(int.from_bytes(self.raw(4),
+                                                        'little')))
+        return '0x' + '_'.join(words)
+
+    def line(self) -> str:
+        header = self.varint()
+        kind = header & 7
+        if kind == LINE_INTERNED:
+            return self.interned(header)
+        if kind == LINE_NEW:
+            return self.new_string()
+        if kind == LINE_HEX_INTERNED:
+            return self.interned(header) + self.hex_value()
+        if kind == LINE_HEX_NEW:
+            return self.new_string() + self.hex_value()
+        if kind == LINE_LITERAL:
+            return self.string()
+        raise TraceDecodeError('Unknown line kind {} at offset {}.'
+                               .format(kind, self.pos))
+
+    def record(self, last_cycle: int) -> Tuple[int, List[str]]:
+        cycle = (last_cycle + self.varint()) & 0xffffffff
+        num_lines = self.varint()
+        return (cycle, [self.line() for _ in range(num_lines)])
+
+
+def format_record(cycle: int, lines: List[str]) -> str:
+    '''Format a trace record like LogTraceListener::AcceptTraceString'''
+    out = []
+    for idx, line in enumerate(lines):
+        if idx:
+            out.append('    {}\n'.format(line))
+        elif len(line) <= 1:
+            out.append('ERR: Bad line at {} line should be more than 1 '
+                       'character: {}\n'.format(cycle, line))
+        elif line[0] in 'ES':
+            out.append('{} {:09d}{}\n'.format(line[0], cycle, line[1:]))
+        else:
+            out.append('! {:09d}\n    {}\n'.format(cycle, line))
+    return ''.join(out)
+
+
+def read_trace(path: str) -> bytes:
+    if not path.endswith('.zst'):
+        with open(path, 'rb') as handle:
+            return handle.read()
+
+    proc = subprocess.run(['zstd', '-dc', path],
+                          stdout=subprocess.PIPE,
+                          check=True)
+    return proc.stdout
+
+
+def decode(data: bytes, out: BinaryIO) -> None:
+    if data[:len(MAGIC)] != MAGIC:
+        raise TraceDecodeError('Not a binary OTBN trace (bad magic).')
+
+    decoder = Decoder(data)
+    decoder.pos = len(MAGIC)
+    cycle = 0
+    while not decoder.at_end():
+        cycle, lines = decoder.record(cycle)
+        out.write(format_record(cycle, lines).encode('utf-8'))
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser()
+    parser.add_argument('trace', help='Binary trace (.bin or .bin.zst)')
+    parser.add_argument('-o', '--output',
+                        help='Write the text trace here (default: stdout)')
+    args = parser.parse_args()
+
+    try:
+        data = read_trace(args.trace)
+    except (OSError, subprocess.CalledProcessError) as err:
+        print('Failed to read {}: {}'.format(args.trace, err),
+              file=sys.stderr)
+        return 1
+
+    try:
+        if args.output is None:
+            decode(data, sys.stdout.buffer)
+        else:
+            with open(args.output, 'wb') as out:
+                decode(data, out)
+    except TraceDecodeError as err:
+        print('Failed to decode {}: {}'.format(args.trace, err),
+              file=sys.stderr)
+        return 1
+
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
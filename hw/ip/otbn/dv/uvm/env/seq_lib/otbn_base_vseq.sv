@@ -82,21 +82,24 @@ class otbn_base_vseq extends cip_base_vseq #(
 
       // What offset and size (in 32 bit words) is this segment?
       bit [31:0] seg_off, seg_size;
+      bit [31:0] words[];
       if (!OtbnMemUtilGetSegInfo(cfg.mem_util, for_imem, seg_idx, seg_off, seg_size)) begin
         `uvm_fatal(`gfn, $sformatf("Failed to get segment info for segment %0d.", seg_idx))
       end
 
+      // Fetch the whole segment in one DPI call, rather than a call per word.
+      words = new[seg_size];
+      if (!OtbnMemUtilGetSegWords(cfg.mem_util, for_imem, seg_idx, words)) begin
+        `uvm_fatal(`gfn, $sformatf("Failed to get segment data for segment %0d.", seg_idx))
+      end
+
       // Add each word.
-      for (bit [31:0] i = 0; i < seg_size; i++) begin
-        bit [31:0] word_off, data;
+      foreach (words[i]) begin
+        bit [31:0] word_off;
         otbn_loaded_word entry;
 
         word_off = seg_off + i;
 
-        if (!OtbnMemUtilGetSegData(cfg.mem_util, for_imem, word_off, data)) begin
-          `uvm_fatal(`gfn, $sformatf("Failed to get segment data at word offset %0d.", word_off))
-        end
-
         // Since we know that the segment data lies in IMEM or DMEM and that this fits in the
         // address space, we know that the top two bits of the word address are zero.
         `DV_CHECK_FATAL(word_off[31:30] == 2'b00)
@@ -107,7 +110,7 @@ class otbn_base_vseq extends cip_base_vseq #(
 
         entry.for_imem = for_imem;
         entry.offset   = word_off[21:0];
-        entry.data     = data;
+        entry.data     = words[i];
         entries.push_back(entry);
       end
     end
@@ -210,6 +213,23 @@ class otbn_base_vseq extends cip_base_vseq #(
   protected task _run_loop_warps();
     logic [31:0] addr, old_iters, old_count;
     bit [31:0]   new_count, new_iters;
+    int          num_warps;
+    bit [31:0]   warp_addrs[], warp_from_cnts[], warp_to_cnts[];
+    bit [31:0]   warps[bit [63:0]];
+
+    // Fetch all the loop warps for the loaded program with a single DPI call, rather than asking
+    // otbn_memutil about each loop iteration. They are stored in warps, mapping {addr, from_cnt}
+    // to the new count.
+    num_warps = OtbnMemUtilGetNumLoopWarps(cfg.mem_util);
+    warp_addrs = new[num_warps];
+    warp_from_cnts = new[num_warps];
+    warp_to_cnts = new[num_warps];
+    if (!OtbnMemUtilGetLoopWarps(cfg.mem_util, warp_addrs, warp_from_cnts, warp_to_cnts)) begin
+      `dv_fatal("Failed to get loop warps from otbn_memutil.")
+    end
+    for (int i = 0; i < num_warps; i++) begin
+      warps[{warp_addrs[i], warp_from_cnts[i]}] = warp_to_cnts[i];
+    end
 
     forever begin
       // Run on the negative edge of the clock: we want to force a "_d" value, so should make sure
@@ -228,9 +248,12 @@ class otbn_base_vseq extends cip_base_vseq #(
       // (counting up from zero).
       old_count = cfg.loop_vif.loop_iters_to_count(old_iters);
 
-      // Do a DPI call to otbn_memutil to look up whether there is a loop warp that we should be
-      // taking. This returns 1'b1 and fills in new_count if there is a warp that does something.
-      if (!OtbnMemUtilGetLoopWarp(cfg.mem_util, addr, old_count, new_count))
+      // Look up whether there is a loop warp that we should be taking. Skip warps that don't
+      // change the count, which do nothing.
+      if (!warps.exists({addr, old_count}))
+        continue;
+      new_count = warps[{addr, old_count}];
+      if (new_count == old_count)
         continue;
 
       // Convert this back to the "RTL view"
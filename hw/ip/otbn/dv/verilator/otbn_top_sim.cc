@@ -11,11 +11,13 @@
 #include <svdpi.h>
 
 #include "Votbn_top_sim__Syms.h"
+#include "binary_trace_listener.h"
 #include "log_trace_listener.h"
 #include "otbn_memutil.h"
 #include "otbn_model.h"
 #include "otbn_trace_checker.h"
 #include "otbn_trace_source.h"
+#include "profile_trace_listener.h"
 #include "sv_scoped.h"
 #include "verilated_toplevel.h"
 #include "verilator_memutil.h"
@@ -31,17 +33,34 @@ extern int otbn_core_get_stop_pc();
 }
 
 /**
- * SimCtrlExtension that adds a '--otbn-trace-file' command line option. If set
- * it sets up a LogTraceListener that will dump out the trace to the given log
- * file
+ * SimCtrlExtension that adds '--otbn-trace-file' and '--otbn-profile*' command
+ * line options. The first sets up a LogTraceListener that will dump out the
+ * trace to the given log file (or a BinaryTraceListener, if the file name ends
+ * with ".bin" or ".bin.zst"). The others set up a ProfileTraceListener, whose
+ * summary and folded stacks are written at the end of the simulation.
  */
 class OtbnTraceUtil : public SimCtrlExtension {
  private:
-  std::unique_ptr<LogTraceListener> log_trace_listener_;
+  const OtbnMemUtil &mem_util_;
+  std::unique_ptr<OtbnTraceListener> log_trace_listener_;
+  std::unique_ptr<ProfileTraceListener> profile_trace_listener_;
+  std::string profile_path_;
+  std::string profile_folded_path_;
+
+  static bool EndsWith(const std::string &str, const std::string &suffix) {
+    return str.size() >= suffix.size() &&
+           str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
+  }
 
   bool SetupTraceLog(const std::string &log_filename) {
     try {
-      log_trace_listener_ = std::make_unique<LogTraceListener>(log_filename);
+      if (EndsWith(log_filename, ".bin") ||
+          EndsWith(log_filename, ".bin.zst")) {
+        log_trace_listener_ =
+            std::make_unique<BinaryTraceListener>(log_filename);
+      } else {
+        log_trace_listener_ = std::make_unique<LogTraceListener>(log_filename);
+      }
       OtbnTraceSource::get().AddListener(log_trace_listener_.get());
       return true;
     } catch (const std::runtime_error &err) {
@@ -53,16 +72,37 @@ class OtbnTraceUtil : public SimCtrlExtension {
     return false;
   }
 
+  void SetupProfile() {
+    if (!profile_trace_listener_) {
+      profile_trace_listener_ = std::make_unique<ProfileTraceListener>();
+      OtbnTraceSource::get().AddListener(profile_trace_listener_.get());
+    }
+  }
+
   void PrintHelp() {
     std::cout << "Trace log utilities:\n\n"
                  "--otbn-trace-file=FILE\n"
-                 "  Write OTBN trace log to FILE\n\n";
+                 "  Write OTBN trace log to FILE. If FILE ends with '.bin'\n"
+                 "  (or '.bin.zst', to compress with zstd), write a binary\n"
+                 "  trace, which tracer/decode_binary_trace.py converts to\n"
+                 "  the text format\n\n"
+                 "--otbn-profile=FILE\n"
+                 "  Write a profile of the OTBN program (cycles per function,\n"
+                 "  instruction class, loop and PC) to FILE, or to stdout if\n"
+                 "  FILE is '-'\n\n"
+                 "--otbn-profile-folded=FILE\n"
+                 "  Write the cycles of each call stack of the OTBN program\n"
+                 "  to FILE as folded stacks, for flame graphs\n\n";
   }
 
  public:
+  explicit OtbnTraceUtil(const OtbnMemUtil &mem_util) : mem_util_(mem_util) {}
+
   virtual bool ParseCLIArguments(int argc, char **argv, bool &exit_app) {
     const struct option long_options[] = {
         {"otbn-trace-file", required_argument, nullptr, 'l'},
+        {"otbn-profile", required_argument, nullptr, 'p'},
+        {"otbn-profile-folded", required_argument, nullptr, 'f'},
         {"help", no_argument, nullptr, 'h'},
         {nullptr, no_argument, nullptr, 0}};
 
@@ -79,7 +119,18 @@ class OtbnTraceUtil : public SimCtrlExtension {
         case 0:
           break;
         case 'l':
-          return SetupTraceLog(optarg);
+          if (!SetupTraceLog(optarg)) {
+            return false;
+          }
+          break;
+        case 'p':
+          profile_path_ = optarg;
+          SetupProfile();
+          break;
+        case 'f':
+          profile_folded_path_ = optarg;
+          SetupProfile();
+          break;
         case 'h':
           PrintHelp();
           break;
@@ -89,9 +140,41 @@ class OtbnTraceUtil : public SimCtrlExtension {
     return true;
   }
 
+  void PostExec() override {
+    if (!profile_trace_listener_) {
+      return;
+    }
+
+    const ProfileTraceListener::Symbols &symbols = mem_util_.GetCodeSymbols();
+    if (profile_path_ == "-") {
+      std::cout << std::endl;
+      profile_trace_listener_->WriteSummary(std::cout, symbols);
+    } else if (!profile_path_.empty()) {
+      std::ofstream os(profile_path_);
+      profile_trace_listener_->WriteSummary(os, symbols);
+      if (!os) {
+        std::cerr << "ERROR: Failed to write OTBN profile to `"
+                  << profile_path_ << "'." << std::endl;
+        VerilatorSimCtrl::GetInstance().RequestStop(false);
+      }
+    }
+
+    if (!profile_folded_path_.empty()) {
+      std::ofstream os(profile_folded_path_);
+      profile_trace_listener_->WriteFolded(os, symbols);
+      if (!os) {
+        std::cerr << "ERROR: Failed to write OTBN folded stacks to `"
+                  << profile_folded_path_ << "'." << std::endl;
+        VerilatorSimCtrl::GetInstance().RequestStop(false);
+      }
+    }
+  }
+
   ~OtbnTraceUtil() {
     if (log_trace_listener_)
       OtbnTraceSource::get().RemoveListener(log_trace_listener_.get());
+    if (profile_trace_listener_)
+      OtbnTraceSource::get().RemoveListener(profile_trace_listener_.get());
   }
 };
 
@@ -100,7 +183,7 @@ static OtbnMemUtil otbn_memutil("TOP.otbn_top_sim");
 
 int main(int argc, char **argv) {
   VerilatorMemUtil memutil(&otbn_memutil);
-  OtbnTraceUtil traceutil;
+  OtbnTraceUtil traceutil(otbn_memutil);
 
   otbn_top_sim top;
   // Make the otbn_top_sim object visible to OtbnTopApplyLoopWarp.
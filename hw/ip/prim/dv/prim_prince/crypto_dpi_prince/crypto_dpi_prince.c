@@ -28,6 +28,89 @@ extern uint64_t c_dpi_prince_decrypt(const uint64_t ciphertext,
                                old_key_schedule);
 }
 
+/**
+ * Returns a pointer to the elements of a `longint unsigned` open array.
+ *
+ * Points into simulator storage if the array is contiguous, otherwise the
+ * elements are copied to `buf`, which must hold `n` elements.
+ */
+static uint64_t *prince_array_get(const svOpenArrayHandle arr, int n,
+                                  uint64_t *buf) {
+  uint64_t *ptr = (uint64_t *)svGetArrayPtr(arr);
+  if (ptr != NULL && svSizeOfArray(arr) == n * (int)sizeof(uint64_t)) {
+    return ptr;
+  }
+  for (int i = 0; i < n; ++i) {
+    buf[i] = *(const uint64_t *)svGetArrElemPtr1(arr, i);
+  }
+  return buf;
+}
+
+/**
+ * Encrypts or decrypts all elements of `data_i` into `data_o` in one call.
+ *
+ * `key0` and `key1` either hold a single key used for all blocks, or one key
+ * per block.
+ */
+static void prince_crypt_batch(const svOpenArrayHandle data_i,
+                               const svOpenArrayHandle key0,
+                               const svOpenArrayHandle key1,
+                               svOpenArrayHandle data_o, int decrypt,
+                               int num_half_rounds, int old_key_schedule) {
+  const int n = svSize(data_i, 1);
+  const int num_keys = svSize(key0, 1);
+  if (svSize(data_o, 1) != n || svSize(key1, 1) != num_keys ||
+      (num_keys != 1 && num_keys != n)) {
+    printf("ERROR: PRINCE batch expects %d outputs and 1 or %d keys\n", n, n);
+    return;
+  }
+  if (n == 0) {
+    return;
+  }
+
+  uint64_t *buf = (uint64_t *)malloc(3 * n * sizeof(uint64_t));
+  const uint64_t *in = prince_array_get(data_i, n, &buf[0]);
+  const uint64_t *k0 = prince_array_get(key0, num_keys, &buf[n]);
+  const uint64_t *k1 = prince_array_get(key1, num_keys, &buf[2 * n]);
+  uint64_t *out = (uint64_t *)svGetArrayPtr(data_o);
+  const int out_direct =
+      out != NULL && svSizeOfArray(data_o) == n * (int)sizeof(uint64_t);
+  if (!out_direct) {
+    // The input has been consumed by the time the output is written.
+    out = &buf[0];
+  }
+
+  prince_enc_dec_uint64_batch(in, k0, k1, num_keys == 1 ? 0 : 1, out, n,
+                              decrypt, num_half_rounds, old_key_schedule);
+
+  if (!out_direct) {
+    for (int i = 0; i < n; ++i) {
+      *(uint64_t *)svGetArrElemPtr1(data_o, i) = out[i];
+    }
+  }
+  free(buf);
+}
+
+extern void c_dpi_prince_encrypt_batch(const svOpenArrayHandle plaintext,
+                                       const svOpenArrayHandle key0,
+                                       const svOpenArrayHandle key1,
+                                       svOpenArrayHandle ciphertext,
+                                       int num_half_rounds,
+                                       int old_key_schedule) {
+  prince_crypt_batch(plaintext, key0, key1, ciphertext, 0, num_half_rounds,
+                     old_key_schedule);
+}
+
+extern void c_dpi_prince_decrypt_batch(const svOpenArrayHandle ciphertext,
+                                       const svOpenArrayHandle key0,
+                                       const svOpenArrayHandle key1,
+                                       svOpenArrayHandle plaintext,
+                                       int num_half_rounds,
+                                       int old_key_schedule) {
+  prince_crypt_batch(ciphertext, key0, key1, plaintext, 1, num_half_rounds,
+                     old_key_schedule);
+}
+
 #ifdef _cplusplus
 }
 #endif
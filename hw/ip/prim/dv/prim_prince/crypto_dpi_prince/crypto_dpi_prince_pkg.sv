@@ -27,6 +27,28 @@ package crypto_dpi_prince_pkg;
     input int unsigned      new_key_schedule
   );
 
+  // Batch variants: process all elements of `data` in a single call using a
+  // bit-sliced implementation of the cipher. `key0` and `key1` hold either a
+  // single key that is used for all blocks, or one key per block. `data` and
+  // `result` must have the same size.
+  import "DPI-C" context function void c_dpi_prince_encrypt_batch(
+    input  longint unsigned data[],
+    input  longint unsigned key0[],
+    input  longint unsigned key1[],
+    output longint unsigned result[],
+    input  int unsigned     num_half_rounds,
+    input  int unsigned     new_key_schedule
+  );
+
+  import "DPI-C" context function void c_dpi_prince_decrypt_batch(
+    input  longint unsigned data[],
+    input  longint unsigned key0[],
+    input  longint unsigned key1[],
+    output longint unsigned result[],
+    input  int unsigned     num_half_rounds,
+    input  int unsigned     new_key_schedule
+  );
+
   //////////////////////////////////////////////////////
   // SV wrapper functions to be used by the testbench //
   //////////////////////////////////////////////////////
@@ -61,4 +83,23 @@ package crypto_dpi_prince_pkg;
     end
   endfunction
 
+  // Encrypts all `plaintext` blocks with the same key and `num_half_rounds`
+  // half-rounds.
+  function automatic void sv_dpi_prince_encrypt_batch(
+    input bit [63:0]                      plaintext[],
+    input bit [127:0]                     key,
+    input int unsigned                    num_half_rounds,
+    input bit                             old_key_schedule,
+    output bit [63:0]                     ciphertext[]
+  );
+    longint unsigned data[] = new[plaintext.size()];
+    longint unsigned result[] = new[plaintext.size()];
+    longint unsigned key0[] = '{key[127:64]};  // k0 gets assigned the MSB halve
+    longint unsigned key1[] = '{key[63:0]};    // k1 gets assigned the LSB halve
+    foreach (plaintext[i]) data[i] = plaintext[i];
+    c_dpi_prince_encrypt_batch(data, key0, key1, result, num_half_rounds, old_key_schedule);
+    ciphertext = new[result.size()];
+    foreach (result[i]) ciphertext[i] = result[i];
+  endfunction
+
 endpackage
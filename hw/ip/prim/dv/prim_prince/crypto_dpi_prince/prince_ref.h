@@ -33,8 +33,12 @@
  *      schedule detailed in the original PRINCE paper and a newer key schedule.
  *    - Modification of `prince_core(...)` to handle the new key schedule and
  *      user-specified number of half-rounds.
+ *    - Addition of `prince_enc_dec_uint64_batch(...)`, a bit-sliced
+ *      implementation of `prince_enc_dec_uint64(...)` that processes 64 blocks
+ *      at a time.
  */
 
+#include <stddef.h>
 #include <stdint.h>
 #include <string.h>
 
@@ -294,6 +298,227 @@ uint64_t prince_enc_dec_uint64(const uint64_t input, const uint64_t enc_k0,
   return output;
 }
 
+/**
+ * Number of blocks processed in parallel by the bit-sliced implementation.
+ */
+#define PRINCE_SLICES 64
+
+/**
+ * Tables for the bit-sliced implementation, derived from the scalar layers
+ * above so that both implementations compute the same function.
+ */
+typedef struct prince_slice_tables {
+  int ready;
+  // Algebraic normal form of each output bit of the sbox and inverse sbox:
+  // bit u of anf[k] is set if monomial u (a product of the input bits set in
+  // u) is part of output bit k.
+  uint16_t sbox_anf[4];
+  uint16_t sbox_inv_anf[4];
+  // Input bits of each output bit of the linear layers M, M^-1 and M'. Every
+  // output bit is the XOR of exactly three input bits.
+  uint8_t m[64][3];
+  uint8_t m_inv[64][3];
+  uint8_t m_prime[64][3];
+} prince_slice_tables_t;
+
+static inline void prince_slice_anf(unsigned int (*sbox)(unsigned int),
+                                    uint16_t anf[4]) {
+  for (unsigned int k = 0; k < 4; k++) {
+    // Moebius transform of the truth table of output bit k.
+    uint16_t coef = 0;
+    for (unsigned int u = 0; u < 16; u++) {
+      unsigned int bit = 0;
+      for (unsigned int x = 0; x < 16; x++) {
+        if ((x & u) == x) {
+          bit ^= (sbox(x) >> k) & 1;
+        }
+      }
+      coef |= (uint16_t)(bit << u);
+    }
+    anf[k] = coef;
+  }
+}
+
+static inline void prince_slice_linear(uint64_t (*layer)(const uint64_t),
+                                       uint8_t rows[64][3]) {
+  unsigned int cnt[64] = {0};
+  for (unsigned int i = 0; i < 64; i++) {
+    const uint64_t col = layer((uint64_t)1 << i);
+    for (unsigned int b = 0; b < 64; b++) {
+      if (((col >> b) & 1) && cnt[b] < 3) {
+        rows[b][cnt[b]++] = (uint8_t)i;
+      }
+    }
+  }
+}
+
+static inline const prince_slice_tables_t *prince_slice_tables_get(void) {
+  static prince_slice_tables_t tables;
+  if (!tables.ready) {
+    prince_slice_anf(prince_sbox, tables.sbox_anf);
+    prince_slice_anf(prince_sbox_inv, tables.sbox_inv_anf);
+    prince_slice_linear(prince_m_layer, tables.m);
+    prince_slice_linear(prince_m_inv_layer, tables.m_inv);
+    prince_slice_linear(prince_m_prime_layer, tables.m_prime);
+    tables.ready = 1;
+  }
+  return &tables;
+}
+
+/**
+ * Transposes a 64x64 bit matrix in place.
+ *
+ * Afterwards, bit j of a[i] is what was bit i of a[j] before.
+ */
+static inline void prince_slice_transpose(uint64_t a[64]) {
+  uint64_t mask = 0x00000000FFFFFFFF;
+  for (unsigned int j = 32; j != 0; j >>= 1, mask ^= mask << j) {
+    for (unsigned int k = 0; k < 64; k = ((k | j) + 1) & ~j) {
+      const uint64_t t = ((a[k] >> j) ^ a[k | j]) & mask;
+      a[k] ^= t << j;
+      a[k | j] ^= t;
+    }
+  }
+}
+
+/**
+ * Converts one value per block into bit slices.
+ *
+ * If `stride` is 0, all blocks share `in[0]` and no transposition is needed.
+ */
+static inline void prince_slice_load(const uint64_t *in, size_t stride,
+                                     size_t n, uint64_t out[64]) {
+  if (stride == 0) {
+    for (unsigned int b = 0; b < 64; b++) {
+      out[b] = ((in[0] >> b) & 1) ? ~(uint64_t)0 : 0;
+    }
+    return;
+  }
+  for (size_t i = 0; i < 64; i++) {
+    out[i] = i < n ? in[i * stride] : 0;
+  }
+  prince_slice_transpose(out);
+}
+
+static inline void prince_slice_xor(uint64_t s[64], const uint64_t k[64]) {
+  for (unsigned int b = 0; b < 64; b++) {
+    s[b] ^= k[b];
+  }
+}
+
+static inline void prince_slice_xor_const(uint64_t s[64], const uint64_t c) {
+  for (unsigned int b = 0; b < 64; b++) {
+    if ((c >> b) & 1) {
+      s[b] = ~s[b];
+    }
+  }
+}
+
+static inline void prince_slice_s_layer(uint64_t s[64], const uint16_t anf[4]) {
+  for (unsigned int nibble = 0; nibble < 16; nibble++) {
+    uint64_t *x = &s[4 * nibble];
+    uint64_t mono[16];
+    mono[0] = ~(uint64_t)0;
+    for (unsigned int u = 1; u < 16; u++) {
+      // Extend the monomial without the highest input bit of u.
+      const unsigned int hi = u >= 8 ? 3 : u >= 4 ? 2 : u >= 2 ? 1 : 0;
+      mono[u] = mono[u ^ (1u << hi)] & x[hi];
+    }
+    for (unsigned int k = 0; k < 4; k++) {
+      uint64_t y = 0;
+      for (unsigned int u = 0; u < 16; u++) {
+        if ((anf[k] >> u) & 1) {
+          y ^= mono[u];
+        }
+      }
+      x[k] = y;
+    }
+  }
+}
+
+static inline void prince_slice_linear_layer(uint64_t s[64],
+                                             const uint8_t rows[64][3]) {
+  uint64_t t[64];
+  for (unsigned int b = 0; b < 64; b++) {
+    t[b] = s[rows[b][0]] ^ s[rows[b][1]] ^ s[rows[b][2]];
+  }
+  memcpy(s, t, sizeof(t));
+}
+
+/**
+ * Bit-sliced equivalent of `prince_enc_dec_uint64(...)`.
+ *
+ * Encrypts or decrypts `n` blocks, 64 at a time. Block i is processed with
+ * keys `enc_k0[i * key_stride]` and `enc_k1[i * key_stride]`, so a
+ * `key_stride` of 0 uses the same key for all blocks and a `key_stride` of 1
+ * uses one key per block. `output` may alias `input`.
+ */
+static inline void prince_enc_dec_uint64_batch(
+    const uint64_t *input, const uint64_t *enc_k0, const uint64_t *enc_k1,
+    size_t key_stride, uint64_t *output, size_t n, int decrypt,
+    int num_half_rounds, int old_key_schedule) {
+  const prince_slice_tables_t *tables = prince_slice_tables_get();
+  const uint64_t prince_alpha = 0xc0ac29b7c97c50dd;
+  const uint64_t dec_mask = decrypt ? prince_alpha : 0;
+
+  for (size_t base = 0; base < n; base += PRINCE_SLICES) {
+    const size_t num = n - base < PRINCE_SLICES ? n - base : PRINCE_SLICES;
+    uint64_t st[64], k0[64], k0_prime[64], k1[64], k0_new[64];
+
+    // Derive the keys of every block as in prince_enc_dec_uint64().
+    {
+      uint64_t keys[4][PRINCE_SLICES];
+      const size_t num_keys = key_stride ? num : 1;
+      for (size_t i = 0; i < num_keys; i++) {
+        const uint64_t ek0 = enc_k0[(base + i) * key_stride];
+        const uint64_t ek1 = enc_k1[(base + i) * key_stride];
+        const uint64_t ek0_prime = prince_k0_to_k0_prime(ek0);
+        keys[0][i] = decrypt ? ek0_prime : ek0;
+        keys[1][i] = decrypt ? ek0 : ek0_prime;
+        keys[2][i] = ek1 ^ dec_mask;
+        keys[3][i] = old_key_schedule ? keys[2][i] : ek0 ^ dec_mask;
+      }
+      const size_t stride = key_stride ? 1 : 0;
+      prince_slice_load(keys[0], stride, num, k0);
+      prince_slice_load(keys[1], stride, num, k0_prime);
+      prince_slice_load(keys[2], stride, num, k1);
+      prince_slice_load(keys[3], stride, num, k0_new);
+    }
+
+    prince_slice_load(&input[base], 1, num, st);
+    prince_slice_xor(st, k0);
+
+    // prince_core()
+    prince_slice_xor(st, k1);
+    prince_slice_xor_const(st, prince_round_constant(0));
+    for (int round = 1; round <= num_half_rounds; round++) {
+      prince_slice_s_layer(st, tables->sbox_anf);
+      prince_slice_linear_layer(st, tables->m);
+      prince_slice_xor(st, (round % 2 == 1) ? k0_new : k1);
+      prince_slice_xor_const(st, prince_round_constant(round));
+    }
+    prince_slice_s_layer(st, tables->sbox_anf);
+    prince_slice_linear_layer(st, tables->m_prime);
+    prince_slice_s_layer(st, tables->sbox_inv_anf);
+    for (int round = 1; round <= num_half_rounds; round++) {
+      const unsigned int constant_idx = 10 - num_half_rounds + round;
+      prince_slice_xor(st, ((num_half_rounds + round + 1) % 2 == 1) ? k0_new
+                                                                    : k1);
+      prince_slice_xor_const(st, prince_round_constant(constant_idx));
+      prince_slice_linear_layer(st, tables->m_inv);
+      prince_slice_s_layer(st, tables->sbox_inv_anf);
+    }
+    prince_slice_xor(st, k1);
+    prince_slice_xor_const(st, prince_round_constant(11));
+
+    prince_slice_xor(st, k0_prime);
+    prince_slice_transpose(st);
+    for (size_t i = 0; i < num; i++) {
+      output[base + i] = st[i];
+    }
+  }
+}
+
 /**
  * Byte oriented top level function for Prince encryption/decryption.
  *
@@ -23,15 +23,6 @@ static const uint32_t kNumAddrSubstPermRounds = 2;
 static const uint32_t kNumDataSubstPermRounds = 2;
 static const uint32_t kNumPrinceHalfRounds = 2;
 
-static std::vector<uint8_t> byte_reverse_vector(
-    const std::vector<uint8_t> &vec_in) {
-  std::vector<uint8_t> vec_out(vec_in.size());
-
-  std::reverse_copy(std::begin(vec_in), std::end(vec_in), std::begin(vec_out));
-
-  return vec_out;
-}
-
 static uint8_t read_vector_bit(const std::vector<uint8_t> &vec,
                                uint32_t bit_pos) {
   assert(bit_pos / 8 < vec.size());
@@ -197,40 +188,47 @@ static std::vector<uint8_t> scramble_gen_keystream(
     num_repetitions = 1;
   }
 
-  std::vector<uint8_t> keystream;
+  // Initial vector is data for PRINCE to encrypt. Formed from nonce and data
+  // address. All PRINCE instances are computed in a single batched call.
+  std::vector<uint64_t> ivs(num_princes, 0);
 
   for (int i = 0; i < num_princes; ++i) {
-    // Initial vector is data for PRINCE to encrypt. Formed from nonce and data
-    // address
-    std::vector<uint8_t> iv(8, 0);
-
     for (int j = 0; j < kPrinceWidth; ++j) {
+      uint64_t iv_bit;
       if (j < addr_width) {
         // Bottom addr_width bits of IV are address
-        or_vector_bit(iv, j, read_vector_bit(addr, j));
+        iv_bit = read_vector_bit(addr, j);
       } else {
         // Other bits are taken from nonce. Each PRINCE instantiation will use
         // different nonce bits.
         int nonce_bit = (j - addr_width) + i * (kPrinceWidth - addr_width);
-        or_vector_bit(iv, j, read_vector_bit(nonce, nonce_bit));
+        iv_bit = read_vector_bit(nonce, nonce_bit);
       }
+      ivs[i] |= iv_bit << j;
     }
+  }
+
+  // The key is in little endian byte order, K0 is its upper half
+  uint64_t k0 = 0, k1 = 0;
+  for (int i = 0; i < kPrinceWidthByte; ++i) {
+    k1 |= static_cast<uint64_t>(key[i]) << (8 * i);
+    k0 |= static_cast<uint64_t>(key[kPrinceWidthByte + i]) << (8 * i);
+  }
 
-    // PRINCE C reference model works on big-endian byte order
-    iv = byte_reverse_vector(iv);
-    auto key_be = byte_reverse_vector(key);
+  // Apply PRINCE to IVs to produce keystream
+  std::vector<uint64_t> keystream_blocks(num_princes);
+  prince_enc_dec_uint64_batch(ivs.data(), &k0, &k1, 0, keystream_blocks.data(),
+                              num_princes, 0, num_half_rounds, 0);
 
-    // Apply PRINCE to IV to produce keystream
-    std::vector<uint8_t> keystream_block(kPrinceWidthByte);
-    prince_enc_dec(&iv[0], &key_be[0], &keystream_block[0], 0, num_half_rounds,
-                   0);
+  std::vector<uint8_t> keystream;
 
-    // Flip keystream into little endian order and add to keystream vector
-    keystream_block = byte_reverse_vector(keystream_block);
-    // Repeat the output of a single PRINCE instance if needed
+  for (int i = 0; i < num_princes; ++i) {
+    // Add keystream to keystream vector in little endian order, repeating the
+    // output of a single PRINCE instance if needed
     for (int k = 0; k < num_repetitions; ++k) {
-      keystream.insert(keystream.end(), keystream_block.begin(),
-                       keystream_block.end());
+      for (int b = 0; b < kPrinceWidthByte; ++b) {
+        keystream.push_back(keystream_blocks[i] >> (8 * b));
+      }
     }
   }
 
@@ -51,6 +51,9 @@ module prim_generic_ram_1p import prim_ram_1p_pkg::*; #(
   // thrown when using $readmemh system task to backdoor load an image
   always @(posedge clk_i) begin
     if (req_i) begin
+`ifdef SIMUTIL_LAZY_LOAD
+      simutil_lazy_touch(int'(addr_i));
+`endif
       if (write_i) begin
         for (int i=0; i < MaskWidth; i = i + 1) begin
           if (wmask[i]) begin
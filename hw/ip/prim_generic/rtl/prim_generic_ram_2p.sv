@@ -64,6 +64,9 @@ module prim_generic_ram_2p import prim_ram_2p_pkg::*; #(
   // thrown due to 'mem' being driven by two always processes below
   always @(posedge clk_a_i) begin
     if (a_req_i) begin
+`ifdef SIMUTIL_LAZY_LOAD
+      simutil_lazy_touch(int'(a_addr_i));
+`endif
       if (a_write_i) begin
         for (int i=0; i < MaskWidth; i = i + 1) begin
           if (a_wmask[i]) begin
@@ -79,6 +82,9 @@ module prim_generic_ram_2p import prim_ram_2p_pkg::*; #(
 
   always @(posedge clk_b_i) begin
     if (b_req_i) begin
+`ifdef SIMUTIL_LAZY_LOAD
+      simutil_lazy_touch(int'(b_addr_i));
+`endif
       if (b_write_i) begin
         for (int i=0; i < MaskWidth; i = i + 1) begin
           if (b_wmask[i]) begin
@@ -25,6 +25,9 @@ module prim_generic_rom import prim_rom_pkg::*; #(
 
   always_ff @(posedge clk_i) begin
     if (req_i) begin
+`ifdef SIMUTIL_LAZY_LOAD
+      simutil_lazy_touch(int'(addr_i));
+`endif
       rdata_o <= mem[addr_i];
     end
   end
@@ -5,6 +5,7 @@
 #include <iostream>
 #include <string>
 
+#include "sw_profiler.h"
 #include "verilated_toplevel.h"
 #include "verilator_memutil.h"
 #include "verilator_sim_ctrl.h"
@@ -41,6 +42,9 @@ int main(int argc, char **argv) {
   memutil.RegisterMemoryArea("otp", 0x40000000u /* (bogus LMA) */, &otp);
   simctrl.RegisterExtension(&memutil);
 
+  SwProfiler profiler(memutil.GetUnderlying());
+  simctrl.RegisterExtension(&profiler);
+
   // The initial reset delay must be long enough such that pwr/rst/clkmgr will
   // release clocks to the entire design.  This allows for synchronous resets
   // to appropriately propagate.
@@ -194,6 +194,70 @@ module chip_sim_tb (
     u_sw_test_status_if.sw_test_status_addr = `SIM_SRAM_IF.start_addr;
   end
 
+  // Software built with DV logging writes its logs to the word after the test status address (see
+  // kDeviceLogBypassUartAddress in sw/device/lib/arch/device_sim_verilator.c). Pass these writes to
+  // the host, where dv_log_sink.cc decodes and prints them.
+  import "DPI-C" function void dv_log_sink_write(input int unsigned data);
+
+  always @(posedge `SIM_SRAM_IF.clk_i) begin
+    if (`SIM_SRAM_IF.wr_valid &&
+        `SIM_SRAM_IF.tl_h2d.a_address == `SIM_SRAM_IF.start_addr + 4) begin
+      dv_log_sink_write(`SIM_SRAM_IF.tl_h2d.a_data);
+    end
+  end
+
+`ifdef RVFI
+  // Software profiling (see sw_profiler.h). Calls and returns retired by Ibex are passed to the
+  // profiler so that it can keep a shadow call stack, and the PC of the last retired instruction is
+  // sampled every sw_profiler_period() cycles. A call is a jump that links to ra. A return is a
+  // jalr (or c.jr) through ra that doesn't link.
+  import "DPI-C" function int unsigned sw_profiler_period();
+  import "DPI-C" function void sw_profiler_call(input int unsigned target,
+                                                input int unsigned ret_addr);
+  import "DPI-C" function void sw_profiler_return(input int unsigned target);
+  import "DPI-C" function void sw_profiler_sample(input int unsigned pc);
+
+  int unsigned profile_period, profile_count;
+  logic [31:0] profile_pc;
+  logic [31:0] retired_insn;
+  logic        retired_compressed, retired_jump, retired_jalr;
+
+  initial begin
+    profile_period = sw_profiler_period();
+    profile_count = 0;
+    profile_pc = '0;
+  end
+
+  assign retired_insn = `RV_CORE_IBEX.rvfi_insn;
+  assign retired_compressed = retired_insn[1:0] != 2'b11;
+  assign retired_jump = `RV_CORE_IBEX.rvfi_valid && !`RV_CORE_IBEX.rvfi_trap &&
+                        (`RV_CORE_IBEX.rvfi_pc_wdata !=
+                         `RV_CORE_IBEX.rvfi_pc_rdata + (retired_compressed ? 32'd2 : 32'd4));
+  assign retired_jalr = retired_compressed ?
+      (retired_insn[1:0] == 2'b10 && retired_insn[15:13] == 3'b100 && retired_insn[6:2] == '0) :
+      (retired_insn[6:0] == 7'b1100111);
+
+  always @(posedge `RV_CORE_IBEX.clk_i) begin
+    if (profile_period != 0) begin
+      if (`RV_CORE_IBEX.rvfi_valid) begin
+        profile_pc <= `RV_CORE_IBEX.rvfi_pc_rdata;
+      end
+      if (retired_jump && `RV_CORE_IBEX.rvfi_rd_addr == 5'd1) begin
+        sw_profiler_call(`RV_CORE_IBEX.rvfi_pc_wdata, `RV_CORE_IBEX.rvfi_rd_wdata);
+      end else if (retired_jump && retired_jalr && `RV_CORE_IBEX.rvfi_rd_addr == 5'd0 &&
+                   `RV_CORE_IBEX.rvfi_rs1_addr == 5'd1) begin
+        sw_profiler_return(`RV_CORE_IBEX.rvfi_pc_wdata);
+      end
+      if (profile_count + 1 == profile_period) begin
+        sw_profiler_sample(profile_pc);
+        profile_count <= 0;
+      end else begin
+        profile_count <= profile_count + 1;
+      end
+    end
+  end
+`endif
+
   always @(posedge clk_i) begin
     if (u_sw_test_status_if.sw_test_done) begin
       $display("Verilator sim termination requested");
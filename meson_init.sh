@@ -41,12 +41,13 @@ function usage() {
   cat << USAGE
 Configure Meson build targets.
 
-Usage: $0 [-r|-f|-A|-K|-c] [-T PATH] [-t FILE]
+Usage: $0 [-r|-f|-A|-K|-c|-l] [-T PATH] [-t FILE]
 
   -A: Assert that no build dirs exist when running this command.
   -c: Enable coverage (requires clang).
   -f: Force a reconfiguration by removing existing build dirs.
   -K: Keep include search paths as generated by Meson.
+  -l: Make Verilator builds log via the testbench (DV logging), not the UART.
   -r: Reconfigure build dirs, if they exist.
   -t FILE: Configure Meson with toolchain configuration FILE
 
@@ -62,6 +63,7 @@ FLAGS_reconfigure=""
 FLAGS_keep_includes=false
 FLAGS_specified_toolchain_file=false
 FLAGS_coverage=false
+FLAGS_verilator_dv_log=false
 ARG_toolchain_file="${TOOLCHAIN_PATH}/meson-riscv32-unknown-elf-clang.txt"
 # `getopts` usage
 # - The initial colon in the optstring is to suppress the default error
@@ -76,12 +78,13 @@ ARG_toolchain_file="${TOOLCHAIN_PATH}/meson-riscv32-unknown-elf-clang.txt"
 #     relevant parsed option.
 # - After option parsing is finished, we `shift` by `$OPTIND - 1` so that the
 #   remaining (unprocessed) arguments are in `$@` (and $1, $2, $3 etc.).
-while getopts ':AcfKrt:T:' flag; do
+while getopts ':AcfKlrt:T:' flag; do
   case "${flag}" in
     A) FLAGS_assert=true;;
     c) FLAGS_coverage=true;;
     f) FLAGS_force=true;;
     K) FLAGS_keep_includes=true;;
+    l) FLAGS_verilator_dv_log=true;;
     r) FLAGS_reconfigure="--reconfigure";;
     t) FLAGS_specified_toolchain_file=true
        ARG_toolchain_file="${OPTARG}";;
@@ -165,5 +168,6 @@ meson $reconf \
   -Dbin_dir="$BIN_DIR" \
   -Dkeep_includes="$FLAGS_keep_includes" \
   -Dcoverage="$FLAGS_coverage" \
+  -Dverilator_dv_log="$FLAGS_verilator_dv_log" \
   --cross-file="$ARG_toolchain_file" \
   "$OBJ_DIR"
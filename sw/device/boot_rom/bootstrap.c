@@ -123,28 +123,39 @@ static bool check_frame_hash(const dif_hmac_t *hmac,
  * Load spiflash frames from the SPI interface.
  *
  * This function checks that the sequence numbers and hashes of the frames are
- * correct before programming them into flash.
+ * correct before programming them into flash. Frames are double buffered so
+ * that the next frame can be received and checked while the previous one is
+ * being programmed.
  */
 static int bootstrap_flash(const dif_spi_device_t *spi,
                            const dif_spi_device_config_t *spi_config,
                            const dif_hmac_t *hmac) {
   dif_hmac_digest_t ack = {0};
   uint32_t expected_frame_num = 0;
+  spiflash_frame_t frames[2];
+  size_t frame_idx = 0;
+  flash_segment_t segment;
+  flash_transfer_t transfer;
+  bool transfer_pending = false;
   while (true) {
+    if (transfer_pending) {
+      flash_transfer_poll(&transfer);
+    }
+
     size_t bytes_available;
     CHECK_DIF_OK(dif_spi_device_rx_pending(spi, spi_config, &bytes_available));
     if (bytes_available >= sizeof(spiflash_frame_t)) {
-      spiflash_frame_t frame;
-      CHECK_DIF_OK(dif_spi_device_recv(spi, spi_config, &frame,
+      spiflash_frame_t *frame = &frames[frame_idx];
+      CHECK_DIF_OK(dif_spi_device_recv(spi, spi_config, frame,
                                        sizeof(spiflash_frame_t),
                                        /*bytes_received=*/NULL));
 
-      uint32_t frame_num = SPIFLASH_FRAME_NUM(frame.header.frame_num);
+      uint32_t frame_num = SPIFLASH_FRAME_NUM(frame->header.frame_num);
       LOG_INFO("Processing frame #%d, expecting #%d", frame_num,
                expected_frame_num);
 
       if (frame_num == expected_frame_num) {
-        if (!check_frame_hash(hmac, &frame)) {
+        if (!check_frame_hash(hmac, frame)) {
           LOG_ERROR("Detected hash mismatch on frame #%d", frame_num);
           CHECK_DIF_OK(dif_spi_device_send(
               spi, spi_config, (uint8_t *)&ack.digest, sizeof(ack.digest),
@@ -152,7 +163,7 @@ static int bootstrap_flash(const dif_spi_device_t *spi,
           continue;
         }
 
-        compute_sha256(hmac, &frame, sizeof(spiflash_frame_t), &ack);
+        compute_sha256(hmac, frame, sizeof(spiflash_frame_t), &ack);
         CHECK_DIF_OK(dif_spi_device_send(
             spi, spi_config, (uint8_t *)&ack.digest, sizeof(ack.digest),
             /*bytes_received=*/NULL));
@@ -167,13 +178,25 @@ static int bootstrap_flash(const dif_spi_device_t *spi,
           LOG_INFO("Flash erase successful");
         }
 
-        if (flash_write(frame.header.flash_offset, kDataPartition, frame.data,
-                        SPIFLASH_FRAME_DATA_WORDS) != 0) {
+        // Wait for the previous frame before programming this one.
+        if (transfer_pending && flash_transfer_wait(&transfer) != 0) {
           return E_BS_WRITE;
         }
+        segment = (flash_segment_t){
+            .addr = frame->header.flash_offset,
+            .src = frame->data,
+            .size = SPIFLASH_FRAME_DATA_WORDS,
+        };
+        flash_transfer_start(&transfer, kFlashTransferProgram, kDataPartition,
+                             &segment, 1);
+        transfer_pending = true;
+        frame_idx ^= 1;
 
         ++expected_frame_num;
-        if (SPIFLASH_FRAME_IS_EOF(frame.header.frame_num)) {
+        if (SPIFLASH_FRAME_IS_EOF(frame->header.frame_num)) {
+          if (flash_transfer_wait(&transfer) != 0) {
+            return E_BS_WRITE;
+          }
           LOG_INFO("Bootstrap: DONE!");
           return 0;
         }
@@ -28,4 +28,10 @@ const uint32_t kUartNCOValue =
 // Defined in `hw/top_earlgrey/chip_earlgrey_verilator.core`
 const uintptr_t kDeviceTestStatusAddress = 0x30000000;
 
+#ifdef OT_VERILATOR_DV_LOG
+// Decoded on the host by `hw/dv/verilator/cpp/dv_log_sink.cc`, see
+// `hw/top_earlgrey/dv/verilator/chip_sim_tb.sv`.
+const uintptr_t kDeviceLogBypassUartAddress = 0x30000004;
+#else
 const uintptr_t kDeviceLogBypassUartAddress = 0;
+#endif
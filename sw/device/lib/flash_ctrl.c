@@ -13,6 +13,13 @@
 #define PROGRAM_RESOLUTION_WORDS \
   (FLASH_CTRL_PARAM_REG_BUS_PGM_RES_BYTES / sizeof(uint32_t))
 
+// Depth of the read and program FIFOs, see `FifoDepth` in flash_ctrl_pkg.sv.
+#define FIFO_DEPTH_WORDS 16
+// Read FIFO level that triggers a burst read.
+#define RD_FIFO_LVL_WORDS (FIFO_DEPTH_WORDS / 2)
+// Maximum number of words in a single controller operation.
+#define MAX_OP_WORDS (FLASH_CTRL_CONTROL_NUM_MASK + 1)
+
 #define REG32(add) *((volatile uint32_t *)(add))
 #define SETBIT(val, bit) (val | 1 << bit)
 #define CLRBIT(val, bit) (val & ~(1 << bit))
@@ -106,74 +113,186 @@ int flash_page_erase(uint32_t addr, part_type_t part) {
   return get_clr_err();
 }
 
-static int flash_write_internal(uint32_t addr, part_type_t part,
-                                const uint32_t *data, uint32_t size) {
+/* Start the next controller operation of a transfer */
+static void transfer_op_start(flash_transfer_t *transfer) {
+  const flash_segment_t *segment = &transfer->segments[transfer->segment];
+  uint32_t addr = segment->addr + transfer->offset * sizeof(uint32_t);
+  uint32_t words = segment->size - transfer->offset;
+  uint32_t max_words = MAX_OP_WORDS;
+  flash_op_t op = FLASH_READ;
+  if (transfer->op == kFlashTransferProgram) {
+    // Program operations must not cross a program window.
+    max_words = PROGRAM_RESOLUTION_WORDS -
+                (addr / sizeof(uint32_t)) % PROGRAM_RESOLUTION_WORDS;
+    op = FLASH_PROG;
+  }
+  if (words > max_words) {
+    words = max_words;
+  }
+
+  // Discard read level events of previous operations.
+  REG32(FLASH_CTRL0_BASE_ADDR + FLASH_CTRL_INTR_STATE_REG_OFFSET) =
+      1 << FLASH_CTRL_INTR_STATE_RD_LVL_BIT;
   // TODO: Do we need to select bank as part of the write?
-  // TODO: Update with address alignment requirements.
   REG32(FLASH_CTRL0_BASE_ADDR + FLASH_CTRL_ADDR_REG_OFFSET) = addr;
   REG32(FLASH_CTRL0_BASE_ADDR + FLASH_CTRL_CONTROL_REG_OFFSET) =
-      (FLASH_PROG << FLASH_CTRL_CONTROL_OP_OFFSET |
-       part << FLASH_CTRL_CONTROL_PARTITION_SEL_BIT |
-       (size - 1) << FLASH_CTRL_CONTROL_NUM_OFFSET |
+      (op << FLASH_CTRL_CONTROL_OP_OFFSET |
+       transfer->part << FLASH_CTRL_CONTROL_PARTITION_SEL_BIT |
+       (words - 1) << FLASH_CTRL_CONTROL_NUM_OFFSET |
        0x1 << FLASH_CTRL_CONTROL_START_BIT);
-  for (int i = 0; i < size; ++i) {
-    REG32(FLASH_CTRL0_BASE_ADDR + FLASH_CTRL_PROG_FIFO_REG_OFFSET) = data[i];
+  transfer->op_words = words;
+  transfer->op_offset = 0;
+  transfer->op_busy = true;
+}
+
+/* Push all words of the current program operation to the program FIFO */
+static void prog_fifo_fill(flash_transfer_t *transfer) {
+  const uint32_t *data = transfer->segments[transfer->segment].src +
+                         transfer->offset + transfer->op_offset;
+  // A program operation never exceeds a program window, which fits in the
+  // FIFO, so these writes do not stall.
+  for (uint32_t i = transfer->op_offset; i < transfer->op_words; ++i) {
+    REG32(FLASH_CTRL0_BASE_ADDR + FLASH_CTRL_PROG_FIFO_REG_OFFSET) = *data++;
   }
-  wait_done_and_ack();
-  return get_clr_err();
+  transfer->op_offset = transfer->op_words;
 }
 
-// The address is assumed to be aligned to uint32_t.
-int flash_write(uint32_t addr, part_type_t part, const uint32_t *data,
-                uint32_t size) {
-  uint32_t window_offset = (addr / sizeof(uint32_t)) % PROGRAM_RESOLUTION_WORDS;
-  uint32_t max_words = PROGRAM_RESOLUTION_WORDS;
-
-  // If initial address isn't aligned, the delta is the max
-  // number of words that can be programmed.
-  max_words = PROGRAM_RESOLUTION_WORDS - window_offset;
-
-  // Loop through the amount of data to program.
-  uint32_t words_to_program = max_words;
-  uint32_t words_remaining = size;
-  uint32_t current_word = 0;
-  uint32_t err = 0;
-  while (words_remaining > 0) {
-    // Determine the number of words to program.
-    if (words_remaining < max_words) {
-      words_to_program = words_remaining;
-    } else {
-      words_to_program = max_words;
-    }
-    err |= flash_write_internal(addr + current_word * sizeof(uint32_t), part,
-                                data, words_to_program);
-    current_word += words_to_program;
-    data += words_to_program;
-
-    // Increment remaining words and reset max words to program.
-    max_words = PROGRAM_RESOLUTION_WORDS;
-    words_remaining = size - current_word;
+/*
+ * Return the number of words that can be read from the read FIFO at once.
+ *
+ * Reading an empty read FIFO stalls the bus until the controller provides the
+ * next word (all ones on errors), so the returned count only has to be a good
+ * estimate to avoid long stalls, not an exact one.
+ */
+static uint32_t rd_fifo_burst_get(const flash_transfer_t *transfer) {
+  uint32_t remaining = transfer->op_words - transfer->op_offset;
+  uint32_t burst = 0;
+  if ((REG32(FLASH_CTRL0_BASE_ADDR + FLASH_CTRL_OP_STATUS_REG_OFFSET) >>
+       FLASH_CTRL_OP_STATUS_DONE_BIT) &
+      0x1) {
+    // All words of the operation are in the FIFO.
+    return remaining;
+  }
+  uint32_t status = REG32(FLASH_CTRL0_BASE_ADDR + FLASH_CTRL_STATUS_REG_OFFSET);
+  if ((status >> FLASH_CTRL_STATUS_RD_FULL_BIT) & 0x1) {
+    burst = FIFO_DEPTH_WORDS;
+  } else if ((REG32(FLASH_CTRL0_BASE_ADDR + FLASH_CTRL_INTR_STATE_REG_OFFSET) >>
+              FLASH_CTRL_INTR_STATE_RD_LVL_BIT) &
+             0x1) {
+    // Clear the event before draining so that the next one is not lost.
+    REG32(FLASH_CTRL0_BASE_ADDR + FLASH_CTRL_INTR_STATE_REG_OFFSET) =
+        1 << FLASH_CTRL_INTR_STATE_RD_LVL_BIT;
+    burst = RD_FIFO_LVL_WORDS;
+  } else if (((status >> FLASH_CTRL_STATUS_RD_EMPTY_BIT) & 0x1) == 0) {
+    burst = 1;
   }
-  return err;
+  return burst < remaining ? burst : remaining;
 }
 
-int flash_read(uint32_t addr, part_type_t part, uint32_t size, uint32_t *data) {
-  REG32(FLASH_CTRL0_BASE_ADDR + FLASH_CTRL_ADDR_REG_OFFSET) = addr;
-  REG32(FLASH_CTRL0_BASE_ADDR + FLASH_CTRL_CONTROL_REG_OFFSET) =
-      FLASH_READ << FLASH_CTRL_CONTROL_OP_OFFSET |
-      part << FLASH_CTRL_CONTROL_PARTITION_SEL_BIT |
-      (size - 1) << FLASH_CTRL_CONTROL_NUM_OFFSET |
-      0x1 << FLASH_CTRL_CONTROL_START_BIT;
-  for (uint32_t i = 0; i < size;) {
-    if (((REG32(FLASH_CTRL0_BASE_ADDR + FLASH_CTRL_STATUS_REG_OFFSET) >>
-          FLASH_CTRL_STATUS_RD_EMPTY_BIT) &
-         0x1) == 0) {
+/* Move all words that are available in the read FIFO to the destination */
+static void rd_fifo_drain(flash_transfer_t *transfer) {
+  uint32_t *data = transfer->segments[transfer->segment].dst +
+                   transfer->offset + transfer->op_offset;
+  uint32_t burst;
+  while ((burst = rd_fifo_burst_get(transfer)) > 0) {
+    for (uint32_t i = 0; i < burst; ++i) {
       *data++ = REG32(FLASH_CTRL0_BASE_ADDR + FLASH_CTRL_RD_FIFO_REG_OFFSET);
-      i++;
     }
+    transfer->op_offset += burst;
   }
-  wait_done_and_ack();
-  return get_clr_err();
+}
+
+/* Check whether the current operation is done, and ACK it if so */
+static bool transfer_op_done(flash_transfer_t *transfer) {
+  uint32_t op_status =
+      REG32(FLASH_CTRL0_BASE_ADDR + FLASH_CTRL_OP_STATUS_REG_OFFSET);
+  if (((op_status >> FLASH_CTRL_OP_STATUS_DONE_BIT) & 0x1) == 0) {
+    return false;
+  }
+  REG32(FLASH_CTRL0_BASE_ADDR + FLASH_CTRL_OP_STATUS_REG_OFFSET) = 0;
+  if ((op_status >> FLASH_CTRL_OP_STATUS_ERR_BIT) & 0x1) {
+    transfer->err |= get_clr_err();
+  }
+  return true;
+}
+
+void flash_transfer_start(flash_transfer_t *transfer, flash_transfer_op_t op,
+                          part_type_t part, const flash_segment_t *segments,
+                          size_t num_segments) {
+  *transfer = (flash_transfer_t){
+      .op = op,
+      .part = part,
+      .segments = segments,
+      .num_segments = num_segments,
+  };
+  if (op == kFlashTransferRead) {
+    uint32_t fifo_lvl =
+        REG32(FLASH_CTRL0_BASE_ADDR + FLASH_CTRL_FIFO_LVL_REG_OFFSET);
+    fifo_lvl &= ~(FLASH_CTRL_FIFO_LVL_RD_MASK << FLASH_CTRL_FIFO_LVL_RD_OFFSET);
+    fifo_lvl |= RD_FIFO_LVL_WORDS << FLASH_CTRL_FIFO_LVL_RD_OFFSET;
+    REG32(FLASH_CTRL0_BASE_ADDR + FLASH_CTRL_FIFO_LVL_REG_OFFSET) = fifo_lvl;
+  }
+  flash_transfer_poll(transfer);
+}
+
+bool flash_transfer_poll(flash_transfer_t *transfer) {
+  while (true) {
+    if (!transfer->op_busy) {
+      while (transfer->segment < transfer->num_segments &&
+             transfer->offset == transfer->segments[transfer->segment].size) {
+        ++transfer->segment;
+        transfer->offset = 0;
+      }
+      if (transfer->segment == transfer->num_segments) {
+        return true;
+      }
+      transfer_op_start(transfer);
+      if (transfer->op == kFlashTransferProgram) {
+        prog_fifo_fill(transfer);
+      }
+    }
+    if (transfer->op == kFlashTransferRead) {
+      rd_fifo_drain(transfer);
+      if (transfer->op_offset < transfer->op_words) {
+        return false;
+      }
+    }
+    if (!transfer_op_done(transfer)) {
+      return false;
+    }
+    transfer->offset += transfer->op_words;
+    transfer->op_busy = false;
+  }
+}
+
+int flash_transfer_wait(flash_transfer_t *transfer) {
+  while (!flash_transfer_poll(transfer)) {
+  }
+  return transfer->err;
+}
+
+// The address is assumed to be aligned to uint32_t.
+int flash_write(uint32_t addr, part_type_t part, const uint32_t *data,
+                uint32_t size) {
+  flash_segment_t segment = {
+      .addr = addr,
+      .src = data,
+      .size = size,
+  };
+  flash_transfer_t transfer;
+  flash_transfer_start(&transfer, kFlashTransferProgram, part, &segment, 1);
+  return flash_transfer_wait(&transfer);
+}
+
+int flash_read(uint32_t addr, part_type_t part, uint32_t size, uint32_t *data) {
+  flash_segment_t segment = {
+      .addr = addr,
+      .dst = data,
+      .size = size,
+  };
+  flash_transfer_t transfer;
+  flash_transfer_start(&transfer, kFlashTransferRead, part, &segment, 1);
+  return flash_transfer_wait(&transfer);
 }
 
 void flash_cfg_bank_erase(bank_index_t bank, bool erase_en) {
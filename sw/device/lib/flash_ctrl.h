@@ -6,6 +6,7 @@
 #define OPENTITAN_SW_DEVICE_LIB_FLASH_CTRL_H_
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 // Flash memory base defines, _SZ are presented in bytes
@@ -91,6 +92,95 @@ int flash_write(uint32_t addr, part_type_t part, const uint32_t *data,
  */
 int flash_read(uint32_t addr, part_type_t part, uint32_t size, uint32_t *data);
 
+/**
+ * Flash transfer operations.
+ */
+typedef enum flash_transfer_op {
+  kFlashTransferRead = 0,
+  kFlashTransferProgram = 1,
+} flash_transfer_op_t;
+
+/**
+ * A contiguous region of flash used in a scatter-gather transfer.
+ */
+typedef struct flash_segment {
+  /** Flash address 32bit aligned. */
+  uint32_t addr;
+  /** Buffer to read into, for read transfers. */
+  uint32_t *dst;
+  /** Data to program, for program transfers. */
+  const uint32_t *src;
+  /** Number of 4B words in this segment. */
+  uint32_t size;
+} flash_segment_t;
+
+/**
+ * State of an asynchronous scatter-gather transfer.
+ *
+ * Callers must not modify this struct or the segments it points to until
+ * the transfer is complete.
+ */
+typedef struct flash_transfer {
+  /** Operation performed on all segments. */
+  flash_transfer_op_t op;
+  /** Flash partition to access. */
+  part_type_t part;
+  /** Segments of the transfer. */
+  const flash_segment_t *segments;
+  /** Number of segments. */
+  size_t num_segments;
+  /** Index of the current segment. */
+  size_t segment;
+  /** Number of words of the current segment that are complete. */
+  uint32_t offset;
+  /** Number of words in the current controller operation. */
+  uint32_t op_words;
+  /** Number of words of the current operation that went through the FIFO. */
+  uint32_t op_offset;
+  /** Whether a controller operation is in progress. */
+  bool op_busy;
+  /** Accumulated error codes, non zero on failure. */
+  int err;
+} flash_transfer_t;
+
+/**
+ * Start an asynchronous scatter-gather transfer.
+ *
+ * Reads are split into as few controller operations as possible and drained
+ * from the read FIFO in bursts. Programs are split at program window
+ * boundaries; each window is pushed to the program FIFO in one burst.
+ *
+ * The controller must be idle, i.e. no other operation may be in progress.
+ *
+ * @param transfer Transfer state, initialized by this function.
+ * @param op Operation to perform.
+ * @param part Flash parittion to access.
+ * @param segments Segments to transfer, in order.
+ * @param num_segments Number of segments.
+ */
+void flash_transfer_start(flash_transfer_t *transfer, flash_transfer_op_t op,
+                          part_type_t part, const flash_segment_t *segments,
+                          size_t num_segments);
+
+/**
+ * Advance an asynchronous transfer without blocking.
+ *
+ * Moves all data that is currently available through the FIFOs and starts
+ * the next controller operation when the current one is done.
+ *
+ * @param transfer Transfer state.
+ * @return Whether the transfer is complete.
+ */
+bool flash_transfer_poll(flash_transfer_t *transfer);
+
+/**
+ * Block until an asynchronous transfer is complete.
+ *
+ * @param transfer Transfer state.
+ * @return Non zero on failure.
+ */
+int flash_transfer_wait(flash_transfer_t *transfer);
+
 /**
  * Configure bank erase enable
  */
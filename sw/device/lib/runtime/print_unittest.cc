@@ -15,11 +15,17 @@ extern "C" {
 #include "gtest/gtest.h"
 #include "sw/device/lib/dif/dif_uart.h"
 
-// NOTE: This is only present so that print.c can link without pulling in
+// NOTE: These are only present so that print.c can link without pulling in
 // dif_uart.c.
 extern "C" dif_result_t dif_uart_byte_send_polled(const dif_uart *, uint8_t) {
   return kDifOk;
 }
+extern "C" dif_result_t dif_uart_bytes_send(const dif_uart *, const uint8_t *,
+                                            size_t bytes_requested,
+                                            size_t *bytes_written) {
+  *bytes_written = bytes_requested;
+  return kDifOk;
+}
 
 namespace base {
 namespace {
@@ -203,6 +209,20 @@ TEST_F(PrintfTest, BinaryWithWidth) {
   EXPECT_EQ(buf_, "Hello, 00000000000000000000000010101010!\n");
 }
 
+TEST_F(PrintfTest, DecimalLimits) {
+  EXPECT_EQ(base_printf("%u %u %d %d", 0, 4294967295u, 2147483647, INT32_MIN),
+            35);
+  EXPECT_EQ(buf_, "0 4294967295 2147483647 -2147483648");
+}
+
+TEST_F(PrintfTest, DecimalAllDigits) {
+  for (uint32_t value : {9u, 10u, 99u, 100u, 1234567890u, 3999999999u}) {
+    buf_.clear();
+    base_printf("%u", value);
+    EXPECT_EQ(buf_, std::to_string(value));
+  }
+}
+
 TEST_F(PrintfTest, IncompleteSpec) {
   base_printf("Hello, %");
   EXPECT_THAT(buf_, StartsWith("Hello, "));
@@ -228,6 +248,43 @@ TEST_F(PrintfTest, ManySpecifiers) {
   EXPECT_THAT(buf_, StartsWith("2 + 8 == 10, also spelled 0xa"));
 }
 
+// Counts the calls to the sink, to check that output is buffered.
+struct CountingSink {
+  static size_t Sink(void *data, const char *buf, size_t len) {
+    auto *sink = static_cast<CountingSink *>(data);
+    sink->buf.append(buf, len);
+    ++sink->calls;
+    return len;
+  }
+
+  buffer_sink_t AsBufferSink() {
+    return {/*data=*/static_cast<void *>(this), /*sink=*/&Sink};
+  }
+
+  std::string buf;
+  int calls = 0;
+};
+
+TEST(FprintfTest, BatchesPieces) {
+  CountingSink sink;
+  buffer_sink_t out = sink.AsBufferSink();
+  EXPECT_EQ(base_fprintf(out, "%d + %d == %d", 2, 8, 10), 11);
+  EXPECT_EQ(sink.buf, "2 + 8 == 10");
+  EXPECT_EQ(sink.calls, 1);
+}
+
+TEST(FprintfTest, LongStrings) {
+  CountingSink sink;
+  buffer_sink_t out = sink.AsBufferSink();
+  std::string str(100, 'x');
+  std::string expected;
+  for (int i = 0; i < 10; ++i) {
+    base_fprintf(out, "[%s] %d ", str.c_str(), i);
+    expected += "[" + str + "] " + std::to_string(i) + " ";
+  }
+  EXPECT_EQ(sink.buf, expected);
+}
+
 TEST(SnprintfTest, SimpleWrite) {
   std::string buf(128, '\0');
   auto len = base_snprintf(&buf[0], buf.size(), "Hello, World!\n");
@@ -8,6 +8,11 @@
 /**
  * Sends the LLVM profile buffer along with its length and CRC32.
  *
+ * The profile data is streamed as it is produced, so there is no limit on its
+ * size. It is sent as lines of hex over the UART or, if the device has a log
+ * bypass address, as log lines with raw words. `util/device_profile_data.py`
+ * extracts it from the device output.
+ *
  * This function must be called at the end of a test. Note that this profile
  * data is raw and must be indexed before it can be used to generate coverage
  * reports.
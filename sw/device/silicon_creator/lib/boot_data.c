@@ -13,6 +13,7 @@
 //#include "sw/device/silicon_creator/lib/drivers/flash_ctrl.h"
 #include "sw/device/lib/flash_ctrl.h"
 #include "sw/device/silicon_creator/lib/drivers/hmac.h"
+#include "sw/device/silicon_creator/lib/drivers/retention_sram.h"
 #include "sw/device/silicon_creator/lib/error.h"
 
 #include "flash_ctrl_regs.h"  // Generated.
@@ -160,6 +161,76 @@ static rom_error_t boot_data_entry_read(uint32_t page_base, size_t index,
   return kErrorOk;
 }
 
+/**
+ * Checks whether the boot data entry at the given page and index is empty.
+ *
+ * Only the identifier is read if it shows that the entry is not empty.
+ *
+ * @param page_base Page base address in bytes.
+ * @param index Index of the entry to check in the given page.
+ * @param[out] is_empty Whether the entry is empty.
+ * @return The result of the operation.
+ */
+static rom_error_t boot_data_entry_is_empty(uint32_t page_base, size_t index,
+                                            hardened_bool_t *is_empty) {
+  *is_empty = kHardenedBoolFalse;
+  uint32_t identifier;
+  RETURN_IF_ERROR(boot_data_identifier_read(page_base, index, &identifier));
+  // Check all words of this entry only if it can be empty.
+  if (identifier == kBootDataEmptyWordValue) {
+    boot_data_buffer_t buf;
+    RETURN_IF_ERROR(boot_data_entry_read(page_base, index, &buf));
+    *is_empty = boot_data_is_empty(&buf);
+  }
+  return kErrorOk;
+}
+
+/**
+ * Writes a boot data entry to the given page and index.
+ *
+ * The entry is programmed with a single flash operation.
+ *
+ * @param page_base Page base address in bytes.
+ * @param index Index of the entry to write in the given page.
+ * @param boot_data A boot data entry.
+ * @return The result of the operation.
+ */
+static rom_error_t boot_data_entry_write(uint32_t page_base, size_t index,
+                                         const boot_data_t *boot_data) {
+  const uint32_t addr = boot_data_entry_address_get(page_base, index);
+  boot_data_buffer_t buf;
+  memcpy(&buf, boot_data, sizeof(buf));
+  // TODO(#8777): Update error handling after switching to silicon_creator
+  // driver.
+  if (flash_write(addr, kInfoPartition, buf.data, kBootDataNumWords) != 0) {
+    return kErrorBootDataFlash;
+  }
+  return kErrorOk;
+}
+
+/**
+ * Invalidates the boot data entry at the given page and index.
+ *
+ * This function sets the `identifier` field of the entry to
+ * `kBootDataInvalidatedIdentifier`.
+ *
+ * @param page_base Page base address in bytes.
+ * @param index Index of the entry to invalidate in the given page.
+ * @return The result of the operation.
+ */
+static rom_error_t boot_data_entry_invalidate(uint32_t page_base,
+                                              size_t index) {
+  const uint32_t addr = boot_data_entry_address_get(page_base, index) +
+                        offsetof(boot_data_t, identifier);
+  const uint32_t identifier = kBootDataInvalidatedIdentifier;
+  // TODO(#8777): Update error handling after switching to silicon_creator
+  // driver.
+  if (flash_write(addr, kInfoPartition, &identifier, 1) != 0) {
+    return kErrorBootDataFlash;
+  }
+  return kErrorOk;
+}
+
 /**
  * A struct that stores some information about the first empty and last valid
  * entries in a flash info page.
@@ -194,45 +265,50 @@ typedef struct boot_data_page_info {
 /**
  * Populates a page info struct for the given page.
  *
- * This function performs a forward search to find the first empty boot data
+ * This function performs a binary search to find the first empty boot data
  * entry followed by a backward search to find the last valid boot data entry.
  *
+ * Since boot data pages are append-only logs, all entries that follow the
+ * first empty entry are also empty, which makes a binary search possible.
+ * Entries with torn writes are not empty and are therefore treated as used.
+ *
  * @param page_base Page base address in bytes.
  * @param[out] page_info Page info struct for the given page.
  * @return The result of the operation.
  */
 static rom_error_t boot_data_page_info_get(uint32_t page_base,
                                            boot_data_page_info_t *page_info) {
-  uint32_t identifiers[kBootDataEntriesPerPage];
-  boot_data_buffer_t buf;
-
   page_info->base_addr = page_base;
   page_info->has_empty_entry = kHardenedBoolFalse;
   page_info->has_valid_entry = kHardenedBoolFalse;
 
-  // Perform a forward search to find the first empty entry.
-  for (size_t i = 0; i < kBootDataEntriesPerPage; ++i) {
-    // Read and cache the identifier to quickly determine if an entry can be
-    // empty or valid.
-    RETURN_IF_ERROR(boot_data_identifier_read(page_base, i, &identifiers[i]));
-    // Check all words of this entry only if it can be empty.
-    if (identifiers[i] == kBootDataEmptyWordValue) {
-      RETURN_IF_ERROR(boot_data_entry_read(page_base, i, &buf));
-      if (boot_data_is_empty(&buf) == kHardenedBoolTrue) {
-        page_info->first_empty_index = i;
-        page_info->has_empty_entry = kHardenedBoolTrue;
-        break;
-      }
+  // Perform a binary search to find the first empty entry. Entries before
+  // `begin` are known to be used and entries starting at `end` are known to be
+  // empty.
+  size_t begin = 0;
+  size_t end = kBootDataEntriesPerPage;
+  while (begin < end) {
+    const size_t mid = begin + (end - begin) / 2;
+    hardened_bool_t is_empty;
+    RETURN_IF_ERROR(boot_data_entry_is_empty(page_base, mid, &is_empty));
+    if (is_empty == kHardenedBoolTrue) {
+      end = mid;
+    } else {
+      begin = mid + 1;
     }
   }
+  if (end < kBootDataEntriesPerPage) {
+    page_info->first_empty_index = end;
+    page_info->has_empty_entry = kHardenedBoolTrue;
+  }
 
   // Perform a backward search to find the last valid entry.
-  size_t start_index = (page_info->has_empty_entry == kHardenedBoolTrue)
-                           ? page_info->first_empty_index - 1
-                           : kBootDataEntriesPerPage - 1;
-  for (size_t i = start_index; i < kBootDataEntriesPerPage; --i) {
+  for (size_t i = end - 1; i < kBootDataEntriesPerPage; --i) {
+    uint32_t identifier;
+    RETURN_IF_ERROR(boot_data_identifier_read(page_base, i, &identifier));
     // Check the digest only if this entry can be valid.
-    if (identifiers[i] == kBootDataIdentifier) {
+    if (identifier == kBootDataIdentifier) {
+      boot_data_buffer_t buf;
       hardened_bool_t is_valid;
       RETURN_IF_ERROR(boot_data_entry_read(page_base, i, &buf));
       RETURN_IF_ERROR(boot_data_digest_is_valid(&buf, &is_valid));
@@ -286,6 +362,158 @@ static rom_error_t boot_data_active_page_find(
   return kErrorBootDataNotFound;
 }
 
+/**
+ * Boot data cache stored in the retention SRAM.
+ *
+ * This struct caches the location of the newest boot data entry so that
+ * `boot_data_read()` and `boot_data_write()` do not have to search both info
+ * pages on every call. Since the retention SRAM persists across resets and is
+ * not protected, the cache is only a hint: the cached entry is read from the
+ * flash and must be valid, must have the cached counter value, and must be
+ * followed by an empty entry in the same page before it is used.
+ */
+typedef struct boot_data_cache {
+  /**
+   * Must be `kBootDataCacheIdentifier` for the cache to be used.
+   */
+  uint32_t identifier;
+  /**
+   * Base address of the active page.
+   */
+  uint32_t page_base;
+  /**
+   * Index of the newest entry in the active page.
+   */
+  uint32_t index;
+  /**
+   * Counter value of the newest entry.
+   */
+  uint32_t counter;
+} boot_data_cache_t;
+static_assert(sizeof(boot_data_cache_t) ==
+                  sizeof((retention_sram_t){0}.boot_data_cache),
+              "`boot_data_cache_t` must fit in the retention SRAM.");
+
+enum {
+  /**
+   * Boot data cache identifier value (ASCII "BDCA").
+   */
+  kBootDataCacheIdentifier = 0x41434442,
+};
+
+/**
+ * Returns a pointer to the boot data cache in the retention SRAM.
+ *
+ * @return A pointer to the boot data cache.
+ */
+static volatile boot_data_cache_t *boot_data_cache_get(void) {
+  return (volatile boot_data_cache_t *)retention_sram_get()->boot_data_cache;
+}
+
+/**
+ * Invalidates the boot data cache.
+ */
+static void boot_data_cache_invalidate(void) {
+  boot_data_cache_get()->identifier = kBootDataInvalidatedIdentifier;
+}
+
+/**
+ * Updates the boot data cache.
+ *
+ * @param page_base Base address of the active page.
+ * @param index Index of the newest entry in the active page.
+ * @param counter Counter value of the newest entry.
+ */
+static void boot_data_cache_update(uint32_t page_base, size_t index,
+                                   uint32_t counter) {
+  volatile boot_data_cache_t *cache = boot_data_cache_get();
+  cache->identifier = kBootDataInvalidatedIdentifier;
+  cache->page_base = page_base;
+  cache->index = index;
+  cache->counter = counter;
+  cache->identifier = kBootDataCacheIdentifier;
+}
+
+/**
+ * Populates the page info struct of the active page using the boot data cache.
+ *
+ * The cache is used only if the cached entry is the last used entry of a page
+ * that is not full. Otherwise, the newest entry may be in the other page and
+ * both pages must be searched.
+ *
+ * @param[out] page_info Page info struct of the active info page.
+ * @param[out] is_hit Whether `page_info` was populated using the cache.
+ * @return The result of the operation.
+ */
+static rom_error_t boot_data_cache_page_info_get(
+    boot_data_page_info_t *page_info, hardened_bool_t *is_hit) {
+  *is_hit = kHardenedBoolFalse;
+  volatile boot_data_cache_t *cache = boot_data_cache_get();
+  if (cache->identifier != kBootDataCacheIdentifier) {
+    return kErrorOk;
+  }
+  const uint32_t page_base = cache->page_base;
+  const uint32_t index = cache->index;
+  const uint32_t counter = cache->counter;
+  if ((page_base != kBootDataPage0Base && page_base != kBootDataPage1Base) ||
+      index >= kBootDataEntriesPerPage - 1) {
+    return kErrorOk;
+  }
+
+  hardened_bool_t is_empty;
+  RETURN_IF_ERROR(boot_data_entry_is_empty(page_base, index + 1, &is_empty));
+  if (is_empty != kHardenedBoolTrue) {
+    return kErrorOk;
+  }
+
+  boot_data_buffer_t buf;
+  hardened_bool_t is_valid;
+  RETURN_IF_ERROR(boot_data_entry_read(page_base, index, &buf));
+  memcpy(&page_info->last_valid_entry, &buf, sizeof(buf));
+  if (page_info->last_valid_entry.identifier != kBootDataIdentifier ||
+      page_info->last_valid_entry.counter != counter) {
+    return kErrorOk;
+  }
+  RETURN_IF_ERROR(boot_data_digest_is_valid(&buf, &is_valid));
+  if (is_valid != kHardenedBoolTrue) {
+    return kErrorOk;
+  }
+
+  page_info->base_addr = page_base;
+  page_info->has_empty_entry = kHardenedBoolTrue;
+  page_info->first_empty_index = index + 1;
+  page_info->has_valid_entry = kHardenedBoolTrue;
+  page_info->last_valid_index = index;
+  *is_hit = kHardenedBoolTrue;
+  return kErrorOk;
+}
+
+/**
+ * Returns the page info struct of the active info page.
+ *
+ * This function first tries the boot data cache and falls back to searching
+ * both info pages, updating the cache with the result.
+ *
+ * @param[out] page_info Page info struct of the active info page.
+ * @return The result of the operation.
+ */
+static rom_error_t boot_data_active_page_get(boot_data_page_info_t *page_info) {
+  hardened_bool_t is_hit;
+  RETURN_IF_ERROR(boot_data_cache_page_info_get(page_info, &is_hit));
+  if (is_hit == kHardenedBoolTrue) {
+    return kErrorOk;
+  }
+
+  rom_error_t error = boot_data_active_page_find(page_info);
+  if (error == kErrorOk) {
+    boot_data_cache_update(page_info->base_addr, page_info->last_valid_index,
+                           page_info->last_valid_entry.counter);
+  } else {
+    boot_data_cache_invalidate();
+  }
+  return error;
+}
+
 /**
  * Default boot data to use if the device is in a non-prod state and there is
  * no valid boot data entry in the flash info pages.
@@ -333,7 +561,7 @@ static rom_error_t boot_data_default_get(lifecycle_state_t lc_state,
 
 rom_error_t boot_data_read(lifecycle_state_t lc_state, boot_data_t *boot_data) {
   boot_data_page_info_t active_page;
-  rom_error_t error = boot_data_active_page_find(&active_page);
+  rom_error_t error = boot_data_active_page_get(&active_page);
   switch (error) {
     case kErrorOk:
       *boot_data = active_page.last_valid_entry;
@@ -346,3 +574,55 @@ rom_error_t boot_data_read(lifecycle_state_t lc_state, boot_data_t *boot_data) {
       return error;
   }
 }
+
+rom_error_t boot_data_write(const boot_data_t *boot_data) {
+  boot_data_page_info_t active_page;
+  rom_error_t error = boot_data_active_page_get(&active_page);
+  if (error != kErrorOk && error != kErrorBootDataNotFound) {
+    return error;
+  }
+
+  boot_data_t new_entry = *boot_data;
+  new_entry.identifier = kBootDataIdentifier;
+  uint32_t page_base = kBootDataPage0Base;
+  size_t index = 0;
+  if (error == kErrorOk) {
+    new_entry.counter = active_page.last_valid_entry.counter + 1;
+    if (active_page.has_empty_entry == kHardenedBoolTrue) {
+      page_base = active_page.base_addr;
+      index = active_page.first_empty_index;
+    } else if (active_page.base_addr == kBootDataPage0Base) {
+      page_base = kBootDataPage1Base;
+    }
+  } else {
+    new_entry.counter = kBootDataDefault.counter + 1;
+  }
+  RETURN_IF_ERROR(boot_data_digest_compute(&new_entry, &new_entry.digest));
+
+  // Invalidate the cache until the new entry is written so that an interrupted
+  // write is never hidden by a stale cache.
+  boot_data_cache_invalidate();
+  // TODO(#8777): Update error handling after switching to silicon_creator
+  // driver.
+  if (error == kErrorBootDataNotFound) {
+    // Erase the second page as well since it may hold an entry whose counter
+    // is not less than the counter of the new entry.
+    if (flash_page_erase(kBootDataPage1Base, kInfoPartition) != 0) {
+      return kErrorBootDataFlash;
+    }
+  }
+  if (index == 0) {
+    if (flash_page_erase(page_base, kInfoPartition) != 0) {
+      return kErrorBootDataFlash;
+    }
+  }
+  RETURN_IF_ERROR(boot_data_entry_write(page_base, index, &new_entry));
+  // Invalidate the previous entry only after the new entry is written so that
+  // there is always at least one valid entry in the flash.
+  if (error == kErrorOk) {
+    RETURN_IF_ERROR(boot_data_entry_invalidate(active_page.base_addr,
+                                               active_page.last_valid_index));
+  }
+  boot_data_cache_update(page_base, index, new_entry.counter);
+  return kErrorOk;
+}
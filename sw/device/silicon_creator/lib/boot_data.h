@@ -119,6 +119,27 @@ static_assert(kBootDataIdentifier != kBootDataInvalidatedIdentifier,
  */
 rom_error_t boot_data_read(lifecycle_state_t lc_state, boot_data_t *boot_data);
 
+/**
+ * Writes the given boot data to the flash info partition.
+ *
+ * The new entry is written to the first empty entry of the active page, or to
+ * the first entry of the other page after erasing it if the active page is
+ * full. The previous entry is invalidated after the new entry is written.
+ *
+ * The `digest`, `identifier`, and `counter` fields of `boot_data` are ignored:
+ * `counter` is set to one more than the counter of the newest entry (or of the
+ * default boot data if there is no valid entry) and `digest` is computed
+ * before writing. If there is no valid entry, both pages are erased.
+ *
+ * The flash controller must be initialized with proper permissions for the
+ * first and second info pages of the second flash bank before calling this
+ * function.
+ *
+ * @param boot_data New boot data.
+ * @return The result of the operation.
+ */
+rom_error_t boot_data_write(const boot_data_t *boot_data);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif  // __cplusplus
@@ -232,6 +232,40 @@ rom_error_t read_full_page_1_test(void) {
   return kErrorOk;
 }
 
+rom_error_t write_rollover_test(void) {
+  erase_boot_data_pages();
+
+  boot_data_t boot_data = kTestBootData;
+  for (size_t i = 0; i <= kBootDataEntriesPerPage; ++i) {
+    boot_data.min_security_version_rom_ext = i;
+    uint64_t start = ibex_mcycle_read();
+    RETURN_IF_ERROR(boot_data_write(&boot_data));
+    uint64_t end = ibex_mcycle_read();
+    if (i == 1 || i == kBootDataEntriesPerPage) {
+      uint32_t cycles = end - start;
+      LOG_INFO("boot_data_write() took %u cycles", cycles);
+    }
+  }
+
+  boot_data_t read_boot_data;
+  uint64_t start = ibex_mcycle_read();
+  RETURN_IF_ERROR(boot_data_read(kLcStateProd, &read_boot_data));
+  uint64_t end = ibex_mcycle_read();
+  RETURN_IF_ERROR(check_boot_data(&read_boot_data));
+  if (read_boot_data.min_security_version_rom_ext != kBootDataEntriesPerPage) {
+    return kErrorUnknown;
+  }
+  uint32_t cycles = end - start;
+  LOG_INFO("boot_data_read() (cached) took %u cycles", cycles);
+
+  boot_data_t page_1_entry;
+  CHECK(flash_read(kBootDataPage1Base, kInfoPartition, kBootDataNumWords,
+                   (uint32_t *)&page_1_entry) == 0,
+        "Flash read failed.");
+  RETURN_IF_ERROR(compare_boot_data(&page_1_entry, &read_boot_data));
+  return kErrorOk;
+}
+
 bool test_main(void) {
   rom_error_t result = kErrorOk;
 
@@ -245,6 +279,7 @@ bool test_main(void) {
   EXECUTE_TEST(result, read_single_page_1_test);
   EXECUTE_TEST(result, read_full_page_0_test);
   EXECUTE_TEST(result, read_full_page_1_test);
+  EXECUTE_TEST(result, write_rollover_test);
 
   return result == kErrorOk;
 }
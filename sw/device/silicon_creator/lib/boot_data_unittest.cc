@@ -0,0 +1,367 @@
+// Copyright lowRISC contributors.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+#include "sw/device/silicon_creator/lib/boot_data.h"
+
+#include <array>
+#include <cstring>
+
+#include "gtest/gtest.h"
+#include "sw/device/lib/flash_ctrl.h"
+#include "sw/device/silicon_creator/lib/drivers/retention_sram.h"
+#include "sw/device/silicon_creator/testing/mask_rom_test.h"
+
+namespace boot_data_unittest {
+namespace {
+
+/**
+ * Number of words in a boot data page.
+ */
+constexpr size_t kPageNumWords = kBootDataEntriesPerPage * kBootDataNumWords;
+
+/**
+ * In-memory model of the two boot data info pages.
+ *
+ * Programming can only clear bits, as in real flash, and a write can be
+ * interrupted after a given number of words to model a torn write.
+ */
+struct FlashInfoPages {
+  std::array<uint32_t, 2 * kPageNumWords> words;
+  /**
+   * Number of words programmed by the next write before it fails, or -1.
+   */
+  int torn_write_words = -1;
+  /**
+   * Index of the write call (counted from the next call) that will be torn.
+   */
+  size_t torn_write_call = 0;
+  size_t num_reads = 0;
+
+  size_t WordIndex(uint32_t addr) {
+    EXPECT_GE(addr, kBootDataPage0Base);
+    EXPECT_EQ(addr % sizeof(uint32_t), 0u);
+    size_t index = (addr - kBootDataPage0Base) / sizeof(uint32_t);
+    EXPECT_LT(index, words.size());
+    return index;
+  }
+
+  /**
+   * Returns the entry at the given page and index.
+   */
+  boot_data_t Entry(uint32_t page_base, size_t index) {
+    boot_data_t entry;
+    std::memcpy(&entry,
+                &words[WordIndex(page_base) + index * kBootDataNumWords],
+                sizeof(entry));
+    return entry;
+  }
+};
+
+FlashInfoPages *flash = nullptr;
+retention_sram_t *ret_sram = nullptr;
+
+/**
+ * Digest state of the fake HMAC.
+ *
+ * The actual digest algorithm is irrelevant for these tests, it only has to
+ * change when the data changes.
+ */
+std::array<uint32_t, 8> hmac_state;
+
+extern "C" {
+
+int flash_read(uint32_t addr, part_type_t part, uint32_t size,
+               uint32_t *data) {
+  EXPECT_EQ(part, kInfoPartition);
+  ++flash->num_reads;
+  std::memcpy(data, &flash->words[flash->WordIndex(addr)],
+              size * sizeof(uint32_t));
+  return 0;
+}
+
+int flash_write(uint32_t addr, part_type_t part, const uint32_t *data,
+                uint32_t size) {
+  EXPECT_EQ(part, kInfoPartition);
+  int ret = 0;
+  if (flash->torn_write_words >= 0 && flash->torn_write_call-- == 0) {
+    size = flash->torn_write_words;
+    flash->torn_write_words = -1;
+    ret = -1;
+  }
+  size_t index = flash->WordIndex(addr);
+  for (size_t i = 0; i < size; ++i) {
+    flash->words[index + i] &= data[i];
+  }
+  return ret;
+}
+
+int flash_page_erase(uint32_t addr, part_type_t part) {
+  EXPECT_EQ(part, kInfoPartition);
+  EXPECT_EQ((addr - kBootDataPage0Base) % (kPageNumWords * sizeof(uint32_t)),
+            0u);
+  size_t index = flash->WordIndex(addr);
+  std::fill_n(&flash->words[index], kPageNumWords, kBootDataEmptyWordValue);
+  return 0;
+}
+
+volatile retention_sram_t *retention_sram_get(void) { return ret_sram; }
+
+void hmac_sha256_init(void) { hmac_state.fill(0x811c9dc5); }
+
+rom_error_t hmac_sha256_update(const void *data, size_t len) {
+  const uint8_t *bytes = static_cast<const uint8_t *>(data);
+  for (size_t i = 0; i < len; ++i) {
+    for (size_t j = 0; j < hmac_state.size(); ++j) {
+      hmac_state[j] = (hmac_state[j] ^ (bytes[i] + j)) * 0x01000193;
+    }
+  }
+  return kErrorOk;
+}
+
+rom_error_t hmac_sha256_final(hmac_digest_t *digest) {
+  std::copy(hmac_state.begin(), hmac_state.end(), digest->digest);
+  return kErrorOk;
+}
+
+}  // extern "C"
+
+class BootDataTest : public mask_rom_test::MaskRomTest {
+ protected:
+  void SetUp() override {
+    flash_.words.fill(kBootDataEmptyWordValue);
+    flash = &flash_;
+    ret_sram_ = {};
+    ret_sram = &ret_sram_;
+  }
+
+  void TearDown() override {
+    flash = nullptr;
+    ret_sram = nullptr;
+  }
+
+  /**
+   * Returns a boot data entry with the given minimum ROM_EXT security version.
+   */
+  static boot_data_t TestBootData(uint32_t min_security_version_rom_ext) {
+    boot_data_t boot_data{};
+    boot_data.min_security_version_rom_ext = min_security_version_rom_ext;
+    return boot_data;
+  }
+
+  /**
+   * Reads the boot data in a prod life cycle state and checks its contents.
+   */
+  void ExpectBootData(uint32_t counter, uint32_t min_security_version_rom_ext) {
+    boot_data_t boot_data;
+    ASSERT_EQ(boot_data_read(kLcStateProd, &boot_data), kErrorOk);
+    EXPECT_EQ(boot_data.identifier, kBootDataIdentifier);
+    EXPECT_EQ(boot_data.counter, counter);
+    EXPECT_EQ(boot_data.min_security_version_rom_ext,
+              min_security_version_rom_ext);
+  }
+
+  void ClearCache() {
+    std::memset(ret_sram_.boot_data_cache, 0,
+                sizeof(ret_sram_.boot_data_cache));
+  }
+
+  FlashInfoPages flash_;
+  retention_sram_t ret_sram_;
+};
+
+/**
+ * Counter value of the first entry written to empty pages.
+ */
+constexpr uint32_t kFirstCounter = 6;
+
+TEST_F(BootDataTest, ReadEmpty) {
+  boot_data_t boot_data;
+  EXPECT_EQ(boot_data_read(kLcStateProd, &boot_data), kErrorBootDataNotFound);
+  EXPECT_EQ(boot_data_read(kLcStateDev, &boot_data), kErrorOk);
+  EXPECT_EQ(boot_data.counter, kFirstCounter - 1);
+}
+
+TEST_F(BootDataTest, WriteEmpty) {
+  boot_data_t boot_data = TestBootData(1);
+  EXPECT_EQ(boot_data_write(&boot_data), kErrorOk);
+
+  boot_data_t entry = flash_.Entry(kBootDataPage0Base, 0);
+  EXPECT_EQ(entry.identifier, kBootDataIdentifier);
+  EXPECT_EQ(entry.counter, kFirstCounter);
+  ExpectBootData(kFirstCounter, 1);
+
+  ClearCache();
+  ExpectBootData(kFirstCounter, 1);
+}
+
+TEST_F(BootDataTest, WriteAppendsAndInvalidates) {
+  for (uint32_t i = 0; i < 3; ++i) {
+    boot_data_t boot_data = TestBootData(i);
+    EXPECT_EQ(boot_data_write(&boot_data), kErrorOk);
+  }
+
+  EXPECT_EQ(flash_.Entry(kBootDataPage0Base, 0).identifier,
+            kBootDataInvalidatedIdentifier);
+  EXPECT_EQ(flash_.Entry(kBootDataPage0Base, 1).identifier,
+            kBootDataInvalidatedIdentifier);
+  EXPECT_EQ(flash_.Entry(kBootDataPage0Base, 2).identifier,
+            kBootDataIdentifier);
+  ExpectBootData(kFirstCounter + 2, 2);
+
+  ClearCache();
+  ExpectBootData(kFirstCounter + 2, 2);
+}
+
+TEST_F(BootDataTest, PageRollover) {
+  for (uint32_t i = 0; i < kBootDataEntriesPerPage; ++i) {
+    boot_data_t boot_data = TestBootData(i);
+    EXPECT_EQ(boot_data_write(&boot_data), kErrorOk);
+  }
+  // Page 0 is full.
+  EXPECT_EQ(flash_.Entry(kBootDataPage0Base, kBootDataEntriesPerPage - 1)
+                .identifier,
+            kBootDataIdentifier);
+  ExpectBootData(kFirstCounter + kBootDataEntriesPerPage - 1,
+                 kBootDataEntriesPerPage - 1);
+
+  // Next write goes to the first entry of page 1.
+  boot_data_t boot_data = TestBootData(100);
+  EXPECT_EQ(boot_data_write(&boot_data), kErrorOk);
+  EXPECT_EQ(flash_.Entry(kBootDataPage0Base, kBootDataEntriesPerPage - 1)
+                .identifier,
+            kBootDataInvalidatedIdentifier);
+  EXPECT_EQ(flash_.Entry(kBootDataPage1Base, 0).identifier,
+            kBootDataIdentifier);
+  ExpectBootData(kFirstCounter + kBootDataEntriesPerPage, 100);
+  ClearCache();
+  ExpectBootData(kFirstCounter + kBootDataEntriesPerPage, 100);
+
+  // Fill page 1 and roll over to page 0, which must be erased first.
+  for (uint32_t i = 1; i <= kBootDataEntriesPerPage; ++i) {
+    boot_data = TestBootData(100 + i);
+    EXPECT_EQ(boot_data_write(&boot_data), kErrorOk);
+  }
+  EXPECT_EQ(flash_.Entry(kBootDataPage0Base, 0).identifier,
+            kBootDataIdentifier);
+  EXPECT_EQ(flash_.Entry(kBootDataPage0Base, 1).identifier,
+            kBootDataEmptyWordValue);
+  ExpectBootData(kFirstCounter + 2 * kBootDataEntriesPerPage,
+                 100 + kBootDataEntriesPerPage);
+  ClearCache();
+  ExpectBootData(kFirstCounter + 2 * kBootDataEntriesPerPage,
+                 100 + kBootDataEntriesPerPage);
+}
+
+TEST_F(BootDataTest, TornEntryWrite) {
+  boot_data_t boot_data = TestBootData(1);
+  EXPECT_EQ(boot_data_write(&boot_data), kErrorOk);
+
+  // Interrupt the write of the second entry half way through.
+  flash_.torn_write_words = kBootDataNumWords / 2;
+  flash_.torn_write_call = 0;
+  boot_data = TestBootData(2);
+  EXPECT_EQ(boot_data_write(&boot_data), kErrorBootDataFlash);
+  ExpectBootData(kFirstCounter, 1);
+  ClearCache();
+  ExpectBootData(kFirstCounter, 1);
+
+  // The next write skips the torn entry.
+  boot_data = TestBootData(3);
+  EXPECT_EQ(boot_data_write(&boot_data), kErrorOk);
+  EXPECT_EQ(flash_.Entry(kBootDataPage0Base, 2).identifier,
+            kBootDataIdentifier);
+  ExpectBootData(kFirstCounter + 1, 3);
+}
+
+TEST_F(BootDataTest, TornInvalidate) {
+  boot_data_t boot_data = TestBootData(1);
+  EXPECT_EQ(boot_data_write(&boot_data), kErrorOk);
+
+  // Interrupt the invalidation of the previous entry.
+  flash_.torn_write_words = 0;
+  flash_.torn_write_call = 1;
+  boot_data = TestBootData(2);
+  EXPECT_EQ(boot_data_write(&boot_data), kErrorBootDataFlash);
+  EXPECT_EQ(flash_.Entry(kBootDataPage0Base, 0).identifier,
+            kBootDataIdentifier);
+  ExpectBootData(kFirstCounter + 1, 2);
+  ClearCache();
+  ExpectBootData(kFirstCounter + 1, 2);
+}
+
+TEST_F(BootDataTest, TornWriteAfterRollover) {
+  for (uint32_t i = 0; i < kBootDataEntriesPerPage; ++i) {
+    boot_data_t boot_data = TestBootData(i);
+    EXPECT_EQ(boot_data_write(&boot_data), kErrorOk);
+  }
+
+  flash_.torn_write_words = 1;
+  flash_.torn_write_call = 0;
+  boot_data_t boot_data = TestBootData(100);
+  EXPECT_EQ(boot_data_write(&boot_data), kErrorBootDataFlash);
+  ExpectBootData(kFirstCounter + kBootDataEntriesPerPage - 1,
+                 kBootDataEntriesPerPage - 1);
+
+  boot_data = TestBootData(101);
+  EXPECT_EQ(boot_data_write(&boot_data), kErrorOk);
+  ExpectBootData(kFirstCounter + kBootDataEntriesPerPage, 101);
+}
+
+TEST_F(BootDataTest, CacheHit) {
+  for (uint32_t i = 0; i < 10; ++i) {
+    boot_data_t boot_data = TestBootData(i);
+    EXPECT_EQ(boot_data_write(&boot_data), kErrorOk);
+  }
+
+  flash_.num_reads = 0;
+  ExpectBootData(kFirstCounter + 9, 9);
+  // Identifier and entry of the next empty slot, and the cached entry.
+  EXPECT_EQ(flash_.num_reads, 3u);
+
+  ClearCache();
+  flash_.num_reads = 0;
+  ExpectBootData(kFirstCounter + 9, 9);
+  EXPECT_GT(flash_.num_reads, 3u);
+  // The cache is filled by the search.
+  flash_.num_reads = 0;
+  ExpectBootData(kFirstCounter + 9, 9);
+  EXPECT_EQ(flash_.num_reads, 3u);
+}
+
+TEST_F(BootDataTest, StaleCacheIgnored) {
+  for (uint32_t i = 0; i < 3; ++i) {
+    boot_data_t boot_data = TestBootData(i);
+    EXPECT_EQ(boot_data_write(&boot_data), kErrorOk);
+  }
+  const std::array<uint32_t, 4> cache{
+      ret_sram_.boot_data_cache[0],
+      ret_sram_.boot_data_cache[1],
+      ret_sram_.boot_data_cache[2],
+      ret_sram_.boot_data_cache[3],
+  };
+
+  // Cache points to an older, invalidated entry.
+  ret_sram_.boot_data_cache[2] = 0;
+  ret_sram_.boot_data_cache[3] = kFirstCounter;
+  ExpectBootData(kFirstCounter + 2, 2);
+
+  // Cache has the wrong counter.
+  std::copy(cache.begin(), cache.end(), ret_sram_.boot_data_cache);
+  ret_sram_.boot_data_cache[3] += 1;
+  ExpectBootData(kFirstCounter + 2, 2);
+
+  // Cache points to the other page.
+  std::copy(cache.begin(), cache.end(), ret_sram_.boot_data_cache);
+  ret_sram_.boot_data_cache[1] = kBootDataPage1Base;
+  ExpectBootData(kFirstCounter + 2, 2);
+
+  // Entries were appended without updating the cache.
+  std::copy(cache.begin(), cache.end(), ret_sram_.boot_data_cache);
+  ret_sram_.boot_data_cache[2] = 1;
+  ret_sram_.boot_data_cache[3] = kFirstCounter + 1;
+  ExpectBootData(kFirstCounter + 2, 2);
+}
+
+}  // namespace
+}  // namespace boot_data_unittest
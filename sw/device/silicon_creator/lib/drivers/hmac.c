@@ -35,30 +35,80 @@ void hmac_sha256_init(void) {
   abs_mmio_write32(TOP_EARLGREY_HMAC_BASE_ADDR + HMAC_CMD_REG_OFFSET, reg);
 }
 
-rom_error_t hmac_sha256_update(const void *data, size_t len) {
-  if (data == NULL) {
-    return kErrorHmacInvalidArgument;
+/**
+ * Returns the number of free entries in the message FIFO.
+ *
+ * @return Number of free entries in 32-bit words.
+ */
+static size_t fifo_free_words_get(void) {
+  uint32_t reg =
+      abs_mmio_read32(TOP_EARLGREY_HMAC_BASE_ADDR + HMAC_STATUS_REG_OFFSET);
+  uint32_t depth = bitfield_field32_read(reg, HMAC_STATUS_FIFO_DEPTH_FIELD);
+  if (depth >= kHmacMsgFifoDepthWords) {
+    return 0;
   }
-  const uint8_t *data_sent = (const uint8_t *)data;
+  return kHmacMsgFifoDepthWords - depth;
+}
 
+/**
+ * Writes a buffer to the message FIFO.
+ *
+ * @param data Buffer to copy data from.
+ * @param len Size of the `data` buffer.
+ */
+static void fifo_write(const uint8_t *data, size_t len) {
   // Individual byte writes are needed if the buffer isn't word aligned.
-  for (; len != 0 && (uintptr_t)data_sent & 3; --len) {
+  for (; len != 0 && (uintptr_t)data & 3; --len) {
     abs_mmio_write8(TOP_EARLGREY_HMAC_BASE_ADDR + HMAC_MSG_FIFO_REG_OFFSET,
-                    *data_sent++);
+                    *data++);
   }
 
-  for (; len >= sizeof(uint32_t); len -= sizeof(uint32_t)) {
-    // FIXME: read_32 does not work for unittests.
-    uint32_t data_aligned = *(const uint32_t *)data_sent;
-    abs_mmio_write32(TOP_EARLGREY_HMAC_BASE_ADDR + HMAC_MSG_FIFO_REG_OFFSET,
-                     data_aligned);
-    data_sent += sizeof(uint32_t);
+  // Write words in bursts that fit in the free space of the FIFO.
+  size_t num_words = len / sizeof(uint32_t);
+  len -= num_words * sizeof(uint32_t);
+  while (num_words != 0) {
+    size_t burst_len = fifo_free_words_get();
+    if (burst_len > num_words) {
+      burst_len = num_words;
+    }
+    num_words -= burst_len;
+    for (; burst_len != 0; --burst_len) {
+      // FIXME: read_32 does not work for unittests.
+      uint32_t data_aligned = *(const uint32_t *)data;
+      abs_mmio_write32(TOP_EARLGREY_HMAC_BASE_ADDR + HMAC_MSG_FIFO_REG_OFFSET,
+                       data_aligned);
+      data += sizeof(uint32_t);
+    }
   }
 
   // Handle non-32bit aligned bytes at the end of the buffer.
   for (; len != 0; --len) {
     abs_mmio_write8(TOP_EARLGREY_HMAC_BASE_ADDR + HMAC_MSG_FIFO_REG_OFFSET,
-                    *data_sent++);
+                    *data++);
+  }
+}
+
+rom_error_t hmac_sha256_update(const void *data, size_t len) {
+  if (data == NULL) {
+    return kErrorHmacInvalidArgument;
+  }
+  fifo_write((const uint8_t *)data, len);
+  return kErrorOk;
+}
+
+rom_error_t hmac_sha256_update_segments(const hmac_segment_t *segments,
+                                        size_t num_segments) {
+  if (segments == NULL) {
+    return kErrorHmacInvalidArgument;
+  }
+  // Check all segments before writing anything to the FIFO.
+  for (size_t i = 0; i < num_segments; ++i) {
+    if (segments[i].data == NULL) {
+      return kErrorHmacInvalidArgument;
+    }
+  }
+  for (size_t i = 0; i < num_segments; ++i) {
+    fifo_write((const uint8_t *)segments[i].data, segments[i].len);
   }
   return kErrorOk;
 }
@@ -15,6 +15,13 @@ extern "C" {
 
 #define HMAC_WARN_UNUSED_RESULT __attribute__((warn_unused_result))
 
+enum {
+  /**
+   * Depth of the HMAC message FIFO in 32-bit words.
+   */
+  kHmacMsgFifoDepthWords = 16,
+};
+
 /**
  * A typed representation of the HMAC digest.
  */
@@ -31,12 +38,26 @@ typedef struct hmac_digest {
  */
 void hmac_sha256_init(void);
 
+/**
+ * A contiguous segment of a message.
+ */
+typedef struct hmac_segment {
+  /**
+   * Start of the segment.
+   */
+  const void *data;
+  /**
+   * Length of the segment in bytes.
+   */
+  size_t len;
+} hmac_segment_t;
+
 /**
  * Sends `len` bytes from `data` to the SHA2-256 function.
  *
- * This function does not check for the size of the available HMAC
- * FIFO. Since the this function is meant to run in blocking mode,
- * polling for FIFO status is equivalent to stalling on FIFO write.
+ * Words are written to the message FIFO in bursts sized to the free space
+ * reported by `STATUS.FIFO_DEPTH` so that the bus is never stalled on a full
+ * FIFO and the engine is kept busy at its line rate.
  *
  * @param data Buffer to copy data from.
  * @param len size of the `data` buffer.
@@ -45,6 +66,21 @@ void hmac_sha256_init(void);
 HMAC_WARN_UNUSED_RESULT
 rom_error_t hmac_sha256_update(const void *data, size_t len);
 
+/**
+ * Sends multiple segments of a message to the SHA2-256 function.
+ *
+ * This is equivalent to calling `hmac_sha256_update()` for each segment in
+ * order. Segments do not need to be word aligned or have lengths that are
+ * multiples of the word size.
+ *
+ * @param segments Segments of the message.
+ * @param num_segments Number of segments.
+ * @return The result of the operation.
+ */
+HMAC_WARN_UNUSED_RESULT
+rom_error_t hmac_sha256_update_segments(const hmac_segment_t *segments,
+                                        size_t num_segments);
+
 /**
  * Finalizes SHA256 operation and writes `digest` buffer.
  *
@@ -8,6 +8,7 @@
 #include "sw/device/lib/arch/device.h"
 #include "sw/device/lib/base/memory.h"
 #include "sw/device/lib/base/mmio.h"
+#include "sw/device/lib/runtime/ibex.h"
 #include "sw/device/lib/runtime/log.h"
 #include "sw/device/lib/runtime/print.h"
 #include "sw/device/silicon_creator/lib/drivers/hmac.h"
@@ -53,10 +54,51 @@ rom_error_t hmac_test(void) {
   return kErrorOk;
 }
 
+rom_error_t hmac_segments_test(void) {
+  // Split the message at unaligned boundaries.
+  const hmac_segment_t kSegments[] = {
+      {.data = &kGettysburgPrelude[0], .len = 3},
+      {.data = &kGettysburgPrelude[3], .len = 0},
+      {.data = &kGettysburgPrelude[3], .len = 70},
+      {.data = &kGettysburgPrelude[73], .len = sizeof(kGettysburgPrelude) - 74},
+  };
+
+  hmac_sha256_init();
+  RETURN_IF_ERROR(
+      hmac_sha256_update_segments(kSegments, ARRAYSIZE(kSegments)));
+
+  hmac_digest_t digest;
+  RETURN_IF_ERROR(hmac_sha256_final(&digest));
+  if (memcmp(digest.digest, kGettysburgDigest, sizeof(digest.digest)) != 0) {
+    return kErrorUnknown;
+  }
+  return kErrorOk;
+}
+
+rom_error_t hmac_throughput_test(void) {
+  // Hash the ROM to measure the throughput of the driver on a large region.
+  const void *data = (const void *)TOP_EARLGREY_ROM_CTRL_ROM_BASE_ADDR;
+  const size_t len = TOP_EARLGREY_ROM_CTRL_ROM_SIZE_BYTES;
+
+  uint64_t start = ibex_mcycle_read();
+  hmac_sha256_init();
+  RETURN_IF_ERROR(hmac_sha256_update(data, len));
+  hmac_digest_t digest;
+  RETURN_IF_ERROR(hmac_sha256_final(&digest));
+  uint64_t end = ibex_mcycle_read();
+
+  uint32_t cycles = end - start;
+  LOG_INFO("Hashed %u bytes in %u cycles (%u.%02u cycles/byte)", len, cycles,
+           cycles / len, (cycles % len) * 100 / len);
+  return kErrorOk;
+}
+
 const test_config_t kTestConfig;
 
 bool test_main(void) {
   rom_error_t result = kErrorOk;
   EXECUTE_TEST(result, hmac_test);
+  EXECUTE_TEST(result, hmac_segments_test);
+  EXECUTE_TEST(result, hmac_throughput_test);
   return result == kErrorOk;
 }
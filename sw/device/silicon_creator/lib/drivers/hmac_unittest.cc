@@ -21,6 +21,14 @@ using ::testing::ElementsAreArray;
 
 class HmacTest : public mask_rom_test::MaskRomTest {
  protected:
+  /**
+   * Expects a read of the `STATUS` register with the given FIFO depth.
+   */
+  void ExpectFifoDepth(uint32_t depth) {
+    EXPECT_ABS_READ32(base_ + HMAC_STATUS_REG_OFFSET,
+                      {{HMAC_STATUS_FIFO_DEPTH_OFFSET, depth}});
+  }
+
   uint32_t base_ = TOP_EARLGREY_HMAC_BASE_ADDR;
   mask_rom_test::MockAbsMmio mmio_;
 };
@@ -62,18 +70,85 @@ TEST_F(Sha256UpdateTest, SendData) {
   EXPECT_EQ(hmac_sha256_update(&kData[1], 2), kErrorOk);
 
   // Trigger a single 32bit aligned write.
+  ExpectFifoDepth(0);
   EXPECT_ABS_WRITE32(base_ + HMAC_MSG_FIFO_REG_OFFSET, 0x03020100);
   EXPECT_EQ(hmac_sha256_update(&kData[0], 4), kErrorOk);
 
   // Trigger 8bit/32bit/8bit sequence.
   EXPECT_ABS_WRITE8(base_ + HMAC_MSG_FIFO_REG_OFFSET, 0x02);
   EXPECT_ABS_WRITE8(base_ + HMAC_MSG_FIFO_REG_OFFSET, 0x03);
+  ExpectFifoDepth(0);
   EXPECT_ABS_WRITE32(base_ + HMAC_MSG_FIFO_REG_OFFSET, 0x07060504);
   EXPECT_ABS_WRITE8(base_ + HMAC_MSG_FIFO_REG_OFFSET, 0x08);
   EXPECT_ABS_WRITE8(base_ + HMAC_MSG_FIFO_REG_OFFSET, 0x09);
   EXPECT_EQ(hmac_sha256_update(&kData[2], 8), kErrorOk);
 }
 
+TEST_F(Sha256UpdateTest, FifoBursts) {
+  std::array<uint32_t, kHmacMsgFifoDepthWords + 4> data;
+  for (size_t i = 0; i < data.size(); ++i) {
+    data[i] = i;
+  }
+
+  // Only two entries are free, then the FIFO is full until it drains
+  // completely, and the remaining words fit in the second burst.
+  ExpectFifoDepth(kHmacMsgFifoDepthWords - 2);
+  EXPECT_ABS_WRITE32(base_ + HMAC_MSG_FIFO_REG_OFFSET, data[0]);
+  EXPECT_ABS_WRITE32(base_ + HMAC_MSG_FIFO_REG_OFFSET, data[1]);
+  ExpectFifoDepth(kHmacMsgFifoDepthWords);
+  ExpectFifoDepth(0);
+  for (size_t i = 2; i < kHmacMsgFifoDepthWords + 2; ++i) {
+    EXPECT_ABS_WRITE32(base_ + HMAC_MSG_FIFO_REG_OFFSET, data[i]);
+  }
+  ExpectFifoDepth(0);
+  EXPECT_ABS_WRITE32(base_ + HMAC_MSG_FIFO_REG_OFFSET,
+                     data[kHmacMsgFifoDepthWords + 2]);
+  EXPECT_ABS_WRITE32(base_ + HMAC_MSG_FIFO_REG_OFFSET,
+                     data[kHmacMsgFifoDepthWords + 3]);
+
+  EXPECT_EQ(hmac_sha256_update(data.data(), sizeof(data)), kErrorOk);
+}
+
+class Sha256UpdateSegmentsTest : public HmacTest {};
+
+TEST_F(Sha256UpdateSegmentsTest, NullArgs) {
+  constexpr uint8_t kData = 0;
+  EXPECT_EQ(hmac_sha256_update_segments(nullptr, 1),
+            kErrorHmacInvalidArgument);
+
+  // Nothing should be written if any of the segments is invalid.
+  const std::array<hmac_segment_t, 2> kSegments = {{
+      {.data = &kData, .len = sizeof(kData)},
+      {.data = nullptr, .len = 0},
+  }};
+  EXPECT_EQ(hmac_sha256_update_segments(kSegments.data(), kSegments.size()),
+            kErrorHmacInvalidArgument);
+}
+
+TEST_F(Sha256UpdateSegmentsTest, SendData) {
+  alignas(uint32_t) constexpr std::array<uint8_t, 16> kData = {
+      0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07,
+      0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f,
+  };
+  const std::array<hmac_segment_t, 4> kSegments = {{
+      {.data = &kData[1], .len = 2},
+      {.data = &kData[4], .len = 8},
+      {.data = &kData[0], .len = 0},
+      {.data = &kData[14], .len = 2},
+  }};
+
+  EXPECT_ABS_WRITE8(base_ + HMAC_MSG_FIFO_REG_OFFSET, 0x01);
+  EXPECT_ABS_WRITE8(base_ + HMAC_MSG_FIFO_REG_OFFSET, 0x02);
+  ExpectFifoDepth(0);
+  EXPECT_ABS_WRITE32(base_ + HMAC_MSG_FIFO_REG_OFFSET, 0x07060504);
+  EXPECT_ABS_WRITE32(base_ + HMAC_MSG_FIFO_REG_OFFSET, 0x0b0a0908);
+  EXPECT_ABS_WRITE8(base_ + HMAC_MSG_FIFO_REG_OFFSET, 0x0e);
+  EXPECT_ABS_WRITE8(base_ + HMAC_MSG_FIFO_REG_OFFSET, 0x0f);
+
+  EXPECT_EQ(hmac_sha256_update_segments(kSegments.data(), kSegments.size()),
+            kErrorOk);
+}
+
 class Sha256FinalTest : public HmacTest {};
 
 TEST_F(Sha256FinalTest, NullArgs) {
@@ -5,8 +5,8 @@
 #ifndef OPENTITAN_SW_DEVICE_SILICON_CREATOR_LIB_DRIVERS_MOCK_HMAC_H_
 #define OPENTITAN_SW_DEVICE_SILICON_CREATOR_LIB_DRIVERS_MOCK_HMAC_H_
 
-#include "sw/device/lib/testing/mask_rom_test.h"
 #include "sw/device/silicon_creator/lib/drivers/hmac.h"
+#include "sw/device/silicon_creator/testing/mask_rom_test.h"
 
 namespace mask_rom_test {
 namespace internal {
@@ -18,6 +18,8 @@ class MockHmac : public GlobalMock<MockHmac> {
  public:
   MOCK_METHOD(void, sha256_init, ());
   MOCK_METHOD(rom_error_t, sha256_update, (const void *, size_t));
+  MOCK_METHOD(rom_error_t, sha256_update_segments,
+              (const hmac_segment_t *, size_t));
   MOCK_METHOD(rom_error_t, sha256_final, (hmac_digest_t *));
 };
 
@@ -33,6 +35,11 @@ rom_error_t hmac_sha256_update(const void *data, size_t len) {
   return MockHmac::Instance().sha256_update(data, len);
 }
 
+rom_error_t hmac_sha256_update_segments(const hmac_segment_t *segments,
+                                        size_t num_segments) {
+  return MockHmac::Instance().sha256_update_segments(segments, num_segments);
+}
+
 rom_error_t hmac_sha256_final(hmac_digest_t *digest) {
   return MockHmac::Instance().sha256_final(digest);
 }
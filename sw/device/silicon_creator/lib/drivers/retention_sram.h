@@ -29,13 +29,23 @@ typedef struct retention_sram {
    */
   uint32_t boot_info;
 
+  /**
+   * Location of the newest boot data entry.
+   *
+   * Maintained by `boot_data_read()` and `boot_data_write()` to avoid
+   * searching both boot data pages on every access. This is only a hint: its
+   * contents are validated against the flash before they are used. See
+   * `boot_data.c` for the layout.
+   */
+  uint32_t boot_data_cache[4];
+
   /**
    * Space reserved for future allocation by the silicon creator.
    *
    * TODO(lowRISC/opentitan#5760): the size / offset of this allocation should
    * be reviewed.
    */
-  uint32_t reserved_creator[447];
+  uint32_t reserved_creator[443];
 
   /**
    * Panic record.
@@ -62,6 +72,8 @@ typedef struct retention_sram {
 } retention_sram_t;
 
 OT_ASSERT_MEMBER_OFFSET(retention_sram_t, boot_info, 0);
+OT_ASSERT_MEMBER_OFFSET(retention_sram_t, boot_data_cache, 4);
+OT_ASSERT_MEMBER_OFFSET(retention_sram_t, reserved_creator, 20);
 OT_ASSERT_MEMBER_OFFSET(retention_sram_t, panic_record, 1792);
 OT_ASSERT_MEMBER_OFFSET(retention_sram_t, reserved_owner, 2048);
 OT_ASSERT_SIZE(retention_sram_t, 4096);
@@ -19,6 +19,10 @@ class MockSigverifyModExpOtbn : public GlobalMock<MockSigverifyModExpOtbn> {
   MOCK_METHOD(rom_error_t, mod_exp,
               (const sigverify_rsa_key_t *, const sigverify_rsa_buffer_t *,
                sigverify_rsa_buffer_t *));
+  MOCK_METHOD(rom_error_t, start,
+              (otbn_t *, const sigverify_rsa_key_t *,
+               const sigverify_rsa_buffer_t *));
+  MOCK_METHOD(rom_error_t, finish, (otbn_t *, sigverify_rsa_buffer_t *));
 };
 
 }  // namespace internal
@@ -34,6 +38,17 @@ rom_error_t sigverify_mod_exp_otbn(const sigverify_rsa_key_t *key,
   return MockSigverifyModExpOtbn::Instance().mod_exp(key, sig, result);
 }
 
+rom_error_t sigverify_mod_exp_otbn_start(otbn_t *otbn,
+                                         const sigverify_rsa_key_t *key,
+                                         const sigverify_rsa_buffer_t *sig) {
+  return MockSigverifyModExpOtbn::Instance().start(otbn, key, sig);
+}
+
+rom_error_t sigverify_mod_exp_otbn_finish(otbn_t *otbn,
+                                          sigverify_rsa_buffer_t *result) {
+  return MockSigverifyModExpOtbn::Instance().finish(otbn, result);
+}
+
 }  // extern "C"
 }  // namespace mask_rom_test
 
@@ -111,20 +111,36 @@ static rom_error_t sigverify_use_sw_rsa_verify(lifecycle_state_t lc_state,
   }
 }
 
-rom_error_t sigverify_rsa_verify(const sigverify_rsa_buffer_t *signature,
-                                 const sigverify_rsa_key_t *key,
-                                 const hmac_digest_t *act_digest,
-                                 lifecycle_state_t lc_state) {
-  hardened_bool_t use_sw;
-  RETURN_IF_ERROR(sigverify_use_sw_rsa_verify(lc_state, &use_sw));
+rom_error_t sigverify_rsa_verify_start(const sigverify_rsa_buffer_t *signature,
+                                       const sigverify_rsa_key_t *key,
+                                       lifecycle_state_t lc_state,
+                                       sigverify_rsa_verify_ctx_t *ctx) {
+  ctx->signature = signature;
+  ctx->key = key;
+  RETURN_IF_ERROR(sigverify_use_sw_rsa_verify(lc_state, &ctx->use_sw));
 
+  switch (ctx->use_sw) {
+    case kHardenedBoolTrue:
+      // Ibex cannot compute the modular exponentiation in the background, it
+      // is deferred to `sigverify_rsa_verify_finish()`.
+      return kErrorOk;
+    case kHardenedBoolFalse:
+      return sigverify_mod_exp_otbn_start(&ctx->otbn, key, signature);
+    default:
+      return kErrorSigverifyBadOtpValue;
+  }
+}
+
+rom_error_t sigverify_rsa_verify_finish(sigverify_rsa_verify_ctx_t *ctx,
+                                        const hmac_digest_t *act_digest) {
   sigverify_rsa_buffer_t enc_msg;
-  switch (use_sw) {
+  switch (ctx->use_sw) {
     case kHardenedBoolTrue:
-      RETURN_IF_ERROR(sigverify_mod_exp_ibex(key, signature, &enc_msg));
+      RETURN_IF_ERROR(
+          sigverify_mod_exp_ibex(ctx->key, ctx->signature, &enc_msg));
       break;
     case kHardenedBoolFalse:
-      RETURN_IF_ERROR(sigverify_mod_exp_otbn(key, signature, &enc_msg));
+      RETURN_IF_ERROR(sigverify_mod_exp_otbn_finish(&ctx->otbn, &enc_msg));
       break;
     default:
       return kErrorSigverifyBadOtpValue;
@@ -134,6 +150,15 @@ rom_error_t sigverify_rsa_verify(const sigverify_rsa_buffer_t *signature,
   return kErrorOk;
 }
 
+rom_error_t sigverify_rsa_verify(const sigverify_rsa_buffer_t *signature,
+                                 const sigverify_rsa_key_t *key,
+                                 const hmac_digest_t *act_digest,
+                                 lifecycle_state_t lc_state) {
+  sigverify_rsa_verify_ctx_t ctx;
+  RETURN_IF_ERROR(sigverify_rsa_verify_start(signature, key, lc_state, &ctx));
+  return sigverify_rsa_verify_finish(&ctx, act_digest);
+}
+
 void sigverify_usage_constraints_get(
     uint32_t selector_bits, manifest_usage_constraints_t *usage_constraints) {
   usage_constraints->selector_bits = selector_bits;
@@ -172,5 +197,27 @@ void sigverify_usage_constraints_get(
   }
 }
 
+rom_error_t sigverify_manifest_digest_compute(const manifest_t *manifest,
+                                              hmac_digest_t *act_digest) {
+  manifest_usage_constraints_t usage_constraints_from_hw;
+  sigverify_usage_constraints_get(manifest->usage_constraints.selector_bits,
+                                  &usage_constraints_from_hw);
+  manifest_digest_region_t digest_region = manifest_digest_region_get(manifest);
+  // Hash usage constraints followed by the remaining part of the image.
+  const hmac_segment_t segments[] = {
+      {
+          .data = &usage_constraints_from_hw,
+          .len = sizeof(usage_constraints_from_hw),
+      },
+      {
+          .data = digest_region.start,
+          .len = digest_region.length,
+      },
+  };
+  hmac_sha256_init();
+  RETURN_IF_ERROR(hmac_sha256_update_segments(segments, ARRAYSIZE(segments)));
+  return hmac_sha256_final(act_digest);
+}
+
 // `extern` declarations for `inline` functions in the header.
 extern uint32_t sigverify_rsa_key_id_get(const sigverify_rsa_buffer_t *modulus);
@@ -8,10 +8,12 @@
 #include <stddef.h>
 #include <stdint.h>
 
+#include "sw/device/lib/base/hardened.h"
 #include "sw/device/silicon_creator/lib/drivers/hmac.h"
 #include "sw/device/silicon_creator/lib/drivers/lifecycle.h"
 #include "sw/device/silicon_creator/lib/error.h"
 #include "sw/device/silicon_creator/lib/manifest.h"
+#include "sw/device/silicon_creator/lib/otbn_util.h"
 #include "sw/device/silicon_creator/lib/sigverify_rsa_key.h"
 
 #ifdef __cplusplus
@@ -49,6 +51,70 @@ rom_error_t sigverify_rsa_verify(const sigverify_rsa_buffer_t *signature,
                                  const hmac_digest_t *act_digest,
                                  lifecycle_state_t lc_state);
 
+/**
+ * Context of a signature verification that is in progress.
+ *
+ * Use `sigverify_rsa_verify_start()` to initialize.
+ */
+typedef struct sigverify_rsa_verify_ctx {
+  /**
+   * Signature to be verified.
+   */
+  const sigverify_rsa_buffer_t *signature;
+  /**
+   * Signer's RSA public key.
+   */
+  const sigverify_rsa_key_t *key;
+  /**
+   * Whether the software implementation is used.
+   */
+  hardened_bool_t use_sw;
+  /**
+   * OTBN context, only valid if the OTBN implementation is used.
+   */
+  otbn_t otbn;
+} sigverify_rsa_verify_ctx_t;
+
+/**
+ * Starts the verification of an RSASSA-PKCS1-v1_5 signature.
+ *
+ * Since the modular exponentiation of the signature does not depend on the
+ * digest of the message, this function starts it on OTBN, if OTBN is used,
+ * and returns without waiting for it to complete. This allows callers to
+ * compute the digest of the message while OTBN is running. Callers must call
+ * `sigverify_rsa_verify_finish()` to complete the verification.
+ *
+ * The actual implementation that is used (software or OTBN) is determined by
+ * the life cycle state of the device and the OTP value.
+ *
+ * @param signature Signature to be verified, must remain valid until
+ * `sigverify_rsa_verify_finish()` returns.
+ * @param key Signer's RSA public key, must remain valid until
+ * `sigverify_rsa_verify_finish()` returns.
+ * @param lc_state Life cycle state of the device.
+ * @param[out] ctx Context of the verification.
+ * @return Result of the operation.
+ */
+rom_error_t sigverify_rsa_verify_start(const sigverify_rsa_buffer_t *signature,
+                                       const sigverify_rsa_key_t *key,
+                                       lifecycle_state_t lc_state,
+                                       sigverify_rsa_verify_ctx_t *ctx);
+
+/**
+ * Completes the verification of an RSASSA-PKCS1-v1_5 signature.
+ *
+ * This function waits for the modular exponentiation started by
+ * `sigverify_rsa_verify_start()`, or computes it on Ibex if the software
+ * implementation is used, and checks the resulting encoded message against
+ * the given digest.
+ *
+ * @param ctx Context of the verification.
+ * @param act_digest Actual digest of the message being verified.
+ * @return Result of the operation.
+ */
+rom_error_t sigverify_rsa_verify_finish(sigverify_rsa_verify_ctx_t *ctx,
+                                        const hmac_digest_t *act_digest);
+
 /**
  * Gets the usage constraints struct that is used for verifying a ROM_EXT.
  *
@@ -68,6 +134,20 @@ rom_error_t sigverify_rsa_verify(const sigverify_rsa_buffer_t *signature,
 void sigverify_usage_constraints_get(
     uint32_t selector_bits, manifest_usage_constraints_t *usage_constraints);
 
+/**
+ * Computes the digest of an image for signature verification.
+ *
+ * The digest covers the usage constraints read from the hardware (see
+ * `sigverify_usage_constraints_get()`) followed by the digest region of the
+ * image (see `manifest_digest_region_get()`).
+ *
+ * @param manifest Manifest of the image.
+ * @param[out] act_digest Digest of the image.
+ * @return Result of the operation.
+ */
+rom_error_t sigverify_manifest_digest_compute(const manifest_t *manifest,
+                                              hmac_digest_t *act_digest);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif  // __cplusplus
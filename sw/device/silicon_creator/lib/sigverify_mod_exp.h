@@ -9,6 +9,7 @@
 #include <stdint.h>
 
 #include "sw/device/silicon_creator/lib/error.h"
+#include "sw/device/silicon_creator/lib/otbn_util.h"
 #include "sw/device/silicon_creator/lib/sigverify_rsa_key.h"
 
 #ifdef __cplusplus
@@ -49,6 +50,35 @@ rom_error_t sigverify_mod_exp_otbn(const sigverify_rsa_key_t *key,
                                    const sigverify_rsa_buffer_t *sig,
                                    sigverify_rsa_buffer_t *result);
 
+/**
+ * Starts the modular exponentiation of an RSA signature on OTBN.
+ *
+ * This function loads the RSA application and its inputs into OTBN and starts
+ * it without waiting for the result so that Ibex can do other work, e.g. hash
+ * the image, in the meantime. Use `sigverify_mod_exp_otbn_finish()` to wait
+ * for and read the result.
+ *
+ * @param[out] otbn OTBN context, must be passed to
+ * `sigverify_mod_exp_otbn_finish()`.
+ * @param key An RSA public key.
+ * @param sig Buffer that holds the signature, little-endian.
+ * @return The result of the operation.
+ */
+rom_error_t sigverify_mod_exp_otbn_start(otbn_t *otbn,
+                                         const sigverify_rsa_key_t *key,
+                                         const sigverify_rsa_buffer_t *sig);
+
+/**
+ * Waits for a modular exponentiation started with
+ * `sigverify_mod_exp_otbn_start()` and reads its result.
+ *
+ * @param otbn OTBN context that was passed to `sigverify_mod_exp_otbn_start()`.
+ * @param result Buffer to write the result to, little-endian.
+ * @return The result of the operation.
+ */
+rom_error_t sigverify_mod_exp_otbn_finish(otbn_t *otbn,
+                                          sigverify_rsa_buffer_t *result);
+
 #ifdef __cplusplus
 }  // extern "C"
 #endif  // __cplusplus
@@ -48,48 +48,6 @@ static bool greater_equal_modulus(const sigverify_rsa_key_t *key,
   return true;
 }
 
-/**
- * Shifts `a` left one bit in-place, i.e. `a <<= 1`.
- *
- * Since the result may not fit in `a`, this function also returns the most
- * significant bit of the result.
- *
- * @param[in,out] a Buffer that holds `a`, little-endian.
- * @return Most significant bit of the result.
- */
-static uint32_t shift_left(sigverify_rsa_buffer_t *a) {
-  const uint32_t msb = a->data[ARRAYSIZE(a->data) - 1] >> 31;
-  for (size_t i = ARRAYSIZE(a->data) - 1; i > 0; --i) {
-    a->data[i] = (a->data[i] << 1) | (a->data[i - 1] >> 31);
-  }
-  a->data[0] <<= 1;
-  return msb;
-}
-
-/**
- * Calculates R^2 mod n, where R = 2^kSigVerifyRsaNumBits.
- *
- * @param key An RSA public key.
- * @param[out] result Buffer to write the result to, little-endian.
- */
-static void calc_r_square(const sigverify_rsa_key_t *key,
-                          sigverify_rsa_buffer_t *result) {
-  memset(result->data, 0, sizeof(result->data));
-  // Since R/2 < n < R, this subtraction ensures that result = R mod n and
-  // fits in `kSigVerifyRsaNumWords` going into the loop.
-  subtract_modulus(key, result);
-
-  // Iteratively shift and reduce `result`.
-  for (size_t i = 0; i < kSigVerifyRsaNumBits; ++i) {
-    uint32_t msb = shift_left(result);
-    // Reduce until result < n. Doing this at every iteration minimizes the
-    // total number of subtractions that we need to perform.
-    while (msb > 0 || greater_equal_modulus(key, result)) {
-      msb -= subtract_modulus(key, result);
-    }
-  }
-}
-
 /**
  * Computes the Montgomery reduction of the product of two integers.
  *
@@ -99,7 +57,15 @@ static void calc_r_square(const sigverify_rsa_key_t *key,
  * - n is the modulus of the key, and
  * - R is 2^`kSigVerifyRsaNumBits`, e.g. 2^3072 for RSA-3072.
  *
- * See Handbook of Applied Cryptography, Ch. 14, Alg. 14.36.
+ * This is the Coarsely Integrated Operand Scanning (CIOS) method, see Koc, C.
+ * K., Acar, T., Kaliski, B. S., Analyzing and Comparing Montgomery
+ * Multiplication Algorithms, and Handbook of Applied Cryptography, Ch. 14,
+ * Alg. 14.36. The multiplication and the reduction steps are interleaved in a
+ * single inner loop so that each word of `y`, `n`, and `result` is loaded only
+ * once per outer iteration. Ibex computes the low and high halves of a 32x32
+ * bit product with separate `mul` and `mulhu` instructions, so the loop is
+ * written such that each 64-bit product is consumed immediately, which lets
+ * the compiler keep all live values in registers.
  *
  * @param key An RSA public key.
  * @param x Buffer that holds `x`, little-endian.
@@ -111,6 +77,7 @@ static void mont_mul(const sigverify_rsa_key_t *key,
                      const sigverify_rsa_buffer_t *y,
                      sigverify_rsa_buffer_t *result) {
   memset(result->data, 0, sizeof(result->data));
+  const uint32_t n0_inv = key->n0_inv[0];
 
   for (size_t i = 0; i < ARRAYSIZE(x->data); ++i) {
     // The loop below reads one word ahead of writes to avoid a separate loop
@@ -121,21 +88,25 @@ static void mont_mul(const sigverify_rsa_key_t *key,
     // and `acc1`. `acc0` and `acc1` can safely store these intermediate values,
     // i.e. without wrapping, because UINT32_MAX^2 + 2*UINT32_MAX is
     // 0xffff_ffff_ffff_ffff.
+    const uint32_t x_i = x->data[i];
+    const uint32_t *y_j = y->data;
+    const uint32_t *n_j = key->n.data;
+    uint32_t *r_j = result->data;
 
     // Holds the sum of the first two addends in step 2.2.
-    uint64_t acc0 = (uint64_t)x->data[i] * y->data[0] + result->data[0];
-    const uint32_t u_i = (uint32_t)acc0 * key->n0_inv[0];
+    uint64_t acc0 = (uint64_t)x_i * *y_j++ + *r_j;
+    const uint32_t u_i = (uint32_t)acc0 * n0_inv;
     // Holds the sum of the all three addends in step 2.2.
-    uint64_t acc1 = (uint64_t)u_i * key->n.data[0] + (uint32_t)acc0;
+    uint64_t acc1 = (uint64_t)u_i * *n_j++ + (uint32_t)acc0;
 
     // Process the i^th digit of `x`, i.e. `x[i]`.
     for (size_t j = 1; j < ARRAYSIZE(result->data); ++j) {
-      acc0 = (uint64_t)x->data[i] * y->data[j] + result->data[j] + (acc0 >> 32);
-      acc1 = (uint64_t)u_i * key->n.data[j] + (uint32_t)acc0 + (acc1 >> 32);
-      result->data[j - 1] = (uint32_t)acc1;
+      acc0 = (uint64_t)x_i * *y_j++ + r_j[1] + (acc0 >> 32);
+      acc1 = (uint64_t)u_i * *n_j++ + (uint32_t)acc0 + (acc1 >> 32);
+      *r_j++ = (uint32_t)acc1;
     }
     acc0 = (acc0 >> 32) + (acc1 >> 32);
-    result->data[ARRAYSIZE(result->data) - 1] = (uint32_t)acc0;
+    *r_j = (uint32_t)acc0;
 
     // The intermediate result of this algorithm before the check below is
     // bounded by R + n (Eq. (4) in Montgomery Arithmetic from a Software
@@ -157,18 +128,15 @@ rom_error_t sigverify_mod_exp_ibex(const sigverify_rsa_key_t *key,
                                    sigverify_rsa_buffer_t *result) {
   sigverify_rsa_buffer_t buf;
 
+  // Note: R^2 mod n is precomputed and stored with the key, see `key->rr`.
   if (key->exponent == 3) {
-    // buf = R^2 mod n
-    calc_r_square(key, &buf);
     // result = sig * R mod n
-    mont_mul(key, sig, &buf, result);
+    mont_mul(key, sig, &key->rr, result);
     // buf = sig^2 * R mod n
     mont_mul(key, result, result, &buf);
   } else if (key->exponent == 65537) {
-    // result = R^2 mod n
-    calc_r_square(key, result);
     // buf = sig * R mod n
-    mont_mul(key, sig, result, &buf);
+    mont_mul(key, sig, &key->rr, &buf);
     for (size_t i = 0; i < 8; ++i) {
       // result = sig^{2*i+1} * R mod n (sig's exponent: 2, 8, 32, ..., 32768)
       mont_mul(key, &buf, &buf, result);
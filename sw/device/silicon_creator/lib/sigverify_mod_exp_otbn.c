@@ -23,46 +23,56 @@ static const otbn_ptr_t kOtbnVarRsaModulus = OTBN_PTR_T_INIT(rsa, modulus);
 
 static const uint32_t kOtbnModeEncrypt = 1;
 
-rom_error_t sigverify_mod_exp_otbn(const sigverify_rsa_key_t *key,
-                                   const sigverify_rsa_buffer_t *sig,
-                                   sigverify_rsa_buffer_t *result) {
+rom_error_t sigverify_mod_exp_otbn_start(otbn_t *otbn,
+                                         const sigverify_rsa_key_t *key,
+                                         const sigverify_rsa_buffer_t *sig) {
   static const uint32_t n_limbs = kSigVerifyRsaNumBits / 256;
 
-  otbn_t otbn;
-  otbn_init(&otbn);
-  RETURN_IF_ERROR(otbn_load_app(&otbn, kOtbnAppRsa));
-
   // TODO: The OTBN routines should be consistent with ibex exponent support.
   if (key->exponent != 65537) {
     return kErrorSigverifyBadExponent;
   }
 
+  otbn_init(otbn);
+  RETURN_IF_ERROR(otbn_load_app(otbn, kOtbnAppRsa));
+
   // Set mode so start() will jump into rsa_encrypt().
   // NOLINTNEXTLINE(bugprone-sizeof-expression)
   RETURN_IF_ERROR(
-      otbn_copy_data_to_otbn(&otbn, sizeof(kOtbnModeEncrypt) / sizeof(uint32_t),
+      otbn_copy_data_to_otbn(otbn, sizeof(kOtbnModeEncrypt) / sizeof(uint32_t),
                              &kOtbnModeEncrypt, kOtbnVarRsaMode));  //
 
   // Set the number of 256-bit limbs for this RSA operation.
   // NOLINTNEXTLINE(bugprone-sizeof-expression)
   RETURN_IF_ERROR(otbn_copy_data_to_otbn(
-      &otbn, sizeof(n_limbs) / sizeof(uint32_t), &n_limbs, kOtbnVarRsaNLimbs));
+      otbn, sizeof(n_limbs) / sizeof(uint32_t), &n_limbs, kOtbnVarRsaNLimbs));
 
   // Set the modulus.
-  RETURN_IF_ERROR(otbn_copy_data_to_otbn(&otbn, kSigVerifyRsaNumWords,
+  RETURN_IF_ERROR(otbn_copy_data_to_otbn(otbn, kSigVerifyRsaNumWords,
                                          key->n.data, kOtbnVarRsaModulus));
   // Set the message text.
-  RETURN_IF_ERROR(otbn_copy_data_to_otbn(&otbn, kSigVerifyRsaNumWords,
+  RETURN_IF_ERROR(otbn_copy_data_to_otbn(otbn, kSigVerifyRsaNumWords,
                                          sig->data, kOtbnVarRsaIn));
 
   // Start the OTBN routine.
-  RETURN_IF_ERROR(otbn_execute_app(&otbn));
+  return otbn_execute_app(otbn);
+}
 
+rom_error_t sigverify_mod_exp_otbn_finish(otbn_t *otbn,
+                                          sigverify_rsa_buffer_t *result) {
   // Spin here waiting for OTBN to complete.
-  RETURN_IF_ERROR(otbn_busy_wait_for_done(&otbn));
+  RETURN_IF_ERROR(otbn_busy_wait_for_done(otbn));
 
   // Read digest out of OTBN dmem.
-  RETURN_IF_ERROR(otbn_copy_data_from_otbn(&otbn, kSigVerifyRsaNumWords,
+  RETURN_IF_ERROR(otbn_copy_data_from_otbn(otbn, kSigVerifyRsaNumWords,
                                            kOtbnVarRsaOut, result->data));
   return kErrorOk;
 }
+
+rom_error_t sigverify_mod_exp_otbn(const sigverify_rsa_key_t *key,
+                                   const sigverify_rsa_buffer_t *sig,
+                                   sigverify_rsa_buffer_t *result) {
+  otbn_t otbn;
+  RETURN_IF_ERROR(sigverify_mod_exp_otbn_start(&otbn, key, sig));
+  return sigverify_mod_exp_otbn_finish(&otbn, result);
+}
@@ -48,6 +48,14 @@ typedef struct sigverify_rsa_key {
    * first word, which is equal to -n^-1 mod 2^32.
    */
   uint32_t n0_inv[8];
+  /**
+   * R^2 mod n, where R = 2^`kSigVerifyRsaNumBits`, little-endian.
+   *
+   * This value is used to convert signatures to the Montgomery domain. Storing
+   * it with the key avoids computing it at run time, which would otherwise
+   * dominate the cost of signature verification on Ibex.
+   */
+  sigverify_rsa_buffer_t rr;
   /**
    * Exponent.
    */
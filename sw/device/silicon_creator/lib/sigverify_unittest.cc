@@ -9,8 +9,10 @@
 
 #include "gtest/gtest.h"
 #include "sw/device/lib/base/hardened.h"
+#include "sw/device/silicon_creator/lib/drivers/mock_hmac.h"
 #include "sw/device/silicon_creator/lib/drivers/mock_lifecycle.h"
 #include "sw/device/silicon_creator/lib/drivers/mock_otp.h"
+#include "sw/device/silicon_creator/lib/mock_manifest.h"
 #include "sw/device/silicon_creator/lib/mock_sigverify_mod_exp_ibex.h"
 #include "sw/device/silicon_creator/lib/mock_sigverify_mod_exp_otbn.h"
 #include "sw/device/silicon_creator/testing/mask_rom_test.h"
@@ -167,13 +169,44 @@ TEST_P(SigverifyInNonTestStates, GoodSignatureOtbn) {
   EXPECT_CALL(otp_,
               read32(OTP_CTRL_PARAM_CREATOR_SW_CFG_USE_SW_RSA_VERIFY_OFFSET))
       .WillOnce(Return(kHardenedBoolFalse));
-  EXPECT_CALL(sigverify_mod_exp_otbn_, mod_exp(&key_, &kSignature, NotNull()))
-      .WillOnce(DoAll(SetArgPointee<2>(kEncMsg), Return(kErrorOk)));
+  EXPECT_CALL(sigverify_mod_exp_otbn_, start(NotNull(), &key_, &kSignature))
+      .WillOnce(Return(kErrorOk));
+  EXPECT_CALL(sigverify_mod_exp_otbn_, finish(NotNull(), NotNull()))
+      .WillOnce(DoAll(SetArgPointee<1>(kEncMsg), Return(kErrorOk)));
 
   EXPECT_EQ(sigverify_rsa_verify(&kSignature, &key_, &kTestDigest, GetParam()),
             kErrorOk);
 }
 
+TEST_P(SigverifyInNonTestStates, GoodSignatureOtbnStartFinish) {
+  EXPECT_CALL(otp_,
+              read32(OTP_CTRL_PARAM_CREATOR_SW_CFG_USE_SW_RSA_VERIFY_OFFSET))
+      .WillOnce(Return(kHardenedBoolFalse));
+  EXPECT_CALL(sigverify_mod_exp_otbn_, start(NotNull(), &key_, &kSignature))
+      .WillOnce(Return(kErrorOk));
+
+  sigverify_rsa_verify_ctx_t ctx;
+  EXPECT_EQ(sigverify_rsa_verify_start(&kSignature, &key_, GetParam(), &ctx),
+            kErrorOk);
+
+  // The result is only read after the digest is available.
+  EXPECT_CALL(sigverify_mod_exp_otbn_, finish(&ctx.otbn, NotNull()))
+      .WillOnce(DoAll(SetArgPointee<1>(kEncMsg), Return(kErrorOk)));
+
+  EXPECT_EQ(sigverify_rsa_verify_finish(&ctx, &kTestDigest), kErrorOk);
+}
+
+TEST_P(SigverifyInNonTestStates, OtbnStartError) {
+  EXPECT_CALL(otp_,
+              read32(OTP_CTRL_PARAM_CREATOR_SW_CFG_USE_SW_RSA_VERIFY_OFFSET))
+      .WillOnce(Return(kHardenedBoolFalse));
+  EXPECT_CALL(sigverify_mod_exp_otbn_, start(NotNull(), &key_, &kSignature))
+      .WillOnce(Return(kErrorSigverifyBadExponent));
+
+  EXPECT_EQ(sigverify_rsa_verify(&kSignature, &key_, &kTestDigest, GetParam()),
+            kErrorSigverifyBadExponent);
+}
+
 TEST_P(SigverifyInNonTestStates, BadSignatureOtbn) {
   // Corrupt the words of the encoded message by flipping their bits and check
   // that signature verification fails.
@@ -184,8 +217,10 @@ TEST_P(SigverifyInNonTestStates, BadSignatureOtbn) {
     EXPECT_CALL(otp_,
                 read32(OTP_CTRL_PARAM_CREATOR_SW_CFG_USE_SW_RSA_VERIFY_OFFSET))
         .WillOnce(Return(kHardenedBoolFalse));
-    EXPECT_CALL(sigverify_mod_exp_otbn_, mod_exp(&key_, &kSignature, NotNull()))
-        .WillOnce(DoAll(SetArgPointee<2>(bad_enc_msg), Return(kErrorOk)));
+    EXPECT_CALL(sigverify_mod_exp_otbn_, start(NotNull(), &key_, &kSignature))
+        .WillOnce(Return(kErrorOk));
+    EXPECT_CALL(sigverify_mod_exp_otbn_, finish(NotNull(), NotNull()))
+        .WillOnce(DoAll(SetArgPointee<1>(bad_enc_msg), Return(kErrorOk)));
 
     EXPECT_EQ(
         sigverify_rsa_verify(&kSignature, &key_, &kTestDigest, GetParam()),
@@ -370,5 +405,52 @@ TEST_P(SigverifyUsageConstraints, Read) {
 INSTANTIATE_TEST_SUITE_P(UsageConstraintsTestCases, SigverifyUsageConstraints,
                          testing::ValuesIn(kUsageConstraintsTestCases));
 
+class SigverifyManifestDigest : public mask_rom_test::MaskRomTest {
+ protected:
+  SigverifyManifestDigest() {
+    EXPECT_CALL(lifecycle_, DeviceId(NotNull()));
+    EXPECT_CALL(lifecycle_, State()).WillOnce(Return(kLcStateProd));
+    EXPECT_CALL(manifest_mock_, DigestRegion(&manifest_))
+        .WillOnce(Return(digest_region_));
+    EXPECT_CALL(hmac_, sha256_init());
+  }
+
+  manifest_t manifest_{};
+  manifest_digest_region_t digest_region_{
+      .start = &manifest_,
+      .length = sizeof(manifest_),
+  };
+  mask_rom_test::MockHmac hmac_;
+  mask_rom_test::MockManifest manifest_mock_;
+  mask_rom_test::MockLifecycle lifecycle_;
+};
+
+TEST_F(SigverifyManifestDigest, UsageConstraintsThenImage) {
+  EXPECT_CALL(hmac_, sha256_update_segments(NotNull(), 2))
+      .WillOnce([&](const hmac_segment_t *segments, size_t) {
+        EXPECT_EQ(segments[0].len, sizeof(manifest_usage_constraints_t));
+        EXPECT_EQ(segments[1].data, digest_region_.start);
+        EXPECT_EQ(segments[1].len, digest_region_.length);
+        return kErrorOk;
+      });
+  EXPECT_CALL(hmac_, sha256_final(NotNull()))
+      .WillOnce(DoAll(SetArgPointee<0>(kTestDigest), Return(kErrorOk)));
+
+  hmac_digest_t act_digest{};
+  EXPECT_EQ(sigverify_manifest_digest_compute(&manifest_, &act_digest),
+            kErrorOk);
+  EXPECT_THAT(act_digest.digest,
+              testing::ElementsAreArray(kTestDigest.digest));
+}
+
+TEST_F(SigverifyManifestDigest, UpdateError) {
+  EXPECT_CALL(hmac_, sha256_update_segments(NotNull(), 2))
+      .WillOnce(Return(kErrorHmacInvalidArgument));
+
+  hmac_digest_t act_digest{};
+  EXPECT_EQ(sigverify_manifest_digest_compute(&manifest_, &act_digest),
+            kErrorHmacInvalidArgument);
+}
+
 }  // namespace
 }  // namespace sigverify_unittest
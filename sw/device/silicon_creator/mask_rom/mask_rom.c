@@ -114,23 +114,22 @@ static rom_error_t mask_rom_verify(const manifest_t *manifest) {
   RETURN_IF_ERROR(sigverify_rsa_key_get(
       sigverify_rsa_key_id_get(&manifest->modulus), lc_state, &key));
 
-  hmac_sha256_init();
-  // Hash usage constraints.
-  manifest_usage_constraints_t usage_constraints_from_hw;
-  sigverify_usage_constraints_get(manifest->usage_constraints.selector_bits,
-                                  &usage_constraints_from_hw);
-  RETURN_IF_ERROR(hmac_sha256_update(&usage_constraints_from_hw,
-                                     sizeof(usage_constraints_from_hw)));
-  // Hash the remaining part of the image.
-  manifest_digest_region_t digest_region = manifest_digest_region_get(manifest);
-  RETURN_IF_ERROR(
-      hmac_sha256_update(digest_region.start, digest_region.length));
-  // Verify signature
-  hmac_digest_t act_digest;
-  RETURN_IF_ERROR(hmac_sha256_final(&act_digest));
-  RETURN_IF_ERROR(
-      sigverify_rsa_verify(&manifest->signature, key, &act_digest, lc_state));
-  return kErrorOk;
+  // Start signature verification first. The modular exponentiation does not
+  // depend on the digest, so OTBN, if used, computes it while Ibex feeds the
+  // image to HMAC below.
+  sigverify_rsa_verify_ctx_t verify_ctx;
+  RETURN_IF_ERROR(sigverify_rsa_verify_start(&manifest->signature, key,
+                                             lc_state, &verify_ctx));
+
+  hmac_digest_t act_digest = {0};
+  rom_error_t digest_error =
+      sigverify_manifest_digest_compute(manifest, &act_digest);
+  // Always join with the signature verification so that OTBN is idle before
+  // this function returns.
+  rom_error_t verify_error =
+      sigverify_rsa_verify_finish(&verify_ctx, &act_digest);
+  RETURN_IF_ERROR(digest_error);
+  return verify_error;
 }
 
 /**
@@ -4,8 +4,10 @@
 
 #include "sw/device/lib/flash_ctrl.h"
 
+#include "sw/device/lib/arch/device.h"
 #include "sw/device/lib/base/memory.h"
 #include "sw/device/lib/base/mmio.h"
+#include "sw/device/lib/runtime/ibex.h"
 #include "sw/device/lib/runtime/log.h"
 #include "sw/device/lib/testing/check.h"
 #include "sw/device/lib/testing/test_framework/test_main.h"
@@ -188,6 +190,82 @@ static void test_memory_protection(void) {
   }
 }
 
+/*
+ * Log the throughput of an operation in MB/s.
+ */
+static void log_throughput(const char *msg, uint32_t bytes, uint64_t cycles) {
+  uint32_t kb_per_s = (uint64_t)bytes * kClockFreqCpuHz / cycles / 1000;
+  LOG_INFO("%s: %u bytes in %u cycles, %u.%3u MB/s", msg, bytes,
+           (uint32_t)cycles, kb_per_s / 1000, kb_per_s % 1000);
+}
+
+/*
+ * Measure read and program throughput for a full data page, and check
+ * scatter-gather transfers against the blocking functions.
+ */
+static void test_throughput(void) {
+  flash_default_region_access(/*rd_en=*/true, /*prog_en=*/true,
+                              /*erase_en=*/true);
+
+  uintptr_t page_addr = FLASH_MEM_BASE_ADDR + FLASH_BANK_SZ + FLASH_PAGE_SZ;
+  uint32_t input_page[FLASH_WORDS_PER_PAGE];
+  uint32_t output_page[FLASH_WORDS_PER_PAGE];
+  for (int i = 0; i < FLASH_WORDS_PER_PAGE; ++i) {
+    input_page[i] = 0xa5a5a5a5 ^ (i * 0x01010101);
+  }
+  const uint32_t page_bytes = FLASH_WORDS_PER_PAGE * sizeof(uint32_t);
+
+  CHECK_EQZ(flash_page_erase(page_addr, kDataPartition));
+  uint64_t start = ibex_mcycle_read();
+  CHECK_EQZ(
+      flash_write(page_addr, kDataPartition, input_page, FLASH_WORDS_PER_PAGE));
+  log_throughput("flash_write", page_bytes, ibex_mcycle_read() - start);
+
+  start = ibex_mcycle_read();
+  CHECK_EQZ(flash_read(page_addr, kDataPartition, FLASH_WORDS_PER_PAGE,
+                       output_page));
+  log_throughput("flash_read", page_bytes, ibex_mcycle_read() - start);
+  CHECK_ARRAYS_EQ(output_page, input_page, FLASH_WORDS_PER_PAGE);
+
+  // Gather the two halves of the page in reverse order.
+  const uint32_t half_words = FLASH_WORDS_PER_PAGE / 2;
+  flash_segment_t segments[2] = {
+      {
+          .addr = page_addr + half_words * sizeof(uint32_t),
+          .dst = output_page,
+          .size = half_words,
+      },
+      {
+          .addr = page_addr,
+          .dst = output_page + half_words,
+          .size = half_words,
+      },
+  };
+  memset(output_page, 0, sizeof(output_page));
+  flash_transfer_t transfer;
+  start = ibex_mcycle_read();
+  flash_transfer_start(&transfer, kFlashTransferRead, kDataPartition, segments,
+                       ARRAYSIZE(segments));
+  CHECK_EQZ(flash_transfer_wait(&transfer));
+  log_throughput("flash_transfer read", page_bytes, ibex_mcycle_read() - start);
+  CHECK_ARRAYS_EQ(output_page, input_page + half_words, half_words);
+  CHECK_ARRAYS_EQ(output_page + half_words, input_page, half_words);
+
+  // Program the same page from the two halves, scattered, and read it back.
+  CHECK_EQZ(flash_page_erase(page_addr, kDataPartition));
+  segments[0].src = input_page + half_words;
+  segments[1].src = input_page;
+  start = ibex_mcycle_read();
+  flash_transfer_start(&transfer, kFlashTransferProgram, kDataPartition,
+                       segments, ARRAYSIZE(segments));
+  CHECK_EQZ(flash_transfer_wait(&transfer));
+  log_throughput("flash_transfer program", page_bytes,
+                 ibex_mcycle_read() - start);
+  CHECK_EQZ(flash_read(page_addr, kDataPartition, FLASH_WORDS_PER_PAGE,
+                       output_page));
+  CHECK_ARRAYS_EQ(output_page, input_page, FLASH_WORDS_PER_PAGE);
+}
+
 const test_config_t kTestConfig;
 
 bool test_main(void) {
@@ -200,6 +278,7 @@ bool test_main(void) {
 
   test_basic_io();
   test_memory_protection();
+  test_throughput();
 
   flash_cfg_bank_erase(FLASH_BANK_0, /*erase_en=*/false);
   flash_cfg_bank_erase(FLASH_BANK_1, /*erase_en=*/false);
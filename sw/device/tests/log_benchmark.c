@@ -0,0 +1,84 @@
+// Copyright lowRISC contributors.
+// Licensed under the Apache License, Version 2.0, see LICENSE for details.
+// SPDX-License-Identifier: Apache-2.0
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "sw/device/lib/runtime/ibex.h"
+#include "sw/device/lib/runtime/log.h"
+#include "sw/device/lib/runtime/print.h"
+#include "sw/device/lib/testing/test_framework/test_main.h"
+
+/**
+ * Measures the cost of logging in CPU cycles.
+ *
+ * Each case is timed over `kNumIterations` calls with the `mcycle` counter and
+ * the averages are logged at the end. `base_snprintf()` measures formatting
+ * alone, while `LOG_INFO()` includes sending the line over the UART (or, on
+ * devices with a log bypass address, writing the raw arguments to it). Run it
+ * under Verilator to compare changes to the printing code.
+ */
+
+enum {
+  /**
+   * Number of calls to time for each case.
+   */
+  kNumIterations = 8,
+};
+
+const test_config_t kTestConfig;
+
+static uint32_t cycles_since(uint64_t start) {
+  return (uint32_t)(ibex_mcycle_read() - start);
+}
+
+static uint32_t bench_snprintf_text(void) {
+  char buf[64];
+  uint64_t start = ibex_mcycle_read();
+  for (uint32_t i = 0; i < kNumIterations; ++i) {
+    base_snprintf(buf, sizeof(buf), "The quick brown fox jumps over the dog.");
+  }
+  return cycles_since(start) / kNumIterations;
+}
+
+static uint32_t bench_snprintf_ints(void) {
+  char buf[64];
+  uint64_t start = ibex_mcycle_read();
+  for (uint32_t i = 0; i < kNumIterations; ++i) {
+    base_snprintf(buf, sizeof(buf), "%u %d 0x%08x %b", 4000000000u + i,
+                  -123456789, 0xdeadbeef, i);
+  }
+  return cycles_since(start) / kNumIterations;
+}
+
+static uint32_t bench_log_text(void) {
+  uint64_t start = ibex_mcycle_read();
+  for (uint32_t i = 0; i < kNumIterations; ++i) {
+    LOG_INFO("The quick brown fox jumps over the dog.");
+  }
+  return cycles_since(start) / kNumIterations;
+}
+
+static uint32_t bench_log_ints(void) {
+  uint64_t start = ibex_mcycle_read();
+  for (uint32_t i = 0; i < kNumIterations; ++i) {
+    LOG_INFO("%u %d 0x%08x %b", 4000000000u + i, -123456789, 0xdeadbeef, i);
+  }
+  return cycles_since(start) / kNumIterations;
+}
+
+bool test_main(void) {
+  uint32_t snprintf_text = bench_snprintf_text();
+  uint32_t snprintf_ints = bench_snprintf_ints();
+  uint32_t log_text = bench_log_text();
+  uint32_t log_ints = bench_log_ints();
+
+  LOG_INFO("Average cycles per call:");
+  LOG_INFO("  base_snprintf, text:     %u", snprintf_text);
+  LOG_INFO("  base_snprintf, integers: %u", snprintf_ints);
+  LOG_INFO("  LOG_INFO, text:          %u", log_text);
+  LOG_INFO("  LOG_INFO, integers:      %u", log_ints);
+
+  return true;
+}
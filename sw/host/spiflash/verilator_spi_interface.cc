@@ -4,6 +4,8 @@
 
 #include "sw/host/spiflash/verilator_spi_interface.h"
 
+#include <algorithm>
+#include <cerrno>
 #include <cstring>
 #include <fcntl.h>
 #include <iostream>
@@ -18,9 +20,23 @@ namespace opentitan {
 namespace spiflash {
 namespace {
 
-// TODO: If transmission is not successful, adapt this by an argument.
-/** Required delay to synchronize transactions with simulation environment. */
-constexpr int kWriteReadDelay = 20000000;
+/**
+ * Header of a spidpi transaction: flags, SCK half-period and a 16-bit
+ * little-endian length (see hw/dv/dpi/spidpi/spidpi.h).
+ */
+constexpr size_t kHeaderSize = 4;
+
+/** Largest transaction spidpi accepts, in bytes. */
+constexpr size_t kMaxTransactionSize = 2048;
+
+/** SPI mode 0, MSB first. */
+constexpr uint8_t kFlags = 0;
+
+/** Let spidpi pick its default SCK rate. */
+constexpr uint8_t kHalfPeriod = 0;
+
+/** Number of transactions to wait for the hash of a frame in CheckHash(). */
+constexpr int kHashReadAttempts = 4;
 
 /** Configure `fd` as a serial port with baud rate 9600. */
 bool SetTermOpts(int fd) {
@@ -68,19 +84,35 @@ size_t ReadBytes(int fd, uint8_t *rx, size_t size) {
   size_t bytes_read = 0;
   while (bytes_read != size) {
     ssize_t read_size = read(fd, &rx[bytes_read], size - bytes_read);
-    switch (read_size) {
-      case -1:
-        if (errno == EAGAIN || errno == EWOULDBLOCK) {
-          continue;
-        }
-        break;
-      default:
-        bytes_read += read_size;
+    if (read_size == -1) {
+      if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+        continue;
+      }
+      break;
     }
+    bytes_read += read_size;
   }
   return bytes_read;
 }
 
+/**
+ * Writes `size` bytes from `tx` to `fd`. Returns the number of bytes written.
+ */
+size_t WriteBytes(int fd, const uint8_t *tx, size_t size) {
+  size_t bytes_written = 0;
+  while (bytes_written != size) {
+    ssize_t write_size = write(fd, &tx[bytes_written], size - bytes_written);
+    if (write_size == -1) {
+      if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+        continue;
+      }
+      break;
+    }
+    bytes_written += write_size;
+  }
+  return bytes_written;
+}
+
 }  // namespace
 
 VerilatorSpiInterface::~VerilatorSpiInterface() {
@@ -98,13 +130,40 @@ bool VerilatorSpiInterface::Init() {
 }
 
 bool VerilatorSpiInterface::TransmitFrame(const uint8_t *tx, size_t size) {
-  size_t bytes_written = write(fd_, tx, size);
-  if (bytes_written != size) {
+  return Transact(tx, size);
+}
+
+bool VerilatorSpiInterface::Transact(const uint8_t *tx, size_t size) {
+  if (size == 0 || size > kMaxTransactionSize) {
+    std::cerr << "Unable to send a frame of " << size
+              << " bytes in one transaction." << std::endl;
+    return false;
+  }
+
+  // Send the data with chip select held low for the whole of it.
+  std::vector<uint8_t> xact(kHeaderSize + size);
+  xact[0] = kFlags;
+  xact[1] = kHalfPeriod;
+  xact[2] = size & 0xff;
+  xact[3] = size >> 8;
+  std::memcpy(&xact[kHeaderSize], tx, size);
+  size_t bytes_written = WriteBytes(fd_, &xact[0], xact.size());
+  if (bytes_written != xact.size()) {
     std::cerr << "Failed to write bytes to spi interface. Bytes written: "
-              << bytes_written << " expected: " << size << std::endl;
+              << bytes_written << " expected: " << xact.size() << std::endl;
+    return false;
+  }
+
+  // spidpi returns what the device sent back once the transaction is over, so
+  // this also waits for the simulation to catch up.
+  rx_.resize(size);
+  size_t bytes_read = ReadBytes(fd_, &rx_[0], size);
+  if (bytes_read != size) {
+    std::cerr << "Failed to read bytes from spi interface. Bytes read: "
+              << bytes_read << " expected: " << size << std::endl;
+    rx_.clear();
     return false;
   }
-  usleep(kWriteReadDelay);
   return true;
 }
 
@@ -112,14 +171,23 @@ bool VerilatorSpiInterface::CheckHash(const uint8_t *tx, size_t size) {
   uint8_t hash[SHA256_DIGEST_SIZE];
   SHA256_hash(tx, size, hash);
 
-  std::vector<uint8_t> rx(size);
-  size_t bytes_read = ReadBytes(fd_, &rx[0], size);
-  if (bytes_read < size) {
-    std::cerr << "Failed to read bytes from spi interface. Bytes read: "
-              << bytes_read << " expected: " << size << std::endl;
+  // The device acknowledges a frame by sending its hash, which the host can
+  // only see in a later transaction. Like FtdiSpiInterface, read it back with
+  // transactions of a whole frame of dummy bytes: the device reads its input
+  // a frame at a time and drops frames with a bad frame number, so this keeps
+  // it aligned with the real frames. The ack might not be ready by the first
+  // read, so look for the hash anywhere in the data and try a few times.
+  std::vector<uint8_t> dummy(size, 0xff);
+  for (int i = 0; i < kHashReadAttempts; ++i) {
+    if (!Transact(&dummy[0], dummy.size())) {
+      return false;
+    }
+    if (std::search(rx_.begin(), rx_.end(), hash, hash + SHA256_DIGEST_SIZE) !=
+        rx_.end()) {
+      return true;
+    }
   }
-
-  return !std::memcmp(&rx[0], hash, SHA256_DIGEST_SIZE);
+  return false;
 }
 }  // namespace spiflash
 }  // namespace opentitan
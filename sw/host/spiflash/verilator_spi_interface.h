@@ -6,6 +6,7 @@
 #define OPENTITAN_SW_HOST_SPIFLASH_VERILATOR_SPI_INTERFACE_H_
 
 #include <string>
+#include <vector>
 
 #include "sw/host/spiflash/spi_interface.h"
 
@@ -15,8 +16,8 @@ namespace spiflash {
 /**
  * Implements SPI interface for an OpenTitan instance running on Verilator.
  * The OpenTitan Verilator model provides a file handle for the SPI device
- * interface. This class sends ands recevies data to the device handle, and
- * adds synchronication delays between writes and reads.
+ * interface. This class sends each frame to it as a single SPI transaction,
+ * and reads the device's acknowledgement back with further transactions.
  * This class is not thread safe.
  */
 class VerilatorSpiInterface : public SpiInterface {
@@ -35,8 +36,16 @@ class VerilatorSpiInterface : public SpiInterface {
   bool CheckHash(const uint8_t *tx, size_t size) final;
 
  private:
+  /**
+   * Sends `size` bytes from `tx` in one SPI transaction and stores the data
+   * that the device sent back in `rx_`.
+   */
+  bool Transact(const uint8_t *tx, size_t size);
+
   std::string spi_filename_;
   int fd_;
+  // Data received during the last transaction
+  std::vector<uint8_t> rx_;
 };
 
 }  // namespace spiflash
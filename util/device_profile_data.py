@@ -14,16 +14,25 @@ Typical usage:
     llvm-cov show OBJECT_FILE -instr-profile=foo.profdata
 """
 import argparse
-import zlib
 import re
 import sys
+import zlib
+
+HEADER_RE = re.compile(r'LLVM profile data \(length: (?P<length>\d+)\):')
+TRAILER_RE = re.compile(
+    r'LLVM profile data end \(CRC32: (?P<checksum>[0-9A-Fa-f]{8})\)')
+# A line of profile data: hex digits, optionally after a log prefix (when the
+# device sends the data through the DV log bypass instead of the UART).
+DATA_RE = re.compile(r'(?:^|\s)(?P<data>(?:[0-9A-Fa-f]{2})+)\s*$')
 
 
 def extract_profile_data(device_output_file):
     """Parse device output to extract LLVM profile data.
 
-    This function returns the LLVM profile data as a byte array after
-    verifying its length and checksum.
+    The device output is processed line by line, so it is never held in memory
+    as a whole. If the output contains more than one profile, the last complete
+    one is used. This function returns the LLVM profile data as a byte array
+    after verifying its length and checksum.
 
     Args:
         device_output_file: File that contains the device output.
@@ -33,37 +42,48 @@ def extract_profile_data(device_output_file):
         ValueError: If LLVM profile data cannot be detected in the device
             output or its length or checksum is incorrect.
     """
-    lines = device_output_file.read().decode('utf-8', 'ignore').splitlines()
-    for i, line in zip(reversed(range(len(lines))), reversed(lines)):
-        match = re.match(
-            r"""
-                LLVM\ profile\ data
-                \ \(length:\ (?P<length>\d*),
-                \ CRC32:\ (?P<checksum>[0-9A-F]*)\):
-            """, line, re.VERBOSE)
+    result = None
+    exp_length = None
+    data = bytearray()
+    for raw_line in device_output_file:
+        line = raw_line.decode('utf-8', 'ignore')
+        match = HEADER_RE.search(line)
         if match:
             exp_length = int(match.group('length'))
-            exp_checksum = match.group('checksum')
-            byte_array = bytes.fromhex(lines[i + 1])
-            break
+            data = bytearray()
+            continue
+        if exp_length is None:
+            continue
+
+        match = TRAILER_RE.search(line)
+        if match:
+            # The last line may be padded to a whole number of words.
+            act_length = len(data)
+            if act_length < exp_length or act_length >= exp_length + 16:
+                raise ValueError(
+                    ('Length check failed! ',
+                     f'Expected: {exp_length}, actual: {act_length}.'))
+            del data[exp_length:]
+            exp_checksum = int(match.group('checksum'), 16)
+            act_checksum = zlib.crc32(data)
+            if act_checksum != exp_checksum:
+                raise ValueError(
+                    ('Checksum check failed! ',
+                     f'Expected: {exp_checksum:08X}, '
+                     f'actual: {act_checksum:08X}.'))
+            result = bytes(data)
+            exp_length = None
+            continue
+
+        match = DATA_RE.search(line)
+        if match:
+            data += bytes.fromhex(match.group('data'))
+
     # Check if output has LLVM profile data
-    if not match:
+    if result is None:
         raise ValueError(
             'Could not detect the LLVM profile data in device output.')
-    # Check length
-    act_length = len(byte_array)
-    if act_length != exp_length:
-        raise ValueError(('Length check failed! ',
-                          f'Expected: {exp_length}, actual: {act_length}.'))
-    # Check checksum
-    act_checksum = zlib.crc32(byte_array).to_bytes(4,
-                                                   byteorder='little',
-                                                   signed=False).hex().upper()
-    if act_checksum != exp_checksum:
-        raise ValueError(
-            ('Checksum check failed! ',
-             f'Expected: {exp_checksum}, actual: {act_checksum}.'))
-    return byte_array
+    return result
 
 
 def main():
@@ -0,0 +1,162 @@
+#!/usr/bin/env python3
+# Copyright lowRISC contributors.
+# Licensed under the Apache License, Version 2.0, see LICENSE for details.
+# SPDX-License-Identifier: Apache-2.0
+"""Watch and drive GPIOs of a Verilator simulation over gpiodpi's FIFOs.
+
+This talks the binary protocol described in hw/dv/dpi/gpiodpi/gpiodpi.h, which
+is enabled by passing +GPIODPI_BINARY_gpio0 to the simulation. Each change of
+the pins arrives as a record with the clock cycle at which it happened.
+
+Typical usage:
+    ./gpiodpi.py gpio0-read                  # print every change
+    ./gpiodpi.py gpio0-read --pins 0-7       # only changes on pins 0 to 7
+    ./gpiodpi.py gpio0-read --drive 0x10=1   # drive pin 4 high, then watch
+
+The GpioDpi class can also be used from other scripts.
+"""
+import argparse
+import struct
+import sys
+from typing import Iterator, NamedTuple, Optional, Tuple
+
+MAGIC = b'GPIO'
+VERSION = 1
+
+# struct gpiodpi_header, gpiodpi_record and gpiodpi_host_record in gpiodpi.h,
+# which use host byte order and have no padding
+HEADER = struct.Struct('=4sHH')
+RECORD = struct.Struct('=QIIII')
+HOST_RECORD = struct.Struct('=II')
+
+
+class GpioChange(NamedTuple):
+    cycle: int
+    changed: int
+    value: int
+    oe: int
+    dropped: int
+
+    def pin(self, idx: int) -> Optional[int]:
+        '''Return the value of a pin, or None if the device isn't driving it'''
+        if not (self.oe >> idx) & 1:
+            return None
+        return (self.value >> idx) & 1
+
+
+class GpioDpi:
+    '''The host side of a gpiodpi instance in binary mode'''
+
+    def __init__(self, read_path: str, write_path: Optional[str] = None):
+        self._read = open(read_path, 'rb')
+        self._write = open(write_path, 'wb') if write_path else None
+
+        header = self._read_exact(HEADER.size)
+        if header is None:
+            raise ValueError('{} closed before sending a header.'
+                             .format(read_path))
+        magic, version, self.n_bits = HEADER.unpack(header)
+        if magic != MAGIC or version != VERSION:
+            raise ValueError('{} does not speak version {} of the binary '
+                             'gpiodpi protocol. Was the simulation started '
+                             'with +GPIODPI_BINARY_<name>?'
+                             .format(read_path, VERSION))
+
+    def _read_exact(self, size: int) -> Optional[bytes]:
+        data = b''
+        while len(data) < size:
+            chunk = self._read.read(size - len(data))
+            if not chunk:
+                return None
+            data += chunk
+        return data
+
+    def changes(self) -> Iterator[GpioChange]:
+        '''Yield pin changes until the simulation closes the FIFO'''
+        while True:
+            data = self._read_exact(RECORD.size)
+            if data is None:
+                return
+            yield GpioChange(*RECORD.unpack(data))
+
+    def drive(self, mask: int, value: int) -> None:
+        '''Drive the pins in mask to the corresponding bits of value'''
+        if self._write is None:
+            raise RuntimeError('No write FIFO was given.')
+        self._write.write(HOST_RECORD.pack(mask, value))
+        self._write.flush()
+
+    def close(self) -> None:
+        self._read.close()
+        if self._write is not None:
+            self._write.close()
+
+
+def parse_pins(text: str) -> int:
+    '''Parse a list of pins like "0-7,12" into a mask'''
+    mask = 0
+    for part in text.split(','):
+        lo, _, hi = part.partition('-')
+        for idx in range(int(lo), int(hi or lo) + 1):
+            mask |= 1 << idx
+    return mask
+
+
+def parse_drive(text: str) -> Tuple[int, int]:
+    '''Parse a MASK=VALUE argument, where VALUE is 0 or 1 for all pins'''
+    mask, _, value = text.partition('=')
+    mask = int(mask, 0)
+    return mask, mask if int(value or '1', 0) else 0
+
+
+def format_pins(change: GpioChange, n_bits: int) -> str:
+    '''Format the pins like the text protocol: pin 0 last, X when floating'''
+    chars = []
+    for idx in reversed(range(n_bits)):
+        value = change.pin(idx)
+        chars.append('X' if value is None else str(value))
+    return ''.join(chars)
+
+
+def main() -> int:
+    parser = argparse.ArgumentParser(description=__doc__.split('\n')[0])
+    parser.add_argument('read_fifo',
+                        help='The device-to-host FIFO, e.g. gpio0-read')
+    parser.add_argument('--write-fifo',
+                        help='The host-to-device FIFO (defaults to the read '
+                        'FIFO with -read replaced by -write)')
+    parser.add_argument('--pins', type=parse_pins,
+                        help='Only print changes on these pins, e.g. 0-7,12')
+    parser.add_argument('--drive', action='append', default=[],
+                        help='Drive the pins in MASK to VALUE (0 or 1) before '
+                        'watching, given as MASK=VALUE. May be repeated.')
+    args = parser.parse_args()
+
+    write_fifo = args.write_fifo
+    if write_fifo is None and args.drive:
+        if not args.read_fifo.endswith('-read'):
+            parser.error('Cannot guess the write FIFO; use --write-fifo.')
+        write_fifo = args.read_fifo[:-len('read')] + 'write'
+
+    gpio = GpioDpi(args.read_fifo, write_fifo)
+    for drive in args.drive:
+        gpio.drive(*parse_drive(drive))
+
+    try:
+        for change in gpio.changes():
+            if change.dropped:
+                print('{} changes dropped'.format(change.dropped))
+            if args.pins is not None and not change.changed & args.pins:
+                continue
+            print('{:>12} {}'.format(change.cycle,
+                                     format_pins(change, gpio.n_bits)))
+            sys.stdout.flush()
+    except KeyboardInterrupt:
+        pass
+    finally:
+        gpio.close()
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())